@@ -231,15 +231,15 @@ int contestia::rx_process(const double *buf, int len)
 		clamp(progStatus.sldrSquelchValue / 5.0 + 3.0, 3.0, 90.0) : 3.0;
 
     Rx->Process(buf, len);
-	sp = 0;
-	for (int i = frequency - Rx->Bandwidth/2; i < frequency - 1 + Rx->Bandwidth/2; i++)
-		if (wf->Pwr(i) > sp)
-			sp = wf->Pwr(i);
-	np = wf->Pwr(frequency + Rx->Bandwidth/2 + 2*Rx->Bandwidth/Rx->Tones);
-	if (np == 0) np = sp + 1e-8;
-	sigpwr = decayavg( sigpwr, sp, 10);
-	noisepwr = decayavg( noisepwr, np, 50);
-	snr = CLAMP(sigpwr / noisepwr, 0.001, 100000);
+// S/N from the demodulator's input spectra: net energy in the Contestia
+// band over the per-bin noise, which is averaged over the SyncMargin bins
+// that flank the band
+	if (Rx->SpectraLevels(sp, np)) {
+		if (np == 0) np = sp + 1e-8;
+		sigpwr = decayavg( sigpwr, sp, 10);
+		noisepwr = decayavg( noisepwr, np, 50);
+		snr = CLAMP(sigpwr / noisepwr, 0.001, 100000);
+	}
 
 	metric = clamp( 5.0 * (Rx->SignalToNoiseRatio() - 3.0), 0, 100);
 	display_metric(metric);
@@ -252,7 +252,8 @@ int contestia::rx_process(const double *buf, int len)
 		}
     }
 	if (gotchar) {
-		snprintf(msg1, sizeof(msg1), "s/n: %4.1f dB", 10*log10(snr) - 20);
+		snprintf(msg1, sizeof(msg1), "s/n: %4.1f dB",
+			 10*log10(snr * Rx->FrequencyBin() / 2500.0));
 		put_Status1(msg1, 5, STATUS_CLEAR);
 		snprintf(msg2, sizeof(msg2), "f/o %+4.1f Hz", Rx->FrequencyOffset());
 		put_Status2(msg2, 5, STATUS_CLEAR);
@@ -216,8 +216,6 @@ void cw::init()
 	trackingfilter->reset();
 	cw_adaptive_receive_threshold = (long int)trackingfilter->run(2 * cw_send_dot_length);
 	put_cwRcvWPM(cw_send_speed);
-	for (int i = 0; i < OUTBUFSIZE; i++)
-		outbuf[i] = qskbuf[i] = 0.0;
 	rx_init();
 	use_paren = progdefaults.CW_use_paren;
 	prosigns = progdefaults.CW_prosigns;
@@ -230,6 +228,27 @@ cw::~cw() {
 	if (cw_FFT_filter) delete cw_FFT_filter;
 	if (bitfilter) delete bitfilter;
 	if (trackingfilter) delete trackingfilter;
+	cw::free_txbuffers();
+}
+
+void cw::alloc_txbuffers()
+{
+	modem::alloc_txbuffers();
+	if (!qskbuf)
+		qskbuf = new double[OUTBUFSIZE]();
+}
+
+void cw::free_txbuffers()
+{
+	delete [] qskbuf;
+	qskbuf = 0;
+	modem::free_txbuffers();
+}
+
+size_t cw::footprint() const
+{
+	return sizeof(*this) + txbuffers_size() +
+		(qskbuf ? OUTBUFSIZE * sizeof(*qskbuf) : 0);
 }
 
 cw::cw() : modem()
@@ -246,6 +265,7 @@ cw::cw() : modem()
 
 	cw_ptr = 0;
 	clrcount = CLRCOUNT;
+	qskbuf = 0;
 
 	samplerate = CWSampleRate;
 	fragmentsize = CWMaxSymLen;
@@ -111,10 +111,18 @@ void rtty::tx_init(SoundBase *sc)
 	videoText();
 }
 
-void rtty::rx_init()
+void rtty_slicer::reset()
 {
-	rxstate = RTTY_RX_STATE_IDLE;
+	state = RTTY_RX_STATE_IDLE;
+	counter = bitcntr = rxdata = 0;
 	rxmode = LETTERS;
+	lost = 0;
+	c = lb = 0;
+}
+
+void rtty::rx_init()
+{
+	branch[0].rx.reset();
 	phaseacc = 0;
 	FSKphaseacc = 0;
 	for (int i = 0; i < RTTYMaxSymLen; i++ ) {
@@ -123,8 +131,6 @@ void rtty::rx_init()
 	bitfilt->reset();
 	poserr = negerr = 0.0;
 
-	lost = 0;
-
 	mark_phase = 0;
 	space_phase = 0;
 	xy_phase = 0.0;
@@ -135,6 +141,8 @@ void rtty::rx_init()
 	space_env = 0;
 
 	inp_ptr = 0;
+
+	div_reset();
 }
 
 void rtty::init()
@@ -176,10 +184,33 @@ rtty::~rtty()
 	if (space_filt) delete space_filt;
 	if (pipe) delete [] pipe;
 	if (dsppipe) delete [] dsppipe;
+	for (int b = 1; b < RTTY_BRANCHES; b++)
+		delete branch[b].bits;
 	delete m_Osc1;
 	delete m_Osc2;
 	delete m_SymShaper1;
 	delete m_SymShaper2;
+	rtty::free_txbuffers();
+}
+
+void rtty::alloc_txbuffers()
+{
+	modem::alloc_txbuffers();
+	if (!FSKbuf)
+		FSKbuf = new double[OUTBUFSIZE];
+}
+
+void rtty::free_txbuffers()
+{
+	delete [] FSKbuf;
+	FSKbuf = 0;
+	modem::free_txbuffers();
+}
+
+size_t rtty::footprint() const
+{
+	return sizeof(*this) + txbuffers_size() +
+		(FSKbuf ? OUTBUFSIZE * sizeof(*FSKbuf) : 0);
 }
 
 void rtty::reset_filters()
@@ -210,6 +241,17 @@ void rtty::reset_filters()
 //		space_filt->create_lpf(rtty_BW/2.0/samplerate);
 		space_filt->create_rttyfilt(rtty_BW/2.0/samplerate);
      }
+
+// the diversity receivers add a narrower filter, or the optimum one if the
+// receive filter is already narrow
+	if (diversity) {
+		div_BW = rtty_BW > 1.8 * rtty_baud ? 1.4 * rtty_baud : 2.0 * rtty_baud;
+		mark_filt->create_rttyfilt_alt(div_BW/2.0/samplerate);
+		space_filt->create_rttyfilt_alt(div_BW/2.0/samplerate);
+	} else {
+		mark_filt->clear_alt();
+		space_filt->clear_alt();
+	}
 }
 
 void rtty::restart()
@@ -234,7 +276,7 @@ void rtty::restart()
 	rtty_stop = progdefaults.rtty_stop;
 
 	txmode = LETTERS;
-	rxmode = LETTERS;
+	branch[0].rx.rxmode = LETTERS;
 	symbollen = (int) (samplerate / rtty_baud + 0.5);
 	set_bandwidth(shift);
 
@@ -261,6 +303,12 @@ void rtty::restart()
 		bits->setLength(symbollen / 2);
 	else
 		bits = new Cmovavg(symbollen / 2);
+	for (int b = 1; b < RTTY_BRANCHES; b++) {
+		if (branch[b].bits)
+			branch[b].bits->setLength(symbollen / 2);
+		else
+			branch[b].bits = new Cmovavg(symbollen / 2);
+	}
 	mark_noise = space_noise = 0;
 	bit = nubit = true;
 
@@ -313,6 +361,8 @@ void rtty::restart()
 
 	for (int i = 0; i < MAXPIPE; i++) mark_history[i] = space_history[i] = complex(0,0);
 
+	div_reset();
+
 	rttyviewer->restart();
 	progStatus.rtty_filter_changed = false;
 
@@ -331,6 +381,9 @@ rtty::rtty(trx_mode tty_mode)
 
 	bitfilt = (Cmovavg *)0;
 	bits = (Cmovavg *)0;
+	for (int b = 0; b < RTTY_BRANCHES; b++)
+		branch[b].bits = (Cmovavg *)0;
+	diversity = progdefaults.rtty_diversity;
 
 	hilbert = new C_FIR_filter();
 	hilbert->init_hilbert(37, 1);
@@ -339,6 +392,7 @@ rtty::rtty(trx_mode tty_mode)
 	dsppipe = new double [MAXPIPE];
 
 	samples = new complex[8];
+	FSKbuf = 0;
 
 	::rttyviewer = new view_rtty(mode);
 
@@ -425,113 +479,96 @@ int rtty::rttyparity(unsigned int c)
 	}
 }
 
-int rtty::decode_char()
+int rtty::decode_char(rtty_slicer& s)
 {
 	unsigned int parbit, par, data;
 
-	parbit = (rxdata >> nbits) & 1;
-	par = rttyparity(rxdata);
+	parbit = (s.rxdata >> nbits) & 1;
+	par = rttyparity(s.rxdata);
 
 	if (rtty_parity != RTTY_PARITY_NONE && parbit != par)
 		return 0;
 
-	data = rxdata & ((1 << nbits) - 1);
+	data = s.rxdata & ((1 << nbits) - 1);
 
 	if (nbits == 5)
-		return baudot_dec(data);
+		return baudot_dec(data, s.rxmode);
 
 	return data;
 }
 
-bool rtty::rx(bool bit)
+// Advance the framing of one receiver by a bit decision.  Returns true at a
+// valid stop bit, with the character and the estimated number of characters
+// lost before it in s.c and s.lb.
+bool rtty::slice(rtty_slicer& s, bool bit)
 {
 	bool flag = false;
-	unsigned char c = 0;
-	int lb;
 
-	lost++;
+	s.lost++;
 
-	switch (rxstate) {
+	switch (s.state) {
 	case RTTY_RX_STATE_IDLE:
 		if (!bit) {
-			rxstate = RTTY_RX_STATE_START;
-			counter = symbollen / 2;
+			s.state = RTTY_RX_STATE_START;
+			s.counter = symbollen / 2;
 		}
 		break;
 
 	case RTTY_RX_STATE_START:
-		if (--counter == 0) {
+		if (--s.counter == 0) {
 			if (!bit) {
-				rxstate = RTTY_RX_STATE_DATA;
-				counter = symbollen;
-				bitcntr = 0;
-				rxdata = 0;
+				s.state = RTTY_RX_STATE_DATA;
+				s.counter = symbollen;
+				s.bitcntr = 0;
+				s.rxdata = 0;
 			} else {
-				rxstate = RTTY_RX_STATE_IDLE;
+				s.state = RTTY_RX_STATE_IDLE;
 			}
 		} else
-			if (bit) rxstate = RTTY_RX_STATE_IDLE;
+			if (bit) s.state = RTTY_RX_STATE_IDLE;
 		break;
 
 	case RTTY_RX_STATE_DATA:
-		if (--counter == 0) {
-			rxdata |= bit << bitcntr++;
-			counter = symbollen;
+		if (--s.counter == 0) {
+			s.rxdata |= bit << s.bitcntr++;
+			s.counter = symbollen;
 		}
 
-		if (bitcntr == nbits) {
+		if (s.bitcntr == nbits) {
 			if (rtty_parity == RTTY_PARITY_NONE) {
-				rxstate = RTTY_RX_STATE_STOP;
+				s.state = RTTY_RX_STATE_STOP;
 			}
 			else {
-				rxstate = RTTY_RX_STATE_PARITY;
+				s.state = RTTY_RX_STATE_PARITY;
 			}
 		}
 		break;
 
 	case RTTY_RX_STATE_PARITY:
-		if (--counter == 0) {
-			rxstate = RTTY_RX_STATE_STOP;
-			rxdata |= bit << bitcntr++;
-			counter = symbollen;
+		if (--s.counter == 0) {
+			s.state = RTTY_RX_STATE_STOP;
+			s.rxdata |= bit << s.bitcntr++;
+			s.counter = symbollen;
 		}
 		break;
 
 	case RTTY_RX_STATE_STOP:
-		if (--counter == 0) {
+		if (--s.counter == 0) {
 			if (bit) {
-				if ((metric >= progStatus.sldrSquelchValue && progStatus.sqlonoff) || !progStatus.sqlonoff) {
-					c = decode_char();
-
-					if ( c != 0 && c != '\r') {
-						put_rx_char(progdefaults.rx_lowercase ? tolower(c) : c, FTextBase::RECV, true);
-					}
-					flag = true;
-
-					/* lb = estimated bytes lost */
-					lb = (lost - bytelen / 2) / bytelen;
-
-					/* HOOKS */
-					if(nbits == 8) put_rx_ssdv(c, lb);
-
-					if (lb != 0)
-						dl_fldigi::hbtint::extrmgr->skipped(lb);
-
-					if (nbits == 5)
-						dl_fldigi::hbtint::extrmgr->push(c, habitat::PUSH_BAUDOT_HACK);
-					else
-						dl_fldigi::hbtint::extrmgr->push(c);
-				}
-				lost = 0;
+				s.c = decode_char(s);
+				/* lb = estimated bytes lost */
+				s.lb = (s.lost - bytelen / 2) / bytelen;
+				s.lost = 0;
+				flag = true;
 			}
-			rxstate = RTTY_RX_STATE_STOP2;
-			counter = symbollen / 2;
+			s.state = RTTY_RX_STATE_STOP2;
+			s.counter = symbollen / 2;
 		}
 		break;
 
 	case RTTY_RX_STATE_STOP2:
-		if (--counter == 0) {
-			rxstate = RTTY_RX_STATE_IDLE;
+		if (--s.counter == 0) {
+			s.state = RTTY_RX_STATE_IDLE;
 		}
 		break;
 	}
@@ -539,6 +576,243 @@ bool rtty::rx(bool bit)
 	return flag;
 }
 
+bool rtty::squelch_open()
+{
+	return !progStatus.sqlonoff || metric >= progStatus.sldrSquelchValue;
+}
+
+bool rtty::rx(bool bit)
+{
+	rtty_slicer& s = branch[0].rx;
+
+	if (!slice(s, bit) || !squelch_open())
+		return false;
+
+	if (diversity)
+		div_vote(0, s.c);
+	else
+		rx_char(s.c, s.lb);
+
+	return true;
+}
+
+void rtty::rx_char(int c, int lb)
+{
+	if ( c != 0 && c != '\r') {
+		put_rx_char(progdefaults.rx_lowercase ? tolower(c) : c, FTextBase::RECV, true);
+	}
+
+	/* HOOKS */
+	if(nbits == 8) put_rx_ssdv(c, lb);
+
+	if (diversity)
+		div_extract(c, lb);
+	else
+		extr_push(c, lb);
+}
+
+void rtty::extr_push(int c, int lb)
+{
+	if (lb != 0)
+		dl_fldigi::hbtint::extrmgr->skipped(lb);
+
+	if (nbits == 5)
+		dl_fldigi::hbtint::extrmgr->push(c, habitat::PUSH_BAUDOT_HACK);
+	else
+		dl_fldigi::hbtint::extrmgr->push(c);
+}
+
+//=====================================================================
+// Diversity decoder
+//
+// Every receiver frames characters on its own.  A character slot opens at
+// the first stop bit any of them sees and closes half a character later;
+// the character most receivers agree on wins, ties going to the lower
+// numbered receiver.  A character heard by a single alternative receiver
+// is dropped as noise.  The winners are shown as they are voted, but a
+// telemetry sentence is held back until its newline: if its checksum fails
+// and one of the receivers decoded the same line with a good checksum,
+// that line is given to the extractors instead.
+//=====================================================================
+
+// give up holding a sentence after this many silent character lengths
+#define RTTY_HOLD_CHARS	8
+// and drop lines longer than this
+#define RTTY_MAX_LINE	1024
+
+static unsigned int ukhas_crc16(const char *s, size_t n)
+{
+	unsigned int crc = 0xFFFF;
+	for (size_t i = 0; i < n; i++) {
+		crc ^= (unsigned char)s[i] << 8;
+		for (int j = 0; j < 8; j++)
+			crc = crc & 0x8000 ? ((crc << 1) ^ 0x1021) & 0xFFFF : (crc << 1) & 0xFFFF;
+	}
+	return crc;
+}
+
+// Position of the "$$" of a sentence in line whose CRC16 or XOR checksum
+// is good, or npos.
+static size_t ukhas_sentence(const std::string& line)
+{
+	size_t start = line.rfind("$$");
+	if (start == std::string::npos)
+		return start;
+	size_t star = line.find('*', start);
+	if (star == std::string::npos)
+		return star;
+
+	const char *body = line.c_str() + start + 2;
+	size_t n = star - start - 2;
+	size_t ndigits = 0;
+	unsigned int sum = 0;
+	for (size_t i = star + 1; i < line.length() && isxdigit((unsigned char)line[i]); i++, ndigits++)
+		sum = (sum << 4) | (isdigit((unsigned char)line[i]) ? line[i] - '0' : toupper(line[i]) - 'A' + 10);
+
+	if (ndigits == 4 && sum == ukhas_crc16(body, n))
+		return start;
+	if (ndigits == 2) {
+		unsigned int x = 0;
+		for (size_t i = 0; i < n; i++)
+			x ^= (unsigned char)body[i];
+		if (sum == x)
+			return start;
+	}
+	return std::string::npos;
+}
+
+void rtty::div_reset()
+{
+	for (int b = 0; b < RTTY_BRANCHES; b++) {
+		if (b != 0) {
+			if (branch[b].bits)
+				branch[b].bits->reset();
+			branch[b].bit = true;
+			branch[b].rx.reset();
+		}
+		branch[b].line.clear();
+		branch[b].done.clear();
+		branch[b].done_at = 0;
+	}
+	alt_mark_env = alt_space_env = 0;
+	rxsample = 0;
+	slot_open = false;
+	last_char_at = 0;
+	held.clear();
+	held_lb.clear();
+}
+
+// bit decision and framing of an alternative receiver
+void rtty::div_run(int b, bool nubit)
+{
+	rtty_branch& br = branch[b];
+
+	double testbit = br.bits->run(nubit);
+	if (!br.bit && testbit > 0.75)
+		br.bit = true;
+	else if (br.bit && testbit < 0.25)
+		br.bit = false;
+
+	if (slice(br.rx, reverse ? !br.bit : br.bit) && squelch_open())
+		div_vote(b, br.rx.c);
+}
+
+void rtty::div_vote(int b, int c)
+{
+	if (slot_open && rxsample - slot_at > (unsigned long)bytelen / 2)
+		div_close();
+	if (!slot_open) {
+		slot_open = true;
+		slot_at = rxsample;
+		for (int i = 0; i < RTTY_BRANCHES; i++)
+			slot_c[i] = -1;
+	}
+	if (slot_c[b] < 0)
+		slot_c[b] = c;
+
+	rtty_branch& br = branch[b];
+	if (c == '\n') {
+		br.done = br.line;
+		br.done += c;
+		br.done_at = rxsample;
+		br.line.clear();
+	} else if (c != 0) {
+		if (br.line.length() >= RTTY_MAX_LINE)
+			br.line.clear();
+		br.line += c;
+	}
+}
+
+void rtty::div_close()
+{
+	int c = -1, votes = 0;
+
+	slot_open = false;
+	for (int i = 0; i < RTTY_BRANCHES; i++) {
+		if (slot_c[i] < 0)
+			continue;
+		int n = 0;
+		for (int j = i; j < RTTY_BRANCHES; j++)
+			n += slot_c[j] == slot_c[i];
+		if (n > votes) {
+			c = slot_c[i];
+			votes = n;
+		}
+	}
+	if (votes < 2 && slot_c[0] < 0)
+		return;
+
+	int lb = ((long)(slot_at - last_char_at) - bytelen / 2) / bytelen;
+	last_char_at = slot_at;
+	rx_char(c, lb);
+}
+
+void rtty::div_extract(int c, int lb)
+{
+	if (held.empty() && c != '$') {
+		extr_push(c, lb);
+		return;
+	}
+
+	held += c;
+	held_lb.push_back(lb);
+	if (c == '\n' || held.length() >= RTTY_MAX_LINE)
+		div_release();
+}
+
+void rtty::div_release()
+{
+	const std::string *line = &held;
+	size_t start = 0;
+
+	if (held[held.length() - 1] == '\n' && ukhas_sentence(held) == std::string::npos) {
+		for (int b = 0; b < RTTY_BRANCHES; b++) {
+			rtty_branch& br = branch[b];
+			if (br.done.empty() || rxsample - br.done_at > 2 * (unsigned long)bytelen)
+				continue;
+			if ((start = ukhas_sentence(br.done)) != std::string::npos) {
+				LOG_VERBOSE("sentence checksum good on diversity receiver %d", b);
+				line = &br.done;
+				break;
+			}
+		}
+		if (line == &held)
+			start = 0;
+	}
+
+	if (line == &held)
+		for (size_t i = 0; i < held.length(); i++)
+			extr_push(held[i], held_lb[i]);
+	else {
+		extr_push((*line)[start], held_lb[0]);
+		for (size_t i = start + 1; i < line->length(); i++)
+			extr_push((*line)[i], 0);
+	}
+
+	held.clear();
+	held_lb.clear();
+}
+
 char snrmsg[80];
 void rtty::Metric()
 {
@@ -602,13 +876,20 @@ int rtty::rx_process(const double *buf, int len)
 	const double *buffer = buf;
 	int length = len;
 
-	complex z, zmark, zspace, *zp_mark, *zp_space;
+	complex z, zmark, zspace, *zp_mark, *zp_space, *zp_amark, *zp_aspace;
 
 	int n_out = 0;
 	static int bitcount = 5 * nbits * symbollen;
 
 	if (rttyviewer && !bHistory &&
-		(dlgViewer->visible() || progStatus.show_channels)) rttyviewer->rx_process(buf, len);
+		((dlgViewer && dlgViewer->visible()) || progStatus.show_channels)) rttyviewer->rx_process(buf, len);
+
+	if (progdefaults.rtty_diversity != diversity) {
+		if (!held.empty())
+			div_release();
+		diversity = progdefaults.rtty_diversity;
+		progStatus.rtty_filter_changed = true;
+	}
 
 	if (progdefaults.RTTY_BW != rtty_BW || 
 		progStatus.rtty_filter_changed) {
@@ -620,6 +901,7 @@ int rtty::rx_process(const double *buf, int len)
 		bits->setLength(symbollen / 2);
 		mark_noise = space_noise = 0;
 		bit = nubit = true;
+		div_reset();
 	}
 
 	Metric();
@@ -639,10 +921,14 @@ int rtty::rx_process(const double *buf, int len)
 // same size outputs available for further processing
 
 		zmark = mixer(mark_phase, frequency + shift/2.0, z);
-		mark_filt->run(zmark, &zp_mark);
-
 		zspace = mixer(space_phase, frequency - shift/2.0, z);
-		n_out = space_filt->run(zspace, &zp_space);
+		if (diversity) {
+			mark_filt->run(zmark, &zp_mark, &zp_amark);
+			n_out = space_filt->run(zspace, &zp_space, &zp_aspace);
+		} else {
+			mark_filt->run(zmark, &zp_mark);
+			n_out = space_filt->run(zspace, &zp_space);
+		}
 
 		if (n_out) {
 			for (int i = 0; i < n_out; i++) {
@@ -774,6 +1060,29 @@ if (progdefaults.true_scope) {
 						set_freq(frequency - freqerr);
 				} else
 					if (bitcount) --bitcount;
+
+				if (diversity) {
+					bool atc = mark_env * mark_mag - 0.5 * mark_env * mark_env >
+						   space_env * space_mag - 0.5 * space_env * space_env;
+					div_run(1, progdefaults.kahn_demod == 0 ?
+						atc : zp_mark[i].norm() > zp_space[i].norm());
+
+					double amark_mag = zp_amark[i].mag();
+					alt_mark_env = decayavg (alt_mark_env, amark_mag,
+							(amark_mag > alt_mark_env) ? symbollen / 4 : symbollen * 16);
+					double aspace_mag = zp_aspace[i].mag();
+					alt_space_env = decayavg (alt_space_env, aspace_mag,
+							(aspace_mag > alt_space_env) ? symbollen / 4 : symbollen * 16);
+					div_run(2, zp_amark[i].norm() > zp_aspace[i].norm());
+					div_run(3, alt_mark_env * amark_mag - 0.5 * alt_mark_env * alt_mark_env >
+						   alt_space_env * aspace_mag - 0.5 * alt_space_env * alt_space_env);
+
+					rxsample++;
+					if (slot_open && rxsample - slot_at > (unsigned long)bytelen / 2)
+						div_close();
+					if (!held.empty() && rxsample - last_char_at > RTTY_HOLD_CHARS * (unsigned long)bytelen)
+						div_release();
+				}
 			}
 		}
 		if (!bitcount && clear_zdata) {
@@ -1113,24 +1422,24 @@ int rtty::baudot_enc(unsigned char data)
 	return -1;
 }
 
-char rtty::baudot_dec(unsigned char data)
+char rtty::baudot_dec(unsigned char data, int& mode)
 {
 	int out = 0;
 
 	switch (data) {
 	case 0x1F:		/* letters */
-		rxmode = LETTERS;
+		mode = LETTERS;
 		break;
 	case 0x1B:		/* figures */
-		rxmode = FIGURES;
+		mode = FIGURES;
 		break;
 	case 0x04:		/* unshift-on-space */
 		if (progdefaults.UOSrx)
-			rxmode = LETTERS;
+			mode = LETTERS;
 		return ' ';
 		break;
 	default:
-		if (rxmode == LETTERS)
+		if (mode == LETTERS)
 			out = letters[data];
 		else
 			out = figures[data];
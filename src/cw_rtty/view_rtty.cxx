@@ -38,6 +38,8 @@ using namespace std;
 #include "Viewer.h"
 #include "qrunner.h"
 
+#include "dl_fldigi/hbtint.h"
+
 //=====================================================================
 // Baudot support
 //=====================================================================
@@ -69,6 +71,7 @@ void view_rtty::rx_init()
 		channel[ch].rxmode = LETTERS;
 		channel[ch].phaseacc = 0;
 		channel[ch].timeout = 0;
+		extr_release(ch);
 		channel[ch].frequency = NULLFREQ;
 		for (int i = 0; i < RTTYMaxSymLen; i++ ) {
 			channel[ch].bbfilter[i] = 0.0;
@@ -190,6 +193,7 @@ void view_rtty::restart()
 
 		channel[ch].state = IDLE;
 		channel[ch].timeout = 0;
+		channel[ch].lost = 0;
 		channel[ch].freqerr = 0.0;
 		channel[ch].filterptr = 0;
 		channel[ch].poscnt = 0;
@@ -213,6 +217,7 @@ void view_rtty::restart()
 	else if (rtty_stop == 1) stl = 1.5;
 	else stl = 2.0;
 	stoplen = (int) (stl * samplerate / rtty_baud + 0.5);
+	bytelen = (1 + nbits + stl + (rtty_parity == RTTY_PARITY_NONE ? 0 : 1)) * samplerate / rtty_baud + 0.5;
 
 	rx_init();
 }
@@ -321,6 +326,8 @@ bool view_rtty::rx(int ch, bool bit)
 	bool flag = false;
 	unsigned char c;
 
+	channel[ch].lost++;
+
 	switch (channel[ch].rxstate) {
 	case RTTY_RX_STATE_IDLE:
 		if (!bit) {
@@ -373,8 +380,12 @@ bool view_rtty::rx(int ch, bool bit)
 				if (channel[ch].metric > rtty_squelch) {
 					c = decode_char(ch);
 // print this RTTY_CHANNEL
-					if ( c != 0 )
+					if ( c != 0 ) {
 						REQ(&viewaddchr, ch, (int)channel[ch].frequency, c, mode);
+						// characters under the squelch count as lost
+						extr_push(ch, c, (channel[ch].lost - bytelen / 2) / bytelen);
+						channel[ch].lost = 0;
+					}
 				}
 				flag = true;
 			}
@@ -421,6 +432,7 @@ void view_rtty::Metric(int ch)
 			channel[ch].freqerr = 0;
 			channel[ch].state = IDLE;
 			REQ(&viewclearchannel, ch);
+			extr_release(ch);
 		}
 	}
 }
@@ -470,6 +482,7 @@ void view_rtty::clearch(int ch)
 	channel[ch].bitfilt->reset();
 	channel[ch].poserr = channel[ch].negerr = 0.0;
 	REQ( &viewclearchannel, ch);
+	extr_release(ch);
 }
 
 void view_rtty::clear()
@@ -485,9 +498,33 @@ void view_rtty::clear()
 		}
 		channel[ch].bitfilt->reset();
 		channel[ch].poserr = channel[ch].negerr = 0.0;
+		extr_release(ch);
 	}
 }
 
+// Each channel has its own sentence extractor, so that the payloads on
+// different channels are not mixed into one sentence
+void view_rtty::extr_push(int ch, int c, int lb)
+{
+	dl_fldigi::hbtint::DExtractorManager *extr =
+		dl_fldigi::hbtint::channel(dl_fldigi::hbtint::channel_rtty_viewer + ch);
+
+	if (lb > 0)
+		extr->skipped(lb);
+
+	if (nbits == 5)
+		extr->push(c, habitat::PUSH_BAUDOT_HACK);
+	else
+		extr->push(c);
+}
+
+// The channel lost its signal; a new one must not finish its sentence
+void view_rtty::extr_release(int ch)
+{
+	channel[ch].lost = 0;
+	dl_fldigi::hbtint::release_channel(dl_fldigi::hbtint::channel_rtty_viewer + ch);
+}
+
 int view_rtty::rx_process(const double *buf, int buflen)
 {
 	complex z, zmark, zspace, *zp_mark, *zp_space;
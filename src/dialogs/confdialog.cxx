@@ -225,8 +225,10 @@ static void cb_bwsrSliderColor(Fl_Button* o, void*) {
     progdefaults.bwsrSliderColor.B = b;
     o->color(fl_rgb_color(r,g,b));
     o->redraw();
-    sldrViewerSquelch->color(fl_rgb_color(r,g,b));
-    sldrViewerSquelch->redraw();
+    if (sldrViewerSquelch) {
+        sldrViewerSquelch->color(fl_rgb_color(r,g,b));
+        sldrViewerSquelch->redraw();
+    }
     mvsquelch->color(fl_rgb_color(r,g,b));
     mvsquelch->redraw();
     
@@ -248,8 +250,10 @@ static void cb_bwsrSldrSelColor(Fl_Button* o, void*) {
     progdefaults.bwsrSldrSelColor.B = b;
     o->color(fl_rgb_color(r,g,b));
     o->redraw();
-    sldrViewerSquelch->selection_color(fl_rgb_color(r,g,b));
-    sldrViewerSquelch->redraw();
+    if (sldrViewerSquelch) {
+        sldrViewerSquelch->selection_color(fl_rgb_color(r,g,b));
+        sldrViewerSquelch->redraw();
+    }
     mvsquelch->selection_color(fl_rgb_color(r,g,b));
     mvsquelch->redraw();
     
@@ -443,7 +447,8 @@ static void cb_mnuScheme(Fl_Choice* o, void*) {
 Fl_Button *bVisibleModes=(Fl_Button *)0;
 
 static void cb_bVisibleModes(Fl_Button* o, void*) {
-  mode_browser->label(o->label());
+  if (!mode_browser) mode_browser = new Mode_Browser;
+mode_browser->label(o->label());
 mode_browser->callback(toggle_visible_modes);
 mode_browser->show(&progdefaults.visible_modes);
 progdefaults.changed = true;
@@ -1958,6 +1963,13 @@ static void cb_chk_true_scope(Fl_Check_Button* o, void*) {
 progdefaults.changed = true;
 }
 
+Fl_Check_Button *chk_rtty_diversity=(Fl_Check_Button *)0;
+
+static void cb_chk_rtty_diversity(Fl_Check_Button* o, void*) {
+  progdefaults.rtty_diversity=o->value();
+progdefaults.changed = true;
+}
+
 Fl_Check_Button *chk_useMARKfreq=(Fl_Check_Button *)0;
 
 static void cb_chk_useMARKfreq(Fl_Check_Button* o, void*) {
@@ -3004,7 +3016,8 @@ progdefaults.changed=true;
 Fl_Button *bVideoIDModes=(Fl_Button *)0;
 
 static void cb_bVideoIDModes(Fl_Button* o, void*) {
-  mode_browser->label(o->label());
+  if (!mode_browser) mode_browser = new Mode_Browser;
+mode_browser->label(o->label());
 mode_browser->callback(0);
 mode_browser->show(&progdefaults.videoid_modes);
 progdefaults.changed = true;
@@ -3029,7 +3042,8 @@ progdefaults.changed = true;
 Fl_Button *bCWIDModes=(Fl_Button *)0;
 
 static void cb_bCWIDModes(Fl_Button* o, void*) {
-  mode_browser->label(o->label());
+  if (!mode_browser) mode_browser = new Mode_Browser;
+mode_browser->label(o->label());
 mode_browser->callback(0);
 mode_browser->show(&progdefaults.cwid_modes);
 progdefaults.changed = true;
@@ -3073,7 +3087,8 @@ progdefaults.changed = true;
 Fl_Button *bRSIDRxModes=(Fl_Button *)0;
 
 static void cb_bRSIDRxModes(Fl_Button* o, void*) {
-  mode_browser->label(o->label());
+  if (!mode_browser) mode_browser = new Mode_Browser;
+mode_browser->label(o->label());
 mode_browser->callback(0);
 mode_browser->show(&progdefaults.rsid_rx_modes);
 progdefaults.changed = true;
@@ -3096,7 +3111,8 @@ progdefaults.changed = true;
 Fl_Button *bRSIDTxModes=(Fl_Button *)0;
 
 static void cb_bRSIDTxModes(Fl_Button* o, void*) {
-  mode_browser->label(o->label());
+  if (!mode_browser) mode_browser = new Mode_Browser;
+mode_browser->label(o->label());
 mode_browser->callback(0);
 mode_browser->show(&progdefaults.rsid_tx_modes);
 progdefaults.changed = true;
@@ -3794,6 +3810,41 @@ dl_fldigi::changed(dl_fldigi::CH_STATIONARY_LOCATION);
 btnApplyConfig->activate();
 }
 
+static void cb_Point(Fl_Check_Button* o, void*) {
+  progdefaults.rotator_enabled = o->value();
+progdefaults.changed = true;
+dl_fldigi::changed(dl_fldigi::CH_ROTATOR_SETTINGS);
+btnApplyConfig->activate();
+}
+
+static void cb_Host(Fl_Input* o, void*) {
+  progdefaults.rotator_host = o->value();
+progdefaults.changed = true;
+dl_fldigi::changed(dl_fldigi::CH_ROTATOR_SETTINGS);
+btnApplyConfig->activate();
+}
+
+static void cb_Port(Fl_Input* o, void*) {
+  progdefaults.rotator_port = o->value();
+progdefaults.changed = true;
+dl_fldigi::changed(dl_fldigi::CH_ROTATOR_SETTINGS);
+btnApplyConfig->activate();
+}
+
+static void cb_Step(Fl_Value_Input2* o, void*) {
+  progdefaults.rotator_min_step = o->value();
+progdefaults.changed = true;
+dl_fldigi::changed(dl_fldigi::CH_ROTATOR_SETTINGS);
+btnApplyConfig->activate();
+}
+
+static void cb_Payload(Fl_Input* o, void*) {
+  progdefaults.rotator_payload = o->value();
+progdefaults.changed = true;
+dl_fldigi::changed(dl_fldigi::CH_ROTATOR_SETTINGS);
+btnApplyConfig->activate();
+}
+
 Fl_Group *tabDLFlights=(Fl_Group *)0;
 
 Fl_Browser *flight_browser=(Fl_Browser *)0;
@@ -6243,6 +6294,12 @@ ormance"));
                 chk_true_scope->callback((Fl_Callback*)cb_chk_true_scope);
                 o->value(progdefaults.true_scope);
               } // Fl_Check_Button* chk_true_scope
+              { Fl_Check_Button* o = chk_rtty_diversity = new Fl_Check_Button(288, 285, 70, 20, _("Diversity decoder"));
+                chk_rtty_diversity->tooltip(_("Vote between several filters and demodulators\nUses more CPU"));
+                chk_rtty_diversity->down_box(FL_DOWN_BOX);
+                chk_rtty_diversity->callback((Fl_Callback*)cb_chk_rtty_diversity);
+                o->value(progdefaults.rtty_diversity);
+              } // Fl_Check_Button* chk_rtty_diversity
               o->end();
             } // Fl_Group* o
             { Fl_Group* o = new Fl_Group(271, 310, 267, 55, _("Log RTTY frequency"));
@@ -8352,6 +8409,52 @@ ased false detection"));
             } // Fl_Group* o
             o->end();
           } // Fl_Group* o
+          { Fl_Group* o = new Fl_Group(0, 50, 540, 317, _("Rotator"));
+            o->hide();
+            { Fl_Group* o = new Fl_Group(5, 60, 530, 130, _("Antenna Rotator (rotctld)"));
+              o->box(FL_ENGRAVED_FRAME);
+              o->align(Fl_Align(FL_ALIGN_TOP_LEFT|FL_ALIGN_INSIDE));
+              { Fl_Check_Button* o = new Fl_Check_Button(15, 85, 275, 25, _("Point the rotator at the payload"));
+                o->tooltip(_("Send the predicted azimuth and elevation to rotctld"));
+                o->down_box(FL_DOWN_BOX);
+                o->callback((Fl_Callback*)cb_Point);
+                o->value(progdefaults.rotator_enabled);
+              } // Fl_Check_Button* o
+              { Fl_Input* o = new Fl_Input(115, 115, 185, 25, _("Host"));
+                o->callback((Fl_Callback*)cb_Host);
+                o->value(progdefaults.rotator_host.c_str());
+              } // Fl_Input* o
+              { Fl_Input* o = new Fl_Input(350, 115, 75, 25, _("Port"));
+                o->callback((Fl_Callback*)cb_Port);
+                o->value(progdefaults.rotator_port.c_str());
+              } // Fl_Input* o
+              { Fl_Value_Input2* o = new Fl_Value_Input2(115, 150, 75, 25, _("Step"));
+                o->tooltip(_("Smallest move sent to the rotator, in degrees"));
+                o->box(FL_DOWN_BOX);
+                o->color(FL_BACKGROUND2_COLOR);
+                o->selection_color(FL_SELECTION_COLOR);
+                o->labeltype(FL_NORMAL_LABEL);
+                o->labelfont(0);
+                o->labelsize(14);
+                o->labelcolor(FL_FOREGROUND_COLOR);
+                o->minimum(0.1);
+                o->maximum(45);
+                o->step(0.1);
+                o->value(2);
+                o->callback((Fl_Callback*)cb_Step);
+                o->align(Fl_Align(FL_ALIGN_LEFT));
+                o->when(FL_WHEN_CHANGED);
+                o->value(progdefaults.rotator_min_step);
+              } // Fl_Value_Input2* o
+              { Fl_Input* o = new Fl_Input(350, 150, 175, 25, _("Payload"));
+                o->tooltip(_("Leave empty to follow the payload heard last"));
+                o->callback((Fl_Callback*)cb_Payload);
+                o->value(progdefaults.rotator_payload.c_str());
+              } // Fl_Input* o
+              o->end();
+            } // Fl_Group* o
+            o->end();
+          } // Fl_Group* o
           { tabDLFlights = new Fl_Group(0, 50, 540, 323, _("Active flights list"));
             tabDLFlights->hide();
             { Fl_Browser* o = flight_browser = new Fl_Browser(5, 60, 530, 225);
@@ -143,8 +143,10 @@
 #endif
 #if BENCHMARK_MODE
 #	include "benchmark.h"
+#	include "corpus.h"
 #endif
 #include "debug.h"
+#include "dspstats.h"
 #include "re.h"
 #include "network.h"
 #include "spot.h"
@@ -2021,6 +2023,11 @@ void cb_mnuDebug(Fl_Widget*, void*)
 	debug::show();
 }
 
+void cb_mnuDspStats(Fl_Widget*, void*)
+{
+	dspstats_show();
+}
+
 #ifndef NDEBUG
 void cb_mnuFun(Fl_Widget*, void*)
 {
@@ -3677,7 +3684,8 @@ _FL_MULTI_LABEL, 0, 14, 0},
 { make_icon_label(_("Command line options"), utilities_terminal_icon), 0, cb_mnuCmdLineHelp, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
 { make_icon_label(_("Audio device info"), audio_card_icon), 0, cb_mnuAudioInfo, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
 { make_icon_label(_("Build info"), executable_icon), 0, cb_mnuBuildInfo, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
-{ make_icon_label(_("Event log"), dialog_information_icon), 0, cb_mnuDebug, 0, FL_MENU_DIVIDER, _FL_MULTI_LABEL, 0, 14, 0},
+{ make_icon_label(_("Event log"), dialog_information_icon), 0, cb_mnuDebug, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
+{ make_icon_label(_("Receive load"), utilities_system_monitor_icon), 0, cb_mnuDspStats, 0, FL_MENU_DIVIDER, _FL_MULTI_LABEL, 0, 14, 0},
 { make_icon_label(_("Check for updates..."), system_software_update_icon), 0, cb_mnuCheckUpdate, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
 { make_icon_label(_("&About"), help_about_icon), 'a', cb_mnuAboutURL, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
 {0,0,0,0,0,0,0,0,0},
@@ -5729,7 +5737,8 @@ Fl_Menu_Item alt_menu_[] = {
 { make_icon_label(_("Command line options"), utilities_terminal_icon), 0, cb_mnuCmdLineHelp, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
 { make_icon_label(_("Audio device info"), audio_card_icon), 0, cb_mnuAudioInfo, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
 { make_icon_label(_("Build info"), executable_icon), 0, cb_mnuBuildInfo, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
-{ make_icon_label(_("Event log"), dialog_information_icon), 0, cb_mnuDebug, 0, FL_MENU_DIVIDER, _FL_MULTI_LABEL, 0, 14, 0},
+{ make_icon_label(_("Event log"), dialog_information_icon), 0, cb_mnuDebug, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
+{ make_icon_label(_("Receive load"), utilities_system_monitor_icon), 0, cb_mnuDspStats, 0, FL_MENU_DIVIDER, _FL_MULTI_LABEL, 0, 14, 0},
 { make_icon_label(_("Check for updates..."), system_software_update_icon), 0, cb_mnuCheckUpdate, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
 { make_icon_label(_("&About"), help_about_icon), 'a', cb_mnuAboutURL, 0, 0, _FL_MULTI_LABEL, 0, 14, 0},
 {0,0,0,0,0,0,0,0,0},
@@ -6630,6 +6639,7 @@ void create_fl_digi_main(int argc, char** argv)
 void put_freq(double frequency)
 {
 	wf->carrier((int)floor(frequency + 0.5));
+	dl_fldigi::hbtint::refresh_audio();
 }
 
 void put_Bandwidth(int bandwidth)
@@ -6951,7 +6961,9 @@ static void put_rx_char_flmain(unsigned int data, int style)
 void put_rx_char(unsigned int data, int style, bool extracted)
 {
 #if BENCHMARK_MODE
-	if (!benchmark.output.empty()) {
+	if (!benchmark.corpus.empty())
+		corpus_put_rx_char(data);
+	else if (!benchmark.output.empty()) {
 		if (unlikely(benchmark.buffer.length() + 16 > benchmark.buffer.capacity()))
 			benchmark.buffer.reserve(benchmark.buffer.capacity() + BUFSIZ);
 		benchmark.buffer += (char)data;
@@ -6978,6 +6990,10 @@ static void put_rx_ssdv_flmain(unsigned int data, int lost)
 
 void put_rx_ssdv(unsigned int data, int lost)
 {
+#if BENCHMARK_MODE
+	if (!benchmark.corpus.empty())
+		corpus_put_rx_byte(data);
+#endif
 	REQ(put_rx_ssdv_flmain, data, lost);
 }
 
@@ -7189,6 +7205,11 @@ int get_tx_char(void)
 	enum { STATE_CHAR, STATE_CTRL };
 	static int state = STATE_CHAR;
 
+#if BENCHMARK_MODE
+	if (!benchmark.corpus.empty())
+		return corpus_get_tx_char();
+#endif
+
 	if (!que_ok) { return GET_TX_CHAR_NODATA; }
 	if (Qwait_time) { return GET_TX_CHAR_NODATA; }
 	if (Qidle_time) { return GET_TX_CHAR_NODATA; }
@@ -20,8 +20,10 @@
 
 #include "dl_fldigi/flights.h"
 #include "dl_fldigi/hbtint.h"
+#include "dl_fldigi/journal.h"
 #include "dl_fldigi/location.h"
 #include "dl_fldigi/gps.h"
+#include "dl_fldigi/tracker.h"
 #include "dl_fldigi/update.h"
 
 using namespace std;
@@ -48,6 +50,7 @@ void init()
 {
     flights::init();
     hbtint::init();
+    journal::init();
 }
 
 void ready(bool hab_mode)
@@ -56,7 +59,10 @@ void ready(bool hab_mode)
 
     flights::load_cache();
     hbtint::start();
+    journal::start();
     location::start();
+    tracker::start();
+    hbtint::refresh_settings();
 
     /* online will call uthr->settings() if hab_mode since it online will
      * "change" from false to true) */
@@ -74,6 +80,8 @@ void cleanup()
     shutting_down = true;
 
     gps::cleanup();
+    tracker::cleanup();
+    journal::cleanup();
     hbtint::cleanup();
     flights::cleanup();
 }
@@ -85,6 +93,9 @@ static void periodically(void *)
 
     Fl::repeat_timeout(period, periodically);
 
+    /* put_freq catches frequency changes, but not reversal */
+    hbtint::refresh_audio();
+
     time_t now = time(NULL);
 
     if (hab_ui_exists)
@@ -136,6 +147,7 @@ void online(bool val)
 
     if (changed)
     {
+        hbtint::refresh_settings();
         hbtint::uthr->settings();
     }
 
@@ -205,11 +217,18 @@ void commit()
         location::current_location_mode = location::new_location_mode;
     }
 
+    hbtint::refresh_settings();
+
     if ((dirty & CH_LOCATION_MODE) || (dirty & CH_GPS_SETTINGS))
     {
         gps::configure_gps();
     }
 
+    if (dirty & CH_ROTATOR_SETTINGS)
+    {
+        tracker::configure();
+    }
+
     /* If the info has been updated, or the upload settings changed... */
     if (dirty & (CH_UTHR_SETTINGS | CH_INFO))
     {
@@ -228,24 +247,57 @@ void commit()
     dirty = CH_NONE;
 }
 
+static void run_message(void *what)
+{
+    UIMessage *message = static_cast<UIMessage *>(what);
+    message->run();
+    delete message;
+}
+
+void UIMessage::post()
+{
+    /* Fails only if FLTK's queue is full */
+    if (Fl::awake(run_message, this) != 0)
+    {
+        LOG_WARN("UI message dropped");
+        delete this;
+    }
+}
+
+class StatusMessage : public UIMessage
+{
+    const string message;
+    const bool important;
+
+public:
+    StatusMessage(const string &m, bool i) : message(m), important(i) {};
+
+    void run()
+    {
+        if (important)
+        {
+            string temp = "WARNING! " + message;
+            put_status_safe(temp.c_str(), 10);
+            last_warn = time(NULL);
+        }
+        /* don't overwrite a warning */
+        else if (time(NULL) - last_warn > 10)
+        {
+            put_status_safe(message.c_str(), 10);
+        }
+    }
+};
+
 void status(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_DEBUG("unimp status: %s", message.c_str());
-
-    /* don't overwrite a warning */
-    if (time(NULL) - last_warn > 10)
-        put_status_safe(message.c_str(), 10);
+    (new StatusMessage(message, false))->post();
 }
 
 void status_important(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_DEBUG("warn status: %s", message.c_str());
-
-    string temp = "WARNING! " + message;
-    put_status_safe(temp.c_str(), 10);
-    last_warn = time(NULL);
+    (new StatusMessage(message, true))->post();
 }
 
 } /* namespace dl_fldigi */
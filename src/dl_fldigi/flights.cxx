@@ -12,6 +12,7 @@
 #include <fstream>
 #include <sstream>
 #include <set>
+#include <map>
 #include <unistd.h>
 
 #include "main.h"
@@ -34,6 +35,9 @@ bool downloaded_flights_once, downloaded_payloads_once;
 
 static string flight_cache_file, payload_cache_file;
 static vector<Json::Value> flight_docs, payload_docs;
+/* read_cache loads the files here, ahead of load_cache */
+static vector<Json::Value> cached_flight_docs, cached_payload_docs;
+static bool cache_read;
 
 /* These pointers just point at some part of the heap allocated by something
  * in either the flight_docs vector (if cur_heap == TRACKING_FLIGHT) or 
@@ -60,6 +64,7 @@ static void write_cache_file(const string &name,
  * cast (int) -> (void *) */
 static void populate_flights();
 static void populate_payloads();
+static void index_payloads();
 
 static void select_flight_payload(int index);
 static void do_select_payload(const Json::Value &payload);
@@ -122,6 +127,15 @@ void cleanup()
     cur_heap = TRACKING_NOTHING;
 }
 
+void read_cache()
+{
+    /* any thread; touches nothing but the cached_ vectors */
+
+    load_cache_file(flight_cache_file, cached_flight_docs);
+    load_cache_file(payload_cache_file, cached_payload_docs);
+    cache_read = true;
+}
+
 void load_cache()
 {
     /* resets everything */
@@ -129,8 +143,14 @@ void load_cache()
 
     /* called with Fl lock acquired */
 
-    load_cache_file(flight_cache_file, flight_docs);
-    load_cache_file(payload_cache_file, payload_docs);
+    if (!cache_read)
+        read_cache();
+
+    flight_docs.swap(cached_flight_docs);
+    payload_docs.swap(cached_payload_docs);
+    cached_flight_docs.clear();
+    cached_payload_docs.clear();
+    cache_read = false;
 
     populate_flights();
     populate_payloads();
@@ -529,6 +549,8 @@ static void populate_flights()
             select_flight(i);
         }
     }
+
+    index_payloads();
 }
 
 static void populate_payloads()
@@ -578,6 +600,61 @@ static void populate_payloads()
             select_payload(i);
         }
     }
+
+    index_payloads();
+}
+
+static void index_payload(map<string, Json::Value> &index,
+                          const Json::Value &payload)
+{
+    if (!payload.isObject())
+        return;
+
+    const Json::Value &sentences = payload["sentences"];
+    if (!sentences.isArray())
+        return;
+
+    for (Json::Value::const_iterator it = sentences.begin();
+            it != sentences.end(); ++it)
+    {
+        const Json::Value &sentence = *it;
+
+        if (!sentence.isObject() || !sentence["callsign"].isString())
+            continue;
+
+        /* insert() keeps the first configuration for a callsign */
+        index.insert(make_pair(sentence["callsign"].asString(), payload));
+    }
+}
+
+/* Hands every payload configuration we have to the extractors, by
+ * callsign, so that a channel can parse sentences from payloads other
+ * than the selected one. Active flights' payloads come before the rest. */
+static void index_payloads()
+{
+    map<string, Json::Value> index;
+
+    for (vector<Json::Value>::const_iterator it = flight_docs.begin();
+            it != flight_docs.end(); ++it)
+    {
+        if (!it->isObject())
+            continue;
+
+        const Json::Value &payloads = (*it)["_payload_docs"];
+        if (!payloads.isArray())
+            continue;
+
+        for (Json::Value::const_iterator p = payloads.begin();
+                p != payloads.end(); ++p)
+            index_payload(index, *p);
+    }
+
+    for (vector<Json::Value>::const_iterator it = payload_docs.begin();
+            it != payload_docs.end(); ++it)
+        index_payload(index, *it);
+
+    LOG_DEBUG("%zi callsigns in the payload index", index.size());
+    hbtint::index_payloads(index);
 }
 
 static void select_flight_payload(int index)
@@ -12,6 +12,7 @@
 #include <signal.h>
 #include <pthread.h>
 #include <stdio.h>
+#include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -19,8 +20,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <termios.h>
+#include <poll.h>
+#include <errno.h>
 #else
 #include <windows.h>
+#include <io.h>
 #endif
 
 #include <FL/Fl.H>
@@ -45,11 +49,14 @@ static GPSThread *gps_thread;
 
 void cleanup()
 {
+    /* The thread never waits for the GUI, so it can be joined directly */
     if (gps_thread)
+    {
         gps_thread->shutdown();
-
-    while (gps_thread)
-        Fl::wait();
+        gps_thread->join();
+        delete gps_thread;
+        gps_thread = 0;
+    }
 }
 
 void configure_gps()
@@ -78,6 +85,10 @@ void configure_gps()
 
 static void gps_thread_death(void *what)
 {
+    /* cleanup() has already joined it */
+    if (dl_fldigi::shutting_down)
+        return;
+
     if (what != gps_thread)
     {
         LOG_ERROR("unknown thread");
@@ -187,9 +198,9 @@ void *GPSThread::run()
     return NULL;
 }
 
+/* Neither may take the FLTK lock; status_important posts a message */
 void GPSThread::warning(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_WARN("hbtGPS %s", message.c_str());
 
     string temp = "GPS Error " + message;
@@ -198,216 +209,158 @@ void GPSThread::warning(const string &message)
 
 void GPSThread::log(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_DEBUG("hbtGPS %s", message.c_str());
 }
 
-static bool check_gpgga(const vector<string> &parts)
-{
-    if (parts.size() < 7)
-        return false;
-
-    if (parts[0] != "$GPGGA")
-        return false;
-
-    /* Fix quality field */
-    if (parts[6] == "0")
-        return false;
+/* With no data for this long the device is closed and opened again */
+static const int read_timeout = 10;
 
-    for (int i = 1; i < 7; i++)
-        if (!parts[i].size())
-            return false;
-
-    return true;
-}
-
-static void split_nmea(const string &data, vector<string> &parts)
+#ifndef __MINGW32__
+void GPSThread::read()
 {
-    size_t a = 0, b = 0;
-
-    while (b != string::npos)
-    {
-        string part;
-        b = data.find_first_of(",*", a);
+    char buf[256];
+    struct pollfd pfd;
 
-        if (b == string::npos)
-            part = data.substr(a);
-        else
-            part = data.substr(a, b - a);
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
 
-        parts.push_back(part);
-        a = b + 1;
+    int ret = poll(&pfd, 1, read_timeout * 1000);
+    if (ret == -1)
+    {
+        /* SIGUSR2 from shutdown() */
+        if (errno == EINTR)
+            return;
+        throw runtime_error("poll() failed");
     }
-}
+    if (ret == 0)
+        throw runtime_error("no data from the GPS");
+    if (!(pfd.revents & POLLIN))
+        throw runtime_error("device error or hangup");
 
-static string parse_hms(const string &part)
-{
-    ostringstream temp;
-    temp << part.substr(0, 2) << ':'
-        << part.substr(2, 2) << ':'
-        << part.substr(4, 2);
-    if (temp.str().size() != 8)
-        throw runtime_error("bad NMEA time");
-    return temp.str();
-}
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n == -1 && (errno == EAGAIN || errno == EINTR))
+        return;
+    if (n <= 0)
+        throw runtime_error("read() failed: EOF or error");
 
-static double parse_ddm(string part, const string &dirpart)
+    for (ssize_t i = 0; i < n; i++)
+        if (parser.feed(buf[i]))
+            position();
+}
+#else
+void GPSThread::read()
 {
-    double degrees, mins;
-    size_t pos = part.find('.');
-    if (pos == string::npos || pos < 3)
-        throw runtime_error("Bad DDM");
-
-    /* Split degrees and minutes parts */
-    part.insert(pos - 2, " ");
-
-    istringstream tmp(part);
-    tmp.exceptions(istringstream::failbit | istringstream::badbit);
-
-    tmp >> degrees;
-    tmp >> mins;
-
-    double value = degrees + mins / 60;
-
-    if (dirpart == "S" || dirpart == "W")
-        return -value;
-    else
-        return value;
+    char buf[256];
+
+    /* The COMMTIMEOUTS set in setup() end the read at a pause in the data,
+     * or after read_timeout seconds with nothing */
+    int n = ::read(fd, buf, sizeof(buf));
+    if (n == 0)
+        throw runtime_error("no data from the GPS");
+    if (n < 0)
+        throw runtime_error("read() failed");
+
+    for (int i = 0; i < n; i++)
+        if (parser.feed(buf[i]))
+            position();
 }
+#endif
 
-static double parse_alt(const string &part, const string &unit_part)
+/* A 10 Hz receiver sends ten fixes a second, and often GGA, RMC and GNS for
+ * each. The UI is refreshed at most once a second, and the position is
+ * uploaded every rate seconds. */
+void GPSThread::position()
 {
-    if (unit_part != "M")
-        throw runtime_error("altitude units are not M");
+    const nmea::Fix &fix = parser.fix();
+    time_t now = time(NULL);
+    bool due = (now - last_upload >= rate);
 
-    istringstream tmp;
-    double value;
+    if (!due && now == last_ui)
+        return;
+    last_ui = now;
 
-    tmp.exceptions(istringstream::failbit | istringstream::badbit);
-    tmp.str(part);
-    tmp >> value;
+    LOG_DEBUG("GPS position: %s %f %f, %fM (%lu sentences, %lu bad checksums)",
+              fix.time, fix.latitude, fix.longitude, fix.altitude,
+              parser.sentences, parser.bad_checksum);
 
-    return value;
+    update_ui(fix, due);
+    if (due)
+        upload(fix);
 }
 
-void GPSThread::read()
+class GPSPositionMessage : public UIMessage
 {
-    /* Read until a newline */
-    char buf[100];
-    char *result;
-    result = fgets(buf, sizeof(buf), f);
-
-    if (result != buf)
-        throw runtime_error("fgets read no data: EOF or error");
-
-    /* Find the $ (i.e., discard garbage before the $) */
-    char *start = strchr(buf, '$');
-
-    if (!start)
-        throw runtime_error("Did not find start delimiter");
+    const nmea::Fix fix;
+    const bool uploaded;
 
-    string data(start);
-    data.erase(data.end() - 1);
+public:
+    GPSPositionMessage(const nmea::Fix &f, bool u)
+        : fix(f), uploaded(u) {};
 
-    log("Read line: " + data);
+    void run()
+    {
+        if (shutting_down)
+            return;
 
-    vector<string> parts;
-    split_nmea(data, parts);
+        ostringstream lat_tmp, lon_tmp, alt_tmp;
+        lat_tmp << fix.latitude;
+        lon_tmp << fix.longitude;
+        if (fix.has_altitude)
+            alt_tmp << fix.altitude;
 
-    if (!check_gpgga(parts))
-        return;
+        gps_pos_time->value(fix.time);
+        gps_pos_lat->value(lat_tmp.str().c_str());
+        gps_pos_lon->value(lon_tmp.str().c_str());
+        gps_pos_altitude->value(alt_tmp.str().c_str());
 
-    string time_str;
-    double latitude, longitude, altitude;
+        gps_pos_save->activate();
 
-    try
-    {
-        time_str = parse_hms(parts[1]);
-        latitude = parse_ddm(parts[2], parts[3]);
-        longitude = parse_ddm(parts[4], parts[5]);
-        altitude = parse_alt(parts[9], parts[10]);
-    }
-    catch (out_of_range e)
-    {
-        throw runtime_error("Failed to parse data (oor)");
-    }
-    catch (istringstream::failure e)
-    {
-        throw runtime_error("Failed to parse data (fail)");
+        /* The location globals belong to the main thread */
+        if (uploaded && location::current_location_mode == location::LOC_GPS)
+        {
+            location::listener_valid = true;
+            location::listener_latitude = fix.latitude;
+            location::listener_longitude = fix.longitude;
+            if (fix.has_altitude)
+                location::listener_altitude = fix.altitude;
+            location::update_distance_bearing();
+        }
     }
+};
 
-    update_ui(time_str, latitude, longitude, altitude);
-    upload(time_str, latitude, longitude, altitude);
-}
-
-void GPSThread::update_ui(const string &time_str,
-                          double latitude, double longitude, double altitude)
+/* uploaded: the position is also the listener's new location */
+void GPSThread::update_ui(const nmea::Fix &fix, bool uploaded)
 {
-    ostringstream lat_tmp, lon_tmp, alt_tmp;
-	lat_tmp << latitude;
-    lon_tmp << longitude;
-    alt_tmp << altitude;
-
-    gps_pos_time->value(time_str.c_str());
-    gps_pos_lat->value(lat_tmp.str().c_str());
-    gps_pos_lon->value(lon_tmp.str().c_str());
-    gps_pos_altitude->value(alt_tmp.str().c_str());
-
-    gps_pos_save->activate();
+    (new GPSPositionMessage(fix, uploaded))->post();
 }
 
-void GPSThread::upload(const string &time_str,
-                       double latitude, double longitude, double altitude)
+void GPSThread::upload(const nmea::Fix &fix)
 {
-    Fl_AutoLock lock;
-
-    LOG_DEBUG("GPS position: %s %f %f, %fM",
-              time_str.c_str(), latitude, longitude, altitude);
-
-    if (time(NULL) - last_upload < rate)
-        return;
-
-    /* Data OK? upload. */
-    if (location::current_location_mode != location::LOC_GPS)
-        throw runtime_error("GPS mode disabled mid-line");
-
     last_upload = time(NULL);
 
-    location::listener_valid = true;
-    location::listener_latitude = latitude;
-    location::listener_longitude = longitude;
-    location::listener_altitude = altitude;
-    location::update_distance_bearing();
-
-    ostringstream temp;
-
     Json::Value data(Json::objectValue);
-    // data["time"] = time_str;
-    data["latitude"] = latitude;
-    data["longitude"] = longitude;
-    data["altitude"] = altitude;
+    // data["time"] = fix.time;
+    data["latitude"] = fix.latitude;
+    data["longitude"] = fix.longitude;
+    /* Receivers that only send RMC give no altitude */
+    if (fix.has_altitude)
+        data["altitude"] = fix.altitude;
     data["chase"] = true;
 
+    /* Data OK? upload. This throws if GPS mode was disabled mid-line */
     hbtint::uthr->listener_telemetry(data);
 }
 
 #ifndef __MINGW32__
 void GPSThread::setup()
 {
-    /* Open the serial port without blocking. Rely on cleanup() */
+    /* Open the serial port without blocking, and leave it that way: read()
+     * waits in poll(). Rely on cleanup() */
     fd = open(device.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK);
     if (fd == -1)
         throw runtime_error("open() failed");
 
-    f = fdopen(fd, "r");
-    if (f == NULL)
-        throw runtime_error("fdopen() failed");
-
-    /* Line buffering */
-    int lbf = setvbuf(f, (char *) NULL, _IOLBF, 0);
-    if (lbf != 0)
-        throw runtime_error("setvbuf() failed");
-
     /* Linux requires baudrates be given as a constant */
     speed_t baudrate = B4800;
     if (baud == 9600)           baudrate = B9600;
@@ -440,37 +393,27 @@ void GPSThread::setup()
     /* Ignore CR in NMEA's CRLF */
     port_settings.c_iflag |= (IGNCR);
 
-    /* Blocking read until 1 character arrives */
+    /* read() returns whatever has arrived */
     port_settings.c_cc[VMIN] = 1;
 
-    /* Re enable blocking for reading. */
-    int set = fcntl(fd, F_SETFL, 0);
-    if (set == -1)
-        throw runtime_error("fcntl() failed");
-
     /* All baud settings */
-    set = tcsetattr(fd, TCSANOW, &port_settings);
+    int set = tcsetattr(fd, TCSANOW, &port_settings);
     if (set == -1)
         throw runtime_error("tcsetattr() failed");
 }
 
 void GPSThread::cleanup()
 {
-    /* The various things will close their underlying fds or handles (w32).
-     * Close the last thing we managed to open */
-    if (f)
-        fclose(f);
-    else if (fd != -1)
+    if (fd != -1)
         close(fd);
 
-    f = NULL;
     fd = -1;
 }
 #else
 void GPSThread::setup()
 {
-    HANDLE handle = CreateFile(device.c_str(), GENERIC_READ, 0, 0,
-                               OPEN_EXISTING, 0, 0);
+    handle = CreateFile(device.c_str(), GENERIC_READ, 0, 0,
+                        OPEN_EXISTING, 0, 0);
     if (handle == INVALID_HANDLE_VALUE)
         throw runtime_error("CreateFile() failed");
 
@@ -489,39 +432,28 @@ void GPSThread::setup()
         throw runtime_error("GetCommState() failed");
 
     COMMTIMEOUTS timeouts;
-    timeouts.ReadIntervalTimeout            = 2000;
+    timeouts.ReadIntervalTimeout            = 50;
     timeouts.ReadTotalTimeoutMultiplier     = 0;
-    timeouts.ReadTotalTimeoutConstant       = 5000;
+    timeouts.ReadTotalTimeoutConstant       = read_timeout * 1000;
     timeouts.WriteTotalTimeoutMultiplier    = 0;
     timeouts.WriteTotalTimeoutConstant      = 0;
 
     if (!SetCommTimeouts(handle, &timeouts))
         throw runtime_error("SetCommTimeouts() failed");
 
+    /* The fd owns the handle from here on */
     fd = _open_osfhandle((intptr_t) handle, _O_RDONLY);
     if (fd == -1)
         throw runtime_error("_open_osfhandle() failed");
-
-    f = fdopen(fd, "r");
-    if (!f)
-        throw runtime_error("fdopen() failed");
-
-    /* Line buffering */
-    int lbf = setvbuf(f, (char *) NULL, _IOLBF, 0);
-    if (lbf != 0)
-        throw runtime_error("setvbuf() failed");
 }
 
 void GPSThread::cleanup()
 {
-    if (f)
-        fclose(f);
-    else if (fd != -1)
+    if (fd != -1)
         close(fd);
     else if (handle != INVALID_HANDLE_VALUE)
         CloseHandle(handle);
 
-    f = NULL;
     fd = -1;
     handle = INVALID_HANDLE_VALUE;
 }
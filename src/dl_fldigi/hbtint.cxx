@@ -9,6 +9,8 @@
 
 #include <string>
 #include <sstream>
+#include <map>
+#include <math.h>
 
 #include <FL/Fl.H>
 
@@ -25,6 +27,8 @@
 #include "dl_fldigi/version.h"
 #include "dl_fldigi/location.h"
 #include "dl_fldigi/flights.h"
+#include "dl_fldigi/journal.h"
+#include "dl_fldigi/tracker.h"
 
 using namespace std;
 
@@ -34,22 +38,116 @@ namespace hbtint {
 static EZ::cURLGlobal *cgl;
 DExtractorManager *extrmgr;
 DUploaderThread *uthr;
-static habitat::UKHASExtractor *ukhas;
 
-static EZ::Mutex rig_mutex;
-static time_t rig_freq_updated, rig_mode_updated;
-static long long rig_freq;
-static string rig_mode;
+/* The decoder channels, each an extractor manager with its own UKHAS
+ * extractor. A released channel may still be in the middle of a push on
+ * the trx thread, so it is only deleted by the next call to channel(),
+ * which comes from that thread. */
+struct Channel
+{
+    DExtractorManager *manager;
+    habitat::UKHASExtractor *ukhas;
+};
+
+static EZ::Mutex channels_mutex;
+static map<int, Channel> channels;
+static vector<Channel> released;
+
+static void delete_channel(const Channel &c)
+{
+    delete c.manager;
+    delete c.ukhas;
+}
+
+/* Callsign -> payload configuration, for routing */
+static EZ::Mutex index_mutex;
+static map<string, Json::Value> payload_index;
+
+/* The uploader, GPS and trx threads take their settings from an immutable
+ * snapshot, so that they never need the FLTK lock to read progdefaults.
+ * Writers copy the current snapshot, modify the copy and swap the pointer;
+ * readers hold a reference (SettingsRef) for as long as they use it. */
+struct Settings
+{
+    string callsign, uri, db;
+    string name, qth, radio, antenna;
+    bool online;
+    location::location_mode location_mode;
+
+    long long rig_freq;
+    string rig_mode;
+    time_t rig_freq_updated, rig_mode_updated;
+    double audio_freq;
+    bool reversed;
+
+    mutable int refs;
+
+    Settings()
+        : online(false), location_mode(location::LOC_STATIONARY),
+          rig_freq(0), rig_freq_updated(0), rig_mode_updated(0),
+          audio_freq(0), reversed(false), refs(1) {};
+};
+
+/* settings_mutex only guards the pointer swap and the reference count
+ * increment; settings_write_mutex serialises writers so that a rig update
+ * and a settings refresh don't lose each other's changes. */
+static EZ::Mutex settings_mutex, settings_write_mutex;
+static const Settings *cur_settings;
+
+static void release_settings(const Settings *s)
+{
+    if (__sync_sub_and_fetch(&s->refs, 1) == 0)
+        delete s;
+}
+
+/* Caller must hold settings_write_mutex */
+static Settings *copy_settings()
+{
+    Settings *s = new Settings(*cur_settings);
+    s->refs = 1;
+    return s;
+}
+
+static void publish_settings(Settings *s)
+{
+    const Settings *old;
+
+    {
+        EZ::MutexLock lock(settings_mutex);
+        old = cur_settings;
+        cur_settings = s;
+    }
+
+    if (old)
+        release_settings(old);
+}
+
+class SettingsRef
+{
+    const Settings *s;
+
+    SettingsRef(const SettingsRef &);
+    SettingsRef &operator=(const SettingsRef &);
+
+public:
+    SettingsRef()
+    {
+        EZ::MutexLock lock(settings_mutex);
+        s = cur_settings;
+        __sync_add_and_fetch(&s->refs, 1);
+    };
+    ~SettingsRef() { release_settings(s); };
+
+    const Settings *operator->() const { return s; };
+};
 
 void init()
 {
     cgl = new EZ::cURLGlobal();
+    cur_settings = new Settings();
 
     uthr = new DUploaderThread();
-    extrmgr = new DExtractorManager(*uthr);
-
-    ukhas = new habitat::UKHASExtractor();
-    extrmgr->add(*ukhas);
+    extrmgr = channel(channel_modem);
 }
 
 void start()
@@ -59,59 +157,160 @@ void start()
 
 void cleanup()
 {
-    delete extrmgr;
-    delete ukhas;
-
-    extrmgr = 0;
-    ukhas = 0;
+    {
+        EZ::MutexLock lock(channels_mutex);
+
+        for (map<int, Channel>::iterator it = channels.begin();
+             it != channels.end(); it++)
+            delete_channel(it->second);
+        for (vector<Channel>::iterator it = released.begin();
+             it != released.end(); it++)
+            delete_channel(*it);
+
+        channels.clear();
+        released.clear();
+        extrmgr = 0;
+    }
 
-    /* This prevents deadlocks with our use of Fl::lock in the uploader
-     * thread (which is a necessary evil since we're accessing loads of
-     * global fldigi stuff) */
+    /* Nothing in the uploader thread waits for the GUI, so it can be
+     * joined directly */
     if (uthr)
+    {
         uthr->shutdown();
+        uthr->join();
+        LOG_INFO("cleaning up");
+        delete uthr;
+        uthr = 0;
+    }
 
-    while (uthr)
-        Fl::wait();
+    {
+        EZ::MutexLock lock(settings_write_mutex);
+        publish_settings(0);
+    }
 
     delete cgl;
     cgl = 0;
 }
 
-void rig_set_freq(long long freq)
+DExtractorManager *channel(int id)
 {
-    EZ::MutexLock lock(rig_mutex);
-    rig_freq_updated = time(NULL);
-    rig_freq = freq;
+    EZ::MutexLock lock(channels_mutex);
+
+    if (released.size())
+    {
+        for (vector<Channel>::iterator it = released.begin();
+             it != released.end(); it++)
+            delete_channel(*it);
+        released.clear();
+    }
+
+    map<int, Channel>::iterator it = channels.find(id);
+    if (it != channels.end())
+        return it->second.manager;
+
+    Channel c;
+    c.manager = new DExtractorManager(*uthr, id);
+    c.ukhas = new habitat::UKHASExtractor();
+    c.manager->add(*c.ukhas);
+    channels[id] = c;
+
+    return c.manager;
 }
 
-void rig_set_mode(const string &mode)
+void release_channel(int id)
 {
-    EZ::MutexLock lock(rig_mutex);
-    rig_mode_updated = time(NULL);
-    rig_mode = mode;
+    if (id == channel_modem)
+        return;
+
+    EZ::MutexLock lock(channels_mutex);
+
+    map<int, Channel>::iterator it = channels.find(id);
+    if (it == channels.end())
+        return;
+
+    released.push_back(it->second);
+    channels.erase(it);
 }
 
-static void uthr_thread_death(void *what)
+void index_payloads(map<string, Json::Value> &index)
 {
-    if (what != uthr)
-    {
-        LOG_ERROR("unknown thread");
+    EZ::MutexLock lock(index_mutex);
+    payload_index.swap(index);
+}
+
+void refresh_settings()
+{
+    EZ::MutexLock lock(settings_write_mutex);
+    if (!cur_settings)
         return;
+
+    Settings *s = copy_settings();
+
+    s->callsign = progdefaults.myCall;
+    s->uri = progdefaults.habitat_uri;
+    s->db = progdefaults.habitat_db;
+    s->name = progdefaults.myName;
+    s->qth = progdefaults.myQth;
+    s->radio = progdefaults.myRadio;
+    s->antenna = progdefaults.myAntenna;
+    s->online = online();
+    s->location_mode = location::current_location_mode;
+
+    if (active_modem)
+    {
+        s->audio_freq = active_modem->get_freq();
+        s->reversed = active_modem->get_reverse();
     }
 
-    LOG_INFO("cleaning up");
-    uthr->join();
-    delete uthr;
-    uthr = 0;
+    publish_settings(s);
 }
 
-/* Modify run() to help us shutdown the thread */
-void *DUploaderThread::run()
+void refresh_audio()
 {
-    void *ret = UploaderThread::run();
-    Fl::awake(uthr_thread_death, this);
-    return ret;
+    if (!active_modem)
+        return;
+
+    double freq = active_modem->get_freq();
+    bool reversed = active_modem->get_reverse();
+
+    EZ::MutexLock lock(settings_write_mutex);
+    if (!cur_settings)
+        return;
+
+    /* put_freq is called often while the AFC tracks; don't swap for
+     * fractions of a Hz */
+    if (fabs(cur_settings->audio_freq - freq) < 1.0 &&
+        cur_settings->reversed == reversed)
+        return;
+
+    Settings *s = copy_settings();
+    s->audio_freq = freq;
+    s->reversed = reversed;
+    publish_settings(s);
+}
+
+void rig_set_freq(long long freq)
+{
+    EZ::MutexLock lock(settings_write_mutex);
+    if (!cur_settings)
+        return;
+
+    Settings *s = copy_settings();
+    s->rig_freq_updated = time(NULL);
+    s->rig_freq = freq;
+    publish_settings(s);
+}
+
+void rig_set_mode(const string &mode)
+{
+    EZ::MutexLock lock(settings_write_mutex);
+    if (!cur_settings)
+        return;
+
+    Settings *s = copy_settings();
+    s->rig_mode_updated = time(NULL);
+    s->rig_mode = mode;
+    publish_settings(s);
 }
 
 /* Some functions below are called via a DUploaderThread pointer so
@@ -122,57 +321,77 @@ void *DUploaderThread::run()
 
 void DUploaderThread::settings()
 {
-    Fl_AutoLock lock;
+    SettingsRef s;
 
     UploaderThread::reset();
 
-    if (!online())
+    if (!s->online)
     {
         warning("upload disabled: offline");
         return;
     }
 
-    if (!progdefaults.myCall.size() || !progdefaults.habitat_uri.size() ||
-        !progdefaults.habitat_db.size())
+    if (!s->callsign.size() || !s->uri.size() || !s->db.size())
     {
         warning("upload disabled: settings missing");
         return;
     }
 
-    UploaderThread::settings(progdefaults.myCall, progdefaults.habitat_uri,
-                             progdefaults.habitat_db);
+    UploaderThread::settings(s->callsign, s->uri, s->db);
 }
 
 void DUploaderThread::payload_telemetry(const string &data,
         const Json::Value &metadata, int time_created)
 {
-    Fl_AutoLock lock;
+    SettingsRef s;
 
     /* If the frequency/mode from the rig is recent, upload it.
      * null metadata is automatically converted to an object by jsoncpp */
 
     Json::Value rig_info(Json::objectValue);
     
-    if (rig_freq_updated >= time(NULL) - 30)
-        rig_info["frequency"] = rig_freq;
-    if (rig_mode_updated >= time(NULL) - 30)
-        rig_info["mode"] = rig_mode;
-    rig_info["audio_frequency"] = active_modem->get_freq();
-    rig_info["reversed"] = active_modem->get_reverse();
+    if (s->rig_freq_updated >= time(NULL) - 30)
+        rig_info["frequency"] = s->rig_freq;
+    if (s->rig_mode_updated >= time(NULL) - 30)
+        rig_info["mode"] = s->rig_mode;
+    rig_info["audio_frequency"] = s->audio_freq;
+    rig_info["reversed"] = s->reversed;
 
     Json::Value new_metadata = metadata;
     new_metadata["rig_info"] = rig_info;
 
+    /* Journal it first, with a definite time, so that a replay is the
+     * same upload */
+    if (time_created == -1)
+        time_created = time(NULL);
+
+    if (!journal::record(data, new_metadata, time_created).size())
+    {
+        log("not uploading duplicate sentence");
+        return;
+    }
+
     UploaderThread::payload_telemetry(data, new_metadata, time_created);
 }
 
+void DUploaderThread::replay_telemetry(const string &data,
+        const Json::Value &metadata, int time_created)
+{
+    UploaderThread::payload_telemetry(data, metadata, time_created);
+}
+
+bool upload_enabled()
+{
+    SettingsRef s;
+    return s->online && s->callsign.size() && s->uri.size() && s->db.size();
+}
 
-/* This function is used for stationary listener telemetry only */
+
+/* This function is used for stationary listener telemetry only. It reads
+ * the location widgets, so must be called from the main thread. */
 
 void DUploaderThread::listener_telemetry()
 {
-    Fl_AutoLock lock;
-
     if (location::current_location_mode != location::LOC_STATIONARY)
     {
         warning("attempted to upload stationary listener "
@@ -197,9 +416,9 @@ void DUploaderThread::listener_telemetry()
 
 void DUploaderThread::listener_telemetry(const Json::Value &data)
 {
-    Fl_AutoLock lock;
+    SettingsRef s;
 
-    if (location::current_location_mode != location::LOC_GPS)
+    if (s->location_mode != location::LOC_GPS)
         throw runtime_error("Attempted to upload GPS data while not "
                             "in GPS mode");
 
@@ -214,35 +433,33 @@ static void info_add(Json::Value &data, const string &key, const string &value)
 
 void DUploaderThread::listener_information()
 {
-    Fl_AutoLock lock;
+    SettingsRef s;
 
     Json::Value data(Json::objectValue);
-    info_add(data, "name", progdefaults.myName);
-    info_add(data, "location", progdefaults.myQth);
-    info_add(data, "radio", progdefaults.myRadio);
-    info_add(data, "antenna", progdefaults.myAntenna);
+    info_add(data, "name", s->name);
+    info_add(data, "location", s->qth);
+    info_add(data, "radio", s->radio);
+    info_add(data, "antenna", s->antenna);
     data["dl_fldigi"] = git_short_commit;
 
     UploaderThread::listener_information(data);
 }
 
-/* These functions absolutely must be thread safe. */
+/* These functions absolutely must be thread safe. None of them may take
+ * the FLTK lock: UI updates are posted as messages. */
 void DUploaderThread::log(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_DEBUG("hbtUT %s", message.c_str());
 }
 
 void DUploaderThread::warning(const string &message)
 {
-    Fl_AutoLock lock;
     LOG_WARN("hbtUT %s", message.c_str());
     status_important(message);
 }
 
 void DUploaderThread::caught_exception(const habitat::NotInitialisedError &e)
 {
-    Fl_AutoLock lock;
     LOG_WARN("NotInitialisedError");
     status_important("Can't upload! Either in offline mode, or "
                         "your callsign is not set.");
@@ -253,15 +470,39 @@ void DUploaderThread::saved_id(const string &type, const string &id)
     /* Log as normal, but also set status */
     UploaderThread::saved_id(type, id);
     status("Uploaded " + type + " successfully");
+
+    if (type == "payload_telemetry")
+        journal::uploaded(id);
 }
 
+class DocsMessage : public UIMessage
+{
+    const vector<Json::Value> docs;
+    const bool payloads;
+
+public:
+    DocsMessage(const vector<Json::Value> &d, bool p)
+        : docs(d), payloads(p) {};
+
+    void run()
+    {
+        if (shutting_down)
+            return;
+
+        if (payloads)
+            flights::new_payload_docs(docs);
+        else
+            flights::new_flight_docs(docs);
+    }
+};
+
 void DUploaderThread::got_flights(const vector<Json::Value> &new_flights)
 {
     ostringstream ltmp;
     ltmp << "Downloaded " << new_flights.size() << " flight docs";
     log(ltmp.str());
 
-    flights::new_flight_docs(new_flights);
+    (new DocsMessage(new_flights, false))->post();
 }
 
 void DUploaderThread::got_payloads(const vector<Json::Value> &new_payloads)
@@ -270,14 +511,114 @@ void DUploaderThread::got_payloads(const vector<Json::Value> &new_payloads)
     ltmp << "Downloaded " << new_payloads.size() << " payload docs";
     log(ltmp.str());
 
-    flights::new_payload_docs(new_payloads);
+    (new DocsMessage(new_payloads, true))->post();
 }
 
 /* Be careful not to call this function instead of dl_fldigi::status() */
 void DExtractorManager::status(const string &msg)
 {
-    Fl_AutoLock lock;
-    LOG_DEBUG("hbtE %s", msg.c_str());
+    if (id == channel_modem)
+        LOG_DEBUG("hbtE %s", msg.c_str());
+    else
+        LOG_DEBUG("hbtE %#x %s", id, msg.c_str());
+}
+
+/* Callsigns longer than this aren't callsigns */
+static const size_t max_callsign = 32;
+
+void DExtractorManager::push(char c, enum habitat::push_flags flags)
+{
+    watch(c);
+    habitat::ExtractorManager::push(c, flags);
+}
+
+/* Picks the callsign out of "$$CALLSIGN," as it arrives, so that the
+ * payload configuration can be switched before the sentence ends */
+void DExtractorManager::watch(char c)
+{
+    if (c == '$')
+    {
+        if (dollars < 2)
+            dollars++;
+        callsign.clear();
+    }
+    else if (dollars < 2)
+    {
+        dollars = 0;
+    }
+    else if (c == ',')
+    {
+        dollars = 0;
+        if (callsign.size())
+            route();
+    }
+    else if (c == '*' || c == '\n' || callsign.size() == max_callsign)
+    {
+        dollars = 0;
+    }
+    else
+    {
+        callsign += c;
+    }
+}
+
+static bool has_callsign(const Json::Value &payload, const string &callsign)
+{
+    const Json::Value &sentences = payload["sentences"];
+    if (!sentences.isArray())
+        return false;
+
+    for (Json::Value::const_iterator it = sentences.begin();
+            it != sentences.end(); ++it)
+    {
+        const Json::Value &sentence = *it;
+
+        if (sentence.isObject() && sentence["callsign"].isString() &&
+            sentence["callsign"].asString() == callsign)
+            return true;
+    }
+
+    return false;
+}
+
+/* Decoder thread */
+void DExtractorManager::route()
+{
+    EZ::MutexLock lock(route_mutex);
+
+    if (callsign == routed_callsign)
+        return;
+    routed_callsign = callsign;
+
+    const Json::Value *use = selected;
+
+    if (!selected || !has_callsign(*selected, callsign))
+    {
+        EZ::MutexLock index_lock(index_mutex);
+
+        map<string, Json::Value>::const_iterator it =
+            payload_index.find(callsign);
+
+        if (it != payload_index.end())
+        {
+            /* routed may be the current payload; let go of it first */
+            habitat::ExtractorManager::payload(NULL);
+            routed = it->second;
+            use = &routed;
+            status("using the payload configuration for " + callsign);
+        }
+    }
+
+    habitat::ExtractorManager::payload(use);
+}
+
+/* Main thread: the selected payload, or NULL */
+void DExtractorManager::payload(const Json::Value *set)
+{
+    EZ::MutexLock lock(route_mutex);
+    selected = set;
+    routed_callsign.clear();
+    habitat::ExtractorManager::payload(set);
 }
 
 static void set_jvalue(Fl_Output *widget, const Json::Value &value)
@@ -314,11 +655,10 @@ static void set_jvalue(Fl_Output *widget, const Json::Value &value)
     }
 }
 
-void DExtractorManager::data(const Json::Value &d)
+/* Shows a parsed (or failed) sentence; runs on the main thread */
+static void show_data(const Json::Value &d)
 {
-    Fl_AutoLock lock;
-
-    if (!hab_ui_exists)
+    if (!hab_ui_exists || shutting_down)
         return;
 
     if (d["_sentence"].isString())
@@ -388,5 +728,21 @@ void DExtractorManager::data(const Json::Value &d)
     location::update_distance_bearing();
 }
 
+class DataMessage : public UIMessage
+{
+    const Json::Value data;
+
+public:
+    DataMessage(const Json::Value &d) : data(d) {};
+    void run() { show_data(data); }
+};
+
+/* Called by the extractors on the trx thread */
+void DExtractorManager::data(const Json::Value &d)
+{
+    tracker::position(d);
+    (new DataMessage(d))->post();
+}
+
 } /* namespace hbtint */
 } /* namespace dl_fldigi */
@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2026 dl-fldigi contributors
+ * License: GNU GPL 3
+ *
+ * journal.cxx: durable telemetry journal and replay of missed uploads
+ */
+
+#include "dl_fldigi/journal.h"
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <list>
+#include <set>
+#include <algorithm>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <openssl/sha.h>
+
+#include "debug.h"
+#include "main.h"
+#include "threads.h"
+
+#include "jsoncpp.h"
+#include "dl_fldigi/dl_fldigi.h"
+#include "dl_fldigi/hbtint.h"
+
+using namespace std;
+
+namespace dl_fldigi {
+namespace journal {
+
+/* Records are written and fsynced at most once per sync_interval, so a
+ * burst of sentences costs one fsync. */
+static const double sync_interval = 1.0;
+/* Replay: at most replay_batch sentences every replay_period seconds, and
+ * none younger than replay_delay, which gives the live upload time to
+ * finish. A sentence that still isn't saved is retried after retry_min
+ * seconds, doubling up to retry_max. */
+static const size_t replay_batch = 10;
+static const time_t replay_period = 10;
+static const time_t replay_delay = 60;
+static const time_t retry_min = 60, retry_max = 1800;
+/* and gives up after this many attempts */
+static const int max_attempts = 10;
+/* The file is truncated when nothing is pending and it has grown past this
+ * many records */
+static const size_t compact_records = 1000;
+/* IDs remembered for de-duplication */
+static const size_t max_seen = 10000;
+
+struct Entry
+{
+    string id, sentence;
+    Json::Value metadata;
+    int time_created;
+    time_t next_attempt;
+    int attempts;
+};
+
+static JournalThread *thr;
+static string filename;
+static FILE *file;
+static size_t file_records;
+
+/* Everything below is guarded by jsync's mutex */
+static syncobj jsync;
+static bool term, running;
+static list<Entry> pending;                /* oldest first */
+static vector<string> to_write;
+static set<string> seen;
+static deque<string> seen_order;
+
+static const char b64chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static string base64(const string &data)
+{
+    string out;
+    size_t i;
+
+    out.reserve((data.size() + 2) / 3 * 4);
+
+    for (i = 0; i + 2 < data.size(); i += 3)
+    {
+        unsigned int v = ((unsigned char) data[i] << 16) |
+                         ((unsigned char) data[i + 1] << 8) |
+                         (unsigned char) data[i + 2];
+        out += b64chars[(v >> 18) & 63];
+        out += b64chars[(v >> 12) & 63];
+        out += b64chars[(v >> 6) & 63];
+        out += b64chars[v & 63];
+    }
+
+    if (i < data.size())
+    {
+        unsigned int v = (unsigned char) data[i] << 16;
+        if (i + 1 < data.size())
+            v |= (unsigned char) data[i + 1] << 8;
+
+        out += b64chars[(v >> 18) & 63];
+        out += b64chars[(v >> 12) & 63];
+        out += (i + 1 < data.size()) ? b64chars[(v >> 6) & 63] : '=';
+        out += '=';
+    }
+
+    return out;
+}
+
+/* The habitat payload_telemetry document ID */
+static string document_id(const string &sentence)
+{
+    string b64 = base64(sentence);
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    char hex[2 * SHA256_DIGEST_LENGTH + 1];
+
+    SHA256((const unsigned char *) b64.data(), b64.size(), digest);
+
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++)
+        snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+
+    return string(hex, 2 * SHA256_DIGEST_LENGTH);
+}
+
+/* Caller must hold the lock */
+static bool remember(const string &id)
+{
+    if (!seen.insert(id).second)
+        return false;
+
+    seen_order.push_back(id);
+    if (seen_order.size() > max_seen)
+    {
+        seen.erase(seen_order.front());
+        seen_order.pop_front();
+    }
+
+    return true;
+}
+
+static Json::Value entry_record(const Entry &e)
+{
+    Json::Value record(Json::objectValue);
+    record["id"] = e.id;
+    record["sentence"] = e.sentence;
+    record["metadata"] = e.metadata;
+    record["time_created"] = e.time_created;
+    return record;
+}
+
+/* Reads the journal and rewrites it with only the pending records. A
+ * record is {"id", "sentence", "metadata", "time_created"}, and {"done": id}
+ * marks it uploaded. A torn last line (crash mid-write) is ignored. */
+static void load()
+{
+    ifstream jf(filename.c_str());
+    list<Entry> loaded;
+
+    while (jf.good())
+    {
+        string line;
+        getline(jf, line, '\n');
+        if (!line.size())
+            continue;
+
+        Json::Reader reader;
+        Json::Value root;
+        if (!reader.parse(line, root, false) || !root.isObject())
+        {
+            LOG_WARN("Ignoring bad journal record");
+            continue;
+        }
+
+        if (root["done"].isString())
+        {
+            string id = root["done"].asString();
+            for (list<Entry>::iterator it = loaded.begin();
+                 it != loaded.end(); it++)
+            {
+                if (it->id == id)
+                {
+                    loaded.erase(it);
+                    break;
+                }
+            }
+        }
+        else if (root["id"].isString() && root["sentence"].isString())
+        {
+            Entry e;
+            e.id = root["id"].asString();
+            e.sentence = root["sentence"].asString();
+            e.metadata = root["metadata"];
+            e.time_created = root["time_created"].asInt();
+            e.next_attempt = 0;
+            e.attempts = 0;
+            loaded.push_back(e);
+        }
+    }
+
+    jf.close();
+
+    string tmpname = filename + ".tmp";
+    ofstream tf(tmpname.c_str(), ios_base::out | ios_base::trunc);
+    for (list<Entry>::const_iterator it = loaded.begin();
+         it != loaded.end() && tf.good(); it++)
+    {
+        Json::FastWriter writer;
+        tf << writer.write(entry_record(*it));
+    }
+
+    bool success = tf.good();
+    tf.close();
+
+    if (!success || rename(tmpname.c_str(), filename.c_str()) != 0)
+    {
+        LOG_WARN("unable to compact %s", filename.c_str());
+        unlink(tmpname.c_str());
+    }
+
+    guard_lock lock(jsync.mtxp());
+    pending.swap(loaded);
+    for (list<Entry>::const_iterator it = pending.begin();
+         it != pending.end(); it++)
+        remember(it->id);
+    file_records = pending.size();
+
+    if (pending.size())
+        LOG_INFO("%lu sentences in the journal to upload",
+                 (unsigned long) pending.size());
+}
+
+void init()
+{
+    filename = HomeDir + "telemetry_journal.json";
+    load();
+
+    file = fopen(filename.c_str(), "a");
+    if (!file)
+        LOG_PERROR(filename.c_str());
+}
+
+void start()
+{
+    guard_lock lock(jsync.mtxp());
+    term = false;
+    running = true;
+    thr = new JournalThread();
+    thr->start();
+}
+
+void cleanup()
+{
+    if (!thr)
+        return;
+
+    {
+        guard_lock lock(jsync.mtxp());
+        term = true;
+        jsync.signal();
+    }
+
+    /* The thread writes whatever is still queued before it exits */
+    thr->join();
+    delete thr;
+    thr = 0;
+
+    if (file)
+        fclose(file);
+    file = 0;
+}
+
+string record(const string &sentence, const Json::Value &metadata,
+              int time_created)
+{
+    Entry e;
+    e.id = document_id(sentence);
+    e.sentence = sentence;
+    e.metadata = metadata;
+    e.time_created = time_created;
+    e.next_attempt = time(NULL) + replay_delay;
+    e.attempts = 0;
+
+    Json::FastWriter writer;
+    string line = writer.write(entry_record(e));
+
+    guard_lock lock(jsync.mtxp());
+
+    if (!remember(e.id))
+        return "";
+
+    pending.push_back(e);
+    if (running)
+        to_write.push_back(line);
+
+    return e.id;
+}
+
+void uploaded(const string &id)
+{
+    guard_lock lock(jsync.mtxp());
+
+    for (list<Entry>::iterator it = pending.begin(); it != pending.end(); it++)
+    {
+        if (it->id == id)
+        {
+            pending.erase(it);
+
+            Json::Value done(Json::objectValue);
+            done["done"] = id;
+            Json::FastWriter writer;
+            if (running)
+                to_write.push_back(writer.write(done));
+            break;
+        }
+    }
+}
+
+/* Journal thread only */
+static void write_lines(const vector<string> &lines, bool compact)
+{
+    if (!file)
+        return;
+
+    if (compact)
+    {
+        /* Nothing is pending, so none of the records are needed */
+        FILE *f = freopen(filename.c_str(), "w", file);
+        if (!f)
+        {
+            LOG_PERROR(filename.c_str());
+            file = 0;
+            return;
+        }
+        file_records = 0;
+    }
+
+    for (vector<string>::const_iterator it = lines.begin();
+         it != lines.end(); it++)
+        fputs(it->c_str(), file);
+
+    file_records += lines.size();
+
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0)
+        LOG_PERROR(filename.c_str());
+}
+
+/* Journal thread only */
+static void replay()
+{
+    if (!hbtint::uthr || !hbtint::upload_enabled())
+        return;
+
+    vector<Entry> batch;
+    time_t now = time(NULL);
+
+    {
+        guard_lock lock(jsync.mtxp());
+
+        for (list<Entry>::iterator it = pending.begin();
+             it != pending.end() && batch.size() < replay_batch; )
+        {
+            if (it->next_attempt > now)
+            {
+                it++;
+                continue;
+            }
+
+            if (it->attempts >= max_attempts)
+            {
+                LOG_WARN("giving up on %s", it->id.c_str());
+                Json::Value done(Json::objectValue);
+                done["done"] = it->id;
+                Json::FastWriter writer;
+                to_write.push_back(writer.write(done));
+                it = pending.erase(it);
+                continue;
+            }
+
+            time_t retry = retry_min << min(it->attempts, 5);
+            it->next_attempt = now + min(retry, retry_max);
+            it->attempts++;
+            batch.push_back(*it);
+            it++;
+        }
+    }
+
+    for (vector<Entry>::const_iterator it = batch.begin();
+         it != batch.end(); it++)
+    {
+        LOG_DEBUG("replaying %s", it->id.c_str());
+        hbtint::uthr->replay_telemetry(it->sentence, it->metadata,
+                                       it->time_created);
+    }
+}
+
+void *JournalThread::run()
+{
+    time_t last_replay = 0;
+    vector<string> lines;
+
+    pthread_mutex_lock(jsync.mtxp());
+
+    for (;;)
+    {
+        bool stop = term;
+        if (!stop)
+            jsync.wait(sync_interval);
+        stop = term;
+
+        lines.clear();
+        lines.swap(to_write);
+        bool compact = pending.empty() && file_records > compact_records;
+        if (stop)
+            running = false;
+
+        pthread_mutex_unlock(jsync.mtxp());
+
+        if (lines.size() || compact)
+            write_lines(lines, compact);
+
+        if (stop)
+            break;
+
+        time_t now = time(NULL);
+        if (now - last_replay >= replay_period)
+        {
+            replay();
+            last_replay = now;
+        }
+
+        pthread_mutex_lock(jsync.mtxp());
+    }
+
+    return NULL;
+}
+
+} /* namespace journal */
+} /* namespace dl_fldigi */
@@ -9,6 +9,7 @@
 #include "dl_fldigi/location.h"
 
 #include <sstream>
+#include <math.h>
 
 #include "configuration.h"
 #include "fl_digi.h"
@@ -16,6 +17,7 @@
 
 #include "dl_fldigi/dl_fldigi.h"
 #include "dl_fldigi/gps.h"
+#include "dl_fldigi/tracker.h"
 
 using namespace std;
 
@@ -41,6 +43,10 @@ void update_distance_bearing()
 {
     Fl_AutoLock lock;
 
+    /* The tracker needs the listener even if there's no balloon yet */
+    tracker::listener(listener_valid, listener_latitude, listener_longitude,
+                      listener_altitude);
+
     if (!hab_ui_exists)
         return;
 
@@ -52,45 +58,53 @@ void update_distance_bearing()
         return;
     }
 
-    /* See habitat-autotracker/autotracker/earthmaths.py. */
-    double c = M_PI/180;
-    double lat1, lon1, lat2, lon2, alt1, alt2;
-    lat1 = listener_latitude * c;
-    lon1 = listener_longitude * c;
-    alt1 = listener_altitude;
-    lat2 = balloon_latitude * c;
-    lon2 = balloon_longitude * c;
-    alt2 = balloon_altitude;
-
-    double radius, d_lon, sa, sb, bearing, aa, ab, angle_at_centre,
-           great_circle_distance, ta, tb, ea, eb, elevation, distance;
-
-    radius = 6371000.0;
-
-    d_lon = lon2 - lon1;
-    sa = cos(lat2) * sin(d_lon);
-    sb = (cos(lat1) * sin(lat2)) - (sin(lat1) * cos(lat2) * cos(d_lon));
-    bearing = atan2(sa, sb);
-    aa = sqrt((sa * sa) + (sb * sb));
-    ab = (sin(lat1) * sin(lat2)) + (cos(lat1) * cos(lat2) * cos(d_lon));
-    angle_at_centre = atan2(aa, ab);
-    great_circle_distance = angle_at_centre * radius;
-
-    ta = radius + alt1;
-    tb = radius + alt2;
-    ea = (cos(angle_at_centre) * tb) - ta;
-    eb = sin(angle_at_centre) * tb;
-    elevation = atan2(ea, eb);
-
-    distance = sqrt((ta * ta) + (tb * tb) -
-                    2 * tb * ta * cos(angle_at_centre));
-
-    bearing *= (180/M_PI);
-    elevation *= (180/M_PI);
-    distance /= 1000;
-
-    if (bearing < 0)
-        bearing += 360;
+    double bearing, elevation, distance;
+    look_angles(listener_latitude, listener_longitude, listener_altitude, 1,
+                &balloon_latitude, &balloon_longitude, &balloon_altitude,
+                &bearing, &elevation, &distance);
+    show_look_angles(bearing, elevation, distance);
+}
+
+/* See habitat-autotracker/autotracker/earthmaths.py. The listener's terms
+ * are worked out once for all n positions. */
+void look_angles(double lat1, double lon1, double alt1, size_t n,
+                 const double *lat2, const double *lon2, const double *alt2,
+                 double *bearing, double *elevation, double *distance)
+{
+    const double c = M_PI/180;
+    const double radius = 6371000.0;
+
+    const double sin_lat1 = sin(lat1 * c), cos_lat1 = cos(lat1 * c);
+    const double ta = radius + alt1;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double sin_lat2 = sin(lat2[i] * c), cos_lat2 = cos(lat2[i] * c);
+        double d_lon = (lon2[i] - lon1) * c;
+        double cos_d_lon = cos(d_lon);
+
+        double sa = cos_lat2 * sin(d_lon);
+        double sb = (cos_lat1 * sin_lat2) - (sin_lat1 * cos_lat2 * cos_d_lon);
+        double aa = sqrt((sa * sa) + (sb * sb));
+        double ab = (sin_lat1 * sin_lat2) + (cos_lat1 * cos_lat2 * cos_d_lon);
+        double angle_at_centre = atan2(aa, ab);
+
+        double tb = radius + alt2[i];
+        double ea = (cos(angle_at_centre) * tb) - ta;
+        double eb = sin(angle_at_centre) * tb;
+
+        double b = atan2(sa, sb) * (180/M_PI);
+        bearing[i] = (b < 0 ? b + 360 : b);
+        elevation[i] = atan2(ea, eb) * (180/M_PI);
+        distance[i] = sqrt((ta * ta) + (tb * tb) -
+                           2 * tb * ta * cos(angle_at_centre)) / 1000;
+    }
+}
+
+void show_look_angles(double bearing, double elevation, double distance)
+{
+    if (!hab_ui_exists)
+        return;
 
     ostringstream str_distance;
     str_distance.precision(4);
@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2026 dl-fldigi contributors
+ * License: GNU GPL 3
+ *
+ * nmea.cxx: allocation free NMEA 0183 position parser
+ */
+
+#include "dl_fldigi/nmea.h"
+
+#include <string.h>
+
+namespace dl_fldigi {
+namespace nmea {
+
+Parser::Parser()
+    : len(0), in_sentence(false),
+      sentences(0), positions(0), bad_checksum(0), bad_data(0), overruns(0)
+{
+    memset(&current, 0, sizeof(current));
+    current.satellites = -1;
+}
+
+bool Parser::feed(char c)
+{
+    if (c == '$')
+    {
+        /* A new sentence; whatever was in progress was truncated */
+        in_sentence = true;
+        len = 0;
+    }
+    else if (!in_sentence)
+    {
+        return false;
+    }
+    else if (c == '\r' || c == '\n')
+    {
+        in_sentence = false;
+        line[len] = '\0';
+        return sentence();
+    }
+
+    if (len == max_sentence)
+    {
+        overruns++;
+        in_sentence = false;
+        return false;
+    }
+
+    line[len++] = c;
+    return false;
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+/* Unsigned decimal with an optional fraction, as NMEA writes numbers.
+ * Written out rather than strtod, which depends on the locale. */
+static bool parse_decimal(const char *s, double &value)
+{
+    bool negative = (*s == '-');
+    if (negative)
+        s++;
+
+    double v = 0, scale = 1;
+    bool digits = false, point = false;
+
+    for (; *s; s++)
+    {
+        if (*s >= '0' && *s <= '9')
+        {
+            v = v * 10 + (*s - '0');
+            if (point)
+                scale *= 10;
+            digits = true;
+        }
+        else if (*s == '.' && !point)
+        {
+            point = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (!digits)
+        return false;
+
+    value = (negative ? -v : v) / scale;
+    return true;
+}
+
+/* ddmm.mmmm or dddmm.mmmm and a hemisphere */
+static bool parse_ddm(const char *s, const char *hemisphere, double limit,
+                      double &value)
+{
+    const char *point = strchr(s, '.');
+    size_t degree_digits = (point ? (size_t) (point - s) : strlen(s));
+    if (degree_digits < 3 || degree_digits > 5)
+        return false;
+    degree_digits -= 2;
+
+    double degrees = 0, minutes;
+    for (size_t i = 0; i < degree_digits; i++)
+    {
+        if (s[i] < '0' || s[i] > '9')
+            return false;
+        degrees = degrees * 10 + (s[i] - '0');
+    }
+
+    if (!parse_decimal(s + degree_digits, minutes) || minutes >= 60)
+        return false;
+
+    value = degrees + minutes / 60;
+    if (value > limit)
+        return false;
+
+    if (hemisphere[0] == 'S' || hemisphere[0] == 'W')
+        value = -value;
+    else if (hemisphere[0] != 'N' && hemisphere[0] != 'E')
+        return false;
+
+    return true;
+}
+
+/* hhmmss or hhmmss.ss into hh:mm:ss */
+static bool parse_hms(const char *s, char *out)
+{
+    for (int i = 0; i < 6; i++)
+        if (s[i] < '0' || s[i] > '9')
+            return false;
+    if (s[6] != '\0' && s[6] != '.')
+        return false;
+    if (s[0] > '2' || (s[0] == '2' && s[1] > '3') || s[2] > '5' || s[4] > '6')
+        return false;
+
+    out[0] = s[0]; out[1] = s[1]; out[2] = ':';
+    out[3] = s[2]; out[4] = s[3]; out[5] = ':';
+    out[6] = s[4]; out[7] = s[5]; out[8] = '\0';
+    return true;
+}
+
+static int parse_int(const char *s)
+{
+    if (!*s)
+        return -1;
+
+    int v = 0;
+    for (; *s; s++)
+    {
+        if (*s < '0' || *s > '9')
+            return -1;
+        v = v * 10 + (*s - '0');
+    }
+    return v;
+}
+
+/* Checks the checksum, splits the fields in place and dispatches on the
+ * sentence type. line holds everything from the $ to before the CR LF. */
+bool Parser::sentence()
+{
+    sentences++;
+
+    char *star = strrchr(line, '*');
+    if (!star || len < 7 || (size_t) (star - line) + 3 != len)
+    {
+        bad_checksum++;
+        return false;
+    }
+
+    unsigned char sum = 0;
+    for (char *p = line + 1; p < star; p++)
+        sum ^= (unsigned char) *p;
+
+    int hi = hex_digit(star[1]), lo = hex_digit(star[2]);
+    if (hi < 0 || lo < 0 || sum != ((hi << 4) | lo))
+    {
+        bad_checksum++;
+        return false;
+    }
+
+    *star = '\0';
+
+    char *fields[max_fields];
+    int n = 0;
+    char *p = line + 1;
+    fields[n++] = p;
+    while ((p = strchr(p, ',')) != NULL)
+    {
+        if (n == max_fields)
+            break;
+        *p++ = '\0';
+        fields[n++] = p;
+    }
+
+    /* Address field: two character talker and the sentence type */
+    if (strlen(fields[0]) != 5)
+        return false;
+
+    const char *type = fields[0] + 2;
+    bool ok;
+
+    if (!strcmp(type, "GGA"))
+        ok = gga(fields, n);
+    else if (!strcmp(type, "RMC"))
+        ok = rmc(fields, n);
+    else if (!strcmp(type, "GNS"))
+        ok = gns(fields, n);
+    else
+        return false;
+
+    if (ok)
+        positions++;
+    return ok;
+}
+
+/* Fields are only copied into current once they have all parsed */
+
+bool Parser::gga(char **f, int n)
+{
+    /* $--GGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,q,nn,h.h,a.a,M,... */
+    if (n < 11)
+        return false;
+
+    /* Fix quality 0: no fix. Not an error. */
+    if (!f[6][0] || f[6][0] == '0')
+        return false;
+
+    Fix fix = current;
+    if (!parse_hms(f[1], fix.time) ||
+        !parse_ddm(f[2], f[3], 90, fix.latitude) ||
+        !parse_ddm(f[4], f[5], 180, fix.longitude) ||
+        !parse_decimal(f[9], fix.altitude) || strcmp(f[10], "M"))
+    {
+        bad_data++;
+        return false;
+    }
+
+    fix.has_altitude = true;
+    fix.satellites = parse_int(f[7]);
+    current = fix;
+    return true;
+}
+
+bool Parser::rmc(char **f, int n)
+{
+    /* $--RMC,hhmmss.ss,A,llll.ll,a,yyyyy.yy,a,x.x,x.x,ddmmyy,... */
+    if (n < 10)
+        return false;
+
+    /* Status V: receiver warning, i.e. no fix */
+    if (strcmp(f[2], "A"))
+        return false;
+
+    Fix fix = current;
+    if (!parse_hms(f[1], fix.time) ||
+        !parse_ddm(f[3], f[4], 90, fix.latitude) ||
+        !parse_ddm(f[5], f[6], 180, fix.longitude))
+    {
+        bad_data++;
+        return false;
+    }
+
+    fix.satellites = -1;
+    current = fix;
+    return true;
+}
+
+bool Parser::gns(char **f, int n)
+{
+    /* $--GNS,hhmmss.ss,llll.ll,a,yyyyy.yy,a,c--c,nn,h.h,a.a,... */
+    if (n < 10)
+        return false;
+
+    /* One mode character per constellation; N for each is no fix */
+    const char *mode = f[6];
+    bool have_fix = false;
+    for (; *mode; mode++)
+        if (*mode != 'N')
+            have_fix = true;
+    if (!have_fix)
+        return false;
+
+    Fix fix = current;
+    if (!parse_hms(f[1], fix.time) ||
+        !parse_ddm(f[2], f[3], 90, fix.latitude) ||
+        !parse_ddm(f[4], f[5], 180, fix.longitude) ||
+        !parse_decimal(f[9], fix.altitude))
+    {
+        bad_data++;
+        return false;
+    }
+
+    fix.has_altitude = true;
+    fix.satellites = parse_int(f[7]);
+    current = fix;
+    return true;
+}
+
+} /* namespace nmea */
+} /* namespace dl_fldigi */
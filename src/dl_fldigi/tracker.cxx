@@ -0,0 +1,555 @@
+/*
+ * Copyright (C) 2026 dl-fldigi contributors
+ * License: GNU GPL 3
+ *
+ * tracker.cxx: payload trajectory prediction and rotator (rotctld) output
+ */
+
+#include "dl_fldigi/tracker.h"
+
+#include <string>
+#include <sstream>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "debug.h"
+#include "threads.h"
+#include "timeops.h"
+#include "socket.h"
+#include "configuration.h"
+
+#include "jsoncpp.h"
+#include "dl_fldigi/dl_fldigi.h"
+#include "dl_fldigi/location.h"
+
+using namespace std;
+
+namespace dl_fldigi {
+namespace tracker {
+
+/* Predictions are made every tick seconds. The fit uses up to history
+ * positions, none more than fit_window seconds older than the newest, and
+ * a prediction is only published up to max_extrapolate seconds after the
+ * last packet. A payload not heard for forget_after seconds is dropped. */
+static const double tick = 0.1;
+static const size_t max_tracks = 32;
+static const size_t history = 8;
+static const double fit_window = 120;
+static const double max_extrapolate = 300;
+static const double forget_after = 3600;
+/* A position further than this from the last one (at max_speed m/s, with
+ * max_jump m of slack for GPS noise) starts the track afresh */
+static const double max_speed = 200, max_jump = 1000;
+/* The UI is refreshed once a second */
+static const double ui_period = 1;
+/* rotctld: reply timeout, and the wait before reconnecting */
+static const double reply_timeout = 1, retry_delay = 5;
+
+static const double deg = M_PI / 180;
+static const double metres_per_degree = 6371000.0 * deg;
+
+struct Sample
+{
+    double t, latitude, longitude, altitude;
+};
+
+struct Track
+{
+    string payload;
+    Sample samples[history];    /* ring; next is the oldest once full */
+    size_t count, next;
+    double heard;
+};
+
+static TrackerThread *thr;
+
+/* Everything below is guarded by tsync's mutex */
+static syncobj tsync;
+static bool term;
+static Track tracks[max_tracks];
+static size_t ntracks;
+static size_t last_heard;       /* index into tracks; valid if ntracks */
+
+/* The model of each track, as arrays so that the thread can evaluate them
+ * all in one loop: the position at t0, and its rate of change per second */
+static double t0[max_tracks], lat0[max_tracks], lon0[max_tracks],
+              alt0[max_tracks], dlat[max_tracks], dlon[max_tracks],
+              dalt[max_tracks];
+
+static bool listener_valid;
+static double listener_lat, listener_lon, listener_alt;
+
+static bool rot_enabled;
+static string rot_host, rot_port, rot_payload;
+static double rot_min_step;
+static unsigned int rot_generation;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* -180 to 180 */
+static double wrap(double degrees)
+{
+    if (degrees > 180)
+        return degrees - 360;
+    if (degrees < -180)
+        return degrees + 360;
+    return degrees;
+}
+
+static bool get_double(const Json::Value &value, double &out)
+{
+    if (value.isNumeric())
+    {
+        out = value.asDouble();
+        return true;
+    }
+
+    if (!value.isString())
+        return false;
+
+    istringstream strm(value.asString());
+    strm >> out;
+    return !strm.fail();
+}
+
+void start()
+{
+    configure();
+
+    guard_lock lock(tsync.mtxp());
+    term = false;
+    thr = new TrackerThread();
+    thr->start();
+}
+
+void cleanup()
+{
+    if (!thr)
+        return;
+
+    thr->shutdown();
+    thr->join();
+    delete thr;
+    thr = 0;
+}
+
+void configure()
+{
+    guard_lock lock(tsync.mtxp());
+    rot_enabled = progdefaults.rotator_enabled;
+    rot_host = progdefaults.rotator_host;
+    rot_port = progdefaults.rotator_port;
+    rot_min_step = progdefaults.rotator_min_step;
+    rot_payload = progdefaults.rotator_payload;
+    rot_generation++;
+}
+
+void listener(bool valid, double latitude, double longitude, double altitude)
+{
+    guard_lock lock(tsync.mtxp());
+    listener_valid = valid;
+    listener_lat = latitude;
+    listener_lon = longitude;
+    listener_alt = altitude;
+}
+
+/* Caller must hold the lock */
+static void forget(size_t i)
+{
+    ntracks--;
+
+    if (i != ntracks)
+    {
+        tracks[i] = tracks[ntracks];
+        t0[i] = t0[ntracks];
+        lat0[i] = lat0[ntracks];
+        lon0[i] = lon0[ntracks];
+        alt0[i] = alt0[ntracks];
+        dlat[i] = dlat[ntracks];
+        dlon[i] = dlon[ntracks];
+        dalt[i] = dalt[ntracks];
+    }
+
+    if (last_heard == ntracks)
+        last_heard = i;
+}
+
+/* Caller must hold the lock. Finds the payload's track, or makes one,
+ * replacing the one heard least recently if the table is full. */
+static size_t find(const string &payload)
+{
+    for (size_t i = 0; i < ntracks; i++)
+        if (tracks[i].payload == payload)
+            return i;
+
+    if (ntracks == max_tracks)
+    {
+        size_t oldest = 0;
+        for (size_t i = 1; i < ntracks; i++)
+            if (tracks[i].heard < tracks[oldest].heard)
+                oldest = i;
+        forget(oldest);
+    }
+
+    Track &track = tracks[ntracks];
+    track.payload = payload;
+    track.count = 0;
+    track.next = 0;
+    return ntracks++;
+}
+
+/* Caller must hold the lock. Least squares fit of east, north and up
+ * against time, in metres on a plane tangent at the newest position.
+ * The model starts from the newest position itself rather than the fitted
+ * line, which would lag behind a change of course. */
+static void fit(size_t i)
+{
+    const Track &track = tracks[i];
+    const Sample &newest = track.samples[(track.next + history - 1) % history];
+
+    double cos_lat = cos(newest.latitude * deg);
+    if (cos_lat < 0.01)
+        cos_lat = 0.01;
+
+    double n = 0, st = 0, stt = 0, se = 0, ste = 0, sn = 0, stn = 0,
+           su = 0, stu = 0;
+
+    for (size_t j = 0; j < track.count; j++)
+    {
+        const Sample &s = track.samples[j];
+        double t = s.t - newest.t;
+        if (t < -fit_window)
+            continue;
+
+        double e = wrap(s.longitude - newest.longitude) * cos_lat *
+                   metres_per_degree;
+        double nm = (s.latitude - newest.latitude) * metres_per_degree;
+        double u = s.altitude - newest.altitude;
+
+        n++;
+        st += t;
+        stt += t * t;
+        se += e;
+        ste += t * e;
+        sn += nm;
+        stn += t * nm;
+        su += u;
+        stu += t * u;
+    }
+
+    double ve = 0, vn = 0, vu = 0;
+    double denominator = n * stt - st * st;
+
+    /* Packets a second or two apart say little about the velocity */
+    if (n >= 2 && denominator > n * n)
+    {
+        ve = (n * ste - st * se) / denominator;
+        vn = (n * stn - st * sn) / denominator;
+        vu = (n * stu - st * su) / denominator;
+    }
+
+    t0[i] = newest.t;
+    lat0[i] = newest.latitude;
+    lon0[i] = newest.longitude;
+    alt0[i] = newest.altitude;
+    dlat[i] = vn / metres_per_degree;
+    dlon[i] = ve / (metres_per_degree * cos_lat);
+    dalt[i] = vu;
+
+    LOG_DEBUG("%s: %.1f m/s at %.0f degrees, ascent %.1f m/s (%d positions)",
+              track.payload.c_str(), sqrt(ve * ve + vn * vn),
+              fmod(atan2(ve, vn) / deg + 360, 360), vu, (int) n);
+}
+
+void position(const Json::Value &d)
+{
+    if (!d["_parsed"].isBool() || !d["_parsed"].asBool() ||
+        !d["payload"].isString())
+        return;
+
+    Sample s;
+    if (!get_double(d["latitude"], s.latitude) ||
+        !get_double(d["longitude"], s.longitude) ||
+        !get_double(d["altitude"], s.altitude))
+        return;
+
+    if (fabs(s.latitude) > 90 || fabs(s.longitude) > 180 ||
+        (s.latitude == 0 && s.longitude == 0))
+        return;
+
+    s.t = now();
+
+    guard_lock lock(tsync.mtxp());
+
+    size_t i = find(d["payload"].asString());
+    Track &track = tracks[i];
+
+    if (track.count)
+    {
+        const Sample &last = track.samples[(track.next + history - 1) %
+                                           history];
+        double dt = s.t - last.t;
+        double e = wrap(s.longitude - last.longitude) *
+                   cos(s.latitude * deg) * metres_per_degree;
+        double n = (s.latitude - last.latitude) * metres_per_degree;
+        double u = s.altitude - last.altitude;
+
+        if (sqrt(e * e + n * n + u * u) > max_speed * dt + max_jump)
+        {
+            LOG_WARN("%s: position jumped; restarting its track",
+                     track.payload.c_str());
+            track.count = 0;
+            track.next = 0;
+        }
+    }
+
+    track.samples[track.next] = s;
+    track.next = (track.next + 1) % history;
+    if (track.count < history)
+        track.count++;
+    track.heard = s.t;
+    last_heard = i;
+
+    fit(i);
+}
+
+void TrackerThread::shutdown()
+{
+    {
+        guard_lock lock(tsync.mtxp());
+        term = true;
+        tsync.signal();
+    }
+
+    /* Cut short a connect() or a wait for rotctld */
+#ifndef __MINGW32__
+    pthread_kill(thread, SIGUSR2);
+#endif
+}
+
+class LookAnglesMessage : public UIMessage
+{
+    const double bearing, elevation, distance;
+
+public:
+    LookAnglesMessage(double b, double e, double d)
+        : bearing(b), elevation(e), distance(d) {};
+
+    void run()
+    {
+        if (!shutting_down)
+            location::show_look_angles(bearing, elevation, distance);
+    }
+};
+
+/* Tracker thread only: the connection to rotctld */
+class Rotator
+{
+    Socket *sock;
+    double retry_at;
+    bool pointed, failing;
+    double azimuth, elevation;
+
+    void error(const string &message, double t);
+
+public:
+    Rotator()
+        : sock(0), retry_at(0), pointed(false), failing(false),
+          azimuth(0), elevation(0) {};
+    ~Rotator() { disconnect(); }
+
+    void disconnect();
+    void point(const string &host, const string &port, double min_step,
+               double az, double el, double t);
+};
+
+void Rotator::disconnect()
+{
+    delete sock;
+    sock = 0;
+    pointed = false;
+    retry_at = 0;
+}
+
+/* Only the first of a run of failures is reported in the status bar */
+void Rotator::error(const string &message, double t)
+{
+    if (!failing)
+        status_important("rotator: " + message);
+    else
+        LOG_DEBUG("rotator: %s", message.c_str());
+
+    failing = true;
+    disconnect();
+    retry_at = t + retry_delay;
+}
+
+/* Sends "P az el" if it moved by min_step or more, and waits for rotctld
+ * to reply RPRT 0 */
+void Rotator::point(const string &host, const string &port, double min_step,
+                    double az, double el, double t)
+{
+    /* Rotators don't look below the horizon */
+    if (el < 0)
+        el = 0;
+
+    if (pointed && fabs(wrap(az - azimuth)) < min_step &&
+        fabs(el - elevation) < min_step)
+        return;
+
+    if (!sock && t < retry_at)
+        return;
+
+    try
+    {
+        if (!sock)
+        {
+            /* Connecting is bounded by reply_timeout too, so that a
+             * rotctld that is down doesn't hold up the tracker thread */
+            sock = new Socket(Address(host.c_str(), port.c_str()));
+            sock->set_nonblocking();
+            sock->set_timeout(reply_timeout);
+            sock->connect();
+            LOG_INFO("connected to rotctld at %s:%s", host.c_str(),
+                     port.c_str());
+        }
+
+        char command[32];
+        snprintf(command, sizeof(command), "P %.1f %.1f\n", az, el);
+        if (sock->send(command, strlen(command)) != strlen(command))
+            throw SocketException("timed out sending to rotctld");
+
+        string reply;
+        char c;
+        while (reply.size() < 64)
+        {
+            if (sock->recv(&c, 1) != 1)
+                throw SocketException("no reply from rotctld");
+            if (c == '\n')
+                break;
+            reply += c;
+        }
+
+        /* An error (say, out of range) is not worth reconnecting for;
+         * the next move will try again */
+        if (reply != "RPRT 0")
+            LOG_WARN("rotctld replied %s to %s", reply.c_str(), command);
+
+        pointed = true;
+        failing = false;
+        azimuth = az;
+        elevation = el;
+    }
+    catch (const SocketException &e)
+    {
+        error(e.what(), t);
+    }
+}
+
+void *TrackerThread::run()
+{
+    double lat[max_tracks], lon[max_tracks], alt[max_tracks],
+           bearing[max_tracks], elevation[max_tracks], distance[max_tracks];
+    Rotator rotator;
+    unsigned int generation = 0;
+    double last_ui = 0;
+
+#ifndef __MINGW32__
+    sigset_t usr2;
+    sigemptyset(&usr2);
+    sigaddset(&usr2, SIGUSR2);
+    pthread_sigmask(SIG_UNBLOCK, &usr2, NULL);
+#endif
+
+    pthread_mutex_lock(tsync.mtxp());
+
+    while (!term)
+    {
+        tsync.wait(tick);
+        if (term)
+            break;
+
+        double t = now();
+
+        for (size_t i = ntracks; i-- > 0; )
+            if (t - tracks[i].heard > forget_after)
+                forget(i);
+
+        size_t n = ntracks;
+
+        /* Straight line extrapolation of every track at once */
+        for (size_t i = 0; i < n; i++)
+        {
+            double dt = t - t0[i];
+            dt = (dt < max_extrapolate ? dt : max_extrapolate);
+            lat[i] = lat0[i] + dlat[i] * dt;
+            lon[i] = lon0[i] + dlon[i] * dt;
+            alt[i] = alt0[i] + dalt[i] * dt;
+        }
+
+        /* The displayed payload is the one heard last, as in the rest of
+         * the UI; the rotator's may be chosen */
+        int ui = -1, rot = -1;
+        if (n && t - tracks[last_heard].heard <= max_extrapolate)
+            ui = last_heard;
+
+        if (rot_enabled && rot_payload.size())
+        {
+            for (size_t i = 0; i < n; i++)
+                if (tracks[i].payload == rot_payload &&
+                    t - tracks[i].heard <= max_extrapolate)
+                    rot = i;
+        }
+        else if (rot_enabled)
+        {
+            rot = ui;
+        }
+
+        bool have_listener = listener_valid;
+        double lat1 = listener_lat, lon1 = listener_lon,
+               alt1 = listener_alt;
+        bool enabled = rot_enabled;
+        string host = rot_host, port = rot_port;
+        double min_step = rot_min_step;
+        bool reconfigured = (rot_generation != generation);
+        generation = rot_generation;
+
+        pthread_mutex_unlock(tsync.mtxp());
+
+        if (reconfigured || !enabled)
+            rotator.disconnect();
+
+        if (have_listener && n)
+        {
+            location::look_angles(lat1, lon1, alt1, n, lat, lon, alt,
+                                  bearing, elevation, distance);
+
+            if (rot != -1)
+                rotator.point(host, port, min_step, bearing[rot],
+                              elevation[rot], t);
+
+            if (ui != -1 && hab_ui_exists && t - last_ui >= ui_period)
+            {
+                (new LookAnglesMessage(bearing[ui], elevation[ui],
+                                       distance[ui]))->post();
+                last_ui = t;
+            }
+        }
+
+        pthread_mutex_lock(tsync.mtxp());
+    }
+
+    pthread_mutex_unlock(tsync.mtxp());
+    return NULL;
+}
+
+} /* namespace tracker */
+} /* namespace dl_fldigi */
@@ -62,9 +62,8 @@ const char cDTMF::rc[] = "123A456B789C*0#D";
 /*
  * calculate the power of each tone using Goertzel filters
  */
-void cDTMF::calc_power()
+void cDTMF::calc_power(double sr)
 {
-	double sr = active_modem->get_samplerate();
 // reset row freq filters
 	for (int i = 0; i < 4; i++) filt[i]->reset(240, row[i], sr);
 // reset col freq filters
@@ -94,9 +93,9 @@ void cDTMF::calc_power()
  *
  */
 
-int cDTMF::decode()
+int cDTMF::decode(double sr)
 { 
-	calc_power();
+	calc_power(sr);
 
 	if (maxpower < (10 * progStatus.sldrSquelchValue))
 		return ' ';
@@ -123,15 +122,20 @@ int cDTMF::decode()
  * read in frames, output the decoded
  * results
  */
-void cDTMF::receive(const float* buf, size_t len)
+bool cDTMF::enabled()
+{
+	return progdefaults.DTMFdecode;
+}
+
+void cDTMF::process(const sc_block& blk, std::vector<sc_event>& events)
 {
 	int x;
 	static size_t dptr = 0;
 	size_t bufptr = 0;
+	const float* buf = blk.buf;
+	size_t len = blk.len;
 
-	if (!progdefaults.DTMFdecode) return;
-
-	framesize = (active_modem->get_samplerate() == 8000) ? 240 : 331;
+	framesize = (blk.samplerate == 8000) ? 240 : 331;
 
 	while (1) {
 		int i;
@@ -146,13 +150,13 @@ void cDTMF::receive(const float* buf, size_t len)
 		}
 		dptr = 0;
 
-		x = decode(); 
+		x = decode(blk.samplerate);
 		if (x == ' ') {
 			silence_time++;
 			if (silence_time == 4 && !dtmfchars.empty()) dtmfchars += ' ';
 			if (silence_time == FLUSH_TIME) {
 				if (!dtmfchars.empty()) {
-					REQ(showDTMF, dtmfchars);
+					events.push_back(sc_event(0, dtmfchars));
 					dtmfchars.clear();
 				}
 				silence_time = 0;
@@ -166,6 +170,11 @@ void cDTMF::receive(const float* buf, size_t len)
 	}
 }
 
+void cDTMF::dispatch(const sc_event& ev)
+{
+	REQ(showDTMF, ev.text);
+}
+
 //======================================================================
 // DTMF tone transmit
 //======================================================================
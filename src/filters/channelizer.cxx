@@ -0,0 +1,145 @@
+// ----------------------------------------------------------------------------
+// channelizer.cxx  --  polyphase DFT filter bank
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include <cmath>
+
+#include "channelizer.h"
+#include "util.h"
+
+// stopband attenuation of the prototype, and the widest transition band that
+// is used when the decimation leaves more room than that
+#define CH_ATTEN          60.0
+#define CH_MAX_TRANSITION 500.0
+
+// zeroth order modified Bessel function of the first kind
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0, q = x * x / 4.0;
+	for (int k = 1; k < 50 && term > sum * 1e-12; k++) {
+		term *= q / ((double)k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+channelizer::channelizer()
+	: nbins(0), decim(1), samplerate(0.0), hpos(0), phase(0), fft(0)
+{
+}
+
+channelizer::~channelizer()
+{
+	delete fft;
+}
+
+void channelizer::init(int nbins_, int decim_, double samplerate_, double passband)
+{
+	if (nbins_ != nbins) {
+		delete fft;
+		fft = new Cfft(nbins_);
+		work.resize(nbins_);
+	}
+	nbins = nbins_;
+	decim = MAX(decim_, 1);
+	samplerate = samplerate_;
+
+	// the band from outrate - passband up is folded onto the passband
+	double outrate = samplerate / decim;
+	double tw = CLAMP(outrate - 2.0 * passband, 0.1 * passband, CH_MAX_TRANSITION);
+	double fc = (passband + tw / 2.0) / samplerate;
+
+	// Kaiser's estimates of the length and shape parameter; the length is
+	// rounded up to whole multiples of nbins
+	size_t taps = (size_t)ceil((CH_ATTEN - 8.0) / (2.285 * 2.0 * M_PI * tw / samplerate));
+	taps = MAX((taps + nbins - 1) / nbins, (size_t)1) * nbins;
+	double beta = 0.5842 * pow(CH_ATTEN - 21.0, 0.4) + 0.07886 * (CH_ATTEN - 21.0);
+
+	h.resize(taps);
+	double mid = (taps - 1) / 2.0, i0b = bessel_i0(beta), sum = 0.0;
+	for (size_t j = 0; j < taps; j++) {
+		double t = j - mid;
+		double sinc = (t == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+		double r = t / mid;
+		h[j] = sinc * bessel_i0(beta * sqrt(MAX(0.0, 1.0 - r * r))) / i0b;
+		sum += h[j];
+	}
+	// unity gain at DC, and undo the 1/nbins scaling of Cfft
+	for (size_t j = 0; j < taps; j++)
+		h[j] *= nbins / sum;
+
+	hist.resize(2 * taps);
+	reset();
+}
+
+void channelizer::reset(void)
+{
+	hist.assign(hist.size(), 0.0);
+	hpos = 0;
+	phase = 0;
+}
+
+int channelizer::bin(double f) const
+{
+	int k = (int)floor(f * nbins / samplerate + 0.5);
+	return CLAMP(k, 0, nbins / 2);
+}
+
+int channelizer::process(const double* buf, int len)
+{
+	size_t taps = h.size();
+	int half = nbins / 2 + 1;
+	int nout = 0;
+
+	out.resize(((phase + len) / decim + 1) * half);
+
+	for (int i = 0; i < len; i++) {
+		hist[hpos] = hist[hpos + taps] = buf[i];
+		if (++hpos == taps)
+			hpos = 0;
+		if (++phase < decim)
+			continue;
+		phase = 0;
+
+		// Fold the weighted window into nbins phases.  The sample at window
+		// position j is taps - 1 - j samples old and, as taps is a multiple
+		// of nbins, belongs to phase nbins - 1 - j % nbins.
+		const double* w = &hist[hpos];
+		const double* c = &h[0];
+		for (int r = 0; r < nbins; r++)
+			work[r] = complex(0.0, 0.0);
+		for (size_t p = 0; p < taps; p += nbins) {
+			for (int q = 0; q < nbins; q++)
+				work[nbins - 1 - q].re += c[q] * w[q];
+			c += nbins;
+			w += nbins;
+		}
+
+		// Cfft transforms with exp(+j...), so bin k is found at -k
+		fft->cdft(&work[0]);
+		complex* o = &out[nout * half];
+		o[0] = work[0];
+		for (int k = 1; k < half; k++)
+			o[k] = work[nbins - k];
+		nout++;
+	}
+
+	return nout;
+}
@@ -55,6 +55,7 @@ fftfilt::fftfilt(double f1, double f2, int len)
 		ovlbuf[i].re = ovlbuf[i].im = 0.0;
 
 	inptr = 0;
+	altfilter = altdata = altovlbuf = 0;
 
 	create_filter(f1, f2);
 }
@@ -76,6 +77,7 @@ fftfilt::fftfilt(double f, int len)
 		ovlbuf[i].re = ovlbuf[i].im = 0.0;
 
 	inptr = 0;
+	altfilter = altdata = altovlbuf = 0;
 
 	create_lpf(f);
 }
@@ -87,6 +89,7 @@ fftfilt::~fftfilt()
 	if (ovlbuf) delete [] ovlbuf;
 	if (filter) delete [] filter;
 	if (filtdata) delete [] filtdata;
+	clear_alt();
 }
 
 
@@ -155,16 +158,16 @@ void fftfilt::create_lpf(double f)
 
 //bool print_filter = true; // flag to inhibit printing multiple copies
 
-void fftfilt::create_rttyfilt(double f)
+void fftfilt::rttyfilt_response(complex *h, double f)
 {
 	int len = filterlen / 2 + 1;
-	double t, h, it;
+	double t, w, it;
 	Cfft *tmpfft;
 	tmpfft = new Cfft(filterlen);
 
 	// initialize the filter to zero
 	for (int i = 0; i < filterlen; i++)
-		filter[i].re   = filter[i].im   = 0.0;
+		h[i].re   = h[i].im   = 0.0;
 
 	// get an array to hold the sinc-respose
 	double* sinc_array = new double[ len ];
@@ -173,7 +176,7 @@ void fftfilt::create_rttyfilt(double f)
 	for (int i = 0; i < len; ++i) {
 		it = (double)i;
 		t  = it - ( (double)len - 1.0) / 2.0;
-		h  = it / ( (double)len - 1.0);
+		w  = it / ( (double)len - 1.0);
 
 		// create the filter impulses with an additional zero at 1.5f
 		// remark: sinc(..) is scaled by 2, see misc.h
@@ -201,34 +204,87 @@ void fftfilt::create_rttyfilt(double f)
 	for (int i = 0; i < len; ++i) {
 		it = (double)i;
 		t  = it - ( (double)len - 1.0) / 2.0;
-		h  = it / ( (double)len - 1.0);
+		w  = it / ( (double)len - 1.0);
 
-		filter[i].re = ( sinc_array[i] ) * (double)filterlen * blackman(h);
-		sinc_array[i] = filter[i].re;
+		h[i].re = ( sinc_array[i] ) * (double)filterlen * blackman(w);
+		sinc_array[i] = h[i].re;
 		}
 
 // perform the complex forward fft to obtain H(w)
-	tmpfft->cdft(filter);
+	tmpfft->cdft(h);
 /*
 	if (print_filter) {
 		printf("Modified Lanzcos 1.5 stop bit filter\n\n");
 		printf("h(t), |H(w)|, dB\n\n");
-		double dc = 20*log10(filter[0].mag());
+		double dc = 20*log10(h[0].mag());
 		for (int i = 0; i < len; i++)
 			printf("%f, %f, %f\n", 
 				sinc_array[i], 
-				filter[i].mag(),
-				20*log10(filter[i].mag()) - dc);
+				h[i].mag(),
+				20*log10(h[i].mag()) - dc);
 		print_filter = false;
 	}
 */
-// start outputs after 2 full passes are complete
-	pass = 2;
 	delete tmpfft;
 	delete [] sinc_array;
 
 }
 
+void fftfilt::create_rttyfilt(double f)
+{
+	rttyfilt_response(filter, f);
+// start outputs after 2 full passes are complete
+	pass = 2;
+}
+
+// A second rtty response, run on the same input as the first.  The forward
+// transform is shared, so it costs one multiply and inverse transform.
+void fftfilt::create_rttyfilt_alt(double f)
+{
+	if (!altfilter) {
+		altfilter = new complex[filterlen];
+		altdata   = new complex[filterlen];
+		altovlbuf = new complex[filterlen/2];
+	}
+	for (int i = 0; i < filterlen/2; i++)
+		altovlbuf[i].re = altovlbuf[i].im = 0.0;
+	rttyfilt_response(altfilter, f);
+	pass = 2;
+}
+
+void fftfilt::clear_alt()
+{
+	delete [] altfilter;
+	delete [] altdata;
+	delete [] altovlbuf;
+	altfilter = altdata = altovlbuf = 0;
+}
+
+/*
+ * Multiply the spectrum in data by the filter shape h, transform it back
+ * and overlap-add it with the tail of the previous block in ovl.
+ */
+void fftfilt::convolve(complex *data, const complex *h, complex *ovl)
+{
+	const int filterlen_div2 = filterlen / 2 ;
+
+// multiply with the filter shape
+	for (int i = 0; i < filterlen; i++)
+		data[i] *= h[i];
+
+// IFFT transpose back to the time domain
+	ift->icdft(data);
+
+// overlap and add
+	for (int i = 0; i < filterlen_div2; i++) {
+		data[i] += ovl[i];
+	}
+
+// save the second half for overlapping
+	// Memcpy is allowed because complex are POD objects.
+	memcpy( ovl, data + filterlen_div2, sizeof( ovl[0] ) * filterlen_div2 );
+}
+
 /*
  * Filter with fast convolution (overlap-add algorithm).
  */
@@ -249,29 +305,45 @@ int fftfilt::run(const complex& in, complex **out)
 // FFT transpose to the frequency domain
 	fft->cdft(filtdata);
 
-// multiply with the filter shape
-	for (int i = 0; i < filterlen; i++)
-//		filtdata[i] = filtdata[i] * filter[i];
-		filtdata[i] *= filter[i];
+	convolve(filtdata, filter, ovlbuf);
+	*out = filtdata;
 
-// IFFT transpose back to the time domain
-	ift->icdft(filtdata);
+// clear inbuf pointer
+	inptr = 0;
 
-// overlap and add
-	for (int i = 0; i < filterlen_div2; i++) {
-		filtdata[i] += ovlbuf[i];
-	}
-	*out = filtdata;
+// signal the caller there is filterlen/2 samples ready
+	if (pass) return 0;
 
-// save the second half for overlapping
-	// Memcpy is allowed because complex are POD objects.
-	memcpy( ovlbuf, filtdata + filterlen_div2, sizeof( ovlbuf[0] ) * filterlen_div2 );
+	return filterlen_div2;
+}
 
+/*
+ * As above, also filtering the same input with the second response
+ * into *altout.  create_rttyfilt_alt must have been called.
+ */
+int fftfilt::run(const complex& in, complex **out, complex **altout)
+{
+	const int filterlen_div2 = filterlen / 2 ;
+	filtdata[inptr++] = in;
+
+	if (inptr < filterlen_div2)
+		return 0;
+	if (pass) --pass;
+
+	for (int i = filterlen_div2 ; i < filterlen; i++)
+		filtdata[i].re = filtdata[i].im = 0.0;
+
+	fft->cdft(filtdata);
+
+	memcpy( altdata, filtdata, sizeof( altdata[0] ) * filterlen );
+	convolve(altdata, altfilter, altovlbuf);
+	*altout = altdata;
+
+	convolve(filtdata, filter, ovlbuf);
+	*out = filtdata;
 
-// clear inbuf pointer
 	inptr = 0;
 
-// signal the caller there is filterlen/2 samples ready
 	if (pass) return 0;
 
 	return filterlen_div2;
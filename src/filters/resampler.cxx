@@ -0,0 +1,171 @@
+// ----------------------------------------------------------------------------
+// resampler.cxx  --  rational polyphase sample rate converter
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include <cmath>
+#include <map>
+#include <utility>
+#include <pthread.h>
+
+#include "resampler.h"
+#include "threads.h"
+#include "util.h"
+
+// The passband extends to 0.45 and the stopband starts at 0.5 of the lower
+// of the two rates, with 80 dB of attenuation.
+#define RS_PASS       0.45
+#define RS_STOP       0.50
+#define RS_ATTEN      80.0
+#define RS_MAX_PHASES 1024
+#define RS_MAX_TAPS   512
+
+static pthread_mutex_t bank_mutex = PTHREAD_MUTEX_INITIALIZER;
+typedef std::map<std::pair<unsigned, unsigned>, polyphase_resampler::bank_t*> bank_map_t;
+static bank_map_t banks;
+
+static unsigned gcd(unsigned a, unsigned b)
+{
+	while (b) {
+		unsigned t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+// zeroth order modified Bessel function of the first kind
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0, q = x * x / 4.0;
+	for (int k = 1; k < 50 && term > sum * 1e-12; k++) {
+		term *= q / ((double)k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+// Banks are never freed; there are only ever a few distinct ratios.
+const polyphase_resampler::bank_t* polyphase_resampler::get_bank(unsigned L, unsigned M)
+{
+	guard_lock lock(&bank_mutex);
+
+	bank_map_t::const_iterator i = banks.find(std::make_pair(L, M));
+	if (i != banks.end())
+		return i->second;
+
+	// band edges as fractions of the upsampled rate
+	double scale = (L < M ? (double)L / M : 1.0) / L;
+	double fc = (RS_PASS + RS_STOP) / 2.0 * scale;
+	double df = (RS_STOP - RS_PASS) * scale;
+
+	// Kaiser's estimates of the length and shape parameter
+	size_t taps = (size_t)ceil((RS_ATTEN - 8.0) / (2.285 * 2.0 * M_PI * df) / L);
+	if (taps > RS_MAX_TAPS)
+		taps = RS_MAX_TAPS;
+	if (taps < 2)
+		taps = 2;
+	double beta = 0.1102 * (RS_ATTEN - 8.7);
+
+	bank_t* b = new bank_t;
+	b->L = L;
+	b->M = M;
+	b->taps = taps;
+	b->h.resize(L * taps);
+
+	size_t n = L * taps;
+	double mid = (n - 1) / 2.0, i0b = bessel_i0(beta);
+	for (size_t j = 0; j < n; j++) {
+		double t = j - mid;
+		double sinc = (t == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+		double r = t / mid;
+		double w = bessel_i0(beta * sqrt(MAX(0.0, 1.0 - r * r))) / i0b;
+		// coefficient j belongs to phase j % L, tap j / L counted from the
+		// newest sample
+		b->h[(j % L) * taps + (taps - 1 - j / L)] = sinc * w * L;
+	}
+
+	banks[std::make_pair(L, M)] = b;
+	return b;
+}
+
+polyphase_resampler::polyphase_resampler()
+	: inrate(0), outrate(0), bank(0), hpos(0), phase(0)
+{
+}
+
+bool polyphase_resampler::set_rates(int inrate_, int outrate_)
+{
+	if (inrate_ == inrate && outrate_ == outrate && bank)
+		return true;
+	if (inrate_ <= 0 || outrate_ <= 0)
+		return false;
+
+	unsigned g = gcd(inrate_, outrate_);
+	unsigned L = outrate_ / g, M = inrate_ / g;
+	if (L > RS_MAX_PHASES)
+		return false;
+
+	inrate = inrate_;
+	outrate = outrate_;
+	bank = get_bank(L, M);
+	hist.resize(2 * bank->taps);
+	reset();
+
+	return true;
+}
+
+void polyphase_resampler::reset(void)
+{
+	hist.assign(hist.size(), 0.0f);
+	hpos = 0;
+	phase = 0;
+}
+
+size_t polyphase_resampler::process(const float* in, size_t inlen, float* out, size_t outlen, size_t& used)
+{
+	const unsigned L = bank->L, M = bank->M;
+	const size_t taps = bank->taps;
+	float* const hp = &hist[0];
+	const float* const h = &bank->h[0];
+	size_t nout = 0;
+
+	for (used = 0; used < inlen; used++) {
+		// outputs due after this input sample
+		size_t n = (phase < L) ? (L - phase + M - 1) / M : 0;
+		if (nout + n > outlen)
+			break;
+
+		hp[hpos] = hp[hpos + taps] = in[used];
+		if (++hpos == taps)
+			hpos = 0;
+
+		const float* x = hp + hpos;
+		for (; phase < L; phase += M) {
+			const float* c = h + phase * taps;
+			float y = 0.0f;
+			for (size_t k = 0; k < taps; k++)
+				y += c[k] * x[k];
+			out[nout++] = y;
+		}
+		phase -= L;
+	}
+
+	return nout;
+}
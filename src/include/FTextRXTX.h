@@ -40,19 +40,10 @@ public:
 
 #if FLDIGI_FLTK_API_MAJOR == 1 && FLDIGI_FLTK_API_MINOR == 3
 	virtual void	add(unsigned int  c, int attr = RECV);
-	virtual	void	add(const char *s, int attr = RECV)
-        {
-                while (*s)
-                        add(*s++, attr);
-        }
 #else
 	virtual void	add(unsigned char c, int attr = RECV);
-	virtual	void	add(const char *s, int attr = RECV)
-        {
-                while (*s)
-                        add(*s++, attr);
-        }
 #endif
+	virtual	void	add(const char *s, int attr = RECV);
 
 	void		set_quick_entry(bool b);
 	bool		get_quick_entry(void) { return menu[RX_MENU_QUICK_ENTRY].value(); }
@@ -85,6 +76,26 @@ private:
 	FTextRX();
 	FTextRX(const FTextRX &t);
 
+	void		add_begin(void);
+	void		add_end(void);
+#if FLDIGI_FLTK_API_MAJOR == 1 && FLDIGI_FLTK_API_MINOR == 3
+	void		add_char(unsigned int c, int attr);
+	double		line_width(const char *cp);
+#else
+	void		add_char(unsigned char c, int attr);
+#endif
+	void		flush_pending(void);
+	void		new_line(const char *style);
+
+	int		rx_lines;	///< newlines in the buffer, counted as added
+	std::string	pending_text;	///< verbatim text not inserted yet
+	std::string	pending_style;	///< and its style
+#if FLDIGI_FLTK_API_MAJOR == 1 && FLDIGI_FLTK_API_MINOR == 3
+	double		s_text_width;	///< width of s_text, or negative if unknown
+	Fl_Font		s_text_font;	///< font and size s_text_width was measured with
+	int		s_text_size;
+#endif
+
 protected:
 	static Fl_Menu_Item menu[];
 	struct {
@@ -100,7 +100,6 @@ protected:
 	int					popx, popy;
 	bool					wrap;
 	int					wrap_col;
-	int					max_lines;
 	bool					scroll_hint;
 	bool	restore_wrap;
 //	bool	wrap_restore;
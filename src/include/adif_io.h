@@ -3,6 +3,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <string>
 
 #include "qso_db.h"
 
@@ -11,9 +12,7 @@
 class cAdifIO {
 private:
 	bool write_all;
-	cQsoRec *adifqso;
 	FILE *adiFile;
-	void fillfield(int, char *);
 	static int instances;
 public:
 	cAdifIO ();
@@ -22,9 +21,10 @@ public:
 	int writeAdifRec () {return 0;};
 	void readFile (const char *, cQsoDb *);
 	void do_readfile(const char *, cQsoDb *);
-	void do_writelog();
+	void do_writelog(const std::string &, cQsoDb *);
 	int writeFile (const char *, cQsoDb *);
 	int writeLog (const char *, cQsoDb *, bool b = true);
+	int appendLog (const char *, cQsoDb *, cQsoRec *);
 	bool log_changed(const char *fname);
 };
 
@@ -14,6 +14,9 @@ struct benchmark_params {
 	int src_type;
 	std::string input, output, buffer;
 	size_t samples;
+	// test-vector corpus, see corpus.h
+	std::string corpus, snr, drift, clock, corpus_dir;
+	int jobs;
 };
 extern struct benchmark_params benchmark;
 
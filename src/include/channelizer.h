@@ -0,0 +1,72 @@
+// ----------------------------------------------------------------------------
+// channelizer.h  --  polyphase DFT filter bank
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef CHANNELIZER_H_
+#define CHANNELIZER_H_
+
+#include <vector>
+
+#include "complex.h"
+#include "fft.h"
+
+// Splits a real signal into nbins equally spaced channels and decimates them
+// all at once: every decim input samples, the last L samples are weighted by
+// one low-pass prototype, folded into nbins phases and transformed with one
+// FFT.  Bin k then holds the signal mixed with exp(j*2*pi*f*n/samplerate)
+// for the bin centre f = k * samplerate / nbins and low-pass filtered, but
+// without the bin centre's phase rotation.  To shift a signal at any f' in
+// the bin to baseband, multiply the bin by exp(j*2*pi*f'*n/samplerate),
+// where n counts input samples; this costs one phasor per output sample
+// instead of one per input sample.
+class channelizer
+{
+public:
+	channelizer();
+	~channelizer();
+
+	// nbins must be a power of 2.  Signals up to passband Hz from a bin
+	// centre are passed; the stopband is placed so that nothing aliases
+	// into the passband at the decimated rate.
+	void init(int nbins, int decim, double samplerate, double passband);
+	void reset(void);
+
+	int get_nbins(void) const { return nbins; }
+	int get_decim(void) const { return decim; }
+	size_t get_taps(void) const { return h.size(); }
+	// the bin whose centre is nearest to f, for 0 <= f <= samplerate / 2
+	int bin(double f) const;
+
+	// Filters len samples and returns the number of new outputs.  Output i
+	// is an array of nbins / 2 + 1 bins and is valid until the next call.
+	int process(const double* buf, int len);
+	const complex* output(int i) const { return &out[i * (nbins / 2 + 1)]; }
+
+private:
+	int nbins, decim;
+	double samplerate;
+	std::vector<double> h;          // prototype, oldest sample first
+	std::vector<double> hist;       // 2 x taps, so that a window is contiguous
+	size_t hpos;
+	int phase;
+	Cfft* fft;
+	std::vector<complex> work;
+	std::vector<complex> out;
+};
+
+#endif // CHANNELIZER_H_
@@ -262,6 +262,7 @@ extern Fl_Choice *mnu_kahn_demod;
 extern Fl_Check_Button *chkUOSrx;
 extern Fl_Check_Button *btnPreferXhairScope;
 extern Fl_Check_Button *chk_true_scope;
+extern Fl_Check_Button *chk_rtty_diversity;
 extern Fl_Check_Button *chk_useMARKfreq;
 extern Fl_Button *btnRTTY_mark_color;
 extern Fl_Group *tabTHOR;
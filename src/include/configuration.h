@@ -26,6 +26,7 @@
 #define _CONFIGURATION_H
 
 #include <string>
+#include <vector>
 
 #include "rtty.h"
 #include "waterfall.h"
@@ -256,6 +257,10 @@
               "1 - use Kahn power demodulator\n"                                        \
               "0 - use ATC (Kok Chen) demodulator",                                     \
               1)                                                                        \
+        ELEM_(bool, rtty_diversity, "RTTYDIVERSITY",                                    \
+              "Decode with several filters and demodulators and vote on\n"              \
+              "each character",                                                         \
+              false)                                                                    \
         ELEM_(bool, true_scope, "TRUESCOPE",                                            \
               "Enabled  - XY scope displays Mark/Space channel signals\n"               \
               "Disabled - XY scope displays pseudo M/S signals",                        \
@@ -727,6 +732,10 @@
         ELEM_(bool, rxtext_tooltips, "RXTEXTTOOLTIPS",                                  \
               "Show callsign tooltips in received text",                                \
               false)                                                                    \
+        ELEM_(int, rxtext_max_lines, "RXTEXTMAXLINES",                                  \
+              "Maximum number of lines kept in the received text.\n"                    \
+              "Oldest lines are dropped beyond it. 0 for no limit",                     \
+              0)                                                                        \
         ELEM_(bool, autofill_qso_fields, "AUTOFILLQSO",                                 \
               "Auto-fill Country and Azimuth QSO fields",                               \
               false)                                                                    \
@@ -1355,6 +1364,20 @@
         ELEM_(int, ViewerFontsize, "VIEWERFONTSIZE",                                    \
               "Signal Viewer font size",                                                \
               FL_NORMAL_SIZE)                                                           \
+        /* Skimmer */                                                                   \
+        ELEM_(bool, SkimmerEnabled, "SKIMMERENABLED",                                   \
+              "Detect and decode every CW, PSK31, PSK63 and RTTY signal\n"              \
+              "in the passband",                                                        \
+              false)                                                                    \
+        ELEM_(double, SkimmerSNR, "SKIMMERSNR",                                         \
+              "Skimmer detection threshold in dB above the noise floor",                \
+              10.0)                                                                     \
+        ELEM_(int, SkimmerDecoders, "SKIMMERDECODERS",                                  \
+              "Most signals that the skimmer decodes at once",                          \
+              32)                                                                       \
+        ELEM_(bool, SkimmerLog, "SKIMMERLOG",                                           \
+              "Append skimmer decodes to skimmer.log, one line per signal",             \
+              true)                                                                     \
                                                                                         \
         ELEM_(Fl_Color, Sql1Color, "SQL1COLOR",                                         \
               "UI SQL button select color 1",                                           \
@@ -1452,6 +1475,18 @@
         ELEM_(int, gps_speed, "GPSSPEED", "GPS Serial baud", 0)                         \
         ELEM_(int, gps_period, "GPSPERIOD", "GPS Upload period", 30)                    \
                                                                                         \
+        /* dl-fldigi antenna rotator (rotctld) */                                       \
+        ELEM_(bool, rotator_enabled, "ROTATORENABLED",                                  \
+                "Point a rotator at the tracked payload", false)                        \
+        ELEM_(std::string, rotator_host, "ROTATORHOST",                                 \
+                "rotctld address", "localhost")                                         \
+        ELEM_(std::string, rotator_port, "ROTATORPORT",                                 \
+                "rotctld port", "4533")                                                 \
+        ELEM_(double, rotator_min_step, "ROTATORMINSTEP",                               \
+                "Smallest rotator move, in degrees", 2.0)                               \
+        ELEM_(std::string, rotator_payload, "ROTATORPAYLOAD",                           \
+                "Payload to point at; empty for the last one heard", "")                \
+                                                                                        \
         /* dl-fldigi Misc config stuff */                                               \
         ELEM_(int, png_wfall, "PNG_WFALL", "", 0)                                       \
         ELEM_(std::string, waterfall_png_location, "PNG_WFALL_LOC",                     \
@@ -1517,6 +1552,10 @@
        ELEM_(bool, WEFAX_AdifLog, "WEFAXADIFLOG",                                       \
              "Logs wefax file names in Adif log file",                                  \
              false)                                                                     \
+       ELEM_(bool, WEFAX_StreamSave, "WEFAXSTREAMSAVE",                                 \
+             "Spool received rows to disk and save images from there,\n"                \
+             "row by row, instead of from the viewer",                                  \
+             false)                                                                     \
        /* NAVTEX configuration items */                                                 \
        ELEM_(bool, NVTX_AdifLog, "NAVTEXADIFLOG",                                       \
              "Logs Navtex messages in Adig log file",                                   \
@@ -1527,6 +1566,9 @@
        ELEM_(int, NVTX_MinSizLoggedMsg, "NAVTEXMINSIZLOGGEDMSG",                        \
              "Minimum length of logged messages",                                       \
              0 )                                                                        \
+       ELEM_(std::string, NVTX_ExtraCarriers, "NAVTEXEXTRACARRIERS",                    \
+             "Audio frequencies in Hz of additional decoders, separated by ';'",        \
+             "")                                                                        \
         /* WX fetch from NOAA */                                                        \
         ELEM_(std::string, wx_sta, "WX_STA",                                            \
               "4 letter specifier for wx station",                                      \
@@ -1579,6 +1621,8 @@ struct configuration
 
 	void initInterface();
 	void initMixerDevices();
+	static void findCommPorts(std::vector<std::string>& ports);
+	void setCommPorts(const std::vector<std::string>& ports);
 	void testCommPorts();
 	const char* strBaudRate();
 	int  BaudRate(size_t);
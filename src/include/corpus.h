@@ -0,0 +1,41 @@
+// ----------------------------------------------------------------------------
+// corpus.h  --  reference signal corpus for the benchmark mode
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef CORPUS_H_
+#define CORPUS_H_
+
+// The corpus is generated with the modems' own transmitters: habitat style
+// telemetry sentences over every RTTY configuration that payloads use, SSDV
+// packets over 8-bit RTTY, DominoEX and Feld Hell.  Each signal is impaired
+// with a timing offset, frequency drift and white noise at a range of SNRs,
+// all from fixed seeds, then decoded again.  The run reports the character
+// error rate, the number of sentences or packets recovered and the decoding
+// speed of every case, and the lowest SNR at which nothing was lost.
+
+// main thread: check the corpus options and build the list of cases
+int setup_corpus(void);
+// trx thread: generate and decode the corpus, in benchmark.jobs processes
+void do_corpus(void);
+
+// the modem hooks, get_tx_char, put_rx_char and put_rx_ssdv in benchmark mode
+int corpus_get_tx_char(void);
+void corpus_put_rx_char(unsigned int data);
+void corpus_put_rx_byte(unsigned int data);
+
+#endif // CORPUS_H_
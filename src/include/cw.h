@@ -164,7 +164,7 @@ protected:
 	double risetime;			    	// leading/trailing edge rise time (msec)
 	int knum;					// number of samples on edges
 	int QSKshape;                   		// leading/trailing edge shape factor
-	double qskbuf[OUTBUFSIZE];			// signal array for qsk drive
+	double *qskbuf;					// signal array for qsk drive
 	double qskphase;				//
 	bool firstelement;
 	
@@ -217,6 +217,9 @@ protected:
 public:
 	cw();
 	~cw();
+	void	alloc_txbuffers();
+	void	free_txbuffers();
+	size_t	footprint() const;
 	void	init();
 	void	rx_init();
 	void	tx_init(SoundBase *sc);
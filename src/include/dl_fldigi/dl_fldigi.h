@@ -16,6 +16,18 @@ public:
     ~Fl_AutoLock() { Fl::unlock(); };
 };
 
+/* A UI update from another thread. post() hands it to the main thread with
+ * Fl::awake, which does not take the FLTK lock, so the poster never waits
+ * for the GUI; run() is then called with the lock held and the message is
+ * deleted. */
+class UIMessage
+{
+public:
+    virtual ~UIMessage() {};
+    virtual void run() = 0;
+    void post();
+};
+
 enum changed_groups
 {
     CH_NONE = 0x00,
@@ -23,7 +35,8 @@ enum changed_groups
     CH_INFO = 0x02,
     CH_LOCATION_MODE = 0x04,
     CH_STATIONARY_LOCATION = 0x08,
-    CH_GPS_SETTINGS = 0x10
+    CH_GPS_SETTINGS = 0x10,
+    CH_ROTATOR_SETTINGS = 0x20
 };
 
 extern bool hab_ui_exists, shutting_down;
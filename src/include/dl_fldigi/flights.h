@@ -21,6 +21,9 @@ void cleanup();
 
 void new_flight_docs(const std::vector<Json::Value> &docs);
 void new_payload_docs(const std::vector<Json::Value> &docs);
+/* read_cache may run on another thread before load_cache, so that the
+ * files are parsed while the GUI is built */
+void read_cache();
 void load_cache();
 void payload_search(bool next);
 void select_flight(int index);
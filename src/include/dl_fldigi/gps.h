@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <time.h>
 #include "habitat/EZ.h"
+#include "dl_fldigi/nmea.h"
 #ifdef __MINGW32__
 #include <windows.h>
 #endif
@@ -17,14 +18,14 @@ class GPSThread : public EZ::SimpleThread
     const std::string device;
     const int baud, rate;
     bool term;
-    time_t last_upload;
+    time_t last_upload, last_ui;
 
 #ifdef __MINGW32__
     HANDLE handle;
 #endif
     int fd;
-    FILE *f;
     int wait_exp;
+    nmea::Parser parser;
 
     void prepare_signals();
     void send_signal();
@@ -38,16 +39,18 @@ class GPSThread : public EZ::SimpleThread
     void warning(const std::string &message);
 
     void read();
-    void update_ui(const string &time_str, double lat, double lon, double alt);
-    void upload(const string &time_str, double lat, double lon, double alt);
+    void position();
+    void update_ui(const nmea::Fix &fix, bool uploaded);
+    void upload(const nmea::Fix &fix);
 
 public:
     GPSThread(const std::string &d, int b, int r)
         : device(d), baud(b), rate(r), term(false), last_upload(0),
+          last_ui(0),
 #ifdef __MINGW32__
           handle(INVALID_HANDLE_VALUE),
 #endif
-          fd(-1), f(NULL), wait_exp(0) {};
+          fd(-1), wait_exp(0) {};
     ~GPSThread() {};
 
     void *run();
@@ -3,7 +3,9 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include "jsoncpp.h"
+#include "habitat/EZ.h"
 #include "habitat/Extractor.h"
 #include "habitat/UploaderThread.h"
 
@@ -14,11 +16,15 @@ class DUploaderThread : public habitat::UploaderThread
 {
 public:
     /* These functions call super() functions, but with data grabbed from
-     * progdefaults and other globals. */
+     * the settings snapshot (see refresh_settings) and other globals. */
     void settings();
     void payload_telemetry(const string &data,
                            const Json::Value &metadata=Json::Value::null,
                            int time_created=-1);
+    /* Upload a sentence from the journal; its metadata already has the
+     * rig_info and it is not journalled again */
+    void replay_telemetry(const string &data, const Json::Value &metadata,
+                          int time_created);
     void listener_telemetry();
     void listener_telemetry(const Json::Value &data);
     void listener_information();
@@ -36,27 +42,71 @@ public:
     void got_flights(const std::vector<Json::Value> &flights);
     void got_payloads(const std::vector<Json::Value> &payloads);
 
-    /* Modify run() to help us shutdown the thread */
-    void *run();
 };
 
+/* One per decoder channel, each with its own sentence buffer and payload
+ * configuration; they all upload through uthr. Sentences from the payload
+ * given to payload() are parsed with it. As the callsign of any other
+ * sentence arrives, the channel switches to the configuration that
+ * index_payloads() has for that callsign, if there is one. */
 class DExtractorManager : public habitat::ExtractorManager
 {
+    const int id;
+
+    /* route_mutex guards selected and routed: payload() is called from
+     * the main thread, push() from the decoder's */
+    EZ::Mutex route_mutex;
+    const Json::Value *selected;
+    Json::Value routed;
+    std::string callsign, routed_callsign;
+    int dollars;
+
+    void watch(char c);
+    void route();
+
 public:
-    DExtractorManager(habitat::UploaderThread &u)
-        : habitat::ExtractorManager(u) {};
+    DExtractorManager(habitat::UploaderThread &u, int i)
+        : habitat::ExtractorManager(u), id(i), selected(NULL),
+          dollars(0) {};
+
+    void push(char c, enum habitat::push_flags flags=habitat::PUSH_NONE);
+    void payload(const Json::Value *set);
 
     void status(const std::string &msg);
     void data(const Json::Value &d);
 };
 
+/* Decoder channel ids: the active modem, and the RTTY viewer's channels */
+const int channel_modem = 0;
+const int channel_rtty_viewer = 0x100;
+
+/* The active modem's channel */
 extern DExtractorManager *extrmgr;
 extern DUploaderThread *uthr;
 
+/* trx thread: a decoder channel's extractor, created on first use */
+DExtractorManager *channel(int id);
+/* Any thread: the decoder lost the channel's signal; its extractor and
+ * any partial sentence are thrown away. Does nothing to channel_modem. */
+void release_channel(int id);
+/* Main thread: every known payload configuration by callsign. The
+ * contents of index are swapped in. */
+void index_payloads(std::map<std::string, Json::Value> &index);
+
 void init();
 void start();
 void cleanup();
 
+/* The uploader never reads progdefaults; call this from the main thread
+ * whenever the settings it uses may have changed (callsign, habitat URI,
+ * listener info, online, location mode) */
+void refresh_settings();
+/* Any thread (put_freq calls it on the trx thread): copy the modem's
+ * audio frequency and reversal */
+void refresh_audio();
+/* Any thread: online, and the upload settings are complete */
+bool upload_enabled();
+
 /* Called by a line in dialog/fl-digi.cxx, which is called when any rig
  * management gets the current frequency from the rig. */
 void rig_set_freq(long long freq);
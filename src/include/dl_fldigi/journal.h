@@ -0,0 +1,41 @@
+#ifndef DL_FLDIGI_JOURNAL_H
+#define DL_FLDIGI_JOURNAL_H
+
+#include <string>
+#include "jsoncpp.h"
+#include "habitat/EZ.h"
+
+namespace dl_fldigi {
+namespace journal {
+
+/* Every decoded sentence is appended to a journal on disk before it is
+ * uploaded, and marked done when habitat has saved it. Sentences that could
+ * not be uploaded (offline, network down) are replayed, oldest first, once
+ * uploads work again. Records are keyed by the habitat document ID, which
+ * is the SHA-256 of the base64 encoded sentence; a sentence that is already
+ * in the journal is not recorded twice. */
+
+/* init, start and cleanup are called from dl_fldigi::init, ready, cleanup */
+void init();
+void start();
+void cleanup();
+
+/* Any thread. Returns the document ID, or "" if the sentence is a
+ * duplicate and should not be uploaded again. metadata must include the
+ * rig_info, so that a replayed upload is identical to the live one. */
+std::string record(const std::string &sentence, const Json::Value &metadata,
+                   int time_created);
+
+/* Uploader thread: habitat saved the payload_telemetry document id */
+void uploaded(const std::string &id);
+
+class JournalThread : public EZ::SimpleThread
+{
+public:
+    void *run();
+};
+
+} /* namespace journal */
+} /* namespace dl_fldigi */
+
+#endif /* DL_FLDIGI_JOURNAL_H */
@@ -1,6 +1,8 @@
 #ifndef DL_FLDIGI_LOCATION_H
 #define DL_FLDIGI_LOCATION_H
 
+#include <stddef.h>
+
 namespace dl_fldigi {
 namespace location {
 
@@ -22,6 +24,14 @@ void start();
 void update_distance_bearing();
 void update_stationary();
 
+/* Bearing and elevation (degrees) and distance (km) from a listener to n
+ * positions at once. Any thread; the arrays are the tracker's. */
+void look_angles(double lat1, double lon1, double alt1, size_t n,
+                 const double *lat2, const double *lon2, const double *alt2,
+                 double *bearing, double *elevation, double *distance);
+/* Main thread: fill in habDistance, habBearing and habElevation */
+void show_look_angles(double bearing, double elevation, double distance);
+
 } /* namespace location */
 } /* namespace dl_fldigi */
 
@@ -0,0 +1,55 @@
+#ifndef DL_FLDIGI_NMEA_H
+#define DL_FLDIGI_NMEA_H
+
+#include <stddef.h>
+
+namespace dl_fldigi {
+namespace nmea {
+
+/* NMEA 0183 allows 82 characters; leave room for receivers that don't */
+const size_t max_sentence = 120;
+const int max_fields = 24;
+
+/* The position as of the last good sentence. RMC carries no altitude, so
+ * altitude is the one from the last GGA or GNS. */
+struct Fix
+{
+    char time[9];               /* hh:mm:ss */
+    double latitude, longitude;
+    double altitude;
+    bool has_altitude;
+    int satellites;             /* -1 if the last sentence didn't say */
+};
+
+/* Incremental parser: bytes from the serial port are fed in as they
+ * arrive, with no allocation and no per-line copies. Accepts GGA, RMC and
+ * GNS from any talker (GP, GN, GL, GA, ...), and only with a good
+ * checksum. */
+class Parser
+{
+    char line[max_sentence + 1];
+    size_t len;
+    bool in_sentence;
+    Fix current;
+
+    bool sentence();
+    bool gga(char **fields, int n);
+    bool rmc(char **fields, int n);
+    bool gns(char **fields, int n);
+
+public:
+    /* Counters since construction */
+    unsigned long sentences, positions, bad_checksum, bad_data, overruns;
+
+    Parser();
+
+    /* Feed one byte. Returns true when it completed a sentence that
+     * updated the position. */
+    bool feed(char c);
+    const Fix &fix() const { return current; }
+};
+
+} /* namespace nmea */
+} /* namespace dl_fldigi */
+
+#endif /* DL_FLDIGI_NMEA_H */
@@ -0,0 +1,39 @@
+#ifndef DL_FLDIGI_TRACKER_H
+#define DL_FLDIGI_TRACKER_H
+
+#include "jsoncpp.h"
+#include "habitat/EZ.h"
+
+namespace dl_fldigi {
+namespace tracker {
+
+/* Keeps the last few positions of every payload that has been decoded, fits
+ * a velocity and ascent rate to them, and extrapolates all of them ten
+ * times a second. The prediction for the payload heard last is shown in
+ * the distance, bearing and elevation boxes; the one for the rotator's
+ * payload is sent to rotctld (hamlib's rotator daemon) with the P command
+ * whenever it has moved by at least rotator_min_step degrees. */
+
+/* start and cleanup are called from dl_fldigi::ready, cleanup */
+void start();
+void cleanup();
+/* Main thread: the rotator settings changed */
+void configure();
+
+/* trx thread: a decoded sentence, from DExtractorManager::data */
+void position(const Json::Value &data);
+/* Any thread: the listener's location, from update_distance_bearing */
+void listener(bool valid, double latitude, double longitude,
+              double altitude);
+
+class TrackerThread : public EZ::SimpleThread
+{
+public:
+    void *run();
+    void shutdown();
+};
+
+} /* namespace tracker */
+} /* namespace dl_fldigi */
+
+#endif /* DL_FLDIGI_TRACKER_H */
@@ -0,0 +1,89 @@
+// ----------------------------------------------------------------------------
+// dspstats.h  --  receive loop load and latency counters
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef DSPSTATS_H_
+#define DSPSTATS_H_
+
+#include <cstddef>
+#include <string>
+
+// The stages of the receive loop that are timed on every block
+enum {
+	DSP_STAGE_READ,         // waiting for and converting soundcard samples
+	DSP_STAGE_WATERFALL,    // queueing the waterfall update
+	DSP_STAGE_MODEM,        // the modem's rx_process
+	DSP_STAGE_SIDECHAIN,    // handing the block to RSID, DTMF etc.
+	DSP_STAGE_DISPATCH,     // acting on side-chain detections
+	DSP_NUM_STAGES
+};
+
+// Counted by whichever thread sees them, including the audio callbacks
+enum {
+	DSP_XRUN_IN_OVERFLOW,   // the audio device dropped input
+	DSP_XRUN_IN_UNDERFLOW,
+	DSP_XRUN_OUT_UNDERFLOW, // the audio device ran out of output
+	DSP_XRUN_OUT_OVERFLOW,
+	DSP_XRUN_SNDRB_FULL,    // input dropped because the trx thread was late
+	DSP_XRUN_QRUNNER_FULL,  // GUI requests from the trx thread dropped
+	DSP_NUM_XRUNS
+};
+
+// Block processing time histogram: bin i counts the blocks that took less
+// than DSP_HIST_BASE << i seconds, the last bin all slower blocks
+#define DSP_HIST_BINS 12
+#define DSP_HIST_BASE 125e-6
+
+struct dsp_stats {
+	double stage[DSP_NUM_STAGES];   // seconds spent in each stage
+	double audio;                   // seconds of audio received
+	double busy;                    // seconds spent processing, not waiting
+	double load;                    // recent busy / audio time; 1.0 is real time
+	double block_max;               // slowest block, seconds
+	unsigned long blocks;
+	unsigned long hist[DSP_HIST_BINS];
+	size_t trxrb_fill, trxrb_size;
+	size_t sndrb_fill, sndrb_max, sndrb_size;
+	size_t qrunner_depth, qrunner_max;
+	unsigned long xruns[DSP_NUM_XRUNS];
+};
+
+// trx thread: dspstats_begin when a block starts, dspstats_stage as each
+// stage ends, and dspstats_end with the block length when it is done
+void dspstats_begin(void);
+void dspstats_stage(int stage);
+void dspstats_end(size_t len, int samplerate);
+void dspstats_levels(size_t trxrb_fill, size_t trxrb_size,
+		     size_t sndrb_fill, size_t sndrb_size, size_t qrunner_depth,
+		     unsigned long qrunner_nfull);
+
+// any thread, lock-free
+void dspstats_xrun(int kind);
+
+// any thread
+void dspstats_get(dsp_stats& st);
+void dspstats_reset(void);
+const char* dspstats_stage_name(int stage);
+const char* dspstats_xrun_name(int kind);
+// a plain text summary, for the status panel and the event log
+void dspstats_report(std::string& text);
+
+// main thread: the status panel
+void dspstats_show(void);
+
+#endif // DSPSTATS_H_
@@ -1,8 +1,9 @@
 #include <string>
 
 #include "filters.h"
+#include "sidechain.h"
 
-class cDTMF {
+class cDTMF : public sc_detector {
 public:
 #define N        240 // 30 msec interval at 8000 sps
 
@@ -40,7 +41,7 @@ private:
 	std::string dtmfchars;
 
 public:
-	cDTMF() {
+	cDTMF() : sc_detector("DTMF") {
 		for (int i = 0; i < 4; i++) filt[i] = new goertzel(240, row[i], 8000);
 		for (int i = 0; i < 4; i++) filt[i+4] = new goertzel(240, col[i], 8000);
 		for (int i = 0; i < N; i++) data[i] = 0;
@@ -51,9 +52,11 @@ public:
 	}
 	~cDTMF() {};
 // receive
-	void calc_power();
-	int decode();
-	void receive(const float* buf, size_t len);
+	void calc_power(double sr);
+	int decode(double sr);
+	bool enabled();
+	void process(const sc_block& blk, std::vector<sc_event>& events);
+	void dispatch(const sc_event& ev);
 // transmit
 	void makeshape();
 	void silence(int);
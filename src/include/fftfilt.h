@@ -23,6 +23,12 @@ protected:
 	int inptr;
 	int pass;
 	int window;
+// optional second response over the same input, see run(in, out, altout)
+	complex *altfilter;
+	complex *altdata;
+	complex *altovlbuf;
+	void rttyfilt_response(complex *h, double f);
+	void convolve(complex *data, const complex *h, complex *ovl);
 public:
 	fftfilt(double f1, double f2, int len);
 	fftfilt(double f, int len);
@@ -30,8 +36,11 @@ public:
 	void create_filter(double f1, double f2);
 	void create_lpf(double f);
 	void create_rttyfilt(double f);
+	void create_rttyfilt_alt(double f);
+	void clear_alt();
 	void set_window(int w) { window = w; }
 	int run(const complex& in, complex **out);
+	int run(const complex& in, complex **out, complex **altout);
 };
 
 #endif
@@ -165,21 +165,22 @@ template <class Type>
      //    printf("%2d %9.5f %9.5f\n",idx,Buff[idx].Re,Buff[idx].Im);  
      }
 
-   // core process: the classic tripple loop of butterflies
-   // radix-2 FFT: the first and the second pass are by hand 
-   // looks like there is no gain by separating the second pass
-   // and even the first pass is in question ?
+   // core process: the first pass by hand, then the remaining passes
+   // two at a time with radix-4 butterflies, so the data is swept
+   // half as many times; a single radix-2 pass finishes an odd count
    template <class BuffType>
     void CoreProc(BuffType x[])
      { size_t Groups,GroupSize2,Group,Bf,TwidIdx;
        size_t Size2=Size/2;
        for(Bf=0; Bf<Size; Bf+=2) FFT2(x[Bf],x[Bf+1]); // first pass
-       // for(Bf=0; Bf<Size; Bf+=4) FFT4(x[Bf],x[Bf+1],x[Bf+2],x[Bf+3]); // second
-       // for(Groups=Size2/4,GroupSize2=4; Groups; Groups>>=1, GroupSize2<<=1)
-       for(Groups=Size2/2,GroupSize2=2; Groups; Groups>>=1, GroupSize2<<=1)
-         for(Group=0,Bf=0; Group<Groups; Group++,Bf+=GroupSize2)
+       for(Groups=Size2/2,GroupSize2=2; Groups>1; Groups>>=2, GroupSize2<<=2)
+         for(Group=0,Bf=0; Group<Groups; Group+=2,Bf+=3*GroupSize2)
            for(TwidIdx=0; TwidIdx<Size2; TwidIdx+=Groups,Bf++)
-           { FFTbf(x[Bf],x[Bf+GroupSize2],Twiddle[TwidIdx]); }
+           { FFTbf4(x[Bf],x[Bf+GroupSize2],x[Bf+2*GroupSize2],x[Bf+3*GroupSize2],
+                    Twiddle[TwidIdx],Twiddle[TwidIdx/2]); }
+       if(Groups) // odd number of passes left: the last one is radix-2
+         for(Bf=0,TwidIdx=0; TwidIdx<Size2; TwidIdx++,Bf++)
+         { FFTbf(x[Bf],x[Bf+GroupSize2],Twiddle[TwidIdx]); }
      }
 
    // radix-2 FFT with a "shrink" factor
@@ -238,6 +239,31 @@ template <class Type>
        x0.Re=x0.Re+x1W.Re;
        x0.Im=x0.Im+x1W.Im; }
 
+   // two radix-2 passes in one go: (x0,x1) and (x2,x3) with W1,
+   // then (x0,x2) with W2 and (x1,x3) with W2 rotated by a quarter turn
+   template <class BuffType>
+    inline void FFTbf4(BuffType &x0, BuffType &x1, BuffType &x2, BuffType &x3,
+                       Type &W1, Type &W2)
+     { Type x1W,x3W,x2W;
+       x1W.Re=x1.Re*W1.Re+x1.Im*W1.Im;
+       x1W.Im=(-x1.Re*W1.Im)+x1.Im*W1.Re;
+       x3W.Re=x3.Re*W1.Re+x3.Im*W1.Im;
+       x3W.Im=(-x3.Re*W1.Im)+x3.Im*W1.Re;
+       Type a0,a1,a2,a3;
+       a0.Re=x0.Re+x1W.Re; a0.Im=x0.Im+x1W.Im;
+       a1.Re=x0.Re-x1W.Re; a1.Im=x0.Im-x1W.Im;
+       a2.Re=x2.Re+x3W.Re; a2.Im=x2.Im+x3W.Im;
+       a3.Re=x2.Re-x3W.Re; a3.Im=x2.Im-x3W.Im;
+       x2W.Re=a2.Re*W2.Re+a2.Im*W2.Im;
+       x2W.Im=(-a2.Re*W2.Im)+a2.Im*W2.Re;
+       x3W.Re=a3.Re*W2.Re+a3.Im*W2.Im;   // times conj(j*W2) = -j*conj(W2)
+       x3W.Im=(-a3.Re*W2.Im)+a3.Im*W2.Re;
+       x1W.Re=x3W.Im; x1W.Im=(-x3W.Re);
+       x0.Re=a0.Re+x2W.Re; x0.Im=a0.Im+x2W.Im;
+       x2.Re=a0.Re-x2W.Re; x2.Im=a0.Im-x2W.Im;
+       x1.Re=a1.Re+x1W.Re; x1.Im=a1.Im+x1W.Im;
+       x3.Re=a1.Re-x1W.Re; x3.Im=a1.Im-x1W.Im; }
+
    // special 2-point FFT for the first pass
    template <class BuffType>
     inline void FFT2(BuffType &x0, BuffType &x1)
@@ -313,6 +313,16 @@ public:
 
 	BoxFilter<Type> Filter;
 
+// signal band for the S/N measurement [spectra bins], set by the user;
+// the noise is taken from MeasureMargin bins either side of it
+	size_t	MeasureLo;
+	size_t	MeasureHi;
+	size_t	MeasureMargin;
+// in-band signal and per-bin noise energy, summed over MeasureCount windows
+	Type	BandEnergy;
+	Type	NoiseEnergy;
+	size_t	MeasureCount;
+
 public:
 	MFSK_InputProcessor() {
 			Init();
@@ -328,6 +338,9 @@ public:
 			OutTap = 0;
 			WindowShape = 0;
 			FFT_Buff = 0;
+			MeasureLo = MeasureHi = MeasureMargin = 0;
+			BandEnergy = NoiseEnergy = 0;
+			MeasureCount = 0;
 			Spectra[0] = 0;
 			Spectra[1] = 0;
 			Output = 0;
@@ -463,12 +476,39 @@ public:
 				Energy[Idx] = Filter.Output*Scale;
 	}
 
+// measure the signal band against its neighbourhood, on the raw
+// energies before they are limited and equalized
+	void MeasureBand(void) {
+			if (MeasureHi <= MeasureLo || MeasureHi > SpectraLen)
+				return;
+			size_t Freq;
+			size_t NoiseLo = MeasureLo > MeasureMargin ? MeasureLo - MeasureMargin : 0;
+			size_t NoiseHi = MeasureHi + MeasureMargin;
+			if (NoiseHi > SpectraLen) NoiseHi = SpectraLen;
+			size_t NoiseBins = (MeasureLo - NoiseLo) + (NoiseHi - MeasureHi);
+			if (NoiseBins == 0)
+				return;
+			Type Band = 0, Noise = 0;
+			for (Freq = MeasureLo; Freq < MeasureHi; Freq++)
+				Band += Energy[Freq];
+			for (Freq = NoiseLo; Freq < MeasureLo; Freq++)
+				Noise += Energy[Freq];
+			for (Freq = MeasureHi; Freq < NoiseHi; Freq++)
+				Noise += Energy[Freq];
+			Noise /= NoiseBins;
+			BandEnergy += Band - Noise * (MeasureHi - MeasureLo);
+			NoiseEnergy += Noise;
+			MeasureCount++;
+	}
+
 // here we process the spectral data
 	void ProcessSpectra(Cmpx<Type> *Spectra) {
 			size_t Freq;
 			for (Freq = 0; Freq < SpectraLen; Freq++)
 				Energy[Freq] = Spectra[Freq].Energy();
 
+			MeasureBand();
+
 			LimitSpectraPeaks(Spectra, WindowLen / 64, 4.0);
 			LimitSpectraPeaks(Spectra, WindowLen / 64, 4.0);
 			LimitSpectraPeaks(Spectra, WindowLen / 64, 4.0);
@@ -503,38 +543,43 @@ public:
 			}
 	}
 
+// The window loops sweep the whole tap ring once, so the pointer ends
+// where it started. They are split at the wrap point into two plain
+// loops without index masking, which the compiler can vectorise.
 	void ProcessInpWindow_Re(void) {
-			size_t Time;
-			for (Time = 0; Time < WindowLen; Time++) {
-				FFT_Buff[Time].Re = InpTap[InpTapPtr] * WindowShape[Time];
-				InpTapPtr += 1;
-				InpTapPtr &= WrapMask;
-			}
+			size_t Time, Head = WindowLen - InpTapPtr;
+			const Type *Tap = InpTap + InpTapPtr;
+			for (Time = 0; Time < Head; Time++)
+				FFT_Buff[Time].Re = Tap[Time] * WindowShape[Time];
+			for ( ; Time < WindowLen; Time++)
+				FFT_Buff[Time].Re = InpTap[Time - Head] * WindowShape[Time];
 	}
 
 	void ProcessInpWindow_Im(void) {
-			size_t Time;
-			for (Time = 0; Time < WindowLen; Time++) {
-				FFT_Buff[Time].Im = InpTap[InpTapPtr] * WindowShape[Time];
-				InpTapPtr += 1;
-				InpTapPtr &= WrapMask;
-			}
+			size_t Time, Head = WindowLen - InpTapPtr;
+			const Type *Tap = InpTap + InpTapPtr;
+			for (Time = 0; Time < Head; Time++)
+				FFT_Buff[Time].Im = Tap[Time] * WindowShape[Time];
+			for ( ; Time < WindowLen; Time++)
+				FFT_Buff[Time].Im = InpTap[Time - Head] * WindowShape[Time];
 	}
 
-	void ProcessOutWindow_Re(void)
-		{ size_t Time;
-		for (Time=0; Time<WindowLen; Time++)
-		{ OutTap[OutTapPtr] += FFT_Buff[Time].Re*WindowShape[Time];
-			OutTapPtr+=1; OutTapPtr&=WrapMask; }
-		}
+	void ProcessOutWindow_Re(void) {
+			size_t Time, Head = WindowLen - OutTapPtr;
+			Type *Tap = OutTap + OutTapPtr;
+			for (Time = 0; Time < Head; Time++)
+				Tap[Time] += FFT_Buff[Time].Re * WindowShape[Time];
+			for ( ; Time < WindowLen; Time++)
+				OutTap[Time - Head] += FFT_Buff[Time].Re * WindowShape[Time];
+	}
 
 	void ProcessOutWindow_Im(void) {
-			size_t Time;
-			for (Time = 0; Time < WindowLen; Time++) {
-				OutTap[OutTapPtr] += FFT_Buff[Time].Im * WindowShape[Time];
-				OutTapPtr += 1;
-				OutTapPtr &= WrapMask;
-			}
+			size_t Time, Head = WindowLen - OutTapPtr;
+			Type *Tap = OutTap + OutTapPtr;
+			for (Time = 0; Time < Head; Time++)
+				Tap[Time] += FFT_Buff[Time].Im * WindowShape[Time];
+			for ( ; Time < WindowLen; Time++)
+				OutTap[Time - Head] += FFT_Buff[Time].Im * WindowShape[Time];
 	}
 
 	void ProcessOutTap(Type *Output) {
@@ -865,17 +910,24 @@ template <class Type=float>
 		{ InpTap[InpTapPtr]=Input[InpIdx];
 			InpTapPtr+=1; InpTapPtr&=WrapMask; }
 
-		for (Time=0; Time<SymbolLen; Time++)
-		{ FFT_Buff[Time].Re=InpTap[InpTapPtr]*SymbolShape[Time];
-			InpTapPtr+=1; InpTapPtr&=WrapMask; }
+		// a full sweep of the tap ring, split at the wrap point
+		{ size_t Head=SymbolLen-InpTapPtr;
+			const Type *Tap=InpTap+InpTapPtr;
+			for (Time=0; Time<Head; Time++)
+				FFT_Buff[Time].Re=Tap[Time]*SymbolShape[Time];
+			for (		; Time<SymbolLen; Time++)
+				FFT_Buff[Time].Re=InpTap[Time-Head]*SymbolShape[Time]; }
 
 		for (			; InpIdx<SymbolSepar ; InpIdx++)
 		{ InpTap[InpTapPtr]=Input[InpIdx];
 			InpTapPtr+=1; InpTapPtr&=WrapMask; }
 
-		for (Time=0; Time<SymbolLen; Time++)
-		{ FFT_Buff[Time].Im=InpTap[InpTapPtr]*SymbolShape[Time];
-			InpTapPtr+=1; InpTapPtr&=WrapMask; }
+		{ size_t Head=SymbolLen-InpTapPtr;
+			const Type *Tap=InpTap+InpTapPtr;
+			for (Time=0; Time<Head; Time++)
+				FFT_Buff[Time].Im=Tap[Time]*SymbolShape[Time];
+			for (		; Time<SymbolLen; Time++)
+				FFT_Buff[Time].Im=InpTap[Time-Head]*SymbolShape[Time]; }
 
 		FFT.Process(FFT_Buff);
 		FFT.SeparTwoReals(FFT_Buff, Spectra[0], Spectra[1]);
@@ -2128,6 +2180,19 @@ public:
 			SyncBestFreqOffset = 0;
 			SyncSNR = 0;
 
+			{ // S/N measurement band: the tones plus one bin either side
+				int Scale = InputProcessor.WindowLen / Demodulator.SymbolLen;
+				int Span = Demodulator.CarrierSepar * Demodulator.Carriers;
+				int Lo = Reverse ? (int)Demodulator.FirstCarrier + 1 - Span
+						 : (int)Demodulator.FirstCarrier - 1;
+				if (Lo < 0) Lo = 0;
+				InputProcessor.MeasureLo = Lo * Scale;
+				InputProcessor.MeasureHi = (Lo + Span) * Scale;
+				InputProcessor.MeasureMargin = SyncMargin * Scale;
+				InputProcessor.BandEnergy = InputProcessor.NoiseEnergy = 0;
+				InputProcessor.MeasureCount = 0;
+			}
+
 			if (InputBuffer.EnsureSpace(InputProcessor.WindowLen + 2048) < 0)
 				goto Error;
 
@@ -2161,6 +2226,9 @@ public:
 			SyncBestBlockPhase = 0;
 			SyncBestFreqOffset = 0;
 			SyncSNR = 0;
+
+			InputProcessor.BandEnergy = InputProcessor.NoiseEnergy = 0;
+			InputProcessor.MeasureCount = 0;
  
 			Output.Reset();
 	}
@@ -2213,6 +2281,26 @@ Sync. S/N threshold = %3.1f\n",
 			return SyncSNR;
 	}
 
+// average in-band signal energy and per-bin noise energy measured by
+// the input processor since the previous call; returns the number of
+// FFT windows they cover. Signal / (Noise * B / FrequencyBin()) is the
+// S/N in a bandwidth B.
+	size_t SpectraLevels(Type &Signal, Type &Noise) {
+			size_t Count = InputProcessor.MeasureCount;
+			if (Count) {
+				Signal = InputProcessor.BandEnergy / Count;
+				Noise = InputProcessor.NoiseEnergy / Count;
+			}
+			InputProcessor.BandEnergy = InputProcessor.NoiseEnergy = 0;
+			InputProcessor.MeasureCount = 0;
+			return Count;
+	}
+
+// width of one input processor FFT bin [Hz]
+	Type FrequencyBin(void) {
+			return SampleRate / InputProcessor.WindowLen;
+	}
+
 	Type FrequencyOffset(void) {
 			return ( (int)SyncBestFreqOffset - 
 						(int)FreqOffsets / 2) * (SampleRate / Demodulator.SymbolLen);
@@ -37,7 +37,8 @@ protected:
 	double	tx_corr;
 	double	tx_frequency;
 	double  PTTphaseacc;
-	double  PTTchannel[OUTBUFSIZE];
+	double  *PTTchannel;
+	int	PTTchannel_size;
 
 // for CW modem use only
 	bool	cwTrack;
@@ -53,7 +54,8 @@ protected:
 	unsigned char *txstr;
 	unsigned char *txptr;
 
-	double outbuf[OUTBUFSIZE];
+// allocated by alloc_txbuffers() for the duration of a transmission
+	double *outbuf;
 
 	bool	historyON;
 	Digiscope::scope_mode scopemode;
@@ -68,9 +70,11 @@ protected:
 
 	double track_freq(double freq);
 
+	size_t	txbuffers_size() const;
+
 public:
 	modem();
-	virtual ~modem(){};
+	virtual ~modem();
 
 // these processes must be declared in the derived class
 	virtual void init();
@@ -84,6 +88,13 @@ public:
 	virtual void set2(int, int){};
 	virtual void makeTxViewer(int W, int H){};
 
+// TX sample buffers are only held while transmitting
+	virtual void	alloc_txbuffers();
+	virtual void	free_txbuffers();
+/// Bytes held by the modem and its TX buffers; modems with TX buffers
+/// of their own add them.
+	virtual size_t	footprint() const { return sizeof(*this) + txbuffers_size(); }
+
 	virtual void	searchDown() {};
 	virtual void	searchUp() {};
 
@@ -6,14 +6,19 @@
 
 /// Forward definition.
 class navtex_implementation ;
+class navtex_channel ;
 
 #include <string>
+#include <vector>
 
 #include "modem.h"
 
 class navtex : public modem {
 	navtex_implementation * m_impl ;
 
+	/// Additional decoders on other audio carriers, each in its own thread.
+	std::vector< navtex_channel * > m_channels ;
+
 	/// Non-copiable object.
 	navtex();
 	navtex(const navtex *);
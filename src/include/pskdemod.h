@@ -0,0 +1,60 @@
+// ----------------------------------------------------------------------------
+// pskdemod.h  --  BPSK symbol and varicode decoder
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef _PSKDEMOD_H
+#define _PSKDEMOD_H
+
+#include "complex.h"
+#include "filters.h"
+
+// The part of a BPSK receiver that follows the mixer and the decimating
+// filter, shared by the PSK browser and the skimmer: the matched filter and
+// bit clock at 16 samples per symbol, the phase and DCD pattern of each
+// symbol, the AFC error and the varicode decoder.  What the caller does
+// with the DCD, the squelch and the AFC is left to it.
+class pskdemod {
+public:
+	enum { DCD_NONE, DCD_PREAMBLE, DCD_POSTAMBLE };
+
+	pskdemod();
+	void	reset();
+	// one sample at 16 per symbol; true and the symbol when one is due
+	bool	sync(complex z, complex& symbol);
+	// the phase and bits of a symbol, and whether it ended a preamble or
+	// postamble; otherwise quality is averaged over decay symbols
+	int		rx_symbol(complex symbol, int decay);
+	// the bit of the last symbol; a character, or -1 if none is complete
+	int		rx_bit();
+	// the frequency error of the last symbol, in Hz
+	double	freqerr(double samplerate, int symbollen) const;
+
+	double	phase;
+	int		bits;
+	complex	quality;
+
+private:
+	C_FIR_filter	fir2;
+	double			syncbuf[16];
+	double			bitclk;
+	complex			prevsymbol;
+	unsigned int	shreg;
+	unsigned int	dcdshreg;
+};
+
+#endif
@@ -111,6 +111,7 @@ public:
 #endif
                         return true;
                 }
+                nfull++;
 
 #ifndef NDEBUG
 //Remi's extra debugging info		LOG_ERROR("qrunner: thread %" PRIdPTR " fifo full!", GET_THREAD_ID());
@@ -159,6 +160,7 @@ protected:
 	bool inprog;
 public:
 	bool drop_flag;
+	unsigned long nfull;    // requests dropped because the fifo was full
 };
 
 
@@ -4,6 +4,8 @@
 #include <iosfwd>
 #include <string>
 #include <cstring>
+#include <vector>
+#include <tr1/unordered_map>
 
 #include "adif_def.h"
 
@@ -60,11 +62,22 @@ public:
 
 class cQsoDb {
 private:
-	cQsoRec * qsorec;
-	int maxrecs;
-	int nbrrecs;
+	// Records are allocated one by one and never move: growing the log
+	// and sorting it only move pointers.
+	vector<cQsoRec *> qsorec;
 	int dirty;
-	
+
+	// Records by upper-case callsign, for duplicate checks. Rebuilt on
+	// the next lookup after a change which may have altered a callsign.
+	typedef tr1::unordered_map<string, vector<const cQsoRec *> > call_index_t;
+	call_index_t call_index;
+	bool call_index_ok;
+	void index_rec(const cQsoRec *);
+	const vector<const cQsoRec *> *find_call(const char *callsign);
+
+	cQsoDb(const cQsoDb &);
+	cQsoDb &operator=(const cQsoDb &);
+
 	static const int jdays[][13];
 	bool isleapyear( int y ) const;
 	int dayofyear (int year, int mon, int mday);
@@ -78,13 +91,14 @@ public:
 	void clearDatabase();
 	void isdirty(int n) {dirty = n;}
 	int  isdirty() const {return dirty;}
-	void qsoNewRec (cQsoRec *);
+	cQsoRec *qsoNewRec (cQsoRec *);
+	void takeRecs (cQsoDb &);
 	cQsoRec *newrec();
 	void qsoDelRec (int);
 	void qsoUpdRec (int, cQsoRec *);
 	int qsoFindRec (cQsoRec *);
-	cQsoRec *getRec (int n) {return &qsorec[n];};
-	int nbrRecs () const {return nbrrecs;};
+	cQsoRec *getRec (int n) {return qsorec[n];};
+	int nbrRecs () const {return qsorec.size();};
 	bool qsoIsValidFile(const char *);
 	int qsoReadFile (const char *);
 	int qsoWriteFile (const char *);
@@ -93,7 +107,6 @@ public:
 	void SortByMode ();
 	void SortByFreq ();
 	void sort_reverse(bool rev) { reverse = rev;}
-	const cQsoRec *recarray() { return qsorec; }
   
 	bool duplicate(
 		const char *callsign, 
@@ -0,0 +1,83 @@
+// ----------------------------------------------------------------------------
+//      re_filter.h
+//
+// This file is part of fldigi.
+//
+// fldigi is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef RE_FILTER_H_
+#define RE_FILTER_H_
+
+#include <string>
+#include <vector>
+#include <bitset>
+
+// A prefilter for a set of POSIX extended REs which are matched against the
+// last `window' characters of character streams.  The literals that a match
+// of each RE must contain are combined into one Aho-Corasick automaton, which
+// is advanced one character at a time for each stream.  An RE is reported as
+// a candidate only if all its required literals lie within the window and, if
+// it is anchored with a trailing '$', if a match can end with the new
+// character.  REs that cannot be analysed are always candidates.  The filter
+// never rejects a window that the RE would match.
+class re_filter_t
+{
+public:
+	struct stream {
+		stream() : state(0), pos(0), gen(0) { }
+		size_t state;
+		unsigned long pos;
+		std::vector<unsigned long> seen;
+		unsigned gen;
+	};
+
+	re_filter_t(size_t window_ = 32);
+
+	void clear(void);
+	// returns the id of the RE, in order of addition
+	size_t add(const char* re, int cflags);
+	void compile(void);
+
+	// advances s over c and stores the ids of the candidate REs
+	void feed(stream& s, char c, std::vector<size_t>& candidates) const;
+	// restarts s, e.g. after a recompilation, from the len characters at str
+	void reset(stream& s, const char* str, size_t len) const;
+	bool stale(const stream& s) const { return s.gen != gen; }
+
+private:
+	struct pattern_t {
+		bool any;                     // no requirements
+		bool anchored;                // a match must end at the new character
+		std::bitset<256> last;        // characters a match can end with
+		std::vector<std::vector<size_t> > req; // AND of ORs of literal ids
+	};
+	struct node_t {
+		node_t() : fail(0) { }
+		size_t fail;
+		std::vector<size_t> out;      // literals ending here
+	};
+
+	size_t literal(const std::string& s);
+	void advance(stream& s, unsigned char c) const;
+
+	size_t window;
+	unsigned gen;
+	std::vector<pattern_t> patterns;
+	std::vector<std::string> literals;
+	std::vector<node_t> nodes;
+	std::vector<size_t> delta;            // nodes.size() x 256 transitions
+};
+
+#endif // RE_FILTER_H_
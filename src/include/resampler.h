@@ -0,0 +1,62 @@
+// ----------------------------------------------------------------------------
+// resampler.h  --  rational polyphase sample rate converter
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef RESAMPLER_H_
+#define RESAMPLER_H_
+
+#include <vector>
+#include <cstddef>
+
+// Converts between two integer sample rates by the ratio L/M in lowest
+// terms, with a Kaiser-windowed sinc low-pass split into L phases.  The
+// filter banks are designed once per ratio and shared by every resampler
+// that uses that ratio.
+class polyphase_resampler
+{
+public:
+	polyphase_resampler();
+
+	// returns false if the ratio needs too many phases
+	bool set_rates(int inrate, int outrate);
+	int get_inrate(void) const { return inrate; }
+	int get_outrate(void) const { return outrate; }
+	void reset(void);
+
+	// Reads at most inlen samples from in and writes at most outlen samples
+	// to out.  Returns the number of samples written; used is set to the
+	// number of samples read.
+	size_t process(const float* in, size_t inlen, float* out, size_t outlen, size_t& used);
+
+	struct bank_t {
+		unsigned L, M;
+		size_t taps;               // per phase
+		std::vector<float> h;      // L x taps, oldest sample first
+	};
+
+private:
+	static const bank_t* get_bank(unsigned L, unsigned M);
+
+	int inrate, outrate;
+	const bank_t* bank;
+	std::vector<float> hist;           // 2 x taps, so that a window is contiguous
+	size_t hpos;
+	unsigned phase;
+};
+
+#endif // RESAMPLER_H_
@@ -41,12 +41,11 @@
 #ifndef RSID_H
 #define RSID_H
 
-#include <samplerate.h>
-
 #include "ringbuffer.h"
 #include "globals.h"
 #include "modem.h"
 #include "fft.h"
+#include "sidechain.h"
 
 #define RSID_SAMPLE_RATE 11025.0
 
@@ -71,12 +70,13 @@ enum {
 
 struct RSIDs { unsigned short rs; trx_mode mode; const char* name; };
 
-class cRsId {
+class cRsId : public sc_detector {
 
 protected:
 // note: hamming distance > 5 causes false detection on second burst
 enum { HAMMING_HIGH = 2, HAMMING_MED = 4, HAMMING_LOW = 5 };// 6 };
 enum { INITIAL, EXTENDED, WAIT };
+enum { EV_ESCAPE, EV_CODE, EV_CODE2 };
 
 private:
 	// Table of precalculated Reed Solomon symbols
@@ -92,6 +92,7 @@ private:
 	static const int rsid_ids_size2;
 
 	int state;
+	volatile bool reset_pending;
 
 	int hamming_resolution;
 
@@ -127,11 +128,7 @@ private:
 	int		DistanceOut;
 	int		MetricsOut;
 
-// resample
-	SRC_STATE* 	src_state;
-	SRC_DATA	src_data;
 	float*		inptr;
-	static long	src_callback(void* cb_data, float** data);
 
 // transmit
 	double	*outbuf;
@@ -143,14 +140,17 @@ private:
 	void	CalculateBuckets(const double *pSpectrum, int iBegin, int iEnd);
 	bool	search_amp( int &pSymbolOut, int &pBinOut);
 	bool	search_amp2( int &pSymbolOut, int &pBinOut);
-	void	search(void);
+	void	search(const sc_block& blk, std::vector<sc_event>& events);
 	void	apply (int iSymbol, int iBin);
 	void	apply2 (int iSymbol, int iBin);
 public:
 	cRsId();
 	~cRsId();
 	void	reset();
-	void	receive(const float* buf, size_t len);
+	int	samplerate(void);
+	bool	enabled(void);
+	void	process(const sc_block& blk, std::vector<sc_event>& events);
+	void	dispatch(const sc_event& ev);
 	void	send(bool postidle);
 
 friend void reset_rsid(void *who);
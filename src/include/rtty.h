@@ -30,6 +30,8 @@
 #define _RTTY_H
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "complex.h"
 #include "modem.h"
@@ -68,6 +70,36 @@ enum RTTY_PARITY {
 	RTTY_PARITY_ONE
 };
 
+// framing state of one receiver
+struct rtty_slicer {
+	RTTY_RX_STATE	state;
+	int		counter;
+	int		bitcntr;
+	int		rxdata;
+	int		rxmode;		// LETTERS or FIGURES
+	int		lost;		// samples since the last stop bit
+	int		c;		// last character
+	int		lb;		// estimated characters lost before it
+	void reset();
+};
+
+// Diversity receivers, including the normal one.  They share the mixers and
+// the forward transforms of the mark and space filters:
+//   0  normal filter, selected demodulator (the modem's own bit decision)
+//   1  normal filter, the other demodulator
+//   2  narrow filter, Kahn
+//   3  narrow filter, ATC
+#define RTTY_BRANCHES	4
+
+struct rtty_branch {
+	Cmovavg		*bits;		// unused for branch 0
+	bool		bit;
+	rtty_slicer	rx;		// branch 0: the modem's own framing
+	std::string	line;		// characters since the last newline
+	std::string	done;		// the last complete line
+	unsigned long	done_at;	// filter output count at its end
+};
+
 // simple oscillator-class
 class Oscillator
 {
@@ -179,18 +211,14 @@ private:
 	complex mark_history[MAXPIPE];
 	complex space_history[MAXPIPE];
 
-	RTTY_RX_STATE rxstate;
+	rtty_branch branch[RTTY_BRANCHES];
 
-	int counter;
-	int bitcntr;
-	int rxdata;
 	double cfreq; // center frequency between MARK/SPACE tones
 	double shift_offset; // 1/2 rtty_shift
 	double posfreq, negfreq;
 	double freqerrhi, freqerrlo;
 	double poserr, negerr;
 	int poscnt, negcnt;
-	int lost;
 
 	double prevsymbol;
 	complex prevsmpl;
@@ -214,11 +242,23 @@ private:
 	double mark_env;
 	double space_env;
 
-	double FSKbuf[OUTBUFSIZE];		// signal array for qrq drive
+// diversity decoder
+	bool diversity;
+	double div_BW;
+	double alt_mark_env;
+	double alt_space_env;
+	unsigned long rxsample;		// filter outputs since restart
+	bool slot_open;			// collecting votes for a character
+	unsigned long slot_at;
+	int slot_c[RTTY_BRANCHES];	// -1: no character from that branch
+	unsigned long last_char_at;
+	std::string held;		// voted sentence waiting for its checksum
+	std::vector<int> held_lb;
+
+	double *FSKbuf;			// signal array for qrq drive
 	double FSKphaseacc;
 	double FSKnco();
 
-	int rxmode;
 	int txmode;
 	int preamble;
 
@@ -229,9 +269,19 @@ private:
 	inline complex mixer(double &phase, double f, complex in);
 
 	unsigned char Bit_reverse(unsigned char in, int n);
-	int decode_char();
+	int decode_char(rtty_slicer& s);
 	int rttyparity(unsigned int);
+	bool slice(rtty_slicer& s, bool bit);
 	bool rx(bool bit);
+	bool squelch_open();
+	void rx_char(int c, int lb);
+	void extr_push(int c, int lb);
+	void div_reset();
+	void div_run(int b, bool nubit);
+	void div_vote(int b, int c);
+	void div_close();
+	void div_extract(int c, int lb);
+	void div_release();
 // transmit
 	double nco(double freq);
 	void send_symbol(int symbol);
@@ -241,11 +291,14 @@ private:
 //	void keyline(int);
 	int rttyxprocess();
 	int baudot_enc(unsigned char data);
-	char baudot_dec(unsigned char data);
+	char baudot_dec(unsigned char data, int& mode);
 	void Metric();
 public:
 	rtty(trx_mode mode);
 	~rtty();
+	void alloc_txbuffers();
+	void free_txbuffers();
+	size_t footprint() const;
 	void init();
 	void rx_init();
 	void tx_init(SoundBase *sc);
@@ -59,9 +59,12 @@ public:
 	int  Stopbits() { return stopbits;}
 
 	int  ReadBuffer (unsigned char *b, int nbr);
+	int  ReadAvailable (unsigned char *b, int nbr, int msec);
 	int  WriteBuffer(unsigned char *str, int nbr);
 	void FlushBuffer();
 
+	int  Fd() { return fd; }
+
 
 private:
 //Members
@@ -119,6 +122,10 @@ public:
 	int  ReadBuffer (unsigned char *b, int nbr) {
 	  return ReadData (b,nbr);
 	}
+	// reads are bounded by the port's comm timeouts
+	int  ReadAvailable (unsigned char *b, int nbr, int msec) {
+	  return ReadData (b,nbr);
+	}
 
 	BOOL WriteByte(unsigned char bybyte);
 	int WriteBuffer(unsigned char *str, int nbr);
@@ -0,0 +1,102 @@
+// ----------------------------------------------------------------------------
+// sidechain.h  --  receive side-chain detectors
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef SIDECHAIN_H_
+#define SIDECHAIN_H_
+
+#include <string>
+#include <vector>
+
+#include "sound.h"
+
+// Longest block that a detector is given.  Blocks that are resampled to a
+// higher rate than the modem's are split if they do not fit.
+#define SC_MAXBLOCK (2 * SCBLOCKSIZE)
+
+// One receive block, together with the modem state that the detectors need
+// and that must be read on the trx thread.
+struct sc_block {
+	float buf[SC_MAXBLOCK];
+	size_t len;
+	int samplerate;
+	double freq;    // modem audio frequency
+	bool reverse;   // spectrum is inverted (LSB xor waterfall reverse)
+};
+
+class sc_detector;
+
+// A detection, returned by a detector to the trx thread
+struct sc_event {
+	sc_event(int kind_ = 0, int arg1_ = 0, int arg2_ = 0)
+		: det(0), kind(kind_), arg1(arg1_), arg2(arg2_) { }
+	sc_event(int kind_, const std::string& text_)
+		: det(0), kind(kind_), arg1(0), arg2(0), text(text_) { }
+	sc_detector* det;
+	int kind;
+	int arg1, arg2;
+	std::string text;
+};
+
+// Detectors such as RSID and DTMF see the same audio as the modem but run on
+// their own threads.  The audio is converted once for each sample rate that
+// the detectors ask for, and written to a lock-free ring per rate that all
+// detectors at that rate read in place.  The trx thread never waits on a
+// detector: if one falls behind, blocks are dropped and counted.  Detections
+// are queued and handed back to dispatch() on the trx thread, where the
+// detector may change the modem, use REQ etc.
+class sc_detector
+{
+public:
+	sc_detector(const char* name_) : name(name_) { }
+	virtual ~sc_detector() { }
+
+	// the sample rate that process() expects, or 0 for the modem's rate
+	virtual int samplerate(void) { return 0; }
+	// side-chain and trx threads: whether blocks should be processed or
+	// discarded; a stream whose readers are all disabled is not written
+	virtual bool enabled(void) = 0;
+	// side-chain thread: process one block and append any detections
+	virtual void process(const sc_block& blk, std::vector<sc_event>& events) = 0;
+	// trx thread: act on a detection
+	virtual void dispatch(const sc_event& ev) = 0;
+
+	const char* name;
+};
+
+struct sc_stats {
+	const char* name;
+	double cpu;             // seconds of CPU time spent in process()
+	double audio;           // seconds of audio processed
+	unsigned long blocks;
+	unsigned long dropped;
+};
+
+// the detectors must be added before sidechain_start
+void sidechain_add(sc_detector* det);
+void sidechain_start(void);
+// joins the threads and forgets the detectors
+void sidechain_stop(void);
+
+// trx thread
+void sidechain_queue(const float* buf, size_t len, int samplerate, double freq, bool reverse);
+void sidechain_dispatch(void);
+
+void sidechain_stats(std::vector<sc_stats>& stats);
+
+#endif // SIDECHAIN_H_
@@ -0,0 +1,96 @@
+// ----------------------------------------------------------------------------
+// skimmer.h  --  decode every signal in the passband
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#ifndef SKIMMER_H_
+#define SKIMMER_H_
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "sidechain.h"
+#include "globals.h"
+
+// decoder numbers passed to spot_recv start here
+#define SKIM_DECODER_BASE 1000
+
+class Cfft;
+class fork_join;
+class morse;
+struct skim_decoder;
+
+// The skimmer runs on its own side-chain thread.  It looks for peaks in the
+// averaged spectrum and classifies them by their occupied bandwidth and
+// keying as CW, PSK31, PSK63 or RTTY at the configured shift and speed.  A
+// decoder of that type is started for each new signal and released when the
+// signal has been gone for a while.  The decoders run in parallel on a pool
+// of threads, and their text is passed to spot_recv and written to
+// skimmer.log on the trx thread.
+class cSkimmer : public sc_detector
+{
+public:
+	cSkimmer();
+	~cSkimmer();
+
+	int samplerate(void);
+	bool enabled(void);
+	void process(const sc_block& blk, std::vector<sc_event>& events);
+	void dispatch(const sc_event& ev);
+
+private:
+	struct line_t {
+		long long rf;
+		int afreq;
+		trx_mode mode;
+		std::string text;
+		time_t start, last;
+	};
+
+	void spectrum(void);
+	void scan(void);
+	bool is_keyed(int k);
+	int free_id(void);
+	skim_decoder* new_decoder(int kind, double f);
+	void release(skim_decoder* d);
+	void write_line(line_t& line);
+	void flush_lines(time_t now, bool all);
+
+	static void decode_job(void* arg, size_t i);
+
+	// side-chain thread
+	Cfft* fft;
+	std::vector<double> fftbuf, window, avg;
+	std::vector<std::vector<double> > history;
+	size_t fftpos, nspectra;
+	double now;                       // seconds of audio processed
+	std::vector<skim_decoder*> decoders;
+	std::vector<int> released;      // ids, until the trx thread is told
+	const sc_block* blk;
+	fork_join* pool;
+	morse* cw_table;
+
+	// trx thread
+	std::map<int, line_t> lines;
+	FILE* log;
+};
+
+extern cSkimmer* skimmer;
+
+#endif // SKIMMER_H_
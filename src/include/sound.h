@@ -100,6 +100,8 @@ public:
 	virtual size_t	Read(float *, size_t) = 0;
 	virtual void    flush(unsigned dir = UINT_MAX) = 0;
 	virtual bool	must_close(int dir = 0) = 0;
+	// fill level and size of the capture buffer, in samples
+	virtual void	rx_levels(size_t& fill, size_t& size) { fill = size = 0; }
 #if USE_SNDFILE
 	void		get_file_params(const char* def_fname, const char** fname, int* format);
 	int		Capture(bool val);
@@ -194,6 +196,7 @@ public:
 	size_t 		Read(float *buf, size_t count);
 	bool		must_close(int dir = 0);
 	void		flush(unsigned dir = UINT_MAX);
+	void		rx_levels(size_t& fill, size_t& size);
 
 private:
         void		src_data_reset(unsigned dir);
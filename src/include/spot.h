@@ -36,6 +36,7 @@ typedef void (*spot_log_cb_t)(const char* call, const char* loc, long long freq,
 			      trx_mode mode, time_t rtime, void* data);
 
 void spot_recv(char c, int decoder = -1, int afreq = 0, int md = 0);
+void spot_release(int decoder);
 void spot_log(const char* callsign, const char* locator = "", long long freq = 0LL,
 	      trx_mode mode = NUM_MODES, time_t rtime = -1L);
 void spot_manual(const char* callsign, const char* locator = "",
@@ -138,4 +138,35 @@ public:
 	bool wait( double seconds );
 };
 
+/// A fixed set of threads that share loops of independent iterations with
+/// the calling thread.  run() returns when all iterations are done.
+class fork_join
+{
+public:
+	typedef void (*job_t)(void* arg, size_t i);
+
+	// starts up to nthreads helper threads
+	fork_join(int nthreads);
+	~fork_join();
+	// the number of threads that run() uses, including the caller
+	int size(void) const { return nworkers + 1; }
+	// calls job(arg, i) for every i < n
+	void run(job_t job_, void* arg_, size_t n_);
+
+	// the number of online CPUs
+	static int ncpus(void);
+private:
+	struct worker;
+	static void* worker_loop(void* arg);
+	void stripe(int first);
+
+	int nworkers;
+	worker* workers;
+	syncobj done;
+	int pending;
+	job_t job;
+	void* arg;
+	size_t n;
+};
+
 #endif // !THREADS_H_
@@ -93,6 +93,7 @@ struct RTTY_CHANNEL {
 	int			bitcntr;
 	int			rxdata;
 	int			inp_ptr;
+	int			lost;		// samples since the last character shown
 
 	complex		mark_history[MAXPIPE];
 	complex		space_history[MAXPIPE];
@@ -113,6 +114,7 @@ private:
 	int symbollen;
 	int nbits;
 	int stoplen;
+	int bytelen;
 	int msb;
 	bool useFSK;
 
@@ -148,6 +150,8 @@ private:
 	int rttyxprocess();
 	char baudot_dec(int ch, unsigned char data);
 	void Metric(int ch);
+	void extr_push(int ch, int c, int lb);
+	void extr_release(int ch);
 public:
 	view_rtty(trx_mode mode);
 	~view_rtty();
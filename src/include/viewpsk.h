@@ -23,11 +23,16 @@
 #ifndef _VIEWPSK_H
 #define _VIEWPSK_H
 
+#include <vector>
+
 #include "complex.h"
 #include "modem.h"
 #include "globals.h"
 #include "filters.h"
+#include "channelizer.h"
+#include "threads.h"
 #include "pskeval.h"
+#include "pskdemod.h"
 
 //=====================================================================
 #define	VPSKSAMPLERATE	(8000)
@@ -37,34 +42,44 @@
 #define VSIGSEARCH 5
 #define VWAITCOUNT 4
 #define NULLFREQ 1e6
+// channelizer bins, 125 Hz apart
+#define VNUMBINS 64
+// most threads that decode channels besides the trx thread
+#define VMAXWORKERS 4
 //=====================================================================
 
+// a character or DCD change found on a worker thread
+struct VIEWCHR {
+	VIEWCHR(int f, int ch) : freq(f), c(ch) { }
+	int				freq;
+	int				c;
+};
+
 struct CHANNEL {
 	double			phaseacc;
-	complex			prevsymbol;
-	complex			quality;
-	unsigned int	shreg;
+	pskdemod		demod;
 	double			metric;
 
 	double			frequency;
 	double			freqerr;
-	double			phase;
-	double			syncbuf[16];
-
-	C_FIR_filter	*fir1;
-	C_FIR_filter	*fir2;
-	
-	int				bits;
-	double 			bitclk;
-	unsigned int	dcdshreg;
+
 	int 			dcd;
 	int				waitcount;
 	int				timeout;
 	bool			reset;
 	int				acquire;
 
+	int				bin;
+	std::vector<VIEWCHR> chars;
+	double			cpu;		// seconds spent decoding
+	double			audio;		// seconds decoded
 };
 
+// The channels are not mixed and filtered one at a time.  One channelizer
+// splits the audio into bins and decimates it to 16 samples per symbol for
+// all channels at once, so that each channel only has to shift its bin to
+// baseband at the decimated rate.  The symbol decoding of the channels is
+// then shared between the trx thread and a few worker threads.
 class viewpsk {
 private:
 	trx_mode	viewmode;
@@ -88,14 +103,27 @@ private:
 
 	pskeval*	evalpsk;
 
+	channelizer	chz;
+	int			nout;
+	std::vector<int> active;
+
+	fork_join*	pool;
+
+	double		chz_cpu;
+	double		audio;
+
+	void		rx_channel(int ch);
 	void		rx_symbol(int ch, complex symbol);
-	void 		rx_bit(int ch, int bit);
-	void		findsignal(int);
+	void 		rx_bit(int ch);
+	void		findsignals(int);
 	void		afc(int);
+	void		report();
 
 	inline void		timeout_check();
 	inline void		insert();
 
+	static void	rx_job(void* arg, size_t i);
+
 public:
 	viewpsk(pskeval* eval, trx_mode mode);
 	~viewpsk();
@@ -20,6 +20,7 @@ public:
 	static void update_rx_lpm(int lpm);
 	static int update_rx_pic_col(unsigned char data, int pos);
 	static void update_rx_pic_bw(unsigned char data, int pos);
+	static void update_rx_pic_row(const std::string & pixels, int pos);
 	static void tx_viewer_resize(int the_width, int the_height);
 	static void restart_tx_viewer(void);
 	static void abort_rx_viewer(void);
@@ -34,10 +35,12 @@ public:
 	static void cb_mnu_pic_viewer_tx(Fl_Menu_ *, void *);
 	static void setpicture_link(wefax *me);
 	static void save_image(const std::string & fil_name, const std::string & extra_comments);
+	static void saved_image(const std::string & fil_name);
 	static void power( double start, double phase, double image, double black, double stop );
 	static void send_image( const std::string & fil_name );
 	static void set_manual( bool manual_mode );
 	static void update_auto_center( bool is_auto_center );
+	static const std::string & default_dir_get( const std::string & config_dir );
 
 	static void create_both( bool called_from_fl_digi );
 	static void show_both();
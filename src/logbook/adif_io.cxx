@@ -5,6 +5,15 @@
 #include <cstring>
 #include <cstdlib>
 #include <string>
+#include <vector>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef __WOE32__
+#  include <sys/mman.h>
+#endif
 
 #include "fl_digi.h"
 
@@ -118,47 +127,52 @@ static void initfields()
 	}
 }
 
-static inline int findfield( char *p )
-{
-	if (strncasecmp (p, "EOR>", 4) == 0 || !maxlen)
-		return -1;
+// The parser works on a read-only, unterminated view of the file, so
+// every search below is bounded by the end of that view.
 
-	char *pos;
-	char *p1 = strchr(p, ':');
-	char *p2 = strchr(p, '>');
-	if (p1 && p2) {
-		if (p1 < p2) {
-			pos = p;
-			do { *pos = toupper(*pos); } while (++pos < p1);
-			*p1 = 0;
-			pos = strstr(fastlookup, p);
-			*p1 = ':';
-			if (pos) return fields[(pos - fastlookup) / maxlen].type;
-		}
-	}
-	return -2;		//search key not found
+static inline bool is_tag(const char *p, const char *end, const char *tag, size_t len)
+{
+	return (size_t)(end - p) >= len && strncasecmp(p, tag, len) == 0;
 }
 
-int cAdifIO::instances = 0;
-
-cAdifIO::cAdifIO ()
+// returns the position following the first case insensitive match of tag, or 0
+static const char *find_tag(const char *p, const char *end, const char *tag)
 {
-	initfields();
-	instances++;
+	size_t len = strlen(tag);
+	while ((p = (const char *)memchr(p, '<', end - p)) != 0) {
+		if (is_tag(p, end, tag, len))
+			return p + len;
+		p++;
+	}
+	return 0;
 }
 
-cAdifIO::~cAdifIO()
+// p follows the '<' of an ADIF specifier
+// returns the field type, -1 for <EOR>, -2 if the field is not in the database
+static inline int findfield(const char *p, const char *end)
 {
-	if (--instances == 0) {
-		delete [] fastlookup;
-		fastlookup = 0;
+	if (is_tag(p, end, "EOR>", 4) || !maxlen)
+		return -1;
+
+	char name[32];
+	size_t n = 0;
+	for (; p + n < end && n < sizeof(name) - 1; n++) {
+		if (p[n] == ':' || p[n] == '>')
+			break;
+		name[n] = toupper(p[n]);
 	}
+	if (p + n == end || p[n] != ':' || !memchr(p + n, '>', end - p - n))
+		return -2;
+	name[n] = 0;
+	const char *pos = strstr(fastlookup, name);
+	if (pos) return fields[(pos - fastlookup) / maxlen].type;
+	return -2;		//search key not found
 }
 
-void cAdifIO::fillfield (int fieldnum, char *buff)
+static void fillfield(cQsoRec *rec, int fieldnum, const char *buff, const char *end)
 {
-	char *p1 = strchr(buff, ':');
-	char *p2 = strchr(buff, '>');
+	const char *p1 = (const char *)memchr(buff, ':', end - buff);
+	const char *p2 = (const char *)memchr(buff, '>', end - buff);
 	if (!p1 || !p2 || p2 < p1) return; // bad ADIF specifier ---> no ':' after field name
 
 	p1++;
@@ -169,13 +183,48 @@ void cAdifIO::fillfield (int fieldnum, char *buff)
 		}
 		p1++;
 	}
+	if (fldsize > end - (p2 + 1))
+		fldsize = end - (p2 + 1);
 	if ((fieldnum == TIME_ON || fieldnum == TIME_OFF) && fldsize < 6) {
 		string tmp = "";
 		tmp.assign(p2+1, fldsize);
 		while (tmp.length() < 6) tmp += '0';
-		adifqso->putField(fieldnum, tmp.c_str(), 6);
+		rec->putField(fieldnum, tmp.c_str(), 6);
 	} else
-		adifqso->putField (fieldnum, p2+1, fldsize);
+		rec->putField (fieldnum, p2+1, fldsize);
+}
+
+static void parse_records(const char *p, const char *end, cQsoDb *db)
+{
+	cQsoRec *rec = 0;
+	int found;
+
+	while ((p = (const char *)memchr(p, '<', end - p)) != 0) {
+		p++;
+		found = findfield(p, end);
+		if (found > -1) {
+			if (!rec) rec = db->newrec(); // need new record in db
+			fillfield (rec, found, p, end);
+		} else if (found == -1) { // <eor> reached;
+			rec = 0;
+		}
+	}
+}
+
+int cAdifIO::instances = 0;
+
+cAdifIO::cAdifIO ()
+{
+	initfields();
+	instances++;
+}
+
+cAdifIO::~cAdifIO()
+{
+	if (--instances == 0) {
+		delete [] fastlookup;
+		fastlookup = 0;
+	}
 }
 
 static void write_rxtext(const char *s)
@@ -183,55 +232,232 @@ static void write_rxtext(const char *s)
 	ReceiveText->addstr(s);
 }
 
+// Read-only view of a whole file: mapped where the platform allows it,
+// read into memory otherwise.
+class adif_map {
+public:
+	const char *data;
+	size_t size;
+
+	adif_map() : data(0), size(0), mapped(false) { }
+	~adif_map() { close(); }
+
+	bool open(const char *fname) {
+		int fd = ::open(fname, O_RDONLY);
+		if (fd == -1)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) == -1) {
+			::close(fd);
+			return false;
+		}
+		if (st.st_size == 0) {
+			::close(fd);
+			return true;
+		}
+		size = st.st_size;
+#ifndef __WOE32__
+		void *p = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			madvise(p, size, MADV_SEQUENTIAL);
+			data = (const char *)p;
+			mapped = true;
+			::close(fd);
+			return true;
+		}
+#endif
+		char *buf = new char[size];
+		size_t n = 0;
+		ssize_t r;
+		while (n < size && (r = read(fd, buf + n, size - n)) > 0)
+			n += r;
+		::close(fd);
+		data = buf;
+		size = n;
+		return true;
+	}
+
+	void close() {
+#ifndef __WOE32__
+		if (mapped)
+			munmap((void *)data, size);
+		else
+#endif
+			delete [] data;
+		data = 0;
+		size = 0;
+		mapped = false;
+	}
+
+private:
+	bool mapped;
+	adif_map(const adif_map &);
+	adif_map &operator=(const adif_map &);
+};
+
+// Files smaller than two chunks are parsed on the calling thread
+enum { ADIF_MIN_CHUNK = 256 * 1024, ADIF_MAX_READERS = 8 };
+
+struct adif_chunk {
+	const char *start;
+	const char *end;
+	cQsoDb db;
+	pthread_t thread;
+	bool started;
+};
+
+static void *adif_chunk_loop(void *arg)
+{
+	adif_chunk *chunk = static_cast<adif_chunk *>(arg);
+	parse_records(chunk->start, chunk->end, &chunk->db);
+	return NULL;
+}
+
+static int adif_readers(size_t len)
+{
+	long ncpu = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	long n = len / ADIF_MIN_CHUNK;
+	if (n > ncpu) n = ncpu;
+	if (n > ADIF_MAX_READERS) n = ADIF_MAX_READERS;
+	return n < 1 ? 1 : n;
+}
+
+// Splits [p, end) at <EOR> boundaries and parses the pieces in parallel.
+// The records are appended to db in file order.
+static void parse_parallel(const char *p, const char *end, cQsoDb *db)
+{
+	int n = adif_readers(end - p);
+	if (n == 1) {
+		parse_records(p, end, db);
+		return;
+	}
+
+	adif_chunk *chunks = new adif_chunk[n];
+	size_t step = (end - p) / n;
+	const char *start = p;
+	int nchunks = 0;
+	for (int i = 0; i < n && start < end; i++) {
+		const char *stop = end;
+		if (i < n - 1 && start + step < end) {
+			stop = find_tag(start + step, end, "<EOR>");
+			if (!stop) stop = end;
+		}
+		chunks[nchunks].start = start;
+		chunks[nchunks].end = stop;
+		nchunks++;
+		start = stop;
+	}
+
+	for (int i = 1; i < nchunks; i++) {
+		chunks[i].started = (pthread_create(&chunks[i].thread, NULL,
+						    adif_chunk_loop, &chunks[i]) == 0);
+		if (!chunks[i].started) {
+			LOG_PERROR("pthread_create");
+			parse_records(chunks[i].start, chunks[i].end, &chunks[i].db);
+		}
+	}
+	parse_records(chunks[0].start, chunks[0].end, db);
+	for (int i = 1; i < nchunks; i++) {
+		if (chunks[i].started)
+			pthread_join(chunks[i].thread, NULL);
+		db->takeRecs(chunks[i].db);
+	}
+	delete [] chunks;
+}
+
+// What is known about the log file since it was last read or written by
+// us: the running checksum of its records and its size and time.  While
+// the file still matches, new records are appended instead of rewriting
+// the whole log.
+struct adif_tail_t {
+	string fname;
+	off_t size;
+	time_t mtime;
+	Ccrc16 crc;
+	int appended;
+	bool valid;
+	adif_tail_t() : size(0), mtime(0), appended(0), valid(false) { }
+};
+
+static adif_tail_t adif_tail;
+static pthread_mutex_t adif_tail_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// caller holds adif_tail_mutex
+static void tail_set(const string &fname, const Ccrc16 &crc, int appended)
+{
+	struct stat st;
+	adif_tail.valid = (stat(fname.c_str(), &st) == 0);
+	if (!adif_tail.valid)
+		return;
+	adif_tail.fname = fname;
+	adif_tail.size = st.st_size;
+	adif_tail.mtime = st.st_mtime;
+	adif_tail.crc = crc;
+	adif_tail.appended = appended;
+}
+
+// caller holds adif_tail_mutex
+static bool tail_ok(const char *fname)
+{
+	struct stat st;
+	return adif_tail.valid && adif_tail.fname == fname &&
+		stat(fname, &st) == 0 &&
+		st.st_size == adif_tail.size && st.st_mtime == adif_tail.mtime;
+}
+
+// Compares the DATA CHECKSUM in the header [hdr, body) with the checksum
+// of the records in [body, end), leaving the latter in crc
+static bool check_records(const char *hdr, const char *body, const char *end, Ccrc16 &crc)
+{
+	const char *p = find_tag(hdr, body, "<DATA CHECKSUM:");
+	if (!p || !(p = (const char *)memchr(p, '>', body - p)) || body - ++p < 4)
+		return false;
+	string sum(p, 4);
+
+	crc.reset();
+	for (p = body; p < end; p++)
+		crc.update(*p);
+	return crc.sval() == sum;
+}
+
 void cAdifIO::do_readfile(const char *fname, cQsoDb *db)
 {
-	long filesize = 0;
-	char *buff;
-	int found;
-	int retval;
+	adif_map adif;
 
 LOG_INFO("Reading %s", fname);
 
 // open the adif file
-	FILE *adiFile = fopen (fname, "r");
-
-	if (adiFile == NULL) {
+	if (!adif.open(fname)) {
 LOG_INFO("Cannot open %s", fname);
 		return;
 	}
 
-// determine its size for buffer creation
-	fseek (adiFile, 0, SEEK_END);
-	filesize = ftell (adiFile);
-
-	if (filesize == 0) {
+	if (adif.size == 0) {
 		LOG_INFO(_("Empty ADIF logbook file %s"), fl_filename_name(fname));
 		return;
 	}
 
-	buff = new char[filesize + 1];
-
 	static char szmsg[100];
 	static char szmsg2[100];
 	snprintf(szmsg, sizeof(szmsg), "Reading %ld bytes from %s",
-		filesize, fl_filename_name(fname));
+		(long)adif.size, fl_filename_name(fname));
 	REQ(write_rxtext, "\n*** ");
 	REQ(write_rxtext, szmsg);
 	LOG_INFO("%s", szmsg);
-// read the entire file into the buffer
 
-	fseek (adiFile, 0, SEEK_SET);
-	retval = fread (buff, filesize, 1, adiFile);
-	fclose (adiFile);
+	const char *buff = adif.data;
+	const char *end = adif.data + adif.size;
 
 // relaxed file integrity test to all importing from non conforming log programs
-	if (strcasestr(buff, "<CALL:") == 0) {
+	if (!find_tag(buff, end, "<CALL:")) {
 		strcpy(szmsg2, "NO RECORDS IN FILE");
 		REQ(write_rxtext, "\n*** ");
 		REQ(write_rxtext, szmsg2);
 		REQ(write_rxtext, "\n");
 		LOG_INFO("%s", szmsg2);
-		delete [] buff;
 		db->clearDatabase();
 		return;
 	}
@@ -243,14 +469,10 @@ LOG_INFO("Cannot open %s", fname);
 	clock_gettime(CLOCK_REALTIME, &t0);
 #endif
 
-	char *p1 = buff, *p2;
+	const char *p1 = buff;
 	if (*p1 != '<') { // yes, skip over header to start of records
-		p1 = strchr(buff, '<');
-		while (strncasecmp (p1+1,"EOH>", 4) != 0) {
-			p1 = strchr(p1+1, '<'); // find next <> field
-		}
+		p1 = find_tag(buff, end, "<EOH>");
 		if (!p1) {
-			delete [] buff;
 			strcpy(szmsg2, "Corrupt ADIF file ***");
 			REQ(write_rxtext, "\n*** ");
 			REQ(write_rxtext, szmsg2);
@@ -258,24 +480,22 @@ LOG_INFO("Cannot open %s", fname);
 			LOG_ERROR("%s", szmsg2);
 			return;	 // must not be an ADIF compliant file
 		}
-		p1 += 1;
+		if (p1 < end && *p1 == '\r') p1++;
+		if (p1 < end && *p1 == '\n') p1++;
 	}
 
-	p2 = strchr(p1,'<'); // find first ADIF specifier
-
-	adifqso = 0;
-	while (p2) {
-		found = findfield(p2+1);
-		if (found > -1) {
-			if (!adifqso) adifqso = db->newrec(); // need new record in db
-			fillfield (found, p2+1);
-		} else if (found == -1) { // <eor> reached;
-			adifqso = 0;
-		}
-		p1 = p2 + 1;
-		p2 = strchr(p1,'<');
+	parse_parallel(p1, end, db);
+
+	if (db == &qsodb) {
+		Ccrc16 crc;
+		bool ok = p1 != buff && check_records(buff, p1, end, crc);
+		pthread_mutex_lock(&adif_tail_mutex);
+		if (ok)
+			tail_set(fname, crc, 0);
+		else
+			adif_tail.valid = false;
+		pthread_mutex_unlock(&adif_tail_mutex);
 	}
-	delete [] buff;
 
 #ifdef _POSIX_MONOTONIC_CLOCK
 	clock_gettime(CLOCK_MONOTONIC, &t1);
@@ -364,12 +584,7 @@ pthread_mutex_t ADIF_RW_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t ADIF_RW_cond = PTHREAD_COND_INITIALIZER;
 static void ADIF_RW_init();
 
-static string adif_file_image;
 static string adif_file_name;
-static string records;
-static string record;
-static char recfield[200];
-static int nrecs;
 
 static bool ADIF_READ = false;
 static bool ADIF_WRITE = false;
@@ -378,6 +593,16 @@ static cQsoDb *adif_db;
 
 static cAdifIO *adifIO = 0;
 
+// records waiting to be appended to the end of a log file
+struct adif_append {
+	string fname;
+	cQsoRec *rec;
+};
+static vector<adif_append> adif_appends;
+
+// a log which has had this many records appended is rewritten in date order
+enum { ADIF_COMPACT_RECS = 100 };
+
 void cAdifIO::readFile (const char *fname, cQsoDb *db) 
 {
 	ENSURE_THREAD(FLMAIN_TID);
@@ -398,11 +623,22 @@ void cAdifIO::readFile (const char *fname, cQsoDb *db)
 	pthread_mutex_unlock(&ADIF_RW_mutex);
 }
 
-static cQsoDb *adifdb = 0;
 static cQsoDb *wrdb = 0;
 
 static struct timespec t0, t1;
 
+// caller holds ADIF_RW_mutex
+static void drop_appends(const char *fname)
+{
+	for (size_t i = 0; i < adif_appends.size(); ) {
+		if (adif_appends[i].fname == fname) {
+			delete adif_appends[i].rec;
+			adif_appends.erase(adif_appends.begin() + i);
+		} else
+			i++;
+	}
+}
+
 int cAdifIO::writeLog (const char *fname, cQsoDb *db, bool immediate) {
 	ENSURE_THREAD(FLMAIN_TID);
 
@@ -415,26 +651,77 @@ int cAdifIO::writeLog (const char *fname, cQsoDb *db, bool immediate) {
 	clock_gettime(CLOCK_REALTIME, &t0);
 #endif
 
+// the whole database is written, so queued appends to this file are redundant
+	pthread_mutex_lock(&ADIF_RW_mutex);
+	drop_appends(fname);
 	if (!immediate) {
-		pthread_mutex_lock(&ADIF_RW_mutex);
 		adif_file_name = fname;
 		adifIO = this;
 		ADIF_WRITE = true;
 		if (wrdb) delete wrdb;
 		wrdb = new cQsoDb(db);
-		adifdb = wrdb;
 		pthread_cond_signal(&ADIF_RW_cond);
-		pthread_mutex_unlock(&ADIF_RW_mutex);
-	} else {
-		adif_file_name = fname;
-		adifdb = db;
-		do_writelog();
 	}
+	pthread_mutex_unlock(&ADIF_RW_mutex);
+
+	if (immediate)
+		do_writelog(fname, db);
 
 	return 1;
 }
 
-void cAdifIO::do_writelog()
+// Adds rec, which has just been added to db, to the log file.  The record
+// is appended to the file unless the file is not as it was last left, or
+// is due for compaction, in which case the whole of db is written.
+int cAdifIO::appendLog (const char *fname, cQsoDb *db, cQsoRec *rec) {
+	ENSURE_THREAD(FLMAIN_TID);
+
+	pthread_mutex_lock(&adif_tail_mutex);
+	bool append = tail_ok(fname) && adif_tail.appended < ADIF_COMPACT_RECS;
+	pthread_mutex_unlock(&adif_tail_mutex);
+
+	if (!ADIF_RW_thread)
+		ADIF_RW_init();
+
+	pthread_mutex_lock(&ADIF_RW_mutex);
+// a queued rewrite of this file was copied from db before rec was added
+	if (ADIF_WRITE && adif_file_name == fname)
+		append = false;
+	if (append) {
+		adif_append a;
+		a.fname = fname;
+		a.rec = new cQsoRec(*rec);
+		adif_appends.push_back(a);
+		pthread_cond_signal(&ADIF_RW_cond);
+	}
+	pthread_mutex_unlock(&ADIF_RW_mutex);
+
+	if (!append)
+		return writeLog(fname, db, false);
+
+	return 1;
+}
+
+static void adif_record(cQsoRec *rec, string &records)
+{
+	char recfield[200];
+	int j = 0;
+	while (fields[j].type != NUMFIELDS) {
+		const char *sFld = rec->getField(fields[j].type);
+		size_t len = strlen(sFld);
+		if (len) {
+			snprintf(recfield, sizeof(recfield), adifmt,
+				fields[j].name,
+				(int)len);
+			records.append(recfield).append(sFld, len);
+		}
+		j++;
+	}
+	records.append(szEOR);
+	records.append(szEOL);
+}
+
+void cAdifIO::do_writelog(const string &fname, cQsoDb *db)
 {
 	string ADIFHEADER;
 	ADIFHEADER = "File: %s";
@@ -453,47 +740,24 @@ void cAdifIO::do_writelog()
 	Ccrc16 checksum;
 	string s_checksum;
 
-	adiFile = fopen (adif_file_name.c_str(), "w");
+	adiFile = fopen (fname.c_str(), "w");
 
 	if (!adiFile) {
-		LOG_ERROR("Cannot write to %s", adif_file_name.c_str());
-		if (wrdb) {
-			delete wrdb;
-			wrdb = 0;
-		}
+		LOG_ERROR("Cannot write to %s", fname.c_str());
 		return;
 	}
-	LOG_INFO("Writing %s", adif_file_name.c_str());
-
-	string sFld;
-	cQsoRec *rec;
+	LOG_INFO("Writing %s", fname.c_str());
 
-	records.clear();
-	for (int i = 0; i < adifdb->nbrRecs(); i++) {
-		rec = adifdb->getRec(i);
-		record.clear();
-		int j = 0;
-		while (fields[j].type != NUMFIELDS) {
-			sFld = rec->getField(fields[j].type);
-			if (!sFld.empty()) {
-				snprintf(recfield, sizeof(recfield), adifmt,
-					fields[j].name,
-					sFld.length());
-				record.append(recfield).append(sFld);
-			}
-			j++;
-		}
-		record.append(szEOR);
-		record.append(szEOL);
-		records.append(record);
-		adifdb->qsoUpdRec(i, rec);
-	}
-	nrecs = adifdb->nbrRecs();
+	string records;
+	for (int i = 0; i < db->nbrRecs(); i++)
+		adif_record(db->getRec(i), records);
 
 	s_checksum = checksum.scrc16(records);
 
+	pthread_mutex_lock(&adif_tail_mutex);
+
 	fprintf (adiFile, ADIFHEADER.c_str(),
-		 fl_filename_name(adif_file_name.c_str()),
+		 fl_filename_name(fname.c_str()),
 		 strlen(ADIF_VERS), ADIF_VERS,
 		 strlen(PACKAGE_NAME), PACKAGE_NAME,
 		 strlen(PACKAGE_VERSION), PACKAGE_VERSION,
@@ -501,12 +765,12 @@ void cAdifIO::do_writelog()
 		);
 	fprintf (adiFile, "%s", records.c_str());
 
-	fclose (adiFile);
+	if (fclose (adiFile) == 0)
+		tail_set(fname, checksum, 0);
+	else
+		adif_tail.valid = false;
 
-	if (wrdb) {
-		delete wrdb;
-		wrdb = 0;
-	}
+	pthread_mutex_unlock(&adif_tail_mutex);
 
 #ifdef _POSIX_MONOTONIC_CLOCK
 	clock_gettime(CLOCK_MONOTONIC, &t1);
@@ -518,12 +782,83 @@ void cAdifIO::do_writelog()
 	float t = (t0.tv_sec + t0.tv_nsec/1e9);
 
 	static char szmsg[50];
-	snprintf(szmsg, sizeof(szmsg), "%d records in %4.2f seconds", adifdb->nbrRecs(), t);
+	snprintf(szmsg, sizeof(szmsg), "%d records in %4.2f seconds", db->nbrRecs(), t);
 	LOG_INFO("%s", szmsg);
 
 	return;
 }
 
+// Overwrites the value of the DATA CHECKSUM field in the header of fname
+static bool patch_checksum(const char *fname, const string &sum)
+{
+	FILE *f = fopen(fname, "rb+");
+	if (!f)
+		return false;
+
+	char hdr[1024];
+	size_t n = fread(hdr, 1, sizeof(hdr), f);
+	const char *p = find_tag(hdr, hdr + n, "<DATA CHECKSUM:");
+	bool ok = false;
+	if (p && (p = (const char *)memchr(p, '>', hdr + n - p)) != 0 &&
+	    (size_t)(hdr + n - ++p) >= sum.length())
+		ok = fseek(f, p - hdr, SEEK_SET) == 0 &&
+		     fwrite(sum.data(), 1, sum.length(), f) == sum.length();
+
+	if (fclose(f) != 0)
+		ok = false;
+	return ok;
+}
+
+static void append_records(const string &fname, const string &records, int nrecs)
+{
+	pthread_mutex_lock(&adif_tail_mutex);
+
+	bool ok = tail_ok(fname.c_str());
+	FILE *f = fopen(fname.c_str(), "a");
+	if (!f) {
+		LOG_ERROR("Cannot write to %s", fname.c_str());
+		adif_tail.valid = false;
+		pthread_mutex_unlock(&adif_tail_mutex);
+		return;
+	}
+	fprintf(f, "%s", records.c_str());
+	if (fclose(f) != 0)
+		ok = false;
+
+// the next append or save rewrites a file which has changed under us
+	if (ok) {
+		Ccrc16 crc = adif_tail.crc;
+		for (size_t i = 0; i < records.length(); i++)
+			crc.update(records[i]);
+		if (patch_checksum(fname.c_str(), crc.sval()))
+			tail_set(fname, crc, adif_tail.appended + nrecs);
+		else
+			adif_tail.valid = false;
+	} else {
+		LOG_WARN("%s changed since last written", fname.c_str());
+		adif_tail.valid = false;
+	}
+
+	pthread_mutex_unlock(&adif_tail_mutex);
+
+	LOG_INFO("Appended %d records to %s", nrecs, fname.c_str());
+}
+
+static void do_appendlog(vector<adif_append> &appends)
+{
+	size_t i = 0, j;
+	while (i < appends.size()) {
+		string records;
+		for (j = i; j < appends.size() && appends[j].fname == appends[i].fname; j++) {
+			adif_record(appends[j].rec, records);
+			delete appends[j].rec;
+		}
+		append_records(appends[i].fname, records, j - i);
+		i = j;
+	}
+	appends.clear();
+}
+
 //======================================================================
 // thread to support writing database in a separate thread
 //======================================================================
@@ -535,20 +870,45 @@ static void *ADIF_RW_loop(void *args)
 {
 	SET_THREAD_ID(ADIF_RW_TID);
 
+	cQsoDb *db;
+	string fname;
+	vector<adif_append> appends;
+
 	for (;;) {
 		pthread_mutex_lock(&ADIF_RW_mutex);
-		pthread_cond_wait(&ADIF_RW_cond, &ADIF_RW_mutex);
-		pthread_mutex_unlock(&ADIF_RW_mutex);
+		while (!ADIF_RW_EXIT && !ADIF_WRITE && !ADIF_READ && adif_appends.empty())
+			pthread_cond_wait(&ADIF_RW_cond, &ADIF_RW_mutex);
 
-		if (ADIF_RW_EXIT)
+		if (ADIF_RW_EXIT) {
+			pthread_mutex_unlock(&ADIF_RW_mutex);
 			return NULL;
-		if (ADIF_WRITE && adifIO) {
-			adifIO->do_writelog();
+		}
+
+// take the request, so that new ones can be queued while this one runs
+		cAdifIO *io = adifIO;
+		bool write = ADIF_WRITE, read = !write && ADIF_READ;
+		fname = adif_file_name;
+		db = 0;
+		if (write) {
+			db = wrdb;
+			wrdb = 0;
 			ADIF_WRITE = false;
-		} else if (ADIF_READ && adifIO) {
-			adifIO->do_readfile(adif_file_name.c_str(), adif_db);
+		} else if (read) {
+			db = adif_db;
 			ADIF_READ = false;
-		}
+		} else
+			appends.swap(adif_appends);
+		pthread_mutex_unlock(&ADIF_RW_mutex);
+
+		if (write) {
+			if (io && db)
+				io->do_writelog(fname, db);
+			delete db;
+		} else if (read) {
+			if (io)
+				io->do_readfile(fname.c_str(), db);
+		} else
+			do_appendlog(appends);
 	}
 	return NULL;
 }
@@ -969,7 +969,7 @@ void saveRecord() {
 	rec.putField(ITUZ, inpITUZ_log->value());
 	rec.putField(TX_PWR, inpTX_pwr_log->value());
 
-	qsodb.qsoNewRec (&rec);
+	cQsoRec *added = qsodb.qsoNewRec (&rec);
 	dxcc_entity_cache_add(&rec);
 	submit_record(rec);
 
@@ -980,7 +980,7 @@ void saveRecord() {
 
 	loadBrowser();
 
-	adifFile.writeLog (logbook_filename.c_str(), &qsodb);
+	adifFile.appendLog (logbook_filename.c_str(), &qsodb, added);
 }
 
 void updateRecord() {
@@ -31,6 +31,7 @@
 #include <fstream>
 #include <iostream>
 #include <queue>
+#include <algorithm>
 
 #include <time.h>
 
@@ -195,23 +196,33 @@ int compareDates (const cQsoRec &r1, const cQsoRec &r2) {
 	return r1.qsofield[QSO_DATE].compare( r2.qsofield[QSO_DATE] );
 }
 
+// Calls sort by the (call area digit, prefix, suffix) key, with calls that
+// have no digit after the first character first; the key is compared field
+// by field so that the order is transitive, as std::sort requires
+static void splitCall (const char *s, char &digit, size_t &prefix)
+{
+	const char *p = *s ? strpbrk (s+1, "0123456789") : 0;
+	digit = p ? *p : '\0';
+	prefix = p ? p - s : strlen(s);
+}
+
 int compareCalls (const cQsoRec &r1, const cQsoRec &r2) {
-	int cmp = 0;
 	const char * s1 = r1.qsofield[CALL].c_str();
 	const char * s2 = r2.qsofield[CALL].c_str();
-	const char * p1 = strpbrk (s1+1, "0123456789");
-	const char * p2 = strpbrk (s2+1, "0123456789");
-
-	if (p1 && p2) {
-		cmp = (*p1 < *p2) ? -1 : (*p1 > *p2) ? 1 : 0;
-		if (cmp == 0) {
-			cmp = strncmp (s1, s2, max(p1 - s1, p2 - s2));
-			if (cmp == 0)
-				cmp = strcmp(p1+1, p2+1);
-		}
-	} else
-		cmp = strcmp(s1, s2);
-	return cmp;
+	char d1, d2;
+	size_t n1, n2;
+	int cmp;
+
+	splitCall (s1, d1, n1);
+	splitCall (s2, d2, n2);
+
+	if (d1 != d2)
+		return (d1 < d2) ? -1 : 1;
+	if ((cmp = r1.qsofield[CALL].compare(0, n1, r2.qsofield[CALL], 0, n2)) != 0)
+		return cmp;
+	if (!d1)
+		return 0;
+	return strcmp(s1 + n1 + 1, s2 + n2 + 1);
 }
 
 int compareModes (const cQsoRec &r1, const cQsoRec &r2) {
@@ -303,37 +314,31 @@ istream &operator>> (istream &input, cQsoRec &rec ) {
 //======================================================================
 // class cQsoDb
 
-#define MAXRECS 32768
-#define INCRRECS 8192
-
 cQsoDb::cQsoDb() {
-  nbrrecs = 0;
-  maxrecs = MAXRECS;
-  qsorec = new cQsoRec[maxrecs];
   compby = COMPDATE;
   dirty = 0;
+  call_index_ok = false;
 }
 
 cQsoDb::cQsoDb(cQsoDb *db) {
-  nbrrecs = 0;
-  maxrecs = db->nbrRecs();
-  qsorec = new cQsoRec[maxrecs];
-  for (int i = 0; i < maxrecs; i++)
-    qsorec[i] = db->qsorec[i];
+  qsorec.reserve(db->nbrRecs());
+  for (int i = 0; i < db->nbrRecs(); i++)
+    qsorec.push_back(new cQsoRec(*db->qsorec[i]));
   compby = COMPDATE;
-  nbrrecs = maxrecs;
   dirty = 0;
+  call_index_ok = false;
 }
 
 cQsoDb::~cQsoDb() {
-  delete [] qsorec;
+  deleteRecs();
 } 
 
 void cQsoDb::deleteRecs() {
-  delete [] qsorec;
-  nbrrecs = 0;
-  maxrecs = MAXRECS;
-  qsorec = new cQsoRec[maxrecs];
+  for (size_t i = 0; i < qsorec.size(); i++)
+    delete qsorec[i];
+  qsorec.clear();
+  call_index.clear();
+  call_index_ok = false;
   dirty = 0;
 }
 
@@ -341,77 +346,109 @@ void cQsoDb::clearDatabase() {
   deleteRecs();
 }
 
+static string call_key(const char *callsign) {
+  string key(callsign);
+  for (size_t n = 0; n < key.length(); n++)
+    key[n] = toupper(key[n]);
+  return key;
+}
+
+void cQsoDb::index_rec(const cQsoRec *rec) {
+  call_index[call_key(rec->getField(CALL))].push_back(rec);
+}
+
+// Returns the records with this callsign, whatever its case, or 0 if none.
+const vector<const cQsoRec *> *cQsoDb::find_call(const char *callsign) {
+  if (!call_index_ok) {
+    call_index.clear();
+    for (size_t i = 0; i < qsorec.size(); i++)
+      index_rec(qsorec[i]);
+    call_index_ok = true;
+  }
+  call_index_t::const_iterator it = call_index.find(call_key(callsign));
+  return it == call_index.end() ? 0 : &it->second;
+}
+
 int cQsoDb::qsoFindRec(cQsoRec *rec) {
-  for (int i = 0; i < nbrrecs; i++)
-    if (qsorec[i] == *rec)
-      return i;
+  const vector<const cQsoRec *> *recs = find_call(rec->getField(CALL));
+  if (!recs)
+    return -1;
+  for (size_t i = 0; i < recs->size(); i++) {
+    if (*(*recs)[i] == *rec) {
+      vector<cQsoRec *>::iterator it = find(qsorec.begin(), qsorec.end(), (*recs)[i]);
+      return it - qsorec.begin();
+    }
+  }
   return -1;
 }
 
-void cQsoDb::qsoNewRec (cQsoRec *nurec) {
-  if (nbrrecs == maxrecs) {
-    maxrecs += INCRRECS;
-    cQsoRec *atemp = new cQsoRec[maxrecs];
-    for (int i = 0; i < nbrrecs; i++)
-        atemp[i] = qsorec[i];
-    delete [] qsorec;
-    qsorec = atemp;
-  }
-  qsorec[nbrrecs] = *nurec;
-  qsorec[nbrrecs].checkBand();
-  qsorec[nbrrecs].checkDateTimes();
-  nbrrecs++;
+cQsoRec *cQsoDb::qsoNewRec (cQsoRec *nurec) {
+  cQsoRec *rec = new cQsoRec(*nurec);
+  rec->checkBand();
+  rec->checkDateTimes();
+  qsorec.push_back(rec);
+  if (call_index_ok)
+    index_rec(rec);
+  return rec;
 }
 
+// Moves the records of db to the end of this database, leaving db empty.
+void cQsoDb::takeRecs (cQsoDb &db) {
+  qsorec.insert(qsorec.end(), db.qsorec.begin(), db.qsorec.end());
+  db.qsorec.clear();
+  db.call_index.clear();
+  db.call_index_ok = false;
+  call_index_ok = false;
+}
+
+// The caller fills the record in, so the index is rebuilt at the next lookup.
 cQsoRec* cQsoDb::newrec() {
-  if (nbrrecs == maxrecs) {
-    maxrecs += INCRRECS;
-    cQsoRec *atemp = new cQsoRec[maxrecs];
-    for (int i = 0; i < nbrrecs; i++)
-        atemp[i] = qsorec[i];
-    delete [] qsorec;
-    qsorec = atemp;
-  }
-  nbrrecs++;
-  return &qsorec[nbrrecs - 1];
+  qsorec.push_back(new cQsoRec);
+  call_index_ok = false;
+  return qsorec.back();
 }
 
 void cQsoDb::qsoDelRec (int rnbr) {
-  if (rnbr < 0 || rnbr > (nbrrecs - 1)) 
+  if (rnbr < 0 || rnbr > (nbrRecs() - 1)) 
     return;
-  for (int i = rnbr; i < nbrrecs - 1; i++)
-    qsorec[i] = qsorec[i+1];
-  nbrrecs--;
-  qsorec[nbrrecs].clearRec();
+  delete qsorec[rnbr];
+  qsorec.erase(qsorec.begin() + rnbr);
+  call_index_ok = false;
 }
   
 void cQsoDb::qsoUpdRec (int rnbr, cQsoRec *updrec) {
-  if (rnbr < 0 || rnbr > (nbrrecs - 1))
+  if (rnbr < 0 || rnbr > (nbrRecs() - 1))
     return;
-  qsorec[rnbr] = *updrec;
-  qsorec[rnbr].checkBand();
+  *qsorec[rnbr] = *updrec;
+  qsorec[rnbr]->checkBand();
+  call_index_ok = false;
   return;
 }
 
+static bool lessqsos (const cQsoRec *r1, const cQsoRec *r2) {
+  return compareqsos(r1, r2) < 0;
+}
+
+// Only the pointers are sorted, the records stay where they are.
 void cQsoDb::SortByDate (bool how) {
   date_off = how;
   compby = COMPDATE;
-  qsort (qsorec, nbrrecs, sizeof (cQsoRec), compareqsos);
+  sort (qsorec.begin(), qsorec.end(), lessqsos);
 }
 
 void cQsoDb::SortByCall () {
   compby = COMPCALL;
-  qsort (qsorec, nbrrecs, sizeof (cQsoRec), compareqsos);
+  sort (qsorec.begin(), qsorec.end(), lessqsos);
 }
 
 void cQsoDb::SortByMode () {
   compby = COMPMODE;
-  qsort (qsorec, nbrrecs, sizeof (cQsoRec), compareqsos);
+  sort (qsorec.begin(), qsorec.end(), lessqsos);
 }
 
 void cQsoDb::SortByFreq () {
 	compby = COMPFREQ;
-	qsort (qsorec, nbrrecs, sizeof (cQsoRec), compareqsos);
+	sort (qsorec.begin(), qsorec.end(), lessqsos);
 }
 
 bool cQsoDb::qsoIsValidFile(const char *fname) {
@@ -459,8 +496,8 @@ int cQsoDb::qsoWriteFile (const char *fname) {
     return 1;
   }
   outQsoFile << "_LOGBODUP DBX 3.0" << '\n';
-  for (int i = 0; i < nbrrecs; i++)
-    outQsoFile << qsorec[i];
+  for (size_t i = 0; i < qsorec.size(); i++)
+    outQsoFile << *qsorec[i];
   outQsoFile.close();
   return 0;
 }
@@ -527,40 +564,43 @@ bool cQsoDb::duplicate(
 		 b_dtimeDUP = true;
 	unsigned long datetime = epoch_dt(szdate, sztime);
 	unsigned long qsodatetime;
-	
-	for (int i = 0; i < nbrrecs; i++) {
-		if (strcasecmp(qsorec[i].getField(CALL), callsign) == 0) {
+
+	const vector<const cQsoRec *> *recs = find_call(callsign);
+	if (!recs)
+		return false;
+
+	for (size_t n = 0; n < recs->size(); n++) {
+		const cQsoRec &rec = *(*recs)[n];
 // found callsign duplicate
-			b_freqDUP = b_stateDUP = b_modeDUP = 
-				   	   b_xchg1DUP = b_dtimeDUP = false;
-			if (chkfreq) {
-				f2 = (int)atof(qsorec[i].getField(FREQ));
-				b_freqDUP = (f1 == f2);
-			}
-			if (chkstate)
-				b_stateDUP = (qsorec[i].getField(STATE)[0] == 0 && state[0] == 0) ||
-							 (strcasestr(qsorec[i].getField(STATE), state) != 0);
-			if (chkmode)
-				b_modeDUP  = (qsorec[i].getField(MODE)[0] == 0 && mode[0] == 0) ||
-							 (strcasestr(qsorec[i].getField(MODE), mode) != 0);
-			if (chkxchg1)
-				b_xchg1DUP = (qsorec[i].getField(XCHG1)[0] == 0 && xchg1[0] == 0) ||
-							 (strcasestr(qsorec[i].getField(XCHG1), xchg1) != 0);
-
-			if (chkdatetime) {
-				qsodatetime = epoch_dt (
-								qsorec[i].getField(QSO_DATE),
-								qsorec[i].getField(TIME_OFF));
-				if ((datetime - qsodatetime) < interval*60) b_dtimeDUP = true;
-			}
- 			if ( (!chkfreq     || (chkfreq     && b_freqDUP)) &&
-			     (!chkstate    || (chkstate    && b_stateDUP)) &&
-			     (!chkmode     || (chkmode     && b_modeDUP)) &&
-			     (!chkxchg1    || (chkxchg1    && b_xchg1DUP)) &&
-			     (!chkdatetime || (chkdatetime && b_dtimeDUP))) {
-			     return true;
-			 }
+		b_freqDUP = b_stateDUP = b_modeDUP = 
+			   	   b_xchg1DUP = b_dtimeDUP = false;
+		if (chkfreq) {
+			f2 = (int)atof(rec.getField(FREQ));
+			b_freqDUP = (f1 == f2);
+		}
+		if (chkstate)
+			b_stateDUP = (rec.getField(STATE)[0] == 0 && state[0] == 0) ||
+						 (strcasestr(rec.getField(STATE), state) != 0);
+		if (chkmode)
+			b_modeDUP  = (rec.getField(MODE)[0] == 0 && mode[0] == 0) ||
+						 (strcasestr(rec.getField(MODE), mode) != 0);
+		if (chkxchg1)
+			b_xchg1DUP = (rec.getField(XCHG1)[0] == 0 && xchg1[0] == 0) ||
+						 (strcasestr(rec.getField(XCHG1), xchg1) != 0);
+
+		if (chkdatetime) {
+			qsodatetime = epoch_dt (
+							rec.getField(QSO_DATE),
+							rec.getField(TIME_OFF));
+			if ((datetime - qsodatetime) < interval*60) b_dtimeDUP = true;
 		}
+ 			if ( (!chkfreq     || (chkfreq     && b_freqDUP)) &&
+		     (!chkstate    || (chkstate    && b_stateDUP)) &&
+		     (!chkmode     || (chkmode     && b_modeDUP)) &&
+		     (!chkxchg1    || (chkxchg1    && b_xchg1DUP)) &&
+		     (!chkdatetime || (chkdatetime && b_dtimeDUP))) {
+		     return true;
+		 }
 	}
 	return false;
 }
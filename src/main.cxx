@@ -29,6 +29,7 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <vector>
 #include <cstdlib>
 #include <getopt.h>
 #include <sys/types.h>
@@ -118,6 +119,7 @@
 #include "icons.h"
 
 #include "dl_fldigi/dl_fldigi.h"
+#include "dl_fldigi/flights.h"
 
 using namespace std;
 
@@ -180,6 +182,7 @@ FILE	*client;
 bool	mailserver = false, mailclient = false, arqmode = false;
 static bool show_cpucheck = false;
 static bool iconified = false;
+static bool startup_profile = false;
 
 RXMSGSTRUC rxmsgst;
 int		rxmsgid = -1;
@@ -211,6 +214,123 @@ static void arg_error(const char* name, const char* arg, bool missing) noreturn_
 #  define SHOW_WIZARD_BEFORE_MAIN_WINDOW 0
 #endif
 
+// Startup.  The initialisers that touch no widgets -- the country and QSL
+// files, the serial port scan and the flight cache -- run on their own
+// threads while the main thread builds the GUI, and each is joined just
+// before its result is used.  The CPU speed test runs alone before any of
+// them, as it would otherwise be measuring a shared CPU.  With
+// --startup-profile the time spent in every phase is printed when the main
+// window is up.
+
+struct startup_task {
+	startup_task(const char* name_, void (*run_)(void))
+		: name(name_), run(run_), started(false), secs(0.0) { }
+	const char* name;
+	void (*run)(void);
+	pthread_t thread;
+	bool started;
+	double secs;
+};
+
+static struct timespec startup_t0, startup_mark;
+static ostringstream startup_report;
+
+static double seconds_since(const struct timespec& t0)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	t -= t0;
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// main thread: the time since the previous phase ended
+static void startup_phase(const char* name)
+{
+	if (!startup_profile)
+		return;
+	startup_report << "  " << left << setw(28) << name << right
+		       << fixed << setprecision(1) << setw(9)
+		       << seconds_since(startup_mark) * 1e3 << " ms\n";
+	clock_gettime(CLOCK_MONOTONIC, &startup_mark);
+}
+
+static void* startup_thread(void* arg)
+{
+	startup_task* t = static_cast<startup_task*>(arg);
+	struct timespec t0;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	t->run();
+	t->secs = seconds_since(t0);
+
+	return NULL;
+}
+
+static void startup_start(startup_task& t)
+{
+	t.started = (pthread_create(&t.thread, NULL, startup_thread, &t) == 0);
+	if (!t.started) {
+		LOG_ERROR("Could not start %s thread, running it inline", t.name);
+		startup_thread(&t);
+	}
+}
+
+// Waits for the task; the time spent waiting is charged to the task, not to
+// the phase that follows
+static void startup_join(startup_task& t)
+{
+	struct timespec t0;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (t.started) {
+		pthread_join(t.thread, NULL);
+		t.started = false;
+	}
+	if (!startup_profile)
+		return;
+
+	double wait = seconds_since(t0);
+	startup_report << "  " << left << setw(28) << t.name << right
+		       << fixed << setprecision(1) << setw(9) << t.secs * 1e3
+		       << " ms (concurrent, waited " << wait * 1e3 << " ms)\n";
+	clock_gettime(CLOCK_MONOTONIC, &startup_mark);
+}
+
+static void startup_print(void)
+{
+	if (!startup_profile)
+		return;
+	startup_report << "  " << left << setw(28) << "total" << right
+		       << fixed << setprecision(1) << setw(9)
+		       << seconds_since(startup_t0) * 1e3 << " ms\n";
+	cerr << "Startup profile:\n" << startup_report.str();
+	LOG_INFO("Startup profile:\n%s", startup_report.str().c_str());
+}
+
+static void startup_cty(void)
+{
+	dxcc_open(string(progdefaults.cty_dat_pathname).append("cty.dat").c_str());
+}
+
+static void startup_qsl(void)
+{
+	qsl_open(string(progdefaults.cty_dat_pathname).append("lotw1.txt").c_str(), QSL_LOTW);
+	if (!qsl_open(string(progdefaults.cty_dat_pathname).append("eqsl.txt").c_str(), QSL_EQSL))
+		qsl_open(string(progdefaults.cty_dat_pathname).append("AGMemberList.txt").c_str(), QSL_EQSL);
+}
+
+static vector<string> startup_ports;
+static void startup_find_ports(void)
+{
+	configuration::findCommPorts(startup_ports);
+}
+
+static void startup_flights(void)
+{
+	dl_fldigi::flights::read_cache();
+}
+
+
 // these functions are all started after Fl::run() is executing
 void delayed_startup(void *)
 {
@@ -238,6 +358,9 @@ void delayed_startup(void *)
 
 int main(int argc, char ** argv)
 {
+	clock_gettime(CLOCK_MONOTONIC, &startup_t0);
+	startup_mark = startup_t0;
+
 	appname = argv[0];
 	string appdir;
 	string test_file_name;
@@ -345,6 +468,8 @@ int main(int argc, char ** argv)
 	checkdirectories();
 	check_nbems_dirs();
 
+	startup_phase("arguments, directories");
+
 	try {
 		debug::start(string(HomeDir).append("status_log.txt").c_str());
 		time_t t = time(NULL);
@@ -398,6 +523,8 @@ int main(int argc, char ** argv)
 	LOG_INFO("FLMSG_ICS_msg_dir: %s", FLMSG_ICS_msg_dir.c_str());
 	LOG_INFO("FLMSG_ICS_tmp_dir: %s", FLMSG_ICS_tmp_dir.c_str());
 
+	startup_phase("log");
+
 	bool have_config = progdefaults.readDefaultsXML();
 
 	xmlfname = HomeDir;
@@ -411,6 +538,8 @@ int main(int argc, char ** argv)
 
 	checkTLF();
 
+	startup_phase("configuration");
+
 
 	Fl::lock();  // start the gui thread!!
 	Fl::visual(FL_RGB); // insure 24 bit color operation
@@ -424,13 +553,7 @@ int main(int argc, char ** argv)
 	if (progdefaults.cty_dat_pathname.empty())
 		progdefaults.cty_dat_pathname = HomeDir;
 
-	dxcc_open(string(progdefaults.cty_dat_pathname).append("cty.dat").c_str());
-	qsl_open(string(progdefaults.cty_dat_pathname).append("lotw1.txt").c_str(), QSL_LOTW);
-	if (!qsl_open(string(progdefaults.cty_dat_pathname).append("eqsl.txt").c_str(), QSL_EQSL))
-		qsl_open(string(progdefaults.cty_dat_pathname).append("AGMemberList.txt").c_str(), QSL_EQSL);
-
-	progStatus.loadLastState();
-	create_fl_digi_main(argc, argv);
+	startup_phase("fonts");
 
 	if (!have_config || show_cpucheck) {
 		double speed = speed_test(SRC_SINC_FASTEST, 8);
@@ -455,11 +578,33 @@ int main(int argc, char ** argv)
 		LOG_INFO("CPU speed factor=%f: setting slowcpu=%s, sample_converter=\"%s\"", speed,
 			 progdefaults.slowcpu ? "true" : "false",
 			 src_get_name(progdefaults.sample_converter));
+		startup_phase("CPU speed test");
 	}
+
+	startup_task task_cty("cty.dat", startup_cty);
+	startup_task task_qsl("LoTW/eQSL lists", startup_qsl);
+	startup_task task_ports("serial ports", startup_find_ports);
+	startup_task task_flights("flight cache", startup_flights);
+	startup_start(task_cty);
+	startup_start(task_qsl);
+	startup_start(task_ports);
+	startup_start(task_flights);
+
+	progStatus.loadLastState();
+	startup_phase("last state");
+
+	// the main window hides the Countries menu if cty.dat isn't loaded
+	startup_join(task_cty);
+	create_fl_digi_main(argc, argv);
+	startup_phase("main window");
+	startup_join(task_qsl);
+
 	if (progdefaults.XmlRigFilename.empty())
 		progdefaults.XmlRigFilename = xmlfname;
 
 #if BENCHMARK_MODE
+	startup_join(task_ports);
+	startup_join(task_flights);
 	return setup_benchmark();
 #endif
 
@@ -476,10 +621,13 @@ int main(int argc, char ** argv)
 	populate_charset_menu();
 	set_default_charset();
 	setTabColors();
+	startup_phase("dialogs");
 
-	progdefaults.testCommPorts();
+	startup_join(task_ports);
+	progdefaults.setCommPorts(startup_ports);
 
 	macros.loadDefault();
+	startup_phase("macros");
 
 #if USE_HAMLIB
 	xcvr = new Rig();
@@ -489,11 +637,15 @@ int main(int argc, char ** argv)
 
 	progdefaults.setDefaults();
 
+	startup_phase("rig, ptt");
+
 	atexit(sound_close);
 	sound_init();
+	startup_phase("sound");
 
 	progdefaults.initInterface();
 	trx_start();
+	startup_phase("interface, trx");
 
 #if SHOW_WIZARD_BEFORE_MAIN_WINDOW
 	if (!have_config) {
@@ -504,9 +656,11 @@ int main(int argc, char ** argv)
 	}
 #endif
 
-	dlgViewer = createViewer();
+	// The channel viewer and the mode browser are created when they are
+	// first opened
 	create_logbook_dialogs();
 	LOGBOOK_colors_font();
+	startup_phase("logbook dialogs");
 
 // OS X will prevent the main window from being resized if we change its
 // size *after* it has been shown. With some X11 window managers, OTOH,
@@ -524,8 +678,7 @@ int main(int argc, char ** argv)
 		for (Fl_Window* w = Fl::first_window(); w; w = Fl::next_window(w))
 			w->iconize();
 	update_main_title();
-
-	mode_browser = new Mode_Browser;
+	startup_phase("show");
 
 #if !SHOW_WIZARD_BEFORE_MAIN_WINDOW
 	if (!have_config)
@@ -534,7 +687,10 @@ int main(int argc, char ** argv)
 
 	Fl::add_timeout(.05, delayed_startup);
 
+	startup_join(task_flights);
 	dl_fldigi::ready(bHAB);
+	startup_phase("dl-fldigi");
+	startup_print();
 
 	int ret = Fl::run();
 
@@ -673,6 +829,26 @@ void generate_option_help(void) {
 	     << "  --benchmark-src-type TYPE\n"
 	     << "    Specify the sample rate conversion type\n"
 	     << "    Default: " << benchmark.src_type << " (" << src_get_name(benchmark.src_type) << ")\n\n"
+	     << "  --benchmark-corpus SETS\n"
+	     << "    Generate and decode the reference signal corpus instead of the input\n"
+	     << "    A comma separated list of rtty, ssdv, dominoex, hell, or all\n\n"
+	     << "  --benchmark-snr MIN:MAX:STEP\n"
+	     << "    Specify the corpus SNRs in dB, in 2500 Hz; or a comma separated list\n"
+	     << "    Default: " << benchmark.snr << "\n\n"
+	     << "  --benchmark-drift LIST\n"
+	     << "    Specify the corpus frequency drifts in Hz per minute\n"
+	     << "    Default: " << benchmark.drift << "\n\n"
+	     << "  --benchmark-clock LIST\n"
+	     << "    Specify the corpus transmitter clock errors in ppm\n"
+	     << "    Default: " << benchmark.clock << "\n\n"
+	     << "  --benchmark-jobs N\n"
+	     << "    Decode the corpus in N processes\n"
+	     << "    Default: 0 (one per processor)\n\n"
+#  if USE_SNDFILE
+	     << "  --benchmark-corpus-dir DIR\n"
+	     << "    Also save the corpus signals in DIR\n"
+	     << "    Default: the signals are not saved\n\n"
+#  endif
 #endif
 
 	     << "  --cpu-speed-test\n"
@@ -697,6 +873,9 @@ void generate_option_help(void) {
 	     << "  --debug-level LEVEL\n"
 	     << "    Set the event log verbosity\n\n"
 
+	     << "  --startup-profile\n"
+	     << "    Print the time taken by each phase of the startup\n\n"
+
 	     << "  --version\n"
 	     << "    Print version information\n\n"
 
@@ -791,6 +970,8 @@ int parse_args(int argc, char **argv, int& idx)
 	       OPT_BENCHMARK_MODEM, OPT_BENCHMARK_AFC, OPT_BENCHMARK_SQL, OPT_BENCHMARK_SQLEVEL,
 	       OPT_BENCHMARK_FREQ, OPT_BENCHMARK_INPUT, OPT_BENCHMARK_OUTPUT,
 	       OPT_BENCHMARK_SRC_RATIO, OPT_BENCHMARK_SRC_TYPE,
+	       OPT_BENCHMARK_CORPUS, OPT_BENCHMARK_SNR, OPT_BENCHMARK_DRIFT, OPT_BENCHMARK_CLOCK,
+	       OPT_BENCHMARK_JOBS, OPT_BENCHMARK_CORPUS_DIR,
 #endif
 
                OPT_FONT, OPT_WFALL_HEIGHT,
@@ -799,7 +980,7 @@ int parse_args(int argc, char **argv, int& idx)
 #if USE_PORTAUDIO
                OPT_FRAMES_PER_BUFFER,
 #endif
-	       OPT_NOISE, OPT_DEBUG_LEVEL,
+	       OPT_NOISE, OPT_DEBUG_LEVEL, OPT_STARTUP_PROFILE,
                OPT_EXIT_AFTER,
                OPT_DEPRECATED, OPT_HELP, OPT_VERSION, OPT_BUILD_INFO };
 
@@ -837,6 +1018,12 @@ int parse_args(int argc, char **argv, int& idx)
 		{ "benchmark-output", 1, 0, OPT_BENCHMARK_OUTPUT },
 		{ "benchmark-src-ratio", 1, 0, OPT_BENCHMARK_SRC_RATIO },
 		{ "benchmark-src-type", 1, 0, OPT_BENCHMARK_SRC_TYPE },
+		{ "benchmark-corpus", 1, 0, OPT_BENCHMARK_CORPUS },
+		{ "benchmark-snr", 1, 0, OPT_BENCHMARK_SNR },
+		{ "benchmark-drift", 1, 0, OPT_BENCHMARK_DRIFT },
+		{ "benchmark-clock", 1, 0, OPT_BENCHMARK_CLOCK },
+		{ "benchmark-jobs", 1, 0, OPT_BENCHMARK_JOBS },
+		{ "benchmark-corpus-dir", 1, 0, OPT_BENCHMARK_CORPUS_DIR },
 #endif
 
 		{ "font",	   1, 0, OPT_FONT },
@@ -855,6 +1042,7 @@ int parse_args(int argc, char **argv, int& idx)
 
 		{ "noise", 0, 0, OPT_NOISE },
 		{ "debug-level",   1, 0, OPT_DEBUG_LEVEL },
+		{ "startup-profile", 0, 0, OPT_STARTUP_PROFILE },
 
 		{ "help",	   0, 0, OPT_HELP },
 		{ "version",	   0, 0, OPT_VERSION },
@@ -1002,6 +1190,30 @@ int parse_args(int argc, char **argv, int& idx)
 		case OPT_BENCHMARK_SRC_TYPE:
 			benchmark.src_type = strtol(optarg, NULL, 10);
 			break;
+
+		case OPT_BENCHMARK_CORPUS:
+			benchmark.corpus = optarg;
+			break;
+
+		case OPT_BENCHMARK_SNR:
+			benchmark.snr = optarg;
+			break;
+
+		case OPT_BENCHMARK_DRIFT:
+			benchmark.drift = optarg;
+			break;
+
+		case OPT_BENCHMARK_CLOCK:
+			benchmark.clock = optarg;
+			break;
+
+		case OPT_BENCHMARK_JOBS:
+			benchmark.jobs = strtol(optarg, NULL, 10);
+			break;
+
+		case OPT_BENCHMARK_CORPUS_DIR:
+			benchmark.corpus_dir = optarg;
+			break;
 #endif
 
 		case OPT_FONT:
@@ -1061,6 +1273,10 @@ int parse_args(int argc, char **argv, int& idx)
 		}
 			break;
 
+		case OPT_STARTUP_PROFILE:
+			startup_profile = true;
+			break;
+
 		case OPT_DEPRECATED:
 			cerr << "W: the --" << longopts[longindex].name
 			     << " option has been deprecated and will be removed in a future version\n";
@@ -51,17 +51,23 @@
 #include "debug.h"
 
 #include "benchmark.h"
+#include "corpus.h"
 
 using namespace std;
 
-struct benchmark_params benchmark = { MODE_PSK31, 1000, false, false, 0.0, 1.0, SRC_SINC_FASTEST };
+struct benchmark_params benchmark = { MODE_PSK31, 1000, false, false, 0.0, 1.0, SRC_SINC_FASTEST,
+				      "", "", "", 0, "", "-9:12:3", "0", "0", "", 0 };
 
 
 int setup_benchmark(void)
 {
 	ENSURE_THREAD(FLMAIN_TID);
 
-	if (benchmark.input.empty()) {
+	if (!benchmark.corpus.empty()) {
+		if (setup_corpus())
+			return 1;
+	}
+	else if (benchmark.input.empty()) {
 		LOG_ERROR("Missing input");
 		return 1;
 	}
@@ -114,6 +120,11 @@ void do_benchmark(void)
 {
 	ENSURE_THREAD(TRX_TID);
 
+	if (!benchmark.corpus.empty()) {
+		do_corpus();
+		return;
+	}
+
 	if (benchmark.src_ratio != 1.0)
 		LOG_INFO("modem=%" PRIdPTR " (%s) rate=%d ratio=%f converter=%d (\"%s\")",
 			 active_modem->get_mode(), mode_info[active_modem->get_mode()].sname,
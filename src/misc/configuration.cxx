@@ -901,15 +901,10 @@ static bool open_serial(const char* dev)
 }
 #endif // __WOE32__
 
-void configuration::testCommPorts()
+// Lists the serial ports.  This touches no widgets and may be called from
+// any thread.
+void configuration::findCommPorts(vector<string>& ports)
 {
-	int retval;
-
-	inpTTYdev->clear();
-	inpRIGdev->clear();
-	inpXmlRigDevice->clear();
-	inpGPSdev->clear();
-
 #ifndef PATH_MAX
 #  define PATH_MAX 1024
 #endif
@@ -922,44 +917,34 @@ void configuration::testCommPorts()
 #endif
 
 #ifdef __linux__
-	bool ret = false;
-	DIR* sys = NULL;
-	char cwd[PATH_MAX] = { '.', '\0' };
-	if (getcwd(cwd, sizeof(cwd)) == NULL || chdir("/sys/class/tty") == -1 ||
-	    (sys = opendir(".")) == NULL)
-		goto out;
-
-	ssize_t len;
-	struct dirent* dp;
-	while ((dp = readdir(sys))) {
+	// Absolute paths rather than chdir(), which would move the working
+	// directory of every other thread as well
+	DIR* sys = opendir("/sys/class/tty");
+	if (sys) {
+		ssize_t len;
+		struct dirent* dp;
+		char link[PATH_MAX + 1];
+		while ((dp = readdir(sys))) {
 #  ifdef _DIRENT_HAVE_D_TYPE
-		if (dp->d_type != DT_LNK)
-			continue;
+			if (dp->d_type != DT_LNK)
+				continue;
 #  endif
-		if ((len = readlink(dp->d_name, ttyname, sizeof(ttyname)-1)) == -1)
-			continue;
-		ttyname[len] = '\0';
-		if (!strstr(ttyname, "/devices/virtual/")) {
-			snprintf(ttyname, sizeof(ttyname), "/dev/%s", dp->d_name);
-			if (stat(ttyname, &st) == -1 || !S_ISCHR(st.st_mode))
+			snprintf(link, sizeof(link), "/sys/class/tty/%s", dp->d_name);
+			if ((len = readlink(link, ttyname, sizeof(ttyname)-1)) == -1)
 				continue;
-			LOG_INFO("Found serial port %s", ttyname);
-			inpTTYdev->add(ttyname);
-#if USE_HAMLIB
-			inpRIGdev->add(ttyname);
-#endif
-			inpXmlRigDevice->add(ttyname);
-			inpGPSdev->add(ttyname);
+			ttyname[len] = '\0';
+			if (!strstr(ttyname, "/devices/virtual/")) {
+				snprintf(ttyname, sizeof(ttyname), "/dev/%s", dp->d_name);
+				if (stat(ttyname, &st) == -1 || !S_ISCHR(st.st_mode))
+					continue;
+				LOG_INFO("Found serial port %s", ttyname);
+				ports.push_back(ttyname);
+			}
 		}
-	}
-	ret = true;
-
-out:
-	if (sys)
 		closedir(sys);
-	retval = chdir(cwd);
-	if (ret) // do we need to fall back to the probe code below?
 		return;
+	}
+	// otherwise fall back to the probe code below
 #endif // __linux__
 
 	// TODO: will the mingw probing work for cygwin too?
@@ -1011,13 +996,7 @@ out:
 #  endif // __WOE32__
 
 			LOG_INFO("Found serial port %s", ttyname);
-			inpTTYdev->add(ttyname);
-#  if USE_HAMLIB
-			inpRIGdev->add(ttyname);
-#  endif
-			inpXmlRigDevice->add(ttyname);
-
-			inpGPSdev->add(ttyname);
+			ports.push_back(ttyname);
 		}
 #else // __APPLE__
 		glob(tty_fmt[i], 0, NULL, &gbuf);
@@ -1026,18 +1005,39 @@ out:
 			     strstr(gbuf.gl_pathv[j], "modem") )
 				continue;
 			LOG_INFO("Found serial port %s", gbuf.gl_pathv[j]);
-			inpTTYdev->add(gbuf.gl_pathv[j]);
-#  if USE_HAMLIB
-			inpRIGdev->add(gbuf.gl_pathv[j]);
-#  endif
-			inpXmlRigDevice->add(gbuf.gl_pathv[j]);
-			inpGPSdev->add(gbuf.gl_pathv[j]);
+			ports.push_back(gbuf.gl_pathv[j]);
 		}
 		globfree(&gbuf);
 #endif // __APPLE__
 	}
+}
+
+void configuration::testCommPorts()
+{
+	vector<string> ports;
+	findCommPorts(ports);
+	setCommPorts(ports);
+}
+
+// Fills the device choosers with the ports found by findCommPorts
+void configuration::setCommPorts(const vector<string>& ports)
+{
+	inpTTYdev->clear();
+	inpRIGdev->clear();
+	inpXmlRigDevice->clear();
+	inpGPSdev->clear();
+
+	for (vector<string>::const_iterator i = ports.begin(); i != ports.end(); ++i) {
+		inpTTYdev->add(i->c_str());
+#if USE_HAMLIB
+		inpRIGdev->add(i->c_str());
+#endif
+		inpXmlRigDevice->add(i->c_str());
+		inpGPSdev->add(i->c_str());
+	}
 
 #if HAVE_UHROUTER
+	struct stat st;
 	if (stat(UHROUTER_FIFO_PREFIX "Read", &st) != -1 && S_ISFIFO(st.st_mode) &&
 	    stat(UHROUTER_FIFO_PREFIX "Write", &st) != -1 && S_ISFIFO(st.st_mode))
 		inpTTYdev->add(UHROUTER_FIFO_PREFIX);
@@ -0,0 +1,764 @@
+// ----------------------------------------------------------------------------
+// corpus.cxx  --  reference signal corpus for the benchmark mode
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include <string>
+#include <vector>
+#include <set>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <cerrno>
+
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#ifndef __MINGW32__
+#  include <sys/resource.h>
+#  include <sys/wait.h>
+#else
+#  include "compat.h"
+#endif
+
+#if USE_SNDFILE
+#  include <sndfile.h>
+#endif
+
+#include "fl_digi.h"
+#include "sound.h"
+#include "modem.h"
+#include "rtty.h"
+#include "dominoex.h"
+#include "feld.h"
+#include "trx.h"
+#include "ssdv.h"
+#include "rs8.h"
+#include "timeops.h"
+#include "configuration.h"
+#include "status.h"
+#include "threads.h"
+#include "debug.h"
+
+#include "benchmark.h"
+#include "corpus.h"
+
+using namespace std;
+
+#define CORPUS_SENTENCES 3      // telemetry sentences per case
+#define CORPUS_PACKETS 4        // SSDV packets per case
+#define CORPUS_NOISE_BW 2500.0  // the SNR is measured in this bandwidth, Hz
+#define CORPUS_MAX_SECS 600     // a transmitter that runs for longer is stuck
+
+enum { CORPUS_RTTY = 1 << 0, CORPUS_SSDV = 1 << 1, CORPUS_DOMINOEX = 1 << 2, CORPUS_HELL = 1 << 3 };
+
+struct corpus_signal {
+	int set;
+	trx_mode mode;
+	double baud, shift;
+	int bits;
+	const char* name;  // for the report
+	const char* tag;   // for file names
+};
+
+// The RTTY settings in use by habitat payloads, 2 stop bits and no parity
+static const corpus_signal signals[] = {
+	{ CORPUS_RTTY, MODE_RTTY, 50, 425, 7, "RTTY 50/425 7N2", "rtty-50-425-7n2" },
+	{ CORPUS_RTTY, MODE_RTTY, 50, 425, 8, "RTTY 50/425 8N2", "rtty-50-425-8n2" },
+	{ CORPUS_RTTY, MODE_RTTY, 50, 470, 7, "RTTY 50/470 7N2", "rtty-50-470-7n2" },
+	{ CORPUS_RTTY, MODE_RTTY, 50, 470, 8, "RTTY 50/470 8N2", "rtty-50-470-8n2" },
+	{ CORPUS_RTTY, MODE_RTTY, 100, 425, 8, "RTTY 100/425 8N2", "rtty-100-425-8n2" },
+	{ CORPUS_RTTY, MODE_RTTY, 300, 600, 8, "RTTY 300/600 8N2", "rtty-300-600-8n2" },
+	{ CORPUS_SSDV, MODE_RTTY, 300, 600, 8, "SSDV 300/600 8N2", "ssdv-300-600-8n2" },
+	{ CORPUS_SSDV, MODE_RTTY, 600, 1000, 8, "SSDV 600/1000 8N2", "ssdv-600-1000-8n2" },
+	{ CORPUS_DOMINOEX, MODE_DOMINOEX8, 0, 0, 0, "DominoEX 8", "dominoex8" },
+	{ CORPUS_DOMINOEX, MODE_DOMINOEX16, 0, 0, 0, "DominoEX 16", "dominoex16" },
+	{ CORPUS_HELL, MODE_FELDHELL, 0, 0, 0, "Feld Hell", "feldhell" }
+};
+
+static const struct {
+	const char* name;
+	int set;
+} set_names[] = {
+	{ "rtty", CORPUS_RTTY }, { "ssdv", CORPUS_SSDV }, { "dominoex", CORPUS_DOMINOEX },
+	{ "hell", CORPUS_HELL }, { "all", ~0 }
+};
+
+struct corpus_case {
+	const corpus_signal* sig;
+	double snr;    // dB in CORPUS_NOISE_BW
+	double drift;  // Hz per minute
+	double clock;  // transmitter sample clock error, ppm
+	uint32_t seed;
+};
+
+// Sent from the worker processes as it is
+struct corpus_result {
+	double cer;     // character (SSDV: byte) error rate, < 0 if not measured
+	int ok, total;  // sentences or packets recovered
+	double audio;   // seconds of audio decoded
+	double cpu;     // seconds of cpu time spent decoding it
+	int failed;
+};
+
+static vector<corpus_case> cases;
+
+// modem hooks
+static string tx_text;
+static size_t tx_pos;
+static string rx_text, rx_bytes;
+
+int corpus_get_tx_char(void)
+{
+	if (tx_pos < tx_text.length())
+		return (unsigned char)tx_text[tx_pos++];
+	return GET_TX_CHAR_ETX;
+}
+
+void corpus_put_rx_char(unsigned int data)
+{
+	rx_text += (char)data;
+}
+
+void corpus_put_rx_byte(unsigned int data)
+{
+	rx_bytes += (char)data;
+}
+
+// ----------------------------------------------------------------------------
+// The cases
+
+static bool parse_list(const string& s, vector<double>& v)
+{
+	const char* p = s.c_str();
+	char* end;
+
+	v.clear();
+	for (;;) {
+		v.push_back(strtod(p, &end));
+		if (end == p)
+			return false;
+		if (*end == '\0')
+			return true;
+		if (*end != ',')
+			return false;
+		p = end + 1;
+	}
+}
+
+// MIN:MAX:STEP, or a list
+static bool parse_range(const string& s, vector<double>& v)
+{
+	double min, max, step;
+	char c;
+
+	if (s.find(':') == string::npos)
+		return parse_list(s, v);
+	if (sscanf(s.c_str(), "%lf:%lf:%lf%c", &min, &max, &step, &c) != 3 || step <= 0.0 || min > max)
+		return false;
+
+	v.clear();
+	for (int i = 0; min + i * step <= max + step / 1e3; i++)
+		v.push_back(min + i * step);
+	return true;
+}
+
+// FNV-1a, so that a case gets the same signal whatever else is in the run
+static uint32_t case_seed(const corpus_signal& sig, double snr, double drift, double clock)
+{
+	char s[128];
+	snprintf(s, sizeof(s), "%s %g %g %g", sig.tag, snr, drift, clock);
+
+	uint32_t h = 2166136261U;
+	for (const char* p = s; *p; p++) {
+		h ^= (unsigned char)*p;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+int setup_corpus(void)
+{
+	ENSURE_THREAD(FLMAIN_TID);
+
+	int set = 0;
+	string::size_type i = 0, j;
+	do {
+		j = benchmark.corpus.find(',', i);
+		string name = benchmark.corpus.substr(i, j == string::npos ? j : j - i);
+		size_t k;
+		for (k = 0; k < sizeof(set_names)/sizeof(*set_names); k++)
+			if (name == set_names[k].name)
+				break;
+		if (k == sizeof(set_names)/sizeof(*set_names)) {
+			LOG_ERROR("Unknown corpus set \"%s\"", name.c_str());
+			return 1;
+		}
+		set |= set_names[k].set;
+		i = j + 1;
+	} while (j != string::npos);
+
+	vector<double> snrs, drifts, clocks;
+	if (!parse_range(benchmark.snr, snrs)) {
+		LOG_ERROR("Bad SNR range \"%s\"", benchmark.snr.c_str());
+		return 1;
+	}
+	if (!parse_list(benchmark.drift, drifts)) {
+		LOG_ERROR("Bad drift list \"%s\"", benchmark.drift.c_str());
+		return 1;
+	}
+	if (!parse_list(benchmark.clock, clocks)) {
+		LOG_ERROR("Bad clock error list \"%s\"", benchmark.clock.c_str());
+		return 1;
+	}
+	if (benchmark.jobs < 0) {
+		LOG_ERROR("Bad number of jobs %d", benchmark.jobs);
+		return 1;
+	}
+#if USE_SNDFILE
+	if (!benchmark.corpus_dir.empty() && access(benchmark.corpus_dir.c_str(), W_OK) == -1) {
+		LOG_PERROR(benchmark.corpus_dir.c_str());
+		return 1;
+	}
+#endif
+
+	// the report groups the cases by signal, drift and clock error, in
+	// order of SNR
+	cases.clear();
+	for (size_t s = 0; s < sizeof(signals)/sizeof(*signals); s++) {
+		if (!(signals[s].set & set))
+			continue;
+		for (size_t d = 0; d < drifts.size(); d++) {
+			for (size_t c = 0; c < clocks.size(); c++) {
+				for (size_t n = 0; n < snrs.size(); n++) {
+					corpus_case cc = { &signals[s], snrs[n], drifts[d], clocks[c],
+							   case_seed(signals[s], snrs[n], drifts[d], clocks[c]) };
+					cases.push_back(cc);
+				}
+			}
+		}
+	}
+
+	// nothing but the modem in the signal
+	progdefaults.CWid = false;
+	progdefaults.macroCWid = false;
+	progdefaults.sendid = false;
+	progdefaults.sendtextid = false;
+	progdefaults.pretone = 0;
+	progdefaults.noise = false;
+	progdefaults.viewXmtSignal = false;
+	progdefaults.PTTrightchannel = false;
+	progdefaults.TxOffset = 0;
+	progdefaults.rx_lowercase = false;
+
+	LOG_INFO("%u corpus cases", (unsigned)cases.size());
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Signal generation
+
+class corpus_rng
+{
+public:
+	corpus_rng(uint32_t seed) : s(seed ? seed : 0x9e3779b9U) { }
+	uint32_t next(void)
+	{
+		s ^= s << 13;
+		s ^= s >> 17;
+		s ^= s << 5;
+		return s;
+	}
+	// [0, 1)
+	double uniform(void) { return (next() >> 8) / 16777216.0; }
+	double gauss(void)
+	{
+		double u = ((next() >> 8) + 1) / 16777216.0;
+		return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * uniform());
+	}
+private:
+	uint32_t s;
+};
+
+// Captures the transmitter output
+class SoundCapture : public SoundBase
+{
+public:
+	vector<double> buf;
+
+	int	Open(int mode, int freq) { return 0; }
+	void	Close(unsigned dir) { }
+	void	Abort(unsigned dir) { }
+	size_t	Write(double* b, size_t count) { buf.insert(buf.end(), b, b + count); return count; }
+	size_t	Write_stereo(double* l, double* r, size_t count) { return Write(l, count); }
+	size_t	Read(float* b, size_t count) { return 0; }
+	void	flush(unsigned dir) { }
+	bool	must_close(int dir) { return false; }
+};
+
+// CRC16-CCITT, as in UKHAS sentences
+static unsigned crc16(const char* s)
+{
+	unsigned crc = 0xFFFF;
+	for (; *s; s++) {
+		crc ^= (unsigned char)*s << 8;
+		for (int i = 0; i < 8; i++)
+			crc = crc & 0x8000 ? ((crc << 1) ^ 0x1021) & 0xFFFF : (crc << 1) & 0xFFFF;
+	}
+	return crc;
+}
+
+static void make_sentences(string& text, vector<string>& lines, corpus_rng& rng)
+{
+	char body[128], line[160];
+	unsigned t = rng.next() % 86400;
+
+	text = "\n";
+	for (int i = 0; i < CORPUS_SENTENCES; i++, t += 10) {
+		snprintf(body, sizeof(body), "CORPUS,%d,%02u:%02u:%02u,%.5f,%.5f,%u,%d", i + 1,
+			 t / 3600 % 24, t / 60 % 60, t % 60,
+			 50.0 + rng.uniform(), -1.0 + 2.0 * rng.uniform(),
+			 (unsigned)(rng.next() % 40000), (int)(rng.next() % 60) - 40);
+		snprintf(line, sizeof(line), "$$%s*%04X", body, crc16(body));
+		lines.push_back(line);
+		text += line;
+		text += '\n';
+	}
+}
+
+// the CRC-32 of ssdv.c
+static uint32_t ssdv_crc32(const uint8_t* d, size_t len)
+{
+	uint32_t crc = 0xFFFFFFFF, x;
+	for (; len; len--) {
+		x = (crc ^ *d++) & 0xFF;
+		for (int i = 0; i < 8; i++)
+			x = x & 1 ? (x >> 1) ^ 0xEDB88320 : x >> 1;
+		crc = (crc >> 8) ^ x;
+	}
+	return crc ^ 0xFFFFFFFF;
+}
+
+// Valid SSDV packets with a random payload and no image data
+static void make_packets(string& data, corpus_rng& rng, unsigned image)
+{
+	uint8_t pkt[SSDV_PKT_SIZE];
+
+	data.clear();
+	for (unsigned n = 0; n < CORPUS_PACKETS; n++) {
+		pkt[0] = 0x55;                  // sync
+		pkt[1] = 0x66;                  // type
+		pkt[2] = pkt[3] = pkt[4] = 0;   // callsign
+		pkt[5] = 1;
+		pkt[6] = image & 0xFF;
+		pkt[7] = n >> 8;                // packet ID
+		pkt[8] = n & 0xFF;
+		pkt[9] = 320 >> 4;              // width / 16
+		pkt[10] = 240 >> 4;             // height / 16
+		pkt[11] = 0;                    // MCU mode
+		pkt[12] = 0xFF;                 // no MCU in this packet
+		pkt[13] = pkt[14] = 0xFF;
+		for (int i = SSDV_PKT_SIZE_HEADER; i < SSDV_PKT_SIZE_HEADER + SSDV_PKT_SIZE_PAYLOAD; i++)
+			pkt[i] = rng.next() >> 24;
+
+		uint32_t crc = ssdv_crc32(&pkt[1], SSDV_PKT_SIZE_CRCDATA);
+		int i = 1 + SSDV_PKT_SIZE_CRCDATA;
+		pkt[i++] = crc >> 24;
+		pkt[i++] = crc >> 16;
+		pkt[i++] = crc >> 8;
+		pkt[i++] = crc;
+		encode_rs_8(&pkt[1], &pkt[i], 0);
+
+		data.append(reinterpret_cast<const char*>(pkt), SSDV_PKT_SIZE);
+	}
+}
+
+static modem* make_modem(const corpus_signal& sig)
+{
+	if (sig.mode == MODE_RTTY) {
+		int i;
+		for (i = 0; rtty::BAUD[i] != 0 && rtty::BAUD[i] != sig.baud; i++)
+			;
+		progdefaults.rtty_baud = i;
+		for (i = 0; rtty::SHIFT[i] != 0 && rtty::SHIFT[i] != sig.shift; i++)
+			;
+		if (rtty::SHIFT[i] != 0)
+			progdefaults.rtty_shift = i;
+		else {
+			progdefaults.rtty_shift = -1;
+			progdefaults.rtty_custom_shift = (int)sig.shift;
+		}
+		progdefaults.rtty_bits = (sig.bits == 5 ? 0 : sig.bits == 7 ? 1 : 2);
+		progdefaults.rtty_parity = 0;
+		progdefaults.rtty_stop = 2;
+		progdefaults.rtty_autocrlf = false;
+		return new rtty(sig.mode);
+	}
+	else if (sig.mode == MODE_FELDHELL)
+		return new feld(sig.mode);
+	else
+		return new dominoex(sig.mode);
+}
+
+// Runs the transmitter, drifting its frequency as it goes
+static bool generate(modem* m, const corpus_case& c, SoundCapture& out)
+{
+	double f0 = m->get_freq();
+	size_t sr = m->get_samplerate();
+
+	tx_pos = 0;
+	m->tx_init(&out);
+	while (m->tx_process() >= 0) {
+		if (out.buf.size() > sr * CORPUS_MAX_SECS)
+			return false;
+		if (c.drift != 0.0)
+			m->set_freq(f0 + c.drift * out.buf.size() / sr / 60.0);
+	}
+	m->set_freq(f0);
+
+	return true;
+}
+
+// Resamples for the clock error, adds a random lead-in, and adds white noise
+// for the SNR
+static void impair(vector<double>& sig, int sr, const corpus_case& c, corpus_rng& rng)
+{
+	if (sig.empty())
+		return;
+
+	if (c.clock != 0.0) {
+		double ratio = 1.0 + c.clock * 1e-6;
+		vector<float> in(sig.begin(), sig.end()), out((size_t)(sig.size() * ratio) + 64);
+		SRC_DATA src;
+		memset(&src, 0, sizeof(src));
+		src.data_in = &in[0];
+		src.input_frames = in.size();
+		src.data_out = &out[0];
+		src.output_frames = out.size();
+		src.src_ratio = ratio;
+		if (src_simple(&src, SRC_SINC_FASTEST, 1) == 0)
+			sig.assign(out.begin(), out.begin() + src.output_frames_gen);
+	}
+
+	double power = 0.0;
+	for (size_t i = 0; i < sig.size(); i++)
+		power += sig[i] * sig[i];
+	power /= sig.size();
+
+	sig.insert(sig.begin(), (size_t)(sr * (0.5 + rng.uniform())), 0.0);
+	sig.insert(sig.end(), sr, 0.0);
+
+	double sigma = sqrt(power / pow(10.0, c.snr / 10.0) * (sr / 2.0) / CORPUS_NOISE_BW);
+	for (size_t i = 0; i < sig.size(); i++)
+		sig[i] += sigma * rng.gauss();
+}
+
+#if USE_SNDFILE
+static void save_signal(const corpus_case& c, const vector<double>& sig, int sr)
+{
+	char name[128];
+	snprintf(name, sizeof(name), "%s_snr%+.1f_drift%+g_clock%+g.wav",
+		 c.sig->tag, c.snr, c.drift, c.clock);
+	string path = benchmark.corpus_dir;
+	if (*path.rbegin() != '/')
+		path += '/';
+	path += name;
+
+	SF_INFO info;
+	memset(&info, 0, sizeof(info));
+	info.samplerate = sr;
+	info.channels = 1;
+	info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+	SNDFILE* f = sf_open(path.c_str(), SFM_WRITE, &info);
+	if (f) {
+		sf_write_double(f, &sig[0], sig.size());
+		sf_close(f);
+	}
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Scoring
+
+static string printable(const string& s)
+{
+	string p;
+	for (size_t i = 0; i < s.length(); i++)
+		if (s[i] == '\n' || (s[i] >= ' ' && s[i] < 127))
+			p += s[i];
+	return p;
+}
+
+// Levenshtein
+static size_t edit_distance(const string& a, const string& b)
+{
+	vector<size_t> prev(b.length() + 1), cur(b.length() + 1);
+
+	for (size_t j = 0; j <= b.length(); j++)
+		prev[j] = j;
+	for (size_t i = 1; i <= a.length(); i++) {
+		cur[0] = i;
+		for (size_t j = 1; j <= b.length(); j++)
+			cur[j] = min(min(prev[j], cur[j - 1]) + 1, prev[j - 1] + (a[i - 1] != b[j - 1]));
+		prev.swap(cur);
+	}
+	return prev[b.length()];
+}
+
+static int count_packets(const string& bytes)
+{
+	set<unsigned> ids;
+	uint8_t pkt[SSDV_PKT_SIZE];
+	int errors;
+
+	for (size_t i = 0; i + SSDV_PKT_SIZE <= bytes.length(); i++) {
+		if (bytes[i] != 0x55 || bytes[i + 1] != 0x66)
+			continue;
+		memcpy(pkt, bytes.data() + i, SSDV_PKT_SIZE);
+		if (ssdv_dec_is_packet(pkt, &errors, NULL) == 0) {
+			ids.insert((pkt[7] << 8) | pkt[8]);
+			i += SSDV_PKT_SIZE - 1;
+		}
+	}
+	return ids.size();
+}
+
+static void run_case(const corpus_case& c, corpus_result& r)
+{
+	memset(&r, 0, sizeof(r));
+	r.cer = -1.0;
+
+	corpus_rng rng(c.seed);
+	vector<string> lines;
+	if (c.sig->set == CORPUS_SSDV)
+		make_packets(tx_text, rng, c.seed);
+	else
+		make_sentences(tx_text, lines, rng);
+
+	progStatus.carrier = benchmark.freq;
+	modem* m = make_modem(*c.sig);
+	modem* old_modem = active_modem;
+	active_modem = m;
+	m->init();
+
+	SoundCapture out;
+	if (!generate(m, c, out)) {
+		r.failed = 1;
+		active_modem = old_modem;
+		delete m;
+		return;
+	}
+	vector<double>& sig = out.buf;
+	int sr = m->get_samplerate();
+	impair(sig, sr, c, rng);
+#if USE_SNDFILE
+	if (!benchmark.corpus_dir.empty())
+		save_signal(c, sig, sr);
+#endif
+
+	rx_text.clear();
+	rx_bytes.clear();
+	m->rx_init();
+
+	struct rusage ru[2];
+	getrusage(RUSAGE_SELF, &ru[0]);
+	for (size_t i = 0; i < sig.size(); i += SCBLOCKSIZE)
+		m->rx_process(&sig[i], min(sig.size() - i, (size_t)SCBLOCKSIZE));
+	getrusage(RUSAGE_SELF, &ru[1]);
+	ru[1].ru_utime -= ru[0].ru_utime;
+
+	r.audio = (double)sig.size() / sr;
+	r.cpu = ru[1].ru_utime.tv_sec + ru[1].ru_utime.tv_usec / 1e6;
+
+	switch (c.sig->set) {
+	case CORPUS_SSDV:
+		r.cer = (double)edit_distance(tx_text, rx_bytes) / tx_text.length();
+		r.ok = count_packets(rx_bytes);
+		r.total = CORPUS_PACKETS;
+		break;
+	case CORPUS_HELL: // the receiver draws, it does not decode
+		break;
+	default:
+	{
+		string sent = printable(tx_text), rcvd = printable(rx_text);
+		r.cer = (double)edit_distance(sent, rcvd) / sent.length();
+		for (size_t i = 0; i < lines.size(); i++)
+			if (rcvd.find(lines[i]) != string::npos)
+				r.ok++;
+		r.total = lines.size();
+	}
+	}
+
+	active_modem = old_modem;
+	delete m;
+}
+
+// ----------------------------------------------------------------------------
+
+#ifndef __WOE32__
+static bool read_result(int fd, corpus_result& r)
+{
+	char* p = reinterpret_cast<char*>(&r);
+	size_t n = sizeof(r);
+	while (n) {
+		ssize_t k = read(fd, p, n);
+		if (k == -1 && errno == EINTR)
+			continue;
+		if (k <= 0)
+			return false;
+		p += k;
+		n -= k;
+	}
+	return true;
+}
+
+// Worker j runs cases j, j + jobs, j + 2 * jobs...  The modems are not
+// reentrant, so the workers are processes.  Returns the number started.
+static int run_workers(int jobs, vector<corpus_result>& results)
+{
+	vector<pid_t> pids;
+	vector<int> fds;
+
+	for (int j = 0; j < jobs; j++) {
+		int pfd[2];
+		if (pipe(pfd) == -1) {
+			LOG_PERROR("pipe");
+			break;
+		}
+		pid_t pid = fork();
+		if (pid == -1) {
+			LOG_PERROR("fork");
+			close(pfd[0]);
+			close(pfd[1]);
+			break;
+		}
+		if (pid == 0) {
+			close(pfd[0]);
+			for (size_t i = j; i < cases.size(); i += jobs) {
+				corpus_result r;
+				run_case(cases[i], r);
+				if (write(pfd[1], &r, sizeof(r)) != sizeof(r))
+					_exit(EXIT_FAILURE);
+			}
+			_exit(EXIT_SUCCESS);
+		}
+		close(pfd[1]);
+		pids.push_back(pid);
+		fds.push_back(pfd[0]);
+	}
+
+	for (size_t j = 0; j < fds.size(); j++) {
+		for (size_t i = j; i < cases.size(); i += jobs) {
+			if (!read_result(fds[j], results[i])) {
+				memset(&results[i], 0, sizeof(results[i]));
+				results[i].failed = 1;
+			}
+		}
+		close(fds[j]);
+		waitpid(pids[j], NULL, 0);
+	}
+
+	return fds.size();
+}
+#endif
+
+static void report(const string& line)
+{
+	LOG_INFO("%s", line.c_str());
+	if (!benchmark.output.empty()) {
+		benchmark.buffer += line;
+		benchmark.buffer += '\n';
+	}
+}
+
+void do_corpus(void)
+{
+	ENSURE_THREAD(TRX_TID);
+
+	int jobs = benchmark.jobs;
+#ifndef __WOE32__
+	if (jobs == 0)
+		jobs = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (jobs < 1 || cases.size() < 2)
+		jobs = 1;
+	else if ((size_t)jobs > cases.size())
+		jobs = cases.size();
+
+	vector<corpus_result> results(cases.size());
+	struct timespec t[2];
+	clock_gettime(CLOCK_MONOTONIC, &t[0]);
+
+	int started = 0;
+#ifndef __WOE32__
+	if (jobs > 1)
+		started = run_workers(jobs, results);
+#endif
+	// and whatever the workers could not take
+	for (size_t i = 0; i < cases.size(); i++)
+		if ((int)(i % jobs) >= started)
+			run_case(cases[i], results[i]);
+
+	clock_gettime(CLOCK_MONOTONIC, &t[1]);
+	t[1] -= t[0];
+
+	char line[256];
+	for (size_t i = 0; i < cases.size(); i++) {
+		const corpus_case& c = cases[i];
+		const corpus_result& r = results[i];
+
+		int n = snprintf(line, sizeof(line), "%-18s SNR %5.1f dB, drift %+g Hz/min, clock %+g ppm: ",
+				 c.sig->name, c.snr, c.drift, c.clock);
+		if (r.failed)
+			snprintf(line + n, sizeof(line) - n, "failed");
+		else if (r.cer < 0.0)
+			snprintf(line + n, sizeof(line) - n, "decoded at %.0fx real time",
+				 r.cpu > 0.0 ? r.audio / r.cpu : 0.0);
+		else
+			snprintf(line + n, sizeof(line) - n, "CER %6.2f%%, %s %d/%d, decoded at %.0fx real time",
+				 100.0 * r.cer, c.sig->set == CORPUS_SSDV ? "packets" : "sentences",
+				 r.ok, r.total, r.cpu > 0.0 ? r.audio / r.cpu : 0.0);
+		report(line);
+
+		// at the end of each group, the lowest SNR above which nothing was lost
+		if (i + 1 < cases.size() && c.sig == cases[i + 1].sig &&
+		    c.drift == cases[i + 1].drift && c.clock == cases[i + 1].clock)
+			continue;
+		if (r.cer < 0.0 && !r.failed)
+			continue;
+		size_t k = i + 1;
+		while (k > 0 && cases[k - 1].sig == c.sig && cases[k - 1].drift == c.drift &&
+		       cases[k - 1].clock == c.clock && !results[k - 1].failed &&
+		       results[k - 1].ok == results[k - 1].total)
+			k--;
+		if (k <= i)
+			snprintf(line, sizeof(line), "%-18s drift %+g Hz/min, clock %+g ppm: no loss from %.1f dB",
+				 c.sig->name, c.drift, c.clock, cases[k].snr);
+		else
+			snprintf(line, sizeof(line), "%-18s drift %+g Hz/min, clock %+g ppm: losses at every SNR",
+				 c.sig->name, c.drift, c.clock);
+		report(line);
+	}
+
+	snprintf(line, sizeof(line), "%u cases in %.1f seconds, %d jobs", (unsigned)cases.size(),
+		 t[1].tv_sec + t[1].tv_nsec / 1e9, jobs);
+	report(line);
+}
@@ -22,6 +22,15 @@
 
 #include <config.h>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifndef __WOE32__
+#  include <sys/mman.h>
+#endif
+
 #include <cstring>
 #include <cctype>
 #include <cstdlib>
@@ -61,13 +70,41 @@ typedef unordered_map<string, dxcc*> dxcc_map_t;
 typedef vector<dxcc*> dxcc_list_t;
 static dxcc_map_t* cmap = 0;
 static dxcc_list_t* clist = 0;
-static vector<string>* cnames = 0;
+static dxcc_list_t* centries = 0;
+static list<string>* cnames = 0;
+
+// Prefixes and full calls (stored with a leading '=') are looked up in a
+// trie kept in two flat arrays.  The children of a node are contiguous and
+// sorted by label, so a lookup walks the callsign once without allocating.
+struct dxcc_node {
+	uint32_t child;  // index of the first child
+	uint32_t entry;  // index + 1 into centries, or 0
+	unsigned char label;
+	unsigned char nchild;
+};
+static vector<dxcc_node>* ctrie = 0;
 
 static void add_prefix(string& prefix, dxcc* entry);
+static void build_trie(void);
+static bool read_cache(const char* filename);
+static void write_cache(const char* filename);
+
+static void dxcc_alloc(void)
+{
+	cnames = new list<string>;
+	clist = new dxcc_list_t;
+	clist->reserve(345); // approximate number of dxcc entities
+	centries = new dxcc_list_t;
+	centries->reserve(345);
+	ctrie = new vector<dxcc_node>;
+}
 
 bool dxcc_open(const char* filename)
 {
-	if (cmap)
+	if (ctrie)
+		return true;
+
+	if (read_cache(filename))
 		return true;
 
 	ifstream in(filename);
@@ -76,11 +113,8 @@ bool dxcc_open(const char* filename)
 		return false;
 	}
 
+	dxcc_alloc();
 	cmap = new dxcc_map_t;
-	cnames = new vector<string>;
-	cnames->reserve(345); // approximate number of dxcc entities
-	clist = new dxcc_list_t;
-	clist->reserve(345);
 
 	dxcc* entry;
 	string record;
@@ -94,6 +128,7 @@ bool dxcc_open(const char* filename)
 		// read country name
 		cnames->resize(cnames->size() + 1);
 		clist->push_back(entry);
+		centries->push_back(entry);
 		getline(is, cnames->back(), ':');
 		entry->country = cnames->back().c_str();
 		// cq zone
@@ -127,28 +162,34 @@ bool dxcc_open(const char* filename)
 	}
 
 	LOG_VERBOSE("Loaded %" PRIuSZ " prefixes for %u countries", cmap->size(), nrec);
+
+	build_trie();
+	delete cmap;
+	cmap = 0;
+
+	write_cache(filename);
 	return true;
 }
 
 bool dxcc_is_open(void)
 {
-	return cmap;
+	return ctrie;
 }
 
 void dxcc_close(void)
 {
-	if (!cmap)
+	if (!ctrie)
 		return;
-	delete cnames;
-	cnames = 0;
-	map<dxcc*, bool> rm;
-	for (dxcc_map_t::iterator i = cmap->begin(); i != cmap->end(); ++i)
-		if (rm.insert(make_pair(i->second, true)).second)
-			delete i->second;
-	delete cmap;
-	cmap = 0;
+	for (dxcc_list_t::iterator i = centries->begin(); i != centries->end(); ++i)
+		delete *i;
+	delete centries;
+	centries = 0;
 	delete clist;
 	clist = 0;
+	delete cnames;
+	cnames = 0;
+	delete ctrie;
+	ctrie = 0;
 }
 
 const vector<dxcc*>* dxcc_entity_list(void)
@@ -156,40 +197,270 @@ const vector<dxcc*>* dxcc_entity_list(void)
 	return clist;
 }
 
+static inline const dxcc_node* trie_child(const dxcc_node* node, int c)
+{
+	const dxcc_node* p = &(*ctrie)[node->child];
+	for (const dxcc_node* end = p + node->nchild; p < end && p->label <= c; p++)
+		if (p->label == c)
+			return p;
+	return NULL;
+}
+
 const dxcc* dxcc_lookup(const char* callsign)
 {
-	if (!cmap || !callsign || !*callsign)
+	if (!ctrie || !callsign || !*callsign)
 		return NULL;
 
-	string sstr;
-	sstr.resize(strlen(callsign) + 1);
-	transform(callsign, callsign + sstr.length() - 1, sstr.begin() + 1, static_cast<int (*)(int)>(toupper));
+	const dxcc_node* root = &(*ctrie)[0];
+	const dxcc_node* node;
+	const char* p;
 
 	// first look for a full callsign (prefixed with '=')
-	sstr[0] = '=';
-	dxcc_map_t::const_iterator entry = cmap->find(sstr);
-	if (entry != cmap->end())
-		return entry->second;
-
-	// erase the '=' and do a longest prefix search
-	sstr.erase(0, 1);
-	size_t len = sstr.length();
+	for (node = trie_child(root, '='), p = callsign; node && *p; p++)
+		node = trie_child(node, toupper((unsigned char)*p));
+	if (node && node->entry)
+		return (*centries)[node->entry - 1];
+
+	// then do a longest prefix search
+	size_t len = strlen(callsign);
 // accomodate special case for KG4... calls
 // all two letter suffix KG4 calls are Guantanamo
 // all others are US non Guantanamo
-	if (sstr.find("KG4") != string::npos) {
-		if (len == 4 || len == 6) {
-			sstr = "K";
-			len = 1;
+	if (len == 4 || len == 6) {
+		for (p = callsign; p[0] && p[1] && p[2]; p++) {
+			if (toupper(p[0]) == 'K' && toupper(p[1]) == 'G' && p[2] == '4') {
+				callsign = "K";
+				break;
+			}
 		}
 	}
-	do {
-		sstr.resize(len--);
-		if ((entry = cmap->find(sstr)) != cmap->end())
-			return entry->second;
-	} while (len);
+	const dxcc* found = NULL;
+	for (node = root, p = callsign; *p && (node = trie_child(node, toupper((unsigned char)*p))); p++)
+		if (node->entry)
+			found = (*centries)[node->entry - 1];
 
-	return NULL;
+	return found;
+}
+
+typedef vector<pair<const string*, uint32_t> > trie_keys_t;
+
+// Adds the children of node nn for the sorted keys [lo, hi), all of which
+// share their first depth characters, and then the children's subtrees.
+static void build_node(size_t nn, trie_keys_t::const_iterator lo,
+		       trie_keys_t::const_iterator hi, size_t depth)
+{
+	if (lo != hi && lo->first->length() == depth) {
+		(*ctrie)[nn].entry = lo->second;
+		++lo;
+	}
+
+	vector<trie_keys_t::const_iterator> groups;
+	for (trie_keys_t::const_iterator i = lo; i != hi; ++i)
+		if (i == lo || (*i->first)[depth] != (*(i - 1)->first)[depth])
+			groups.push_back(i);
+	groups.push_back(hi);
+
+	size_t child = ctrie->size();
+	(*ctrie)[nn].child = child;
+	(*ctrie)[nn].nchild = groups.size() - 1;
+	dxcc_node n = { 0, 0, 0, 0 };
+	for (size_t g = 0; g + 1 < groups.size(); g++) {
+		n.label = (*groups[g]->first)[depth];
+		ctrie->push_back(n);
+	}
+	for (size_t g = 0; g + 1 < groups.size(); g++)
+		build_node(child + g, groups[g], groups[g + 1], depth + 1);
+}
+
+static bool key_less(const trie_keys_t::value_type& a, const trie_keys_t::value_type& b)
+{
+	return *a.first < *b.first;
+}
+
+static void build_trie(void)
+{
+	// entities first, in file order, then the prefix specific copies
+	map<const dxcc*, bool> base;
+	for (size_t i = 0; i < clist->size(); i++)
+		base[(*clist)[i]] = true;
+	dxcc_list_t entries(*clist);
+	for (size_t i = 0; i < centries->size(); i++)
+		if (!base.count((*centries)[i]))
+			entries.push_back((*centries)[i]);
+	centries->swap(entries);
+
+	unordered_map<const dxcc*, uint32_t> index;
+	for (size_t i = 0; i < centries->size(); i++)
+		index[(*centries)[i]] = i + 1;
+
+	trie_keys_t keys;
+	keys.reserve(cmap->size());
+	for (dxcc_map_t::const_iterator i = cmap->begin(); i != cmap->end(); ++i)
+		if (!i->first.empty())
+			keys.push_back(make_pair(&i->first, index[i->second]));
+	sort(keys.begin(), keys.end(), key_less);
+
+	ctrie->clear();
+	dxcc_node root = { 0, 0, 0, 0 };
+	ctrie->push_back(root);
+	build_node(0, keys.begin(), keys.end(), 0);
+}
+
+// ----------------------------------------------------------------------------
+// Parsed cty.dat cache, in native byte order, valid for a cty.dat of the
+// same path, size and modification time.  It is loaded with a single read.
+
+static const char cty_cache_magic[8] = { 'C', 'T', 'Y', 'C', 'A', 'C', '1', '\0' };
+
+struct cty_cache_header {
+	char magic[8];
+	int64_t size;
+	int64_t mtime;
+	uint32_t path_len;
+	uint32_t names_len;  // NUL separated entity names
+	uint32_t nentries;   // of which the first nbase are the entities
+	uint32_t nbase;
+	uint32_t nnodes;
+	uint32_t pad;
+};
+
+struct cty_cache_entry {
+	uint32_t name;       // offset into the names
+	int32_t cq_zone;
+	int32_t itu_zone;
+	char continent[4];
+	float latitude;
+	float longitude;
+	float gmt_offset;
+};
+
+static string cty_cache_name(void)
+{
+	return string(HomeDir).append("cty.cache");
+}
+
+static bool read_cache(const char* filename)
+{
+	struct stat st;
+	if (stat(filename, &st) == -1)
+		return false;
+
+	string cname = cty_cache_name();
+	ifstream in(cname.c_str(), ios::binary);
+	if (!in)
+		return false;
+	vector<char> buf;
+	if (in.seekg(0, ios::end)) {
+		streamoff n = in.tellg();
+		if (n > (streamoff)sizeof(cty_cache_header)) {
+			buf.resize(n);
+			if (!in.seekg(0, ios::beg).read(&buf[0], n))
+				buf.clear();
+		}
+	}
+	in.close();
+	if (buf.empty())
+		return false;
+
+	cty_cache_header h;
+	memcpy(&h, &buf[0], sizeof(h));
+	size_t path_len = strlen(filename);
+	size_t len = sizeof(h) + ((h.path_len + h.names_len + 3) & ~3) +
+		     (size_t)h.nentries * sizeof(cty_cache_entry) +
+		     (size_t)h.nnodes * sizeof(dxcc_node);
+	if (memcmp(h.magic, cty_cache_magic, sizeof(h.magic)) || h.size != st.st_size ||
+	    h.mtime != st.st_mtime || h.path_len != path_len || len != buf.size() ||
+	    memcmp(&buf[sizeof(h)], filename, path_len) || h.nbase > h.nentries || !h.nnodes)
+		return false;
+
+	const char* names = &buf[sizeof(h) + h.path_len];
+	if (h.names_len && names[h.names_len - 1] != '\0')
+		return false;
+	const char* p = names + ((h.path_len + h.names_len + 3) & ~3) - h.path_len;
+	const cty_cache_entry* ce = reinterpret_cast<const cty_cache_entry*>(p);
+
+	dxcc_alloc();
+	vector<const char*> name_ptr(h.names_len, (const char*)0);
+	for (uint32_t off = 0; off < h.names_len; off += strlen(names + off) + 1) {
+		cnames->push_back(names + off);
+		name_ptr[off] = cnames->back().c_str();
+	}
+	centries->reserve(h.nentries);
+	for (uint32_t i = 0; i < h.nentries; i++, ce++) {
+		dxcc* entry = new dxcc(ce->name < h.names_len && name_ptr[ce->name] ? name_ptr[ce->name] : "",
+				       ce->cq_zone, ce->itu_zone, ce->continent,
+				       ce->latitude, ce->longitude, ce->gmt_offset);
+		centries->push_back(entry);
+		if (i < h.nbase)
+			clist->push_back(entry);
+	}
+	const dxcc_node* nodes = reinterpret_cast<const dxcc_node*>(ce);
+	ctrie->assign(nodes, nodes + h.nnodes);
+	for (vector<dxcc_node>::const_iterator i = ctrie->begin(); i != ctrie->end(); ++i) {
+		if (i->child + i->nchild > h.nnodes || i->entry > h.nentries) {
+			LOG_ERROR("Corrupt cache file \"%s\"", cname.c_str());
+			dxcc_close();
+			return false;
+		}
+	}
+
+	LOG_VERBOSE("Loaded %u countries from \"%s\"", h.nbase, cname.c_str());
+	return true;
+}
+
+static void write_cache(const char* filename)
+{
+	struct stat st;
+	if (stat(filename, &st) == -1)
+		return;
+
+	cty_cache_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, cty_cache_magic, sizeof(h.magic));
+	h.size = st.st_size;
+	h.mtime = st.st_mtime;
+	h.path_len = strlen(filename);
+
+	string names;
+	map<const char*, uint32_t> name_off;
+	for (list<string>::const_iterator i = cnames->begin(); i != cnames->end(); ++i) {
+		name_off[i->c_str()] = names.length();
+		names.append(*i).append(1, '\0');
+	}
+	h.names_len = names.length();
+	names.append(((h.path_len + h.names_len + 3) & ~3) - h.path_len - h.names_len, '\0');
+
+	vector<cty_cache_entry> entries(centries->size());
+	for (size_t i = 0; i < centries->size(); i++) {
+		const dxcc* e = (*centries)[i];
+		map<const char*, uint32_t>::const_iterator n = name_off.find(e->country);
+		entries[i].name = n == name_off.end() ? h.names_len : n->second;
+		entries[i].cq_zone = e->cq_zone;
+		entries[i].itu_zone = e->itu_zone;
+		memcpy(entries[i].continent, e->continent, sizeof(e->continent));
+		entries[i].latitude = e->latitude;
+		entries[i].longitude = e->longitude;
+		entries[i].gmt_offset = e->gmt_offset;
+	}
+	h.nentries = entries.size();
+	h.nbase = clist->size();
+	h.nnodes = ctrie->size();
+
+	// write to a temporary file and rename it, so that readers never see
+	// a partial cache
+	string cname = cty_cache_name(), tmp = cname + ".tmp";
+	ofstream out(tmp.c_str(), ios::binary);
+	out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	out.write(filename, h.path_len);
+	out.write(names.data(), names.length());
+	if (!entries.empty())
+		out.write(reinterpret_cast<const char*>(&entries[0]), entries.size() * sizeof(cty_cache_entry));
+	out.write(reinterpret_cast<const char*>(&(*ctrie)[0]), ctrie->size() * sizeof(dxcc_node));
+	out.close();
+	if (!out || rename(tmp.c_str(), cname.c_str()) == -1) {
+		LOG_VERBOSE("Could not write cache file \"%s\"", cname.c_str());
+		remove(tmp.c_str());
+	}
 }
 
 static void add_prefix(string& prefix, dxcc* entry)
@@ -201,8 +472,8 @@ static void add_prefix(string& prefix, dxcc* entry)
 	}
 
 	string::size_type j = i, first = i;
+	entry = new struct dxcc(*entry);
 	do {
-		entry = new struct dxcc(*entry);
 		switch (prefix[i++]) { // increment i past opening bracket
 		case '(':
 			if ((j = prefix.find(')', i)) == string::npos) {
@@ -246,33 +517,211 @@ static void add_prefix(string& prefix, dxcc* entry)
 
 	prefix.erase(first);
 	(*cmap)[prefix] = entry;
+	centries->push_back(entry);
 }
 
-typedef unordered_map<string, unsigned char> qsl_map_t;
-static qsl_map_t* qsl_calls;
+// ----------------------------------------------------------------------------
+// The LoTW and eQSL member lists are compiled into sorted arrays of
+// fixed-width, NUL padded callsigns, written next to cty.cache and mapped
+// read-only, so that instances on the same host share the pages.  An index
+// is valid for a list of the same path, size and modification time, and is
+// rebuilt otherwise.  A lookup is a binary search that does not allocate.
+
+static const char qsl_index_magic[8] = { 'Q', 'S', 'L', 'I', 'D', 'X', '1', '\0' };
+
+// longest callsign that is indexed, including the padding NUL
+#define QSL_MAX_CALL 32
+
+struct qsl_index_header {
+	char magic[8];
+	int64_t size;
+	int64_t mtime;
+	uint32_t path_len;
+	uint32_t ncalls;
+	uint32_t stride;     // bytes per callsign
+	uint32_t pad;
+};
+
+struct qsl_index {
+	const char* data;    // the whole index file
+	size_t size;
+	bool mapped;
+	const char* calls;
+	uint32_t ncalls;
+	uint32_t stride;
+};
+
+static qsl_index qsl_idx[QSL_END];
 static unsigned char qsl_open_;
 const char* qsl_names[] = { "LoTW", "eQSL" };
 
-bool qsl_open(const char* filename, qsl_t qsl_type)
+static string qsl_index_name(const char* filename)
+{
+	return string(HomeDir).append(fl_filename_name(filename)).append(".idx");
+}
+
+static void qsl_unload(qsl_index& idx)
+{
+#ifndef __WOE32__
+	if (idx.mapped)
+		munmap((void*)idx.data, idx.size);
+	else
+#endif
+		delete [] idx.data;
+	memset(&idx, 0, sizeof(idx));
+}
+
+// Checks the header of an index image against the list it was built from
+static bool qsl_check(qsl_index& idx, const char* filename, const struct stat& st)
+{
+	qsl_index_header h;
+	if (idx.size < sizeof(h))
+		return false;
+	memcpy(&h, idx.data, sizeof(h));
+
+	size_t path_len = strlen(filename);
+	if (memcmp(h.magic, qsl_index_magic, sizeof(h.magic)) || h.size != st.st_size ||
+	    h.mtime != st.st_mtime || h.path_len != path_len ||
+	    h.stride == 0 || h.stride > QSL_MAX_CALL ||
+	    idx.size != sizeof(h) + path_len + (size_t)h.ncalls * h.stride ||
+	    memcmp(idx.data + sizeof(h), filename, path_len))
+		return false;
+
+	idx.calls = idx.data + sizeof(h) + path_len;
+	idx.ncalls = h.ncalls;
+	idx.stride = h.stride;
+	return true;
+}
+
+static bool qsl_map(qsl_index& idx, const char* iname, const char* filename, const struct stat& st)
+{
+	int fd = open(iname, O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat ist;
+	if (fstat(fd, &ist) == -1 || ist.st_size < (off_t)sizeof(qsl_index_header)) {
+		close(fd);
+		return false;
+	}
+	idx.size = ist.st_size;
+#ifndef __WOE32__
+	void* p = mmap(0, idx.size, PROT_READ, MAP_SHARED, fd, 0);
+	if (p != MAP_FAILED) {
+		idx.data = (const char*)p;
+		idx.mapped = true;
+	}
+	else
+#endif
+	{
+		char* buf = new char[idx.size];
+		size_t n = 0;
+		ssize_t r;
+		while (n < idx.size && (r = read(fd, buf + n, idx.size - n)) > 0)
+			n += r;
+		idx.data = buf;
+		idx.size = n;
+	}
+	close(fd);
+
+	if (qsl_check(idx, filename, st))
+		return true;
+	qsl_unload(idx);
+	return false;
+}
+
+// Compiles the list into an index image in idx, and writes it to iname
+static bool qsl_build(qsl_index& idx, const char* iname, const char* filename, const struct stat& st)
 {
 	ifstream in(filename);
 	if (!in)
 		return false;
-	if (!qsl_calls)
-		qsl_calls = new qsl_map_t;
 
-	size_t n = qsl_calls->size();
-	string::size_type p;
+	vector<string> calls;
+	size_t stride = 1;
 	string s;
 	s.reserve(32);
 	while (getline(in, s)) {
-		if ((p = s.rfind('\r')) != string::npos)
+		string::size_type p;
+		if ((p = s.find_first_of("\r \t")) != string::npos)
 			s.erase(p);
-		(*qsl_calls)[s] |= (1 << qsl_type);
+		if (s.empty())
+			continue;
+		if (s.length() >= QSL_MAX_CALL) {
+			LOG_VERBOSE("Skipping \"%s\" in \"%s\"", s.c_str(), filename);
+			continue;
+		}
+		transform(s.begin(), s.end(), s.begin(), static_cast<int (*)(int)>(toupper));
+		calls.push_back(s);
+		stride = max(stride, s.length() + 1);
 	}
+	in.close();
+	sort(calls.begin(), calls.end());
+	calls.erase(unique(calls.begin(), calls.end()), calls.end());
+
+	qsl_index_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, qsl_index_magic, sizeof(h.magic));
+	h.size = st.st_size;
+	h.mtime = st.st_mtime;
+	h.path_len = strlen(filename);
+	h.ncalls = calls.size();
+	h.stride = stride;
+
+	// NUL padding sorts before any character, so memcmp order over the
+	// padded records is the string order used by sort()
+	idx.size = sizeof(h) + h.path_len + calls.size() * stride;
+	char* buf = new char[idx.size];
+	memset(buf, 0, idx.size);
+	memcpy(buf, &h, sizeof(h));
+	memcpy(buf + sizeof(h), filename, h.path_len);
+	char* rec = buf + sizeof(h) + h.path_len;
+	for (vector<string>::const_iterator i = calls.begin(); i != calls.end(); ++i, rec += stride)
+		memcpy(rec, i->data(), i->length());
+	idx.data = buf;
+	idx.calls = buf + sizeof(h) + h.path_len;
+	idx.ncalls = h.ncalls;
+	idx.stride = h.stride;
+
+	// write to a temporary file and rename it, so that other instances
+	// never map a partial index
+	string tmp = string(iname).append(".tmp");
+	ofstream out(tmp.c_str(), ios::binary);
+	out.write(buf, idx.size);
+	out.close();
+	if (!out || rename(tmp.c_str(), iname) == -1) {
+		LOG_VERBOSE("Could not write index file \"%s\"", iname);
+		remove(tmp.c_str());
+	}
+
+	return true;
+}
 
-	LOG_VERBOSE("Added %" PRIuSZ " %s callsigns from \"%s\"",
-		    qsl_calls->size() - n, qsl_names[qsl_type], filename);
+bool qsl_open(const char* filename, qsl_t qsl_type)
+{
+	struct stat st;
+	if (stat(filename, &st) == -1)
+		return false;
+
+	qsl_index& idx = qsl_idx[qsl_type];
+	qsl_unload(idx);
+
+	string iname = qsl_index_name(filename);
+	if (qsl_map(idx, iname.c_str(), filename, st))
+		LOG_VERBOSE("Mapped %u %s callsigns from \"%s\"",
+			    idx.ncalls, qsl_names[qsl_type], iname.c_str());
+	else if (qsl_build(idx, iname.c_str(), filename, st)) {
+		LOG_VERBOSE("Added %u %s callsigns from \"%s\"",
+			    idx.ncalls, qsl_names[qsl_type], filename);
+		// share the written index rather than keep a private copy
+		qsl_index built = idx;
+		memset(&idx, 0, sizeof(idx));
+		if (qsl_map(idx, iname.c_str(), filename, st))
+			qsl_unload(built);
+		else
+			idx = built;
+	}
+	else
+		return false;
 
 	qsl_open_ |= (1 << qsl_type);
 	return true;
@@ -285,22 +734,48 @@ unsigned char qsl_is_open(void)
 
 void qsl_close(void)
 {
-	delete qsl_calls;
-	qsl_calls = 0;
+	for (int i = 0; i < QSL_END; i++)
+		qsl_unload(qsl_idx[i]);
 	qsl_open_ = 0;
 }
 
+static bool qsl_find(const qsl_index& idx, const char* key)
+{
+	const char* base = idx.calls;
+	size_t n = idx.ncalls;
+	while (n > 0) {
+		const char* mid = base + (n / 2) * idx.stride;
+		int c = memcmp(key, mid, idx.stride);
+		if (c == 0)
+			return true;
+		if (c > 0) {
+			base = mid + idx.stride;
+			n -= n / 2 + 1;
+		}
+		else
+			n /= 2;
+	}
+	return false;
+}
+
 unsigned char qsl_lookup(const char* callsign)
 {
-	if (qsl_calls == 0)
+	if (!qsl_open_)
 		return 0;
 
-	string str;
-	str.resize(strlen(callsign));
-	transform(callsign, callsign + str.length(), str.begin(), static_cast<int (*)(int)>(toupper));
-
-	qsl_map_t::const_iterator i = qsl_calls->find(str);
-	return i == qsl_calls->end() ? 0 : i->second;
+	char key[QSL_MAX_CALL];
+	size_t len = strlen(callsign);
+	if (len >= QSL_MAX_CALL)
+		return 0;
+	memset(key, 0, sizeof(key));
+	for (size_t i = 0; i < len; i++)
+		key[i] = toupper((unsigned char)callsign[i]);
+
+	unsigned char q = 0;
+	for (int i = 0; i < QSL_END; i++)
+		if (qsl_idx[i].calls && len < qsl_idx[i].stride && qsl_find(qsl_idx[i], key))
+			q |= (1 << i);
+	return q;
 }
 
 void reload_cty_dat()
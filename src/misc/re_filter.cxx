@@ -0,0 +1,559 @@
+// ----------------------------------------------------------------------------
+//      re_filter.cxx
+//
+// This file is part of fldigi.
+//
+// fldigi is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <set>
+#include <deque>
+#include <algorithm>
+
+#include "re.h"
+#include "re_filter.h"
+
+using namespace std;
+
+// ----------------------------------------------------------------------------
+// RE analysis
+
+// The automaton works on ASCII case folded characters, so the literals are
+// folded too.  This loses nothing for case sensitive REs; the prefilter only
+// becomes a little less selective.
+static inline unsigned char fold(unsigned char c)
+{
+	return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+namespace {
+
+enum { MAX_EXACT = 16, MAX_EXACT_LEN = 8, MAX_EXACT_CHARS = 4 };
+
+typedef set<string> strset;
+
+// What is known about the strings that an RE node matches
+struct info_t {
+	info_t() : exact_ok(true), nullable(true) { exact.insert(""); }
+
+	bool exact_ok;          // exact holds all of them
+	strset exact;
+	vector<strset> req;     // each match contains one string of each set
+	bool nullable;          // the empty string is one of them
+	bitset<256> last;       // their last characters
+};
+
+// the requirements of i, with exact converted to a requirement if possible
+static vector<strset> requirements(const info_t& i)
+{
+	vector<strset> r(i.req);
+	if (i.exact_ok && !i.exact.empty() && !i.exact.count(""))
+		r.push_back(i.exact);
+	return r;
+}
+
+static size_t min_length(const strset& s)
+{
+	size_t n = string::npos;
+	for (strset::const_iterator i = s.begin(); i != s.end(); ++i)
+		n = min(n, i->length());
+	return n;
+}
+
+// the most selective requirement, or an empty set if there is none
+static strset best(const vector<strset>& req)
+{
+	strset b;
+	size_t blen = 0;
+	for (vector<strset>::const_iterator i = req.begin(); i != req.end(); ++i) {
+		size_t n = min_length(*i);
+		if (n > blen) {
+			blen = n;
+			b = *i;
+		}
+	}
+	return b;
+}
+
+static info_t unknown(void)
+{
+	info_t i;
+	i.exact_ok = false;
+	i.exact.clear();
+	i.last.set();
+	return i;
+}
+
+static info_t sequence(const info_t& a, const info_t& b)
+{
+	info_t r;
+	r.nullable = a.nullable && b.nullable;
+	r.last = b.last;
+	if (b.nullable)
+		r.last |= a.last;
+
+	r.exact.clear();
+	if (a.exact_ok && b.exact_ok && a.exact.size() * b.exact.size() <= MAX_EXACT) {
+		bool too_long = false;
+		for (strset::const_iterator i = a.exact.begin(); i != a.exact.end(); ++i) {
+			for (strset::const_iterator j = b.exact.begin(); j != b.exact.end(); ++j) {
+				r.exact.insert(*i + *j);
+				too_long = too_long || i->length() + j->length() > MAX_EXACT_LEN;
+			}
+		}
+		if (!too_long)
+			return r;
+		r.req = requirements(r);
+		r.exact.clear();
+		r.exact_ok = false;
+		return r;
+	}
+
+	r.exact_ok = false;
+	r.req = requirements(a);
+	vector<strset> rb = requirements(b);
+	r.req.insert(r.req.end(), rb.begin(), rb.end());
+	return r;
+}
+
+static info_t alternate(const info_t& a, const info_t& b)
+{
+	info_t r;
+	r.nullable = a.nullable || b.nullable;
+	r.last = a.last | b.last;
+
+	r.exact.clear();
+	if (a.exact_ok && b.exact_ok && a.exact.size() + b.exact.size() <= MAX_EXACT) {
+		r.exact = a.exact;
+		r.exact.insert(b.exact.begin(), b.exact.end());
+		return r;
+	}
+
+	r.exact_ok = false;
+	strset ra = best(requirements(a)), rb = best(requirements(b));
+	if (!ra.empty() && !rb.empty()) {
+		ra.insert(rb.begin(), rb.end());
+		r.req.push_back(ra);
+	}
+	return r;
+}
+
+// min and max repetitions, max < 0 for unbounded
+static info_t repeat(const info_t& a, int min, int max)
+{
+	if (min == 1 && max == 1)
+		return a;
+
+	info_t r;
+	r.last = a.last;
+	r.exact.clear();
+	r.exact_ok = false;
+	if (min == 0) {
+		r.nullable = true;
+		if (max == 1 && a.exact_ok && a.exact.size() < MAX_EXACT) {
+			r.exact = a.exact;
+			r.exact.insert("");
+			r.exact_ok = true;
+		}
+	}
+	else {
+		r.nullable = a.nullable;
+		r.req = requirements(a);
+	}
+	return r;
+}
+
+class parser
+{
+public:
+	parser(const char* re, int cflags)
+		: p(re), icase(cflags & REG_ICASE), newline(cflags & REG_NEWLINE), ok(true) { }
+
+	// returns false if the RE could not be analysed
+	bool parse(info_t& info, bool& anchored)
+	{
+		info = alt(0, &anchored);
+		return ok && !*p;
+	}
+
+private:
+	const char* p;
+	bool icase, newline, ok;
+
+	info_t alt(int depth, bool* anchored)
+	{
+		bool a;
+		info_t r = concat(depth, &a);
+		bool single = true;
+		while (ok && *p == '|') {
+			p++;
+			r = alternate(r, concat(depth, &a));
+			single = false;
+		}
+		if (anchored)
+			*anchored = single && a;
+		return r;
+	}
+
+	info_t concat(int depth, bool* anchored)
+	{
+		info_t r;
+		*anchored = false;
+		while (ok && *p && *p != '|' && !(*p == ')' && depth)) {
+			const char* start = p;
+			info_t i = quantified(depth);
+			*anchored = (p - start == 1 && *start == '$');
+			r = sequence(r, i);
+		}
+		return r;
+	}
+
+	info_t quantified(int depth)
+	{
+		info_t r = atom(depth);
+		while (ok) {
+			if (*p == '*')
+				r = repeat(r, 0, -1);
+			else if (*p == '+')
+				r = repeat(r, 1, -1);
+			else if (*p == '?')
+				r = repeat(r, 0, 1);
+			else if (*p == '{' && isdigit((unsigned char)p[1])) {
+				char* end;
+				int min = strtol(p + 1, &end, 10), max = min;
+				if (*end == ',')
+					max = isdigit((unsigned char)end[1]) ? strtol(end + 1, &end, 10) : (end++, -1);
+				if (*end != '}') {
+					ok = false;
+					break;
+				}
+				p = end;
+				r = repeat(r, min, max);
+			}
+			else
+				break;
+			p++;
+		}
+		return r;
+	}
+
+	info_t atom(int depth)
+	{
+		bitset<256> set;
+		switch (*p) {
+		case '(': {
+			p++;
+			info_t r = alt(depth + 1, 0);
+			if (*p != ')')
+				ok = false;
+			else
+				p++;
+			return r;
+		}
+		case '^': case '$':
+			p++;
+			return info_t();
+		case '.':
+			p++;
+			set.set();
+			set[0] = false;
+			if (newline)
+				set['\n'] = false;
+			return chars(set);
+		case '[':
+			p++;
+			if (!bracket(set))
+				ok = false;
+			return chars(set);
+		case '\\':
+			if (!p[1]) {
+				ok = false;
+				return unknown();
+			}
+			p++;
+			// back references, and the GNU word and buffer operators
+			if ((*p >= '1' && *p <= '9') || isalpha((unsigned char)*p) || strchr("<>`'", *p)) {
+				p++;
+				return unknown();
+			}
+			// fall through
+		default:
+			set[(unsigned char)*p++] = true;
+			return chars(set);
+		}
+	}
+
+	info_t chars(bitset<256> set)
+	{
+		info_t r;
+		r.nullable = false;
+		r.exact.clear();
+
+		bool high = false;
+		for (int c = 128; c < 256 && !high; c++)
+			high = set[c];
+		if (icase) {
+			for (int c = 'a'; c <= 'z'; c++)
+				if (set[c] || set[c - 'a' + 'A'])
+					set[c] = set[c - 'a' + 'A'] = true;
+			// the RE library may fold these according to the locale
+			if (high)
+				for (int c = 128; c < 256; c++)
+					set[c] = true;
+		}
+		r.last = set;
+
+		for (int c = 1; c < 256; c++)
+			if (set[c])
+				r.exact.insert(string(1, fold(c)));
+		r.exact_ok = !(icase && high) && r.exact.size() <= MAX_EXACT_CHARS;
+		if (!r.exact_ok)
+			r.exact.clear();
+		return r;
+	}
+
+	// Character class members.  Bytes above 127 may belong to any class in
+	// the current locale, so they are only added when over-approximating.
+	static void char_class(const string& name, bitset<256>& set, bool high)
+	{
+		static const struct { const char* name; int (*is)(int); } classes[] = {
+			{ "alnum", ::isalnum }, { "alpha", ::isalpha }, { "blank", ::isblank },
+			{ "cntrl", ::iscntrl }, { "digit", ::isdigit }, { "graph", ::isgraph },
+			{ "lower", ::islower }, { "print", ::isprint }, { "punct", ::ispunct },
+			{ "space", ::isspace }, { "upper", ::isupper }, { "xdigit", ::isxdigit }
+		};
+		for (size_t i = 0; i < sizeof(classes)/sizeof(*classes); i++) {
+			if (name != classes[i].name)
+				continue;
+			for (int c = 0; c < 128; c++)
+				if (classes[i].is(c))
+					set[c] = true;
+			if (high)
+				for (int c = 128; c < 256; c++)
+					set[c] = true;
+			return;
+		}
+		// unknown class: regcomp will have failed
+		set.set();
+	}
+
+	// parses a bracket expression after the '[', computing an over-
+	// approximation of its members
+	bool bracket(bitset<256>& set)
+	{
+		bool neg = (*p == '^');
+		if (neg)
+			p++;
+
+		for (bool first = true; *p && (first || *p != ']'); first = false) {
+			int lo;
+			if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '=')) {
+				char kind = p[1];
+				const char* end = p + 2;
+				while (*end && !(end[0] == kind && end[1] == ']'))
+					end++;
+				if (!*end)
+					return false;
+				string name(p + 2, end);
+				p = end + 2;
+				if (kind == ':') {
+					// a negated set must not lose possible members
+					char_class(name, set, !neg);
+					continue;
+				}
+				if (name.length() != 1)
+					return false;
+				lo = (unsigned char)name[0];
+			}
+			else
+				lo = (unsigned char)*p++;
+
+			int hi = lo;
+			if (*p == '-' && p[1] && p[1] != ']') {
+				if (p[1] == '[')
+					return false;
+				hi = (unsigned char)p[1];
+				p += 2;
+			}
+			for (int c = lo; c <= hi; c++)
+				set[c] = true;
+		}
+		if (*p != ']')
+			return false;
+		p++;
+
+		if (neg) {
+			if (icase)
+				for (int c = 'a'; c <= 'z'; c++)
+					if (set[c] || set[c - 'a' + 'A'])
+						set[c] = set[c - 'a' + 'A'] = true;
+			set.flip();
+			set[0] = false;
+			if (newline)
+				set['\n'] = false;
+		}
+		return true;
+	}
+};
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+re_filter_t::re_filter_t(size_t window_)
+	: window(window_), gen(0)
+{
+	clear();
+}
+
+void re_filter_t::clear(void)
+{
+	patterns.clear();
+	literals.clear();
+	nodes.assign(1, node_t());
+	delta.assign(256, 0);
+	gen++;
+}
+
+size_t re_filter_t::literal(const string& s)
+{
+	vector<string>::iterator i = find(literals.begin(), literals.end(), s);
+	if (i != literals.end())
+		return i - literals.begin();
+	literals.push_back(s);
+	return literals.size() - 1;
+}
+
+size_t re_filter_t::add(const char* re, int cflags)
+{
+	pattern_t pt;
+	pt.any = true;
+	pt.anchored = false;
+
+	info_t info;
+	bool anchored;
+	if (parser(re, cflags).parse(info, anchored)) {
+		pt.anchored = anchored && !info.nullable && !(cflags & REG_NEWLINE);
+		pt.last = info.last;
+		vector<strset> req = requirements(info);
+		for (vector<strset>::const_iterator i = req.begin(); i != req.end(); ++i) {
+			pt.req.resize(pt.req.size() + 1);
+			for (strset::const_iterator j = i->begin(); j != i->end(); ++j)
+				pt.req.back().push_back(literal(*j));
+		}
+		pt.any = pt.req.empty() && !pt.anchored;
+	}
+
+	patterns.push_back(pt);
+	return patterns.size() - 1;
+}
+
+// Builds the Aho-Corasick automaton for the literals, with a full
+// transition table so that advancing a stream is a single lookup.
+void re_filter_t::compile(void)
+{
+	nodes.assign(1, node_t());
+	vector<size_t> go(256, 0); // trie edges, 0 for none
+	for (size_t l = 0; l < literals.size(); l++) {
+		size_t n = 0;
+		for (size_t k = 0; k < literals[l].length(); k++) {
+			size_t& next = go[n * 256 + (unsigned char)literals[l][k]];
+			if (!next) {
+				next = nodes.size();
+				nodes.push_back(node_t());
+				go.resize(nodes.size() * 256, 0);
+			}
+			n = go[n * 256 + (unsigned char)literals[l][k]];
+		}
+		nodes[n].out.push_back(l);
+	}
+
+	delta.assign(nodes.size() * 256, 0);
+	deque<size_t> queue;
+	for (int c = 0; c < 256; c++) {
+		if ((delta[c] = go[c]) != 0) {
+			nodes[go[c]].fail = 0;
+			queue.push_back(go[c]);
+		}
+	}
+	while (!queue.empty()) {
+		size_t n = queue.front();
+		queue.pop_front();
+		const vector<size_t>& fout = nodes[nodes[n].fail].out;
+		nodes[n].out.insert(nodes[n].out.end(), fout.begin(), fout.end());
+		for (int c = 0; c < 256; c++) {
+			size_t next = go[n * 256 + c];
+			if (next) {
+				nodes[next].fail = delta[nodes[n].fail * 256 + c];
+				delta[n * 256 + c] = next;
+				queue.push_back(next);
+			}
+			else
+				delta[n * 256 + c] = delta[nodes[n].fail * 256 + c];
+		}
+	}
+	gen++;
+}
+
+inline void re_filter_t::advance(stream& s, unsigned char c) const
+{
+	s.pos++;
+	s.state = delta[s.state * 256 + fold(c)];
+	const vector<size_t>& out = nodes[s.state].out;
+	for (vector<size_t>::const_iterator i = out.begin(); i != out.end(); ++i)
+		s.seen[*i] = s.pos;
+}
+
+void re_filter_t::reset(stream& s, const char* str, size_t len) const
+{
+	s.state = 0;
+	s.pos = 0;
+	s.seen.assign(literals.size(), 0);
+	s.gen = gen;
+	while (len--)
+		advance(s, *str++);
+}
+
+void re_filter_t::feed(stream& s, char c, vector<size_t>& candidates) const
+{
+	candidates.clear();
+	advance(s, c);
+
+	for (size_t i = 0; i < patterns.size(); i++) {
+		const pattern_t& pt = patterns[i];
+		if (pt.any) {
+			candidates.push_back(i);
+			continue;
+		}
+		if (pt.anchored && !pt.last[(unsigned char)c])
+			continue;
+
+		// every requirement needs one literal that lies within the window
+		bool match = true;
+		for (size_t r = 0; r < pt.req.size() && match; r++) {
+			match = false;
+			for (size_t k = 0; k < pt.req[r].size() && !match; k++) {
+				size_t l = pt.req[r][k];
+				match = s.seen[l] && s.seen[l] + window >= s.pos + literals[l].length();
+			}
+		}
+		if (match)
+			candidates.push_back(i);
+	}
+}
@@ -649,15 +649,35 @@ Socket Socket::accept1(void)
 }
 
 ///
-/// Connects the socket to the address that is associated with the object
+/// Connects the socket to the address that is associated with the object.
+/// A non-blocking socket with a timeout waits that long for the connection
+/// to complete.
 ///
 void Socket::connect(void)
 {
 #ifndef NDEBUG
 	LOG_DEBUG("Connecting to %s", address.get_str(ainfo).c_str());
 #endif
-	if (::connect(sockfd, ainfo->ai_addr, ainfo->ai_addrlen) == -1)
-		throw SocketException(errno, "connect");
+	if (::connect(sockfd, ainfo->ai_addr, ainfo->ai_addrlen) == 0)
+		return;
+
+#if defined(__WIN32__)
+	int err = WSAGetLastError();
+	bool pending = (err == WSAEWOULDBLOCK);
+#else
+	int err = errno;
+	bool pending = (err == EINPROGRESS);
+#endif
+	if (!pending || !nonblocking || (timeout.tv_sec == 0 && timeout.tv_usec == 0))
+		throw SocketException(err, "connect");
+
+	if (!wait(1))
+		throw SocketException(ETIMEDOUT, "connect");
+	socklen_t len = sizeof(err);
+	if (getsockopt(sockfd, SOL_SOCKET, SO_ERROR, (char*)&err, &len) == -1)
+		throw SocketException(errno, "getsockopt");
+	if (err)
+		throw SocketException(err, "connect");
 }
 
 ///
@@ -226,8 +226,10 @@ void status::saveLastState()
 			tile_x = mvgroup->w();
 	}
 
-	VIEWERvisible = dlgViewer->visible();
-	VIEWERnchars = brwsViewer->numchars();
+	// the viewer is only created when it is first opened
+	VIEWERvisible = dlgViewer && dlgViewer->visible();
+	if (brwsViewer)
+		VIEWERnchars = brwsViewer->numchars();
 	if (VIEWERvisible) {
 		VIEWERxpos = dlgViewer->x();
 		VIEWERypos = dlgViewer->y();
@@ -24,6 +24,7 @@
 #include <stdexcept>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 #include "threads.h"
 
 THREAD_ID_TYPE thread_id_;
@@ -146,5 +147,108 @@ bool syncobj::wait( double seconds )
 	}
 }
 
+struct fork_join::worker {
+	fork_join* fj;
+	int id;
+	pthread_t thread;
+	syncobj wake;
+	bool go;
+	bool stop;
+};
 
+int fork_join::ncpus(void)
+{
+	long n = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return n < 1 ? 1 : (int)n;
+}
+
+fork_join::fork_join(int nthreads)
+	: nworkers(0), pending(0), job(0), arg(0), n(0)
+{
+	workers = new worker[nthreads > 0 ? nthreads : 0];
+	for (int i = 0; i < nthreads; i++) {
+		workers[i].fj = this;
+		workers[i].id = i + 1;
+		workers[i].go = workers[i].stop = false;
+		if (pthread_create(&workers[i].thread, NULL, worker_loop, &workers[i]) != 0)
+			break;
+		nworkers++;
+	}
+}
+
+fork_join::~fork_join()
+{
+	for (int i = 0; i < nworkers; i++) {
+		pthread_mutex_lock(workers[i].wake.mtxp());
+		workers[i].stop = true;
+		workers[i].wake.signal();
+		pthread_mutex_unlock(workers[i].wake.mtxp());
+		pthread_join(workers[i].thread, NULL);
+	}
+	delete [] workers;
+}
+
+// every size()th iteration, starting with the first'th
+void fork_join::stripe(int first)
+{
+	for (size_t i = first; i < n; i += nworkers + 1)
+		job(arg, i);
+}
 
+void fork_join::run(job_t job_, void* arg_, size_t n_)
+{
+	job = job_;
+	arg = arg_;
+	n = n_;
+
+	if (nworkers == 0 || n < 2) {
+		for (size_t i = 0; i < n; i++)
+			job(arg, i);
+		return;
+	}
+
+	pthread_mutex_lock(done.mtxp());
+	pending = nworkers;
+	pthread_mutex_unlock(done.mtxp());
+	for (int i = 0; i < nworkers; i++) {
+		pthread_mutex_lock(workers[i].wake.mtxp());
+		workers[i].go = true;
+		workers[i].wake.signal();
+		pthread_mutex_unlock(workers[i].wake.mtxp());
+	}
+
+	stripe(0);
+
+	pthread_mutex_lock(done.mtxp());
+	while (pending)
+		done.wait(1.0);
+	pthread_mutex_unlock(done.mtxp());
+}
+
+void* fork_join::worker_loop(void* arg)
+{
+	worker* w = static_cast<worker*>(arg);
+	fork_join* fj = w->fj;
+
+	for (;;) {
+		pthread_mutex_lock(w->wake.mtxp());
+		while (!w->go && !w->stop)
+			w->wake.wait(1.0);
+		w->go = false;
+		pthread_mutex_unlock(w->wake.mtxp());
+		if (w->stop)
+			break;
+
+		fj->stripe(w->id);
+
+		pthread_mutex_lock(fj->done.mtxp());
+		if (--fj->pending == 0)
+			fj->done.signal();
+		pthread_mutex_unlock(fj->done.mtxp());
+	}
+
+	return NULL;
+}
@@ -69,6 +69,7 @@
 #include "debug.h"
 #include "re.h"
 #include "pskrep.h"
+#include "dspstats.h"
 
 // required for flrig support
 #include "fl_digi.h"
@@ -840,6 +841,68 @@ public:
 	}
 };
 
+class Main_get_dsp_stats : public xmlrpc_c::method
+{
+public:
+	Main_get_dsp_stats()
+	{
+		_signature = "S:n";
+		_help = "Returns the receive loop load, stage times, block time histogram, buffer levels and overflow counts.";
+	}
+	void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
+        {
+		dsp_stats st;
+		dspstats_get(st);
+
+		map<string, xmlrpc_c::value> vstruct, stages, levels, xruns;
+		vstruct["load"] = xmlrpc_c::value_double(st.load);
+		vstruct["audio"] = xmlrpc_c::value_double(st.audio);
+		vstruct["busy"] = xmlrpc_c::value_double(st.busy);
+		vstruct["block_max"] = xmlrpc_c::value_double(st.block_max);
+		vstruct["blocks"] = xmlrpc_c::value_int(st.blocks);
+
+		for (int i = 0; i < DSP_NUM_STAGES; i++)
+			stages[dspstats_stage_name(i)] = xmlrpc_c::value_double(st.stage[i]);
+		vstruct["stages"] = xmlrpc_c::value_struct(stages);
+
+		vector<xmlrpc_c::value> hist;
+		for (int i = 0; i < DSP_HIST_BINS; i++)
+			hist.push_back(xmlrpc_c::value_int(st.hist[i]));
+		vstruct["histogram"] = xmlrpc_c::value_array(hist);
+		vstruct["histogram_base"] = xmlrpc_c::value_double(DSP_HIST_BASE);
+
+		levels["sound_fill"] = xmlrpc_c::value_int(st.sndrb_fill);
+		levels["sound_max"] = xmlrpc_c::value_int(st.sndrb_max);
+		levels["sound_size"] = xmlrpc_c::value_int(st.sndrb_size);
+		levels["history_fill"] = xmlrpc_c::value_int(st.trxrb_fill);
+		levels["history_size"] = xmlrpc_c::value_int(st.trxrb_size);
+		levels["queue_depth"] = xmlrpc_c::value_int(st.qrunner_depth);
+		levels["queue_max"] = xmlrpc_c::value_int(st.qrunner_max);
+		vstruct["levels"] = xmlrpc_c::value_struct(levels);
+
+		for (int i = 0; i < DSP_NUM_XRUNS; i++)
+			xruns[dspstats_xrun_name(i)] = xmlrpc_c::value_int(st.xruns[i]);
+		vstruct["overflows"] = xmlrpc_c::value_struct(xruns);
+
+		*retval = xmlrpc_c::value_struct(vstruct);
+	}
+};
+
+class Main_reset_dsp_stats : public xmlrpc_c::method
+{
+public:
+	Main_reset_dsp_stats()
+	{
+		_signature = "n:n";
+		_help = "Resets the receive loop load and overflow counters.";
+	}
+	void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
+        {
+		dspstats_reset();
+		*retval = xmlrpc_c::value_nil();
+	}
+};
+
 class Main_get_sb : public xmlrpc_c::method
 {
 public:
@@ -2757,6 +2820,8 @@ struct Navtex_send_message : public xmlrpc_c::method
 																	\
 	ELEM_(Main_get_status1, "main.get_status1")						\
 	ELEM_(Main_get_status2, "main.get_status2")						\
+	ELEM_(Main_get_dsp_stats, "main.get_dsp_stats")					\
+	ELEM_(Main_reset_dsp_stats, "main.reset_dsp_stats")					\
 																	\
 	ELEM_(Main_get_sb, "main.get_sideband")							\
 	ELEM_(Main_set_sb, "main.set_sideband")							\
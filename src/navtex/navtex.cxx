@@ -26,9 +26,11 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <ctype.h>
 #include <memory.h>
 #include <assert.h>
+#include <time.h>
 
 #include <list>
 #include <vector>
@@ -41,6 +43,8 @@
 #include <fstream>
 #include <stdexcept>
 
+#include <pthread.h>
+
 #include "config.h"
 #include "configuration.h"
 #include "fl_digi.h"
@@ -51,6 +55,7 @@
 #include "locator.h"
 #include "misc.h"
 #include "status.h"
+#include "strutil.h"
 
 class CoordinateT
 {
@@ -77,11 +82,12 @@ public:
 		m_angle = (double)degree + (double)minute / 60.0 + (double)second / 3600.0 ;
 		switch( direction )
 		{
-			case 'E':
-			case 'e':
-				m_angle = -m_angle ;
+			/// East is positive, as with locator2longlat().
 			case 'W':
 			case 'w':
+				m_angle = -m_angle ;
+			case 'E':
+			case 'e':
 				if( ( degree < -180.0 ) || ( degree > 180.0 ) )
 					throw std::runtime_error("Invalid longitude degree");
 				m_is_lon = true ;
@@ -255,81 +261,156 @@ public:
 
 class NavtexCatalog
 {
-	// TODO: Consider a multimap<char, NavtexRecord>
 	typedef std::deque< NavtexRecord > CatalogType ;
 	CatalogType m_catalog ;
 
-	static bool freq_close( double freqA, double freqB )
-	{
-		static const double freq_ratio = 1.1 ;
-		return ( freqA < freqB * freq_ratio ) || ( freqA * freq_ratio > freqB );
-	}
+	/// Usual frequencies in kiloHertz, the last band collects all other ones.
+	static const int nb_bands = 4 ;
 
-	static bool freq_acceptable( double freq )
+	static int freq_band( double freq )
 	{
-		return	freq_close( freq, 518.0 )
-		||	freq_close( freq, 518.0 )
-		||	freq_close( freq, 4209.5 );
+		static const double band_freqs[ nb_bands - 1 ] = { 490.0, 518.0, 4209.5 };
+		static const double freq_ratio = 1.02 ;
+		for( int ix_band = 0; ix_band < nb_bands - 1; ++ix_band ) {
+			if( ( freq < band_freqs[ix_band] * freq_ratio ) && ( freq * freq_ratio > band_freqs[ix_band] ) ) {
+				return ix_band ;
+			}
+		}
+		return nb_bands - 1 ;
 	}
 
-	typedef std::multimap< double, CatalogType::const_iterator > SolutionType ;
+	/// A station as a point on the unit sphere: The nearest one has the
+	/// biggest scalar product, so no trigonometry is needed per candidate.
+	struct IndexEntry {
+		double m_x, m_y, m_z ;
+		const NavtexRecord * m_record ;
+
+		explicit IndexEntry( const CoordinateT::Pair & coo, const NavtexRecord * rec = NULL )
+		: m_record( rec )
+		{
+			double lon = coo.longitude().angle() * M_PI / 180.0 ;
+			double lat = coo.latitude().angle() * M_PI / 180.0 ;
+			m_x = cos(lat) * cos(lon);
+			m_y = cos(lat) * sin(lon);
+			m_z = sin(lat);
+		}
+
+		double dot( const IndexEntry & other ) const
+		{
+			return m_x * other.m_x + m_y * other.m_y + m_z * other.m_z ;
+		}
+	};
+
+	/// Stations bucketed by origin letter then frequency band, built once
+	/// when the catalog is loaded. Each bucket holds a few stations only.
+	static const int nb_origins = 'Z' - 'A' + 1 ;
+	typedef std::vector< IndexEntry > BucketType ;
+	BucketType m_index[ nb_origins ][ nb_bands ];
 
 	static const NavtexRecord & dflt_solution(void) {
 		static const NavtexRecord dfltNavtex ;
 		return dfltNavtex ;
 	}
 
+	/// A missing or unreadable file gives an empty catalog.
 	NavtexCatalog( const std::string & filnam )
 	{
 		LOG_INFO("Opening:%s", filnam.c_str());
 		std::ifstream ifs( filnam.c_str() );
 		if( !ifs )
 		{
-			std::string msg = "Cannot open:" + filnam ;
-			LOG_ERROR("%s",msg.c_str() );
-			throw std::runtime_error(msg);
+			LOG_ERROR("Cannot open:%s", filnam.c_str() );
+			return ;
 		}
 		for( ; ; )
 		{
 			NavtexRecord tmp ;
-			ifs >> tmp ;
+			try {
+				ifs >> tmp ;
+			} catch( const std::exception & exc ) {
+				LOG_ERROR("%s: %s, record %d", filnam.c_str(), exc.what(), (int)m_catalog.size() );
+				break ;
+			}
 			if( !ifs) break ;
 			m_catalog.push_back( tmp );
 		}
 		ifs.close();
+
+		/// A deque never moves its elements, so pointers are stable.
+		for( CatalogType::const_iterator it = m_catalog.begin(), en = m_catalog.end(); it != en ; ++it )
+		{
+			int ix_origin = toupper( it->origin() ) - 'A' ;
+			if( ( ix_origin < 0 ) || ( ix_origin >= nb_origins ) ) continue ;
+			m_index[ ix_origin ][ freq_band( it->frequency() ) ].push_back(
+				IndexEntry( it->coordinates(), &*it ) );
+		}
+		LOG_INFO("%d stations", (int)m_catalog.size() );
+	}
+
+	static const NavtexCatalog * s_inst ;
+
+	static void create(void) {
+		s_inst = new NavtexCatalog(progdefaults.NVTX_Catalog);
 	}
 
+	/// Several decoders may need it at the same time.
 	static const NavtexCatalog & inst() {
-		static const NavtexCatalog *ptr = NULL;
-		if( ptr == NULL ) ptr = new NavtexCatalog(progdefaults.NVTX_Catalog);
-		return *ptr ;
+		static pthread_once_t once = PTHREAD_ONCE_INIT ;
+		pthread_once( &once, create );
+		return *s_inst ;
+	}
+
+	/// Keeps the closest station of the bucket if closer than the current best.
+	static void nearest(
+		const BucketType & bucket,
+		const IndexEntry & pos,
+		const NavtexRecord * & best,
+		double & best_dot )
+	{
+		for( BucketType::const_iterator it = bucket.begin(), en = bucket.end(); it != en ; ++it )
+		{
+			double tmp_dot = pos.dot( *it );
+			if( tmp_dot > best_dot ) {
+				best_dot = tmp_dot ;
+				best = it->m_record ;
+			}
+		}
 	}
 
 public:
+	/// Loads the catalog and builds its index, so that it is not done
+	/// by the decoder when the first message is received.
+	static void preload(void) {
+		inst();
+	}
+
 	/// Usual frequencies are 490, 518 or 4209 kiloHertz.
 	static const NavtexRecord & Find(
 		long long freq_ll,
 		char origin,
 		const CoordinateT::Pair & coo )
 	{
-		SolutionType sol;
+		int ix_origin = toupper( origin ) - 'A' ;
+		if( ( ix_origin < 0 ) || ( ix_origin >= nb_origins ) ) return dflt_solution();
 
 		double freq = freq_ll / 1000.0 ; // As kiloHertz in the data file.
+		int ix_band = freq_band( freq );
 
-		bool okFreq = freq_acceptable( freq );
-
-		for( CatalogType::const_iterator it = inst().m_catalog.begin(), en = inst().m_catalog.end(); it != en ; ++it )
-		{
-			if( origin != it->origin() ) continue ;
-
-			bool freqClose = freq_close( freq, it->frequency() );
-			if( okFreq && ! freqClose ) continue ;
+		const IndexEntry pos( coo );
+		const NavtexCatalog & cat = inst();
+		const NavtexRecord * best = NULL ;
+		double best_dot = -2.0 ;
 
-			double dist = coo.distance( it->coordinates() );
-			sol.insert( SolutionType::value_type( dist, it ) );
+		/// If the frequency is not a usual one, any band is acceptable.
+		if( ix_band != nb_bands - 1 ) {
+			nearest( cat.m_index[ ix_origin ][ ix_band ], pos, best, best_dot );
+		} else {
+			for( int ix_bnd = 0; ix_bnd < nb_bands; ++ix_bnd ) {
+				nearest( cat.m_index[ ix_origin ][ ix_bnd ], pos, best, best_dot );
+			}
 		}
-		
-		return sol.empty() ? dflt_solution() : *( sol.begin()->second );
+
+		return best ? *best : dflt_solution();
 	}
 
 	static const NavtexRecord & Find(
@@ -349,6 +430,8 @@ public:
 	}
 }; // NavtexCatalog
 
+const NavtexCatalog * NavtexCatalog::s_inst = NULL ;
+
 class BiQuadraticFilter {
 public:
 	enum Type {
@@ -664,6 +747,10 @@ public:
 		init_members();
 	}
 
+	char origin(void) const { return m_origin; }
+	char subject(void) const { return m_subject; }
+	int number(void) const { return m_number; }
+
 	typedef std::pair<bool, ccir_message> detect_result ;
 	detect_result detect_header() {
 		size_t qlen = size();
@@ -719,15 +806,14 @@ public:
 		return end_seen ;
 	}
 
-	void display( const std::string & alt_string ) {
+	/// The frequency is the one of the channel which received the message.
+	void display( const std::string & alt_string, long long currFreq ) {
 		std::string::operator=( alt_string );
 		cleanup();
 		if( progdefaults.NVTX_AdifLog ) {
 			/// For updating the logbook with received messages.
 			cQsoRec qso_rec ;
 
-			long long currFreq = wf->rfcarrier();
-
 			if( ! progdefaults.myLocator.empty() ) {
 				const NavtexRecord & refStat = NavtexCatalog::Find(currFreq, m_origin, progdefaults.myLocator );
 				LOG_INFO("name=%s lon=%lf lat=%lf",
@@ -773,12 +859,12 @@ public:
 
 			qso_rec.putField(NOTES, c_str() );
 
-			qsodb.qsoNewRec (&qso_rec);
+			cQsoRec *added = qsodb.qsoNewRec (&qso_rec);
 			qsodb.isdirty(0);
 
 			loadBrowser(true);
 
-			adifFile.writeLog (logbook_filename.c_str(), &qsodb);
+			adifFile.appendLog (logbook_filename.c_str(), &qsodb, added);
 
 			LOG_INFO( _("Updating log book %s"), logbook_filename.c_str() );
 		}
@@ -791,6 +877,52 @@ static const double dflt_center_freq = 1000.0 ;
 
 class navtex ;
 
+/// A message sent by a station on several frequencies is received by all
+/// the channels listening to them: It must be logged once only.
+class navtex_dedup
+{
+	/// Beyond that, a message with the same header is a new broadcast.
+	static const time_t m_window_sec = 4 * 3600 ;
+
+	struct seen_type {
+		time_t m_time ;
+		int    m_channel ;
+	};
+	typedef std::map< std::string, seen_type > seen_map ;
+
+	static pthread_mutex_t s_mutex ;
+	static seen_map        s_seen ;
+public:
+	/// Messages without a header cannot be compared and are always new.
+	/// Repeats on the same channel are kept, as with a single decoder.
+	static bool is_new( char origin, char subject, int number, int channel )
+	{
+		if( ( origin == '?' ) || ( subject == '?' ) ) return true ;
+
+		char key[8];
+		snprintf( key, sizeof(key), "%c%c%02d", origin, subject, number );
+		time_t now = time(NULL);
+
+		guard_lock g( &s_mutex );
+		for( seen_map::iterator it = s_seen.begin(); it != s_seen.end(); ) {
+			if( now - it->second.m_time > m_window_sec ) s_seen.erase( it++ );
+			else ++it ;
+		}
+		seen_map::iterator it = s_seen.find( key );
+		if( ( it != s_seen.end() ) && ( it->second.m_channel != channel ) ) {
+			LOG_INFO("Message %s already received on channel %d", key, it->second.m_channel );
+			return false ;
+		}
+		seen_type & ref = s_seen[ key ];
+		ref.m_time = now ;
+		ref.m_channel = channel ;
+		return true ;
+	}
+};
+
+pthread_mutex_t navtex_dedup::s_mutex = PTHREAD_MUTEX_INITIALIZER ;
+navtex_dedup::seen_map navtex_dedup::s_seen ;
+
 class navtex_implementation {
 
 	enum State {
@@ -818,6 +950,11 @@ class navtex_implementation {
 
 	navtex                        * m_ptr_navtex ;
 
+	/// Zero for the decoder driven by the trx thread, which alone updates the GUI,
+	// the AFC and the logbook. Other channels hand their messages to it.
+	int                             m_channel ;
+	navtex_implementation         * m_primary ;
+
 	pthread_mutex_t                 m_mutex_tx ;
 	typedef std::list<std::string>  TxMsgQueueT ;
 	TxMsgQueueT                     m_tx_msg_queue ;
@@ -871,9 +1008,16 @@ class navtex_implementation {
 	navtex_implementation();
 	navtex_implementation & operator=( const navtex_implementation & );
 public:
-	navtex_implementation(int the_sample_rate, bool only_sitor_b, navtex * ptr_navtex ) {
+	navtex_implementation(
+		int the_sample_rate,
+		bool only_sitor_b,
+		navtex * ptr_navtex,
+		int channel = 0,
+		navtex_implementation * primary = NULL ) {
 		pthread_mutex_init( &m_mutex_tx, NULL );
 		m_ptr_navtex = ptr_navtex ;
+		m_channel = channel ;
+		m_primary = primary ;
 		m_only_sitor_b = only_sitor_b ;
 		m_message_counter = 1 ;
 		m_metric = 0.0 ;
@@ -1074,6 +1218,8 @@ private:
 	}
 
 	void filter_print(int c) {
+		/// Other channels would interleave their characters.
+		if( m_channel != 0 ) return ;
 		if (c == char_bell) {
 			/// TODO: It should be a beep, but French navtex displays a quote.
 			put_rx_char('\'');
@@ -1084,6 +1230,7 @@ private:
 
 	void compute_metric(void)
 	{
+		if( m_channel != 0 ) return ;
 		static double avg_ratio = 0.0 ;
 		static const double width_f = 10.0 ;
        		double numer_mark = wf->powerDensity(m_mark_f, width_f);
@@ -1101,6 +1248,7 @@ private:
 	}
 
 	void process_afc() {
+		if( m_channel != 0 ) return ;
 		if( progStatus.afconoff == false ) return ;
 		static size_t cnt_upd = 0 ;
 		static const size_t delay_upd = 50 ;
@@ -1189,6 +1337,7 @@ private:
 		* an end of emission idle signal alpha for at least 2 seconds.  */
 public:
 	void process_data(const double * data, int nb_samples) {
+		drain_channel_messages();
 		process_afc();
 		process_timeout();
 		for( int i =0; i < nb_samples; ++i ) {
@@ -1377,6 +1526,7 @@ public:
 	/// This updates the window label according to the state.
 	void set_label_from_state(void) const
 	{
+		if( m_channel != 0 ) return ;
 		put_status( state_to_str(m_state) );
 	}
 
@@ -1386,14 +1536,68 @@ private:
 	std::queue< std::string > m_received_messages ;
 
 	void display_message( ccir_message & ccir_msg, const std::string & alt_string ) {
-		if( ccir_msg.size() >= (size_t)progdefaults.NVTX_MinSizLoggedMsg )
+		if( ccir_msg.size() < (size_t)progdefaults.NVTX_MinSizLoggedMsg )
+		{
+			LOG_INFO("Do not log short message:%s", ccir_msg.c_str() );
+			return ;
+		}
+		if( ! navtex_dedup::is_new( ccir_msg.origin(), ccir_msg.subject(), ccir_msg.number(), m_channel ) )
 		{
-			ccir_msg.display(alt_string);
+			return ;
+		}
+		if( m_primary == NULL )
+		{
+			ccir_msg.display(alt_string, wf->rfcarrier());
 			put_received_message( alt_string );
 		}
 		else
 		{
-			LOG_INFO("Do not log short message:%s", ccir_msg.c_str() );
+			m_primary->post_channel_message( ccir_msg, alt_string, m_channel, m_center_frequency_f );
+		}
+	}
+
+	/// Messages decoded by the other channels, waiting for the trx thread.
+	struct channel_message {
+		ccir_message m_msg ;
+		std::string  m_alt_string ;
+		int          m_channel ;
+		double       m_carrier ;
+	};
+	syncobj m_sync_chan ;
+	std::deque< channel_message > m_channel_messages ;
+
+	void post_channel_message( const ccir_message & ccir_msg, const std::string & alt_string, int channel, double carrier )
+	{
+		channel_message tmp ;
+		tmp.m_msg = ccir_msg ;
+		tmp.m_alt_string = alt_string ;
+		tmp.m_channel = channel ;
+		tmp.m_carrier = carrier ;
+		guard_lock g( m_sync_chan.mtxp() );
+		m_channel_messages.push_back( tmp );
+	}
+
+	/// Logs and displays the messages of the other channels, in the trx thread.
+	void drain_channel_messages(void)
+	{
+		std::deque< channel_message > tmp_msgs ;
+		{
+			guard_lock g( m_sync_chan.mtxp() );
+			if( m_channel_messages.empty() ) return ;
+			tmp_msgs.swap( m_channel_messages );
+		}
+		for( size_t i = 0; i < tmp_msgs.size(); ++i ) {
+			channel_message & ref = tmp_msgs[i];
+			/// Same convention as the primary channel, shifted by the audio offset.
+			double offset = ref.m_carrier - m_center_frequency_f ;
+			long long rf_freq = wf->rfcarrier() + (long long)( wf->USB() ? offset : -offset );
+			ref.m_msg.display( ref.m_alt_string, rf_freq );
+			put_received_message( ref.m_alt_string );
+
+			std::string txt = strformat( "\n[%d:%.0f Hz] ", ref.m_channel, ref.m_carrier ) + ref.m_alt_string + "\n" ;
+			for( size_t j = 0; j < txt.size(); ++j ) {
+				put_rx_char( (unsigned char)txt[j] );
+			}
 		}
 	}
 
@@ -1609,6 +1813,84 @@ public:
 
 }; // navtex_implementation
 
+/// An additional decoder on another audio carrier, with its own thread.
+/// The trx thread only copies the samples, so all channels decode in parallel.
+class navtex_channel
+{
+	navtex_implementation m_impl ;
+	pthread_t             m_thread ;
+	syncobj               m_sync ;
+	std::vector<double>   m_samples ; // Filled by the trx thread.
+	bool                  m_stop ;
+	int                   m_max_samples ;
+
+	navtex_channel( const navtex_channel & );
+	navtex_channel & operator=( const navtex_channel & );
+
+	static void * run( void * arg )
+	{
+		navtex_channel * chan = static_cast< navtex_channel * >( arg );
+		std::vector<double> work ;
+		for( ; ; ) {
+			{
+				guard_lock g( chan->m_sync.mtxp() );
+				while( chan->m_samples.empty() && ! chan->m_stop ) {
+					chan->m_sync.wait( 1.0 );
+				}
+				if( chan->m_stop ) break ;
+				work.swap( chan->m_samples );
+			}
+			chan->m_impl.process_data( &work[0], work.size() );
+			work.clear();
+		}
+		return NULL ;
+	}
+public:
+	navtex_channel(
+		int sample_rate,
+		bool only_sitor_b,
+		navtex * ptr_navtex,
+		int channel,
+		navtex_implementation * primary,
+		double carrier )
+	: m_impl( sample_rate, only_sitor_b, ptr_navtex, channel, primary )
+	, m_stop( false )
+	/// A late channel loses its oldest samples rather than growing without limit.
+	, m_max_samples( 10 * sample_rate )
+	{
+		m_impl.set_carrier( carrier );
+		int rc = pthread_create( &m_thread, NULL, run, this );
+		if( rc ) {
+			LOG_ERROR("Cannot start channel %d: %s", channel, strerror(rc) );
+			m_stop = true ;
+		}
+	}
+
+	~navtex_channel()
+	{
+		{
+			guard_lock g( m_sync.mtxp() );
+			if( m_stop ) return ;
+			m_stop = true ;
+			m_sync.signal();
+		}
+		pthread_join( m_thread, NULL );
+	}
+
+	void push( const double * buf, int len )
+	{
+		guard_lock g( m_sync.mtxp() );
+		if( m_stop ) return ;
+		m_samples.insert( m_samples.end(), buf, buf + len );
+		int excess = (int)m_samples.size() - m_max_samples ;
+		if( excess > 0 ) {
+			LOG_WARN("Dropping %d samples", excess );
+			m_samples.erase( m_samples.begin(), m_samples.begin() + excess );
+		}
+		m_sync.signal();
+	}
+}; // navtex_channel
+
 #ifdef NAVTEX_COMMAND_LINE
 int main(int n, const char ** v )
 {
@@ -1651,10 +1933,34 @@ navtex::navtex (trx_mode md)
 		default          : LOG_ERROR("Unknown mode");
 	}
 	m_impl = new navtex_implementation( modem::samplerate, only_sitor_b, this );
+	if( progdefaults.NVTX_AdifLog ) {
+		NavtexCatalog::preload();
+	}
+
+	/// Audio frequencies of the other channels, separated by semicolons.
+	std::stringstream carriers( progdefaults.NVTX_ExtraCarriers );
+	std::string carrier_str ;
+	while( std::getline( carriers, carrier_str, ';' ) ) {
+		double carrier = atof( carrier_str.c_str() );
+		if( ( carrier <= deviation_f ) || ( carrier >= modem::samplerate / 2 - deviation_f ) ) {
+			if( ! carrier_str.empty() ) {
+				LOG_WARN("Invalid channel frequency:%s", carrier_str.c_str() );
+			}
+			continue ;
+		}
+		int channel = m_channels.size() + 1 ;
+		LOG_INFO("Channel %d at %f Hz", channel, carrier );
+		m_channels.push_back( new navtex_channel(
+			modem::samplerate, only_sitor_b, this, channel, m_impl, carrier ) );
+	}
 }
 
 navtex::~navtex()
 {
+	/// The channels post their messages to the main decoder.
+	for( size_t i = 0; i < m_channels.size(); ++i ) {
+		delete m_channels[i];
+	}
 	if( m_impl )
 	{
 		delete m_impl ;
@@ -1671,6 +1977,9 @@ void navtex::restart()
 
 int  navtex::rx_process(const double *buf, int len)
 {
+	for( size_t i = 0; i < m_channels.size(); ++i ) {
+		m_channels[i]->push( buf, len );
+	}
 	m_impl->process_data( buf, len );
 	return 0;
 }
@@ -240,16 +240,15 @@ int olivia::rx_process(const double *buf, int len)
 		clamp(progStatus.sldrSquelchValue / 5.0 + 3.0, 0, 90.0) : 0.0;
 
     Rx->Process(buf, len);
-	sp = 0;
-//	for (int i = frequency - Rx->Bandwidth/2; i < frequency - 1 + Rx->Bandwidth/2; i++)
-	for (int i = frequency - fc_offset; i < frequency + fc_offset; i++)
-		if (wf->Pwr(i) > sp)
-			sp = wf->Pwr(i);
-	np = wf->Pwr(static_cast<int>(frequency + Rx->Bandwidth/2 + 2*Rx->Bandwidth/Rx->Tones));
-	if (np == 0) np = sp + 1e-8;
-	sigpwr = decayavg( sigpwr, sp, 10);
-	noisepwr = decayavg( noisepwr, np, 50);
-	snr = CLAMP(sigpwr / noisepwr, 0.001, 100000);
+// S/N from the demodulator's input spectra: the energy in the signal band,
+// less its noise, against the mean energy per bin of the SyncMargin bins
+// either side of the band
+	if (Rx->SpectraLevels(sp, np)) {
+		if (np == 0) np = sp + 1e-8;
+		sigpwr = decayavg( sigpwr, sp, 10);
+		noisepwr = decayavg( noisepwr, np, 50);
+		snr = CLAMP(sigpwr / noisepwr, 0.001, 100000);
+	}
 
 	metric = clamp( 5.0 * (Rx->SignalToNoiseRatio() - 3.0), 0, 100);
 	display_metric(metric);
@@ -262,7 +261,8 @@ int olivia::rx_process(const double *buf, int len)
 		}
     }
 	if (gotchar) {
-		snprintf(msg1, sizeof(msg1), "s/n: %4.1f dB", 10*log10(snr) - 20);
+		snprintf(msg1, sizeof(msg1), "s/n: %4.1f dB",
+			 10*log10(snr * Rx->FrequencyBin() / 2500.0));
 		put_Status1(msg1, 5, STATUS_CLEAR);
 		snprintf(msg2, sizeof(msg2), "f/o %+4.1f Hz", Rx->FrequencyOffset());
 		put_Status2(msg2, 5, STATUS_CLEAR);
@@ -0,0 +1,118 @@
+// ----------------------------------------------------------------------------
+// pskdemod.cxx  --  BPSK symbol and varicode decoder
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include "pskdemod.h"
+#include "pskcoeff.h"
+#include "pskvaricode.h"
+#include "misc.h"
+
+pskdemod::pskdemod()
+{
+	double fir2c[FIRLEN];
+
+	wsincfilt(fir2c, 1.0 / 16.0, true);	// matched sin(x)/x filter w blackman
+	fir2.init(FIRLEN, 1, fir2c, fir2c);
+	reset();
+}
+
+void pskdemod::reset()
+{
+	phase = 0.0;
+	bits = 0;
+	quality = complex(0.0, 0.0);
+	for (int i = 0; i < 16; i++)
+		syncbuf[i] = 0.0;
+	bitclk = 0.0;
+	prevsymbol = complex(1.0, 0.0);
+	shreg = 0;
+	dcdshreg = 0;
+}
+
+bool pskdemod::sync(complex z, complex& symbol)
+{
+	double sum = 0.0, ampsum = 0.0;
+	int idx = (int)bitclk;
+
+	fir2.run(z, symbol);
+	syncbuf[idx] = 0.8 * syncbuf[idx] + 0.2 * symbol.mag();
+
+	for (int i = 0; i < 8; i++) {
+		sum += (syncbuf[i] - syncbuf[i+8]);
+		ampsum += (syncbuf[i] + syncbuf[i+8]);
+	}
+	sum = (ampsum == 0 ? 0 : sum / ampsum);
+
+	bitclk -= sum / 5.0;
+	bitclk += 1;
+
+	if (bitclk < 0) bitclk += 16.0;
+	if (bitclk >= 16.0) {
+		bitclk -= 16.0;
+		return true;
+	}
+	return false;
+}
+
+int pskdemod::rx_symbol(complex symbol, int decay)
+{
+	phase = (prevsymbol % symbol).arg();
+	prevsymbol = symbol;
+
+	if (phase < 0)
+		phase += 2 * M_PI;
+
+	bits = (((int) (phase / M_PI + 0.5)) & 1) << 1;
+	dcdshreg = (dcdshreg << 2) | bits;
+
+	switch (dcdshreg) {
+	case 0xAAAAAAAA:	/* DCD on by preamble */
+		quality = complex (1.0, 0.0);
+		return DCD_PREAMBLE;
+	case 0:			/* DCD off by postamble */
+		quality = complex (0.0, 0.0);
+		return DCD_POSTAMBLE;
+	default:
+		quality.re = decayavg(quality.re, cos(2 * phase), decay);
+		quality.im = decayavg(quality.im, sin(2 * phase), decay);
+		return DCD_NONE;
+	}
+}
+
+int pskdemod::rx_bit()
+{
+	int c;
+
+	shreg = (shreg << 1) | !bits;
+	if ((shreg & 3) == 0) {
+		c = psk_varicode_decode(shreg >> 2);
+		shreg = 0;
+		return c;
+	}
+	return -1;
+}
+
+double pskdemod::freqerr(double samplerate, int symbollen) const
+{
+	double error = phase - bits * M_PI / 2;
+	if (error < M_PI / 2.0) error += 2 * M_PI;
+	if (error > M_PI / 2.0) error -= 2 * M_PI;
+	return error * (samplerate / (symbollen * 2 * M_PI)) / 16.0;
+}
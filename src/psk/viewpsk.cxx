@@ -30,16 +30,20 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <ctime>
 
 #include "viewpsk.h"
 #include "pskeval.h"
 #include "pskcoeff.h"
-#include "pskvaricode.h"
 #include "misc.h"
 #include "configuration.h"
 #include "Viewer.h"
 #include "qrunner.h"
 #include "status.h"
+#include "timeops.h"
+#include "debug.h"
+
+LOG_FILE_SOURCE(debug::LOG_MODEM);
 
 extern waterfall *wf;
 
@@ -49,13 +53,29 @@ extern waterfall *wf;
 //#define SQLDECAY 50
 #define SQLDECAY 20
 //=====================================================================
+// interval between CPU time reports, in seconds of audio
+#define VREPORTINTERVAL 600.0
+
+#ifdef CLOCK_THREAD_CPUTIME_ID
+#  define VCPUCLOCK CLOCK_THREAD_CPUTIME_ID
+#else
+#  define VCPUCLOCK CLOCK_MONOTONIC
+#endif
+
+static double cputime(void)
+{
+	struct timespec t;
+	clock_gettime(VCPUCLOCK, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
 
 viewpsk::viewpsk(pskeval* eval, trx_mode pskmode)
 {
-	for (int i = 0; i < MAXCHANNELS; i++) {
-		channel[i].fir1 = (C_FIR_filter *)0;
-		channel[i].fir2 = (C_FIR_filter *)0;
-	}
+	for (int i = 0; i < MAXCHANNELS; i++)
+		channel[i].cpu = channel[i].audio = 0.0;
+	chz_cpu = audio = 0.0;
+	nout = 0;
+	pool = new fork_join(CLAMP(fork_join::ncpus() - 1, 0, VMAXWORKERS));
 
 	evalpsk = eval;
 	viewmode = MODE_PREV;
@@ -64,10 +84,8 @@ viewpsk::viewpsk(pskeval* eval, trx_mode pskmode)
 
 viewpsk::~viewpsk()
 {
-	for (int i = 0; i < MAXCHANNELS; i++) {
-		if (channel[i].fir1) delete channel[i].fir1;
-		if (channel[i].fir2) delete channel[i].fir2;
-	}
+	report();
+	delete pool;
 }
 
 void viewpsk::init()
@@ -77,19 +95,14 @@ void viewpsk::init()
 
 	for (int i = 0; i < MAXCHANNELS; i++) {
 		channel[i].phaseacc = 0;
-		channel[i].prevsymbol = complex (1.0, 0.0);
-		channel[i].quality = complex (0.0, 0.0);
-		channel[i].shreg = 0;
-		channel[i].dcdshreg = 0;
+		channel[i].demod.reset();
 		channel[i].dcd = false;
-		channel[i].bitclk = 0;
 		channel[i].freqerr = 0.0;
 		channel[i].timeout = 0;
 		channel[i].frequency = NULLFREQ;
 		channel[i].reset = false;
 		channel[i].acquire = 0;
-		for (int j = 0; j < 16; j++)
-			channel[i].syncbuf[j] = 0.0;
+		channel[i].chars.clear();
 	}
 	for (int i = 0; i < nchannels; i++)
 		REQ(&viewclearchannel, i);
@@ -103,9 +116,6 @@ void viewpsk::restart(trx_mode pskmode)
 	if (viewmode == pskmode) return;
 	viewmode = pskmode;
 
-	double			fir1c[64];
-	double			fir2c[64];
-
 	switch (viewmode) {
 	case MODE_PSK31:
 		symbollen = 256;
@@ -137,21 +147,13 @@ void viewpsk::restart(trx_mode pskmode)
 		break;
 	}
 
-	wsincfilt(fir1c, 1.0 / symbollen, true);	// creates fir1c matched sin(x)/x filter w blackman
-	wsincfilt(fir2c, 1.0 / 16.0, true);			// creates fir2c matched sin(x)/x filter w blackman
-
-	for (int i = 0; i < MAXCHANNELS; i++) {
-		if (channel[i].fir1) delete channel[i].fir1;
-		channel[i].fir1 = new C_FIR_filter();
-		channel[i].fir1->init(FIRLEN, symbollen / 16, fir1c, fir1c);
-
-		if (channel[i].fir2) delete channel[i].fir2;
-		channel[i].fir2 = new C_FIR_filter();
-		channel[i].fir2->init(FIRLEN, 1, fir2c, fir2c);
-	}
-
 	bandwidth = VPSKSAMPLERATE / symbollen;
 
+// replaces the per channel mixer and decimating filter; a channel may lie
+// anywhere in its bin and has a bandwidth either side of it
+	chz.init(VNUMBINS, symbollen / 16, VPSKSAMPLERATE,
+		 0.5 * VPSKSAMPLERATE / VNUMBINS + bandwidth);
+
 	init();
 }
 
@@ -159,33 +161,23 @@ void viewpsk::restart(trx_mode pskmode)
 //========================= viewpsk receive routines ==========================
 //=============================================================================
 
-void viewpsk::rx_bit(int ch, int bit)
+void viewpsk::rx_bit(int ch)
 {
-	int c;
-	channel[ch].shreg = (channel[ch].shreg << 1) | !!bit;
-	if ((channel[ch].shreg & 3) == 0) {
-		c = psk_varicode_decode(channel[ch].shreg >> 2);
-		channel[ch].shreg = 0;
-		if (c == -1) return;
-		if (c == '\n' || c == '\r') c = ' ';
-		if (iscntrl(c & 0xFF)) return;
-		REQ(&viewaddchr, ch, (int)channel[ch].frequency, c, viewmode);
-	}
+	int c = channel[ch].demod.rx_bit();
+	if (c == -1) return;
+	if (c == '\n' || c == '\r') c = ' ';
+	if (iscntrl(c & 0xFF)) return;
+	channel[ch].chars.push_back(VIEWCHR((int)channel[ch].frequency, c));
 }
 
 void viewpsk::afc(int ch)
 {
 	if (channel[ch].dcd == true || channel[ch].acquire) {
-		double error;
 		double lower_bound = (lowfreq + ch * 100) - bandwidth;
 		if (lower_bound < bandwidth) lower_bound = bandwidth;
 		double upper_bound = lowfreq + (ch+1)*100 + bandwidth;
 
-		error = (channel[ch].phase - channel[ch].bits * M_PI / 2);
-		if (error < M_PI / 2.0) error += 2 * M_PI;
-		if (error > M_PI / 2.0) error -= 2 * M_PI;
-		error *= (VPSKSAMPLERATE / (symbollen * 2 * M_PI))/16.0;
-		channel[ch].frequency -= error;
+		channel[ch].frequency -= channel[ch].demod.freqerr(VPSKSAMPLERATE, symbollen);
 		channel[ch].frequency = CLAMP(channel[ch].frequency, lower_bound, upper_bound);
 	}
 	if (channel[ch].acquire) channel[ch].acquire--;
@@ -281,44 +273,25 @@ nexti: ;
 
 void viewpsk::rx_symbol(int ch, complex symbol)
 {
-	int n;
-
-	channel[ch].phase = (channel[ch].prevsymbol % symbol).arg();
-	channel[ch].prevsymbol = symbol;
-
-	if (channel[ch].phase < 0)
-		channel[ch].phase += 2 * M_PI;
-
-	channel[ch].bits = (((int) (channel[ch].phase / M_PI + 0.5)) & 1) << 1;
-	n = 2; // psk
-
-	channel[ch].dcdshreg = (channel[ch].dcdshreg << 2) | channel[ch].bits;
-
-	switch (channel[ch].dcdshreg) {
-	case 0xAAAAAAAA:	/* DCD on by preamble */
+	switch (channel[ch].demod.rx_symbol(symbol, SQLDECAY)) {
+	case pskdemod::DCD_PREAMBLE:
 		if (!channel[ch].dcd)
-			REQ(&viewaddchr, ch, (int)channel[ch].frequency, 0, viewmode);
+			channel[ch].chars.push_back(VIEWCHR((int)channel[ch].frequency, 0));
 		channel[ch].dcd = true;
-		channel[ch].quality = complex (1.0, 0.0);
 		channel[ch].metric = 100;
 		channel[ch].timeout = progdefaults.VIEWERtimeout * VPSKSAMPLERATE / WFBLOCKSIZE;
 		channel[ch].acquire = 0;
 		break;
 
-	case 0:			/* DCD off by postamble */
+	case pskdemod::DCD_POSTAMBLE:
 		channel[ch].dcd = false;
-		channel[ch].quality = complex (0.0, 0.0);
 		channel[ch].metric = 0;
 		channel[ch].acquire = 0;
 //		channel[ch].frequency = NULLFREQ;
 		break;
 
 	default:
-		channel[ch].quality.re = 
-			decayavg(channel[ch].quality.re, cos(n*channel[ch].phase), SQLDECAY);
-		channel[ch].quality.im = 
-			decayavg(channel[ch].quality.im, sin(n*channel[ch].phase), SQLDECAY);
-		channel[ch].metric = channel[ch].quality.norm();
+		channel[ch].metric = channel[ch].demod.quality.norm();
 		if (channel[ch].metric > (progStatus.VIEWER_psksquelch + 6.0)/26.0) {
 			channel[ch].dcd = true;
 		} else {
@@ -328,57 +301,95 @@ void viewpsk::rx_symbol(int ch, complex symbol)
 
 	if (channel[ch].dcd == true) {
 		channel[ch].timeout = progdefaults.VIEWERtimeout * VPSKSAMPLERATE / WFBLOCKSIZE;
-		rx_bit(ch, !channel[ch].bits);
+		rx_bit(ch);
 		channel[ch].acquire = 0;
 	}
 }
 
-int viewpsk::rx_process(const double *buf, int len)
+// Shifts the channel's bin to baseband and decodes the symbols in it.  Runs
+// on the trx thread or a worker thread; the characters are kept until the
+// trx thread can pass them on.
+void viewpsk::rx_channel(int ch)
 {
-	double sum;
-	double ampsum;
-	int idx;
 	complex z, z2;
+	CHANNEL& chan = channel[ch];
+	int decim = chz.get_decim();
+
+	for (int n = 0; n < nout; n++) {
+// the bin is mixed with the channel frequency at the decimated rate
+		z = chz.output(n)[chan.bin] * complex(cos(chan.phaseacc), sin(chan.phaseacc));
+		chan.phaseacc += 2.0 * M_PI * chan.frequency * decim / VPSKSAMPLERATE;
+		if (chan.phaseacc > M_PI)
+			chan.phaseacc -= 2.0 * M_PI * floor(chan.phaseacc / (2.0 * M_PI) + 0.5);
+
+		if (chan.demod.sync(z, z2)) {
+			rx_symbol(ch, z2);
+			afc(ch);
+		}
+	}
+}
+
+// runs on the trx thread or a pool thread
+void viewpsk::rx_job(void* arg, size_t i)
+{
+	viewpsk* v = static_cast<viewpsk*>(arg);
+	int ch = v->active[i];
+	double t0 = cputime();
+	v->rx_channel(ch);
+	v->channel[ch].cpu += cputime() - t0;
+}
+
+void viewpsk::report()
+{
+	double cpu = 0.0, chan_audio = 0.0, cmax = 0.0;
+	for (int ch = 0; ch < MAXCHANNELS; ch++) {
+		cpu += channel[ch].cpu;
+		chan_audio += channel[ch].audio;
+		if (channel[ch].audio > 0.0)
+			cmax = MAX(cmax, channel[ch].cpu / channel[ch].audio);
+		channel[ch].cpu = channel[ch].audio = 0.0;
+	}
+	if (audio > 0.0 && chan_audio > 0.0)
+		LOG_VERBOSE("channelizer %.3f%% of real time, %" PRIuSZ " taps; "
+			    "%.3f%% per channel on average, %.3f%% at most; %d worker threads",
+			    100.0 * chz_cpu / audio, chz.get_taps(),
+			    100.0 * cpu / chan_audio, 100.0 * cmax, pool->size() - 1);
+	chz_cpu = audio = 0.0;
+}
 
+int viewpsk::rx_process(const double *buf, int len)
+{
 	if (nchannels != progdefaults.VIEWERchannels || lowfreq != progdefaults.LowFreqCutoff)
 		init();
 
-// process all channels
+// filter & decimate all channels at once
+	double t0 = cputime();
+	nout = chz.process(buf, len);
+	chz_cpu += cputime() - t0;
+	audio += (double)len / VPSKSAMPLERATE;
+
+	active.clear();
 	for (int ch = 0; ch < nchannels; ch++) {
 		if (channel[ch].frequency == NULLFREQ) continue;
-		for (int ptr = 0; ptr < len; ptr++) {
-// Mix with the internal NCO for each channel
-			z = complex ( buf[ptr] * cos(channel[ch].phaseacc), buf[ptr] * sin(channel[ch].phaseacc) );
-			channel[ch].phaseacc += 2.0 * M_PI * channel[ch].frequency / VPSKSAMPLERATE;
-// filter & decimate
-			if (channel[ch].fir1->run( z, z )) {
-				channel[ch].fir2->run( z, z2 );
-				idx = (int) channel[ch].bitclk;
-				sum = 0.0;
-				ampsum = 0.0;
-				channel[ch].syncbuf[idx] = 0.8 * channel[ch].syncbuf[idx] + 0.2 * z2.mag();
-
-				for (int i = 0; i < 8; i++) {
-					sum += (channel[ch].syncbuf[i] - channel[ch].syncbuf[i+8]);
-					ampsum += (channel[ch].syncbuf[i] + channel[ch].syncbuf[i+8]);
-				}
-				sum = (ampsum == 0 ? 0 : sum / ampsum);
+		channel[ch].bin = chz.bin(channel[ch].frequency);
+		channel[ch].audio += (double)len / VPSKSAMPLERATE;
+		active.push_back(ch);
+	}
 
-				channel[ch].bitclk -= sum / 5.0;
-				channel[ch].bitclk += 1;
+// process all channels
+	pool->run(rx_job, this, active.size());
 
-				if (channel[ch].bitclk < 0) channel[ch].bitclk += 16.0;
-				if (channel[ch].bitclk >= 16.0) {
-					channel[ch].bitclk -= 16.0;
-					rx_symbol(ch, z2);
-					afc(ch);
-				}
-			}
-		}
+	for (size_t i = 0; i < active.size(); i++) {
+		CHANNEL& chan = channel[active[i]];
+		for (size_t j = 0; j < chan.chars.size(); j++)
+			REQ(&viewaddchr, active[i], chan.chars[j].freq, chan.chars[j].c, viewmode);
+		chan.chars.clear();
 	}
 
 	findsignals();
 
+	if (unlikely(audio >= VREPORTINTERVAL))
+		report();
 
 	return 0;
 }
@@ -47,7 +47,7 @@
 #endif
 
 qrunner::qrunner()
-        : attached(false), inprog(false), drop_flag(false)
+        : attached(false), inprog(false), drop_flag(false), nfull(0)
 {
         fifo = new fqueue(FIFO_SIZE);
 #ifndef __WOE32__
@@ -24,7 +24,14 @@
 
 #include <ctime>
 #include <sys/time.h>
+#ifndef __MINGW32__
+#  include <sys/select.h>
+#  include <unistd.h>
+#  include <fcntl.h>
+#endif
+#include <errno.h>
 #include <iostream>
+#include <algorithm>
 #include <list>
 #include <vector>
 #include <string>
@@ -44,6 +51,7 @@
 #include "rigio.h"
 #include "debug.h"
 #include "threads.h"
+#include "timeops.h"
 #include "qrunner.h"
 #include "confdialog.h"
 #include "status.h"
@@ -69,12 +77,40 @@ static long long	llFreq = 0;
 static bool nonCATrig = false;
 
 static void *rigCAT_loop(void *args);
+static void rigCAT_wake(void);
+static bool rigCAT_open_wake(void);
+static void rigCAT_close_wake(void);
 
 #define RXBUFFSIZE 2000
 static unsigned char replybuff[RXBUFFSIZE+1];
-static unsigned char retbuf[3];
 
-bool sendCommand (string s, int retnbr)
+static long long ms_now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000LL + t.tv_nsec / 1000000;
+}
+
+// Finds the last frame of len bytes in buf that starts with pre, or the last
+// len bytes if pre is empty.  Returns -1 if there is none.
+static int find_frame(const unsigned char* buf, int n, int len, const string& pre)
+{
+	if (n < len)
+		return -1;
+	if (pre.empty())
+		return n - len;
+	for (int i = n - len; i >= 0; i--)
+		if (!memcmp(buf + i, pre.data(), pre.length()))
+			return i;
+	return -1;
+}
+
+// Sends s and reads the reply as it arrives, rather than sleeping for the
+// worst case and then reading one byte at a time.  The reply is complete
+// once retnbr bytes, plus the echo if there is one, have been read and, if
+// the rig's reply starts with the fixed string pre, a frame that starts with
+// pre fits in them.  The reply is left at the start of replybuff.
+bool sendCommand (string s, int retnbr, const string& pre = "")
 {
 	int numwrite = (int)s.length();
 	int readafter = progdefaults.RigCatWait;
@@ -86,6 +122,7 @@ bool sendCommand (string s, int retnbr)
 		progdefaults.RigCatWait + (int) ceilf (
 			numread * (9 + progdefaults.RigCatStopbits) *
 			1000.0 / rigio.Baud() );
+	int expected = numread;
 
 	LOG_DEBUG("%s", str2hex(s.data(), s.length()));
 
@@ -95,16 +132,40 @@ bool sendCommand (string s, int retnbr)
 
 	memset(replybuff, 0, RXBUFFSIZE + 1);
 	numread = 0;
-	MilliSleep( readafter );
+
+	if (expected == 0) { // give the rig time to act on the command
+		MilliSleep( readafter );
+		while (rigio.ReadAvailable(replybuff, RXBUFFSIZE, 0) > 0)
+			;
+		memset(replybuff, 0, RXBUFFSIZE + 1);
+		return true;
+	}
+
+	// wait up to readafter for the reply to start, then as long as
+	// characters keep arriving within the port timeout
+	int frame = -1;
+	long long deadline = ms_now() + readafter + rigio.Timeout();
 	while (numread < RXBUFFSIZE) {
-		memset(retbuf, 0, 2);
-		if (rigio.ReadBuffer(retbuf, 1) == 0) break;
-		replybuff[numread] = retbuf[0];
-		numread++;
+		long long wait = deadline - ms_now();
+		if (wait < 0)
+			break;
+		retval = rigio.ReadAvailable(replybuff + numread, RXBUFFSIZE - numread, (int)wait);
+		if (retval < 0)
+			break;
+		if (retval == 0)
+			continue;
+		numread += retval;
+		if (numread >= expected &&
+		    (frame = find_frame(replybuff, numread, retnbr, pre)) >= 0)
+			break;
+		deadline = max(deadline, ms_now() + rigio.Timeout());
 	}
 	LOG_DEBUG("reply %s", str2hex(replybuff, numread));
-	if (numread > retnbr) {
-		memmove(replybuff, replybuff + numread - retnbr, retnbr);
+	if (frame < 0 && numread >= retnbr)
+		frame = numread - retnbr;
+	if (frame >= 0) {
+		memmove(replybuff, replybuff + frame, retnbr);
+		memset(replybuff + retnbr, 0, RXBUFFSIZE + 1 - retnbr);
 		numread = retnbr;
 	}
 
@@ -304,12 +365,53 @@ long long fm_freqdata(DATA d, size_t p)
 	return fret;
 }
 
+// Checks the frequency reply in replybuff against rTemp and converts its
+// data field
+static bool parse_freq(const XMLIOS& rTemp, long long& f)
+{
+	size_t p = 0, pData = 0;
+	size_t len1 = rTemp.str1.size(), len2 = rTemp.str2.size();
+
+// check the pre data string
+	if (len1) {
+		for (size_t i = 0; i < len1; i++) {
+			if ((char)rTemp.str1[i] != (char)replybuff[i]) {
+				LOG_VERBOSE("failed pre data string test @ %" PRIuSZ, i);
+				return false;
+			}
+		}
+		p = len1;
+	}
+	if (rTemp.fill1) p += rTemp.fill1;
+	pData = p;
+	if (rTemp.data.dtype == "BCD") {
+		p += rTemp.data.size / 2;
+		if (rTemp.data.size & 1) p++;
+	} else
+		p += rTemp.data.size;
+// check the post data string
+	if (rTemp.fill2) p += rTemp.fill2;
+
+	if (len2) {
+		for (size_t i = 0; i < len2; i++)
+			if ((char)rTemp.str2[i] != (char)replybuff[p + i]) {
+				LOG_VERBOSE("failed post data string test @ %" PRIuSZ, i);
+				return false;
+			}
+	}
+// convert the data field
+	f = fm_freqdata(rTemp.data, pData);
+	if ( f >= rTemp.data.min && f <= rTemp.data.max)
+		return true;
+	LOG_VERBOSE("freq: %lld", f);
+	return false;
+}
+
 long long rigCAT_getfreq(int retries, bool &failed)
 {
 	XMLIOS modeCmd;
 	list<XMLIOS>::iterator itrCmd;
 	string strCmd;
-	size_t p = 0, len1 = 0, len2 = 0, pData = 0;
 	long long f = 0;
 
 	failed = false;
@@ -348,53 +450,18 @@ long long rigCAT_getfreq(int retries, bool &failed)
 			continue;
 
 		XMLIOS  rTemp = *preply;
-		len1 = rTemp.str1.size();
-		len2 = rTemp.str2.size();
 
 //		for (int n = 0; n < progdefaults.RigCatRetries; n++) {
 		for (int n = 0; n < retries; n++) {
 			if (n && progdefaults.RigCatTimeout > 0)
 				MilliSleep(progdefaults.RigCatTimeout);
 // send the command
-			if ( !sendCommand(strCmd, rTemp.size) ) {
+			if ( !sendCommand(strCmd, rTemp.size, rTemp.str1) ) {
 				LOG_VERBOSE("sendCommand failed");
-				goto retry_get_freq;
+				continue;
 			}
-// check the pre data string
-			p = 0;
-			pData = 0;
-			if (len1) {
-				for (size_t i = 0; i < len1; i++) {
-					if ((char)rTemp.str1[i] != (char)replybuff[i]) {
-						LOG_VERBOSE("failed pre data string test @ %" PRIuSZ, i);
-						goto retry_get_freq;
-					}
-				}
-				p = len1;
-			}
-			if (rTemp.fill1) p += rTemp.fill1;
-			pData = p;
-			if (rTemp.data.dtype == "BCD") {
-				p += rTemp.data.size / 2;
-				if (rTemp.data.size & 1) p++;
-			} else
-				p += rTemp.data.size;
-// check the post data string
-			if (rTemp.fill2) p += rTemp.fill2;
-
-			if (len2) {
-				for (size_t i = 0; i < len2; i++)
-					if ((char)rTemp.str2[i] != (char)replybuff[p + i]) {
-						LOG_VERBOSE("failed post data string test @ %" PRIuSZ, i);
-						goto retry_get_freq;
-					}
-			}
-// convert the data field
-			f = fm_freqdata(rTemp.data, pData);
-			if ( f >= rTemp.data.min && f <= rTemp.data.max)
+			if (parse_freq(rTemp, f))
 				return f;
-			LOG_VERBOSE("freq: %lld", f);
-retry_get_freq: ;
 		}
 	}
 	if (progdefaults.RigCatVSP == false)
@@ -403,7 +470,7 @@ retry_get_freq: ;
 	return 0;
 }
 
-void rigCAT_setfreq(long long f)
+static void rigCAT_do_setfreq(long long f)
 {
 	XMLIOS modeCmd;
 	list<XMLIOS>::iterator itrCmd;
@@ -447,7 +514,7 @@ void rigCAT_setfreq(long long f)
 				bool ok = false;
 				for (int n = 0; n < progdefaults.RigCatRetries; n++) {
 					pthread_mutex_lock(&rigCAT_mutex);
-					ok = sendCommand(strCmd, rTemp.size);
+					ok = sendCommand(strCmd, rTemp.size, rTemp.str1);
 					pthread_mutex_unlock(&rigCAT_mutex);
 					if (ok) return;
 				}
@@ -468,14 +535,70 @@ void rigCAT_setfreq(long long f)
 		LOG_VERBOSE("Retries failed");
 }
 
+// Checks the mode reply in replybuff against rTemp and looks up its data
+// field
+static bool parse_mode(const XMLIOS& rTemp, string& md)
+{
+	list<MODE>::iterator mode;
+	list<MODE> *pmode;
+	string mData;
+	size_t p = 0, pData = 0;
+// check the pre data string
+	size_t len = rTemp.str1.size();
+	if (len) {
+		for (size_t i = 0; i < len; i++)
+			if ((char)rTemp.str1[i] != (char)replybuff[i]) {
+				LOG_VERBOSE("failed pre data string test @ %" PRIuSZ, i);
+				return false;
+			}
+		p = len;
+	}
+	if (rTemp.fill1) p += rTemp.fill1;
+	pData = p;
+// check the post data string
+	p += rTemp.data.size;
+	len = rTemp.str2.size();
+	if (rTemp.fill2) p += rTemp.fill2;
+	if (len) {
+		for (size_t i = 0; i < len; i++)
+			if ((char)rTemp.str2[i] != (char)replybuff[p + i])
+				return false;
+	}
+// convert the data field
+	mData = "";
+	for (int i = 0; i < rTemp.data.size; i++)
+		mData += (char)replybuff[pData + i];
+// for FT100 and the ilk that use bit fields
+	if (rTemp.data.size == 1) {
+		unsigned char d = mData[0];
+		if (rTemp.data.shiftbits)
+			d >>= rTemp.data.shiftbits;
+		d &= rTemp.data.andmask;
+		mData[0] = d;
+	}
+	if (lmodes.empty() == false)
+			pmode = &lmodes;
+	else if (lmodeREPLY.empty() == false)
+		pmode = &lmodeREPLY;
+	else
+		return false;
+	mode = pmode->begin();
+	while (mode != pmode->end()) {
+		if ((*mode).BYTES == mData)
+			break;
+		mode++;
+	}
+	if (mode == pmode->end())
+		return false;
+	md = (*mode).SYMBOL;
+	return true;
+}
+
 string rigCAT_getmode()
 {
 	XMLIOS modeCmd;
 	list<XMLIOS>::iterator itrCmd;
-	list<MODE>::iterator mode;
-	list<MODE> *pmode;
-	string strCmd, mData;
-	size_t len;
+	string strCmd, md;
 
 	if (nonCATrig)
 		return progStatus.noCATmode;
@@ -508,57 +631,11 @@ string rigCAT_getmode()
 		for (int n = 0; n < progdefaults.RigCatRetries; n++) {
 			if (n && progdefaults.RigCatTimeout > 0)
 				MilliSleep(progdefaults.RigCatTimeout);
-			size_t p = 0, pData = 0;
 // send the command
-			if (!sendCommand(strCmd, rTemp.size)) goto retry_get_mode;
-// check the pre data string
-			len = rTemp.str1.size();
-			if (len) {
-				for (size_t i = 0; i < len; i++)
-					if ((char)rTemp.str1[i] != (char)replybuff[i]) {
-						LOG_VERBOSE("failed pre data string test @ %" PRIuSZ, i);
-						goto retry_get_mode;
-					}
-				p = len;
-			}
-			if (rTemp.fill1) p += rTemp.fill1;
-			pData = p;
-// check the post data string
-			p += rTemp.data.size;
-			len = rTemp.str2.size();
-			if (rTemp.fill2) p += rTemp.fill2;
-			if (len) {
-				for (size_t i = 0; i < len; i++)
-					if ((char)rTemp.str2[i] != (char)replybuff[p + i])
-						goto retry_get_mode;
-			}
-// convert the data field
-			mData = "";
-			for (int i = 0; i < rTemp.data.size; i++)
-				mData += (char)replybuff[pData + i];
-// for FT100 and the ilk that use bit fields
-			if (rTemp.data.size == 1) {
-				unsigned char d = mData[0];
-				if (rTemp.data.shiftbits)
-					d >>= rTemp.data.shiftbits;
-				d &= rTemp.data.andmask;
-				mData[0] = d;
-			}
-			if (lmodes.empty() == false)
-					pmode = &lmodes;
-			else if (lmodeREPLY.empty() == false)
-				pmode = &lmodeREPLY;
-			else
-				goto retry_get_mode;
-			mode = pmode->begin();
-			while (mode != pmode->end()) {
-				if ((*mode).BYTES == mData)
-					break;
-				mode++;
-			}
-			if (mode != pmode->end())
-				return ((*mode).SYMBOL);
-retry_get_mode: ;
+			if (!sendCommand(strCmd, rTemp.size, rTemp.str1))
+				continue;
+			if (parse_mode(rTemp, md))
+				return md;
 		}
 	}
 	if (progdefaults.RigCatVSP == false)
@@ -566,7 +643,7 @@ retry_get_mode: ;
 	return "";
 }
 
-void rigCAT_setmode(const string& md)
+static void rigCAT_do_setmode(const string& md)
 {
 	XMLIOS modeCmd;
 	list<XMLIOS>::iterator itrCmd;
@@ -619,7 +696,7 @@ void rigCAT_setmode(const string& md)
 				bool ok = false;
 				for (int n = 0; n < progdefaults.RigCatRetries; n++) {
 					pthread_mutex_lock(&rigCAT_mutex);
-					ok = sendCommand(strCmd, rTemp.size);
+					ok = sendCommand(strCmd, rTemp.size, rTemp.str1);
 					pthread_mutex_unlock(&rigCAT_mutex);
 					if (ok) return;
 				}
@@ -682,7 +759,7 @@ string rigCAT_getwidth()
 			p = 0;
 			pData = 0;
 // send the command
-			if ( !sendCommand(strCmd, rTemp.size) ) goto retry_get_width;
+			if ( !sendCommand(strCmd, rTemp.size, rTemp.str1) ) goto retry_get_width;
 // check the pre data string
 			len = rTemp.str1.size();
 			if (len) {
@@ -738,7 +815,7 @@ retry_get_width: ;
 	return "";
 }
 
-void rigCAT_setwidth(const string& w)
+static void rigCAT_do_setwidth(const string& w)
 {
 	XMLIOS modeCmd;
 	list<XMLIOS>::iterator itrCmd;
@@ -795,7 +872,7 @@ void rigCAT_setwidth(const string& w)
 				bool ok = false;
 				for (int n = 0; n < progdefaults.RigCatRetries; n++) {
 					pthread_mutex_lock(&rigCAT_mutex);
-					ok = sendCommand(strCmd, rTemp.size);
+					ok = sendCommand(strCmd, rTemp.size, rTemp.str1);
 					pthread_mutex_unlock(&rigCAT_mutex);
 					if (ok) return;
 				}
@@ -814,6 +891,89 @@ void rigCAT_setwidth(const string& w)
 	LOG_VERBOSE("Retries failed");
 }
 
+//======================================================================
+// Set requests from other threads are handed to the rigCAT thread, so that
+// the caller does not wait for a poll in progress.  Only the latest request
+// of each kind is kept: a burst of tuning steps becomes one command.
+//======================================================================
+
+static pthread_mutex_t rigCAT_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool		queued_freq = false, queued_mode = false, queued_width = false;
+static long long	queued_f = 0;
+static string		queued_md, queued_bw;
+
+// a rig without CAT only has its status to update, which is done at once
+static bool rigCAT_async(void)
+{
+	return rigCAT_thread && !rigCAT_exit && !nonCATrig &&
+		GET_THREAD_ID() != RIGCTL_TID;
+}
+
+void rigCAT_setfreq(long long f)
+{
+	if (!rigCAT_async()) {
+		rigCAT_do_setfreq(f);
+		return;
+	}
+	pthread_mutex_lock(&rigCAT_queue_mutex);
+	queued_f = f;
+	queued_freq = true;
+	pthread_mutex_unlock(&rigCAT_queue_mutex);
+	rigCAT_wake();
+}
+
+void rigCAT_setmode(const string& md)
+{
+	if (!rigCAT_async()) {
+		rigCAT_do_setmode(md);
+		return;
+	}
+	pthread_mutex_lock(&rigCAT_queue_mutex);
+	queued_md = md;
+	queued_mode = true;
+	pthread_mutex_unlock(&rigCAT_queue_mutex);
+	rigCAT_wake();
+}
+
+void rigCAT_setwidth(const string& w)
+{
+	if (!rigCAT_async()) {
+		rigCAT_do_setwidth(w);
+		return;
+	}
+	pthread_mutex_lock(&rigCAT_queue_mutex);
+	queued_bw = w;
+	queued_width = true;
+	pthread_mutex_unlock(&rigCAT_queue_mutex);
+	rigCAT_wake();
+}
+
+// rigCAT thread: sends the queued requests, mode first so that a rig that
+// changes frequency with the mode ends up on the requested frequency
+static void rigCAT_run_queue(void)
+{
+	bool f_ok, md_ok, bw_ok;
+	long long f;
+	string md, bw;
+
+	pthread_mutex_lock(&rigCAT_queue_mutex);
+	f_ok = queued_freq;
+	md_ok = queued_mode;
+	bw_ok = queued_width;
+	f = queued_f;
+	md = queued_md;
+	bw = queued_bw;
+	queued_freq = queued_mode = queued_width = false;
+	pthread_mutex_unlock(&rigCAT_queue_mutex);
+
+	if (md_ok)
+		rigCAT_do_setmode(md);
+	if (bw_ok)
+		rigCAT_do_setwidth(bw);
+	if (f_ok)
+		rigCAT_do_setfreq(f);
+}
+
 void rigCAT_pttON()
 {
 	XMLIOS modeCmd;
@@ -848,7 +1008,7 @@ void rigCAT_pttON()
 				bool ok = false;
 				for (int n = 0; n < progdefaults.RigCatRetries; n++) {
 					pthread_mutex_lock(&rigCAT_mutex);
-					ok = sendCommand(strCmd, rTemp.size);
+					ok = sendCommand(strCmd, rTemp.size, rTemp.str1);
 					pthread_mutex_unlock(&rigCAT_mutex);
 					if (ok) return;
 				}
@@ -901,7 +1061,7 @@ void rigCAT_pttOFF()
 				bool ok = false;
 				for (int n = 0; n < progdefaults.RigCatRetries; n++) {
 					pthread_mutex_lock(&rigCAT_mutex);
-					ok = sendCommand(strCmd, rTemp.size);
+					ok = sendCommand(strCmd, rTemp.size, rTemp.str1);
 					pthread_mutex_unlock(&rigCAT_mutex);
 					if (ok) return;
 				}
@@ -953,7 +1113,7 @@ void rigCAT_sendINIT(const string& icmd){
 				bool ok = false;
 				for (int n = 0; n < progdefaults.RigCatRetries; n++) {
 					pthread_mutex_lock(&rigCAT_mutex);
-					ok = sendCommand(strCmd, rTemp.size);
+					ok = sendCommand(strCmd, rTemp.size, rTemp.str1);
 					pthread_mutex_unlock(&rigCAT_mutex);
 					if (ok) return;
 				}
@@ -1124,9 +1284,11 @@ echo	   : %c\n",
 
 		rigCAT_thread = new pthread_t;
 
+		rigCAT_open_wake();
 		if (pthread_create(rigCAT_thread, NULL, rigCAT_loop, NULL) < 0) {
 			LOG_ERROR("nonCATrig pthread_create failed");
 			rigio.ClosePort();
+			rigCAT_close_wake();
 			delete rigCAT_thread;
 			rigCAT_thread = 0;
 			return false;
@@ -1143,9 +1305,11 @@ echo	   : %c\n",
 
 	rigCAT_thread = new pthread_t;
 
+	rigCAT_open_wake();
 	if (pthread_create(rigCAT_thread, NULL, rigCAT_loop, NULL) < 0) {
 		LOG_ERROR("rigCAT pthread_create failed");
 		rigio.ClosePort();
+		rigCAT_close_wake();
 		delete rigCAT_thread;
 		rigCAT_thread = 0;
 		return false;
@@ -1169,10 +1333,12 @@ void rigCAT_close(void)
 	pthread_mutex_lock(&rigCAT_mutex);
 		rigCAT_exit = true;
 	pthread_mutex_unlock(&rigCAT_mutex);
+	rigCAT_wake();
 
 	if (!rigCAT_thread) return;
 
 	pthread_join(*rigCAT_thread, NULL);
+	rigCAT_close_wake();
 
 	LOG_VERBOSE("Deleting thread %p", rigCAT_thread);
 	delete rigCAT_thread;
@@ -1229,6 +1395,256 @@ bool ModeIsLSB(const string& s)
 	return false;
 }
 
+//======================================================================
+// The rigCAT thread sleeps in select() on the serial port and on a pipe
+// that is written to when a request is queued or the thread must exit.
+// Output that the rig sends on its own is matched against the frequency and
+// mode frames defined in the rig xml file and shown at once.  Rigs that
+// send their GETFREQ and GETMODE replies, such as the Kenwoods in AI mode,
+// need nothing more.  Other frames are defined as REPLY elements with the
+// symbols XCVFREQ and XCVMODE, e.g. the Icom CI-V transceive frames
+// FE FE 00 <rig> 00 <freq> FD and FE FE 00 <rig> 01 <mode> <filter> FD.
+// A parameter that has been updated this way is not polled again until the
+// next interval.
+//======================================================================
+
+#define RIGCAT_POLL_INTERVAL 200 // msec
+
+#ifndef __MINGW32__
+static int rigCAT_wakefd[2] = { -1, -1 };
+#endif
+
+static string	unsolicited;
+static bool	fresh_freq = false, fresh_mode = false;
+
+static void rigCAT_wake(void)
+{
+#ifndef __MINGW32__
+	if (rigCAT_wakefd[1] != -1) {
+		char c = 0;
+		if (write(rigCAT_wakefd[1], &c, 1) == -1 && errno != EAGAIN)
+			LOG_PERROR("write");
+	}
+#endif
+}
+
+static bool rigCAT_open_wake(void)
+{
+#ifndef __MINGW32__
+	if (pipe(rigCAT_wakefd) == -1) {
+		LOG_PERROR("pipe");
+		rigCAT_wakefd[0] = rigCAT_wakefd[1] = -1;
+		return false;
+	}
+	for (int i = 0; i < 2; i++)
+		fcntl(rigCAT_wakefd[i], F_SETFL, fcntl(rigCAT_wakefd[i], F_GETFL) | O_NONBLOCK);
+#endif
+	return true;
+}
+
+static void rigCAT_close_wake(void)
+{
+#ifndef __MINGW32__
+	for (int i = 0; i < 2; i++) {
+		if (rigCAT_wakefd[i] != -1)
+			close(rigCAT_wakefd[i]);
+		rigCAT_wakefd[i] = -1;
+	}
+#endif
+}
+
+static bool find_reply(const char* cmd, XMLIOS& r)
+{
+	list<XMLIOS>::iterator itrCmd = commands.begin();
+	while (itrCmd != commands.end() && itrCmd->SYMBOL != cmd)
+		++itrCmd;
+	if (itrCmd == commands.end() || itrCmd->info.empty())
+		return false;
+	for (list<XMLIOS>::iterator preply = reply.begin(); preply != reply.end(); ++preply) {
+		if (preply->SYMBOL == itrCmd->info) {
+			r = *preply;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool find_reply_symbol(const char* sym, XMLIOS& r)
+{
+	for (list<XMLIOS>::iterator preply = reply.begin(); preply != reply.end(); ++preply) {
+		if (preply->SYMBOL == sym) {
+			r = *preply;
+			return true;
+		}
+	}
+	return false;
+}
+
+// The frames of one kind that can be told apart by their pre data string
+static void unsolicited_frames(const char* cmd, const char* xcv, vector<XMLIOS>& frames)
+{
+	XMLIOS r;
+	if (find_reply(cmd, r) && !r.str1.empty())
+		frames.push_back(r);
+	if (find_reply_symbol(xcv, r) && !r.str1.empty())
+		frames.push_back(r);
+}
+
+static bool match_frame(const XMLIOS& r, size_t i)
+{
+	if (r.str1.empty() || r.size <= 0 || r.size > RXBUFFSIZE ||
+	    i + r.size > unsolicited.length() ||
+	    unsolicited.compare(i, r.str1.length(), r.str1) != 0)
+		return false;
+	memset(replybuff, 0, RXBUFFSIZE + 1);
+	memcpy(replybuff, unsolicited.data() + i, r.size);
+	return true;
+}
+
+static void rigCAT_update_freq(long long freq)
+{
+	if ((freq > 0) && (freq != llFreq)) {
+		llFreq = freq;
+		show_frequency(freq);
+		wf->rfcarrier(freq);
+	}
+
+	if (freq > 0)
+		dl_fldigi::hbtint::rig_set_freq(freq);
+}
+
+static void rigCAT_update_mode(const string& sMode)
+{
+	if (sMode.size() && sMode != sRigMode) {
+		sRigMode = sMode;
+		if (ModeIsLSB(sMode))
+			wf->USB(false);
+		else
+			wf->USB(true);
+		show_mode(sMode);
+	}
+
+	if (sMode.size())
+		dl_fldigi::hbtint::rig_set_mode(sMode);
+}
+
+// Reads what the rig has sent outside a command and picks out any complete
+// frequency and mode frames.  Returns false if the port cannot be read.
+static bool rigCAT_read_unsolicited(void)
+{
+	unsigned char buf[256];
+	int n;
+	long long f = 0;
+	string md;
+	bool got_f = false, got_md = false;
+
+	pthread_mutex_lock(&rigCAT_mutex);
+	while ((n = rigio.ReadAvailable(buf, sizeof(buf), 0)) > 0)
+		unsolicited.append((const char*)buf, n);
+	if (n < 0) {
+		pthread_mutex_unlock(&rigCAT_mutex);
+		return false;
+	}
+
+	vector<XMLIOS> fr, mr;
+	unsolicited_frames("GETFREQ", "XCVFREQ", fr);
+	unsolicited_frames("GETMODE", "XCVMODE", mr);
+	size_t i = 0, done = 0, len = unsolicited.length(), tail = 0;
+	while (i < len) {
+		size_t k, next = 0;
+		for (k = 0; k < fr.size() && !next; k++) {
+			if (match_frame(fr[k], i) && parse_freq(fr[k], f)) {
+				got_f = true;
+				next = i + fr[k].size;
+			}
+		}
+		for (k = 0; k < mr.size() && !next; k++) {
+			if (match_frame(mr[k], i) && parse_mode(mr[k], md)) {
+				got_md = true;
+				next = i + mr[k].size;
+			}
+		}
+		if (next)
+			done = i = next;
+		else
+			i++;
+	}
+	// keep what could be the start of an incomplete frame
+	for (size_t k = 0; k < fr.size(); k++)
+		tail = max(tail, (size_t)fr[k].size);
+	for (size_t k = 0; k < mr.size(); k++)
+		tail = max(tail, (size_t)mr[k].size);
+	tail = tail ? tail - 1 : 0;
+	if (len - done > tail)
+		done = len - tail;
+	unsolicited.erase(0, done);
+	pthread_mutex_unlock(&rigCAT_mutex);
+
+	if (got_f) {
+		LOG_DEBUG("unsolicited freq %lld", f);
+		rigCAT_update_freq(f);
+		fresh_freq = true;
+	}
+	if (got_md) {
+		LOG_DEBUG("unsolicited mode %s", md.c_str());
+		rigCAT_update_mode(md);
+		fresh_mode = true;
+	}
+	return true;
+}
+
+// Runs queued requests and reads unsolicited rig output until `until' or
+// until the thread is asked to exit
+static void rigCAT_wait(long long until)
+{
+	bool port_ok = !nonCATrig;
+
+	for (;;) {
+		rigCAT_run_queue();
+		if (rigCAT_exit)
+			return;
+		long long wait = until - ms_now();
+		if (wait <= 0)
+			return;
+#ifndef __MINGW32__
+		fd_set rfds;
+		FD_ZERO(&rfds);
+		int nfds = -1;
+		if (rigCAT_wakefd[0] != -1) {
+			FD_SET(rigCAT_wakefd[0], &rfds);
+			nfds = rigCAT_wakefd[0];
+		}
+		int fd = port_ok ? rigio.Fd() : -1;
+		if (fd != -1) {
+			FD_SET(fd, &rfds);
+			nfds = max(nfds, fd);
+		}
+		struct timeval tv;
+		tv.tv_sec = wait / 1000;
+		tv.tv_usec = (wait % 1000) * 1000;
+		int r = select(nfds + 1, &rfds, NULL, NULL, &tv);
+		if (r < 0) {
+			if (errno != EINTR) {
+				LOG_PERROR("select");
+				MilliSleep((long)min(wait, 20LL));
+			}
+			continue;
+		}
+		if (r == 0)
+			continue;
+		if (rigCAT_wakefd[0] != -1 && FD_ISSET(rigCAT_wakefd[0], &rfds)) {
+			char c[16];
+			while (read(rigCAT_wakefd[0], c, sizeof(c)) > 0)
+				;
+		}
+		if (fd != -1 && FD_ISSET(fd, &rfds))
+			port_ok = rigCAT_read_unsolicited();
+#else
+		MilliSleep((long)min(wait, 20LL));
+#endif
+	}
+}
+
 static void *rigCAT_loop(void *args)
 {
 	SET_THREAD_ID(RIGCTL_TID);
@@ -1236,9 +1652,14 @@ static void *rigCAT_loop(void *args)
 	long long freq = 0L;
 	string sWidth, sMode;
 	bool failed;
+	long long next_poll = ms_now();
+
+	unsolicited.clear();
+	fresh_freq = fresh_mode = false;
 
 	for (;;) {
-		MilliSleep(200);
+		next_poll = max(next_poll + RIGCAT_POLL_INTERVAL, ms_now());
+		rigCAT_wait(next_poll);
 
 		if (rigCAT_exit == true)
 			break;
@@ -1246,43 +1667,38 @@ static void *rigCAT_loop(void *args)
 		if (rigCAT_bypass == true)
 			continue;
 
-		pthread_mutex_lock(&rigCAT_mutex);
-			freq = rigCAT_getfreq(progdefaults.RigCatRetries, failed);
-		pthread_mutex_unlock(&rigCAT_mutex);
+		if (fresh_freq) {
+			fresh_freq = false;
+			freq = llFreq;
+		}
+		else {
+			pthread_mutex_lock(&rigCAT_mutex);
+				freq = rigCAT_getfreq(progdefaults.RigCatRetries, failed);
+			pthread_mutex_unlock(&rigCAT_mutex);
+		}
 
 		pthread_mutex_lock(&rigCAT_mutex);
 			sWidth = rigCAT_getwidth();
 		pthread_mutex_unlock(&rigCAT_mutex);
 
-		pthread_mutex_lock(&rigCAT_mutex);
-			sMode = rigCAT_getmode();
-		pthread_mutex_unlock(&rigCAT_mutex);
-
-		if ((freq > 0) && (freq != llFreq)) {
-			llFreq = freq;
-			show_frequency(freq);
-			wf->rfcarrier(freq);
+		if (fresh_mode) {
+			fresh_mode = false;
+			sMode = sRigMode;
+		}
+		else {
+			pthread_mutex_lock(&rigCAT_mutex);
+				sMode = rigCAT_getmode();
+			pthread_mutex_unlock(&rigCAT_mutex);
 		}
 
-		if (freq > 0)
-			dl_fldigi::hbtint::rig_set_freq(freq);
+		rigCAT_update_freq(freq);
 
 		if (sWidth.size() && sWidth != sRigWidth) {
 			sRigWidth = sWidth;
 			show_bw(sWidth);
 		}
 
-		if (sMode.size() && sMode != sRigMode) {
-			sRigMode = sMode;
-			if (ModeIsLSB(sMode))
-				wf->USB(false);
-			else
-				wf->USB(true);
-			show_mode(sMode);
-		}
-
-		if (sMode.size())
-			dl_fldigi::hbtint::rig_set_mode(sMode);
+		rigCAT_update_mode(sMode);
 	}
 
 	wf->USB(true);
@@ -1298,4 +1714,3 @@ static void *rigCAT_loop(void *args)
 
 	return NULL;
 }
-
@@ -38,6 +38,8 @@ LOG_FILE_SOURCE(debug::LOG_RIGCONTROL);
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
+#include <sys/select.h>
+#include <errno.h>
 
 #include <memory>
 
@@ -266,6 +268,37 @@ int  Cserial::ReadBuffer (unsigned char *buf, int nchars)
 	return nread;
 }
 
+///////////////////////////////////////////////////////
+// Function name	: Cserial::ReadAvailable
+// Description		: Waits up to msec for input, then reads
+//			  whatever is available, upto nchars
+// Return type		: # characters received, -1 on error
+// Argument		 : pointer to buffer; # chars to read; msec
+///////////////////////////////////////////////////////
+int  Cserial::ReadAvailable (unsigned char *buf, int nchars, int msec)
+{
+	if (fd < 0) return -1;
+
+	fd_set rfds;
+	struct timeval tv;
+	FD_ZERO (&rfds);
+	FD_SET (fd, &rfds);
+	tv.tv_sec = msec / 1000;
+	tv.tv_usec = (msec % 1000) * 1000;
+	int retval = select (fd + 1, &rfds, (fd_set *)0, (fd_set *)0, &tv);
+	if (retval < 0)
+		return errno == EINTR ? 0 : -1;
+	if (retval == 0)
+		return 0;
+
+	retval = read (fd, (char *)buf, nchars);
+	if (retval < 0)
+		return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+	if (retval == 0) // readable but no data: the device has gone away
+		return -1;
+	return retval;
+}
+
 ///////////////////////////////////////////////////////
 // Function name	: Cserial::WriteBuffer
 // Description		: Writes a string to the selected port
@@ -30,7 +30,6 @@
 #include <cmath>
 #include <cstring>
 #include <float.h>
-#include <samplerate.h>
 
 #include "rsid.h"
 #include "filters.h"
@@ -54,8 +53,7 @@ LOG_FILE_SOURCE(debug::LOG_MODEM);
 void reset_rsid(void *who) {
 	cRsId *me = (cRsId *)who;
 	LOG_INFO("%s", "RxID detector reset");
-	me->state = cRsId::INITIAL;
-	me->reset();
+	me->reset_pending = true; // picked up by the detector thread
 }
 
 void reset_rsid_detector(void *me) {
@@ -86,16 +84,8 @@ const int cRsId::indices[] = {
 	2, 4, 8, 9, 11, 15, 7, 14, 5, 10, 13, 3
 };
 
-cRsId::cRsId()
+cRsId::cRsId() : sc_detector("RxID")
 {
-	int error;
-	src_state = src_new(progdefaults.sample_converter, 1, &error);
-	if (error) {
-		LOG_ERROR("src_new error %d: %s", error, src_strerror(error));
-		abort();
-	}
-	src_data.end_of_input = 0;
-
 	reset();
 
 	rsfft = new Cfft(RSID_FFT_SIZE);
@@ -142,6 +132,7 @@ cRsId::cRsId()
 	hamming_resolution = progdefaults.rsid_resolution;
 
 	state = INITIAL;
+	reset_pending = false;
 }
 
 cRsId::~cRsId()
@@ -151,7 +142,6 @@ cRsId::~cRsId()
 
 	delete [] outbuf;
 	delete rsfft;
-	src_delete(src_state);
 }
 
 void cRsId::reset()
@@ -166,10 +156,6 @@ void cRsId::reset()
 	memset(aFFTAmpl, 0, sizeof(aFFTAmpl));
 	memset(aBuckets, 0, sizeof(aBuckets));
 
-	int error = src_reset(src_state);
-	if (error)
-		LOG_ERROR("src_reset error %d: %s", error, src_strerror(error));
-	src_data.src_ratio = 0.0;
 	inptr = aInputSamples + RSID_FFT_SAMPLES;
 }
 
@@ -217,10 +203,27 @@ void cRsId::CalculateBuckets(const double *pSpectrum, int iBegin, int iEnd)
 	}
 }
 
-void cRsId::receive(const float* buf, size_t len)
+int cRsId::samplerate(void)
+{
+	return (int)RSID_SAMPLE_RATE;
+}
+
+bool cRsId::enabled(void)
+{
+	return progdefaults.rsid;
+}
+
+void cRsId::process(const sc_block& blk, std::vector<sc_event>& events)
 {
-	double src_ratio = RSID_SAMPLE_RATE / active_modem->get_samplerate();
-	bool resample = (fabs(src_ratio - 1.0) >= DBL_EPSILON);
+	if (reset_pending) {
+		reset_pending = false;
+		state = INITIAL;
+		reset();
+	}
+
+	// the side-chain has already converted the audio to RSID_SAMPLE_RATE
+	const float* buf = blk.buf;
+	size_t len = blk.len;
 	size_t ns;
 
 	while (len) {
@@ -229,51 +232,31 @@ void cRsId::receive(const float* buf, size_t len)
 			ns -= RSID_FFT_SAMPLES;
 		ns = RSID_FFT_SAMPLES - ns; // number of additional samples we need to call search()
 
-		if (resample) {
-			if (src_data.src_ratio != src_ratio)
-				src_set_ratio(src_state, src_data.src_ratio = src_ratio);
-			src_data.data_in = const_cast<float*>(buf);
-			src_data.input_frames = len;
-			src_data.data_out = inptr;
-			src_data.output_frames = ns;
-			src_data.input_frames_used = 0;
-			int error = src_process(src_state, &src_data);
-			if (unlikely(error)) {
-				LOG_ERROR("src_process error %d: %s", error, src_strerror(error));
-				return;
-			}
-			inptr += src_data.output_frames_gen;
-			buf += src_data.input_frames_used;
-			len -= src_data.input_frames_used;
-		}
-		else {
-
-			ns = MIN(ns, len);
-			memcpy(inptr, buf, ns * sizeof(*inptr));
-			inptr += ns;
-			buf += ns;
-			len -= ns;
-		}
+		ns = MIN(ns, len);
+		memcpy(inptr, buf, ns * sizeof(*inptr));
+		inptr += ns;
+		buf += ns;
+		len -= ns;
 
 		ns = inptr - aInputSamples;
 		if (ns == RSID_FFT_SAMPLES || ns == RSID_FFT_SIZE)
-			search(); // will reset inptr if at end of input
+			search(blk, events); // will reset inptr if at end of input
 	}
 }
 
-void cRsId::search(void)
+void cRsId::search(const sc_block& blk, std::vector<sc_event>& events)
 {
 	if (progdefaults.rsidWideSearch) {
 		nBinLow = RSID_RESOL + 1;
 		nBinHigh = RSID_FFT_SIZE - 32;
 	}
 	else {
-		double centerfreq = active_modem->get_freq();
+		double centerfreq = blk.freq;
 		nBinLow = (int)((centerfreq  - 100.0 * RSID_RESOL) * 2048.0 / RSID_SAMPLE_RATE);
 		nBinHigh = (int)((centerfreq  + 100.0 * RSID_RESOL) * 2048.0 / RSID_SAMPLE_RATE);
 	}
 
-	bool bReverse = !(wf->Reverse() ^ wf->USB());
+	bool bReverse = blk.reverse;
 	if (bReverse) {
 		nBinLow  = RSID_FFT_SIZE - nBinHigh;
 		nBinHigh = RSID_FFT_SIZE - nBinLow;
@@ -313,27 +296,43 @@ void cRsId::search(void)
 		if (SymbolOut == RSID_ESCAPE) {
 			state = EXTENDED;
 			reset();
-			REQ(reset_rsid_detector, this);  // reset after fixed time interval
+			events.push_back(sc_event(EV_ESCAPE));
 			return;
 		}
 		if (bReverse)
 			BinOut = 1024 - BinOut - 31;
-		apply(SymbolOut, BinOut);
-		Fl::remove_timeout(reset_rsid);
+		events.push_back(sc_event(EV_CODE, SymbolOut, BinOut));
 		state = INITIAL;
 		reset();
 	} else if (state == EXTENDED && search_amp(SymbolOut, BinOut)) {
 		LOG_INFO("Ext' rsid_code detected: %d", SymbolOut);
 		if (bReverse)
 			BinOut = 1024 - BinOut - 31;
-		if (SymbolOut != RSID_ESCAPE2)
-			apply2(SymbolOut, BinOut);
-		Fl::remove_timeout(reset_rsid);
+		events.push_back(sc_event(EV_CODE2, SymbolOut, BinOut));
 		state = INITIAL;
 		reset();
 	}
 }
 
+// Called on the trx thread for each detection made by process()
+void cRsId::dispatch(const sc_event& ev)
+{
+	switch (ev.kind) {
+	case EV_ESCAPE:
+		REQ(reset_rsid_detector, this);  // reset after fixed time interval
+		break;
+	case EV_CODE:
+		apply(ev.arg1, ev.arg2);
+		Fl::remove_timeout(reset_rsid);
+		break;
+	case EV_CODE2:
+		if (ev.arg1 != RSID_ESCAPE2)
+			apply2(ev.arg1, ev.arg2);
+		Fl::remove_timeout(reset_rsid);
+		break;
+	}
+}
+
 void cRsId::apply(int iSymbol, int iBin)
 {
 	ENSURE_THREAD(TRX_TID);
@@ -69,6 +69,7 @@
 #include "timeops.h"
 #include "ringbuffer.h"
 #include "debug.h"
+#include "dspstats.h"
 
 #define	SND_BUF_LEN		65536
 // #define	SRC_BUF_LEN		(8*SND_BUF_LEN)
@@ -1227,6 +1228,16 @@ void SoundPort::flush(unsigned dir)
         }
 }
 
+void SoundPort::rx_levels(size_t& fill, size_t& size)
+{
+        if (sd[0].rb) {
+                fill = sd[0].rb->read_space();
+                size = sd[0].rb->length();
+        }
+        else
+                fill = size = 0;
+}
+
 void SoundPort::src_data_reset(unsigned dir)
 {
         size_t rbsize;
@@ -1426,19 +1437,25 @@ int SoundPort::stream_process(const void* in, void* out, unsigned long nframes,
 {
         struct stream_data* sd = reinterpret_cast<struct stream_data*>(data);
 
+        if (unlikely(flags)) {
+                struct {
+                        PaStreamCallbackFlags f;
+                        int xrun;
+                        const char* s;
+                } fa[] = { { paInputUnderflow, DSP_XRUN_IN_UNDERFLOW, "Input underflow" },
+                           { paInputOverflow, DSP_XRUN_IN_OVERFLOW, "Input overflow" },
+                           { paOutputUnderflow, DSP_XRUN_OUT_UNDERFLOW, "Output underflow" },
+                           { paOutputOverflow, DSP_XRUN_OUT_OVERFLOW, "Output overflow" }
+                };
+                for (size_t i = 0; i < sizeof(fa)/sizeof(*fa); i++) {
+                        if (flags & fa[i].f) {
+                                dspstats_xrun(fa[i].xrun);
 #ifndef NDEBUG
-        struct {
-                PaStreamCallbackFlags f;
-                const char* s;
-        } fa[] = { { paInputUnderflow, "Input underflow" },
-                   { paInputOverflow,  "Input overflow" },
-                   { paOutputUnderflow, "Output underflow" },
-                   { paOutputOverflow, "Output overflow" }
-        };
-        for (size_t i = 0; i < sizeof(fa)/sizeof(*fa); i++)
-                if (flags & fa[i].f)
-			LOG_DEBUG("%s", fa[i].s);
+                                LOG_DEBUG("%s", fa[i].s);
 #endif
+                        }
+                }
+        }
 
         if (unlikely(sd->state == spa_abort || sd->state == spa_complete)) // finished
                 return sd->state;
@@ -1446,9 +1463,15 @@ int SoundPort::stream_process(const void* in, void* out, unsigned long nframes,
         if (in) {
                 switch (sd->state) {
                 case spa_continue: // write into the rb, post rwsem if we wrote anything
-                        if (sd->rb->write(reinterpret_cast<const float*>(in), sd->params.channelCount * nframes))
+                {
+                        size_t n = sd->params.channelCount * nframes;
+                        size_t nwritten = sd->rb->write(reinterpret_cast<const float*>(in), n);
+                        if (nwritten)
                                 sem_post(sd->rwsem);
+                        if (nwritten < n) // the reader is late and we dropped samples
+                                dspstats_xrun(DSP_XRUN_SNDRB_FULL);
                         break;
+                }
                 case spa_drain: case spa_pause: // signal the cv
 			pthread_mutex_lock(sd->cmutex);
 			pthread_cond_signal(sd->ccond);
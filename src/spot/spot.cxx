@@ -29,8 +29,10 @@
 #include "trx.h"
 #include "globals.h"
 #include "re.h"
+#include "re_filter.h"
 #include "fl_digi.h"
 #include "debug.h"
+#include "threads.h"
 #include "spot.h"
 
 // the number of characters that we match our REs against
@@ -62,51 +64,96 @@ struct fre_comp : std::unary_function<const fre_t*, bool>
 typedef list<callback_t*> callback_p_list_t;
 typedef tr1::unordered_map<fre_t*, callback_p_list_t, fre_hash, fre_comp> rcblist_t;
 
-static tr1::unordered_map<int, string> buffers;
+// A decoder's recent text, its state in the RE prefilter, and the mode that
+// the text was received in
+struct decbuf_t
+{
+	decbuf_t() : mode(NUM_MODES + 1) { }
+	string buf;
+	re_filter_t::stream st;
+	int mode;
+};
+
+static tr1::unordered_map<int, decbuf_t> buffers;
 static cblist_t cblist;
 static rcblist_t rcblist;
 
+// The REs of rcblist, in prefilter id order.  Elements of an unordered_map
+// do not move, so these stay valid until the RE is unregistered.
+static vector<rcblist_t::value_type*> rcbvec;
+static re_filter_t rcbfilter(SEARCHLEN);
+
+static void rcbfilter_build(void)
+{
+	rcbvec.clear();
+	rcbfilter.clear();
+	for (rcblist_t::iterator i = rcblist.begin(); i != rcblist.end(); ++i) {
+		rcbvec.push_back(&*i);
+		rcbfilter.add(i->first->re().c_str(), i->first->cf());
+	}
+	rcbfilter.compile();
+}
+
+// Only called on the main thread, which also owns the buffers, the
+// callback tables and the scratch vector below
 void spot_recv(char c, int decoder, int afreq, int md)
 {
-	static trx_mode last_mode = NUM_MODES + 1;
+	ENSURE_THREAD(FLMAIN_TID);
 
-	if (decoder == -1) { // mode without multiple decoders
-		decoder = active_modem->get_mode();
-		if (last_mode != active_modem->get_mode()) {
-			buffers.clear();
-			last_mode = active_modem->get_mode();
-		}
-	} else if (last_mode != md) {
-		buffers.clear();
-		last_mode = md;
-	}
+	if (decoder == -1) // mode without multiple decoders
+		decoder = md = active_modem->get_mode();
 	if (afreq == 0)
 		afreq = active_modem->get_freq();
 
-	string& buf = buffers[decoder];
+	// Decoders of different modes, e.g. the skimmer's, may be interleaved,
+	// so a buffer is only cleared when its own decoder changes mode.
+	decbuf_t& d = buffers[decoder];
+	if (d.mode != md) {
+		d.buf.clear();
+		d.st = re_filter_t::stream();
+		d.mode = md;
+	}
+	trx_mode mode = d.mode;
+	string& buf = d.buf;
 	if (unlikely(buf.capacity() < DECBUFSIZE))
 		buf.reserve(DECBUFSIZE);
 
 	buf += c;
 	string::size_type n = buf.length();
-	if (n == DECBUFSIZE)
+	if (n == DECBUFSIZE) {
 		buf.erase(0, DECBUFSIZE - SEARCHLEN);
+		n = SEARCHLEN;
+	}
 	const char* search = buf.c_str() + (n > SEARCHLEN ? n - SEARCHLEN : 0);
 
-	for (rcblist_t::iterator i = rcblist.begin(); i != rcblist.end(); ++i) {
+	// only the REs that can match the search buffer are tried
+	static vector<size_t> candidates;
+	if (unlikely(rcbfilter.stale(d.st)))
+		rcbfilter.reset(d.st, search, buf.c_str() + n - search - 1);
+	rcbfilter.feed(d.st, c, candidates);
+
+	for (size_t k = 0; k < candidates.size(); k++) {
+		rcblist_t::value_type* i = rcbvec[candidates[k]];
 		if (unlikely(i->first->match(search))) {
 			const vector<regmatch_t>& m = i->first->suboff();
 			for (list<callback_t*>::iterator j = i->second.begin();
 			     j != i->second.end() && (*j)->rcb; ++j) {
 				if (m.empty())
-					(*j)->rcb(last_mode, afreq, search, NULL, 0, (*j)->data);
+					(*j)->rcb(mode, afreq, search, NULL, 0, (*j)->data);
 				else
-					(*j)->rcb(last_mode, afreq, search, &m[0], m.size(), (*j)->data);
+					(*j)->rcb(mode, afreq, search, &m[0], m.size(), (*j)->data);
 			}
 		}
 	}
 }
 
+// Frees the buffer of a decoder that has gone away, e.g. one of the
+// skimmer's
+void spot_release(int decoder)
+{
+	buffers.erase(decoder);
+}
+
 static void get_log_details(long long& freq, trx_mode& mode, time_t& rtime)
 {
 	if (mode == NUM_MODES)
@@ -179,8 +226,10 @@ void spot_register_recv(spot_recv_cb_t rcb, void* rdata, const char* re, int ref
 		i->second.push_back(&cblist.back());
 		delete fre;
 	}
-	else
+	else {
 		rcblist[fre].push_back(&cblist.back());
+		rcbfilter_build();
+	}
 	show_spot(true);
 }
 
@@ -224,6 +273,7 @@ void spot_unregister_recv(spot_recv_cb_t rcb, const void* rdata)
 				if (j->second.empty()) {
 					delete j->first;
 					rcblist.erase(j);
+					rcbfilter_build();
 				}
 				goto out;
 			}
@@ -0,0 +1,295 @@
+// ----------------------------------------------------------------------------
+// dspstats.cxx  --  receive loop load and latency counters
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include <cstring>
+#include <cstdio>
+#include <vector>
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Browser.H>
+#include <FL/Fl_Button.H>
+
+#include "gettext.h"
+#include "dspstats.h"
+#include "sidechain.h"
+#include "threads.h"
+#include "timeops.h"
+#include "misc.h"
+
+// time constant of the recent load, in seconds of audio
+#define DSP_LOAD_TAU 5.0
+
+static const char* stage_names[DSP_NUM_STAGES] = {
+	"read", "waterfall", "modem", "side-chain", "dispatch"
+};
+
+static const char* xrun_names[DSP_NUM_XRUNS] = {
+	"input overflow", "input underflow", "output underflow", "output overflow",
+	"sound card buffer full", "GUI queue full"
+};
+
+// The trx thread times each block on its own and adds it to the shared
+// counters with one lock per block.  The overflow counters are bumped with
+// atomic adds as the audio callbacks must not block.
+static pthread_mutex_t dsp_mutex = PTHREAD_MUTEX_INITIALIZER;
+static dsp_stats shared;
+static unsigned long qrunner_full, qrunner_full_base;
+static volatile unsigned long xruns[DSP_NUM_XRUNS];
+static unsigned long xruns_base[DSP_NUM_XRUNS];
+
+// trx thread
+static struct timespec block_t0, stage_t0;
+static double block_stage[DSP_NUM_STAGES];
+
+static inline double elapsed(struct timespec& t0)
+{
+	struct timespec t1;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double d = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	t0 = t1;
+	return d;
+}
+
+void dspstats_begin(void)
+{
+	clock_gettime(CLOCK_MONOTONIC, &block_t0);
+	stage_t0 = block_t0;
+	memset(block_stage, 0, sizeof(block_stage));
+}
+
+void dspstats_stage(int stage)
+{
+	block_stage[stage] += elapsed(stage_t0);
+}
+
+void dspstats_end(size_t len, int samplerate)
+{
+	double total = elapsed(block_t0);
+	// the time spent waiting for samples is idle time
+	double busy = total - block_stage[DSP_STAGE_READ];
+	double audio = samplerate > 0 ? (double)len / samplerate : 0.0;
+
+	int bin = 0;
+	while (bin < DSP_HIST_BINS - 1 && busy >= DSP_HIST_BASE * (1 << bin))
+		bin++;
+
+	guard_lock lock(&dsp_mutex);
+	for (int i = 0; i < DSP_NUM_STAGES; i++)
+		shared.stage[i] += block_stage[i];
+	shared.audio += audio;
+	shared.busy += busy;
+	if (audio > 0.0)
+		shared.load = decayavg(shared.load, busy / audio, DSP_LOAD_TAU / audio);
+	if (busy > shared.block_max)
+		shared.block_max = busy;
+	shared.blocks++;
+	shared.hist[bin]++;
+}
+
+void dspstats_levels(size_t trxrb_fill, size_t trxrb_size,
+		     size_t sndrb_fill, size_t sndrb_size, size_t qrunner_depth,
+		     unsigned long qrunner_nfull)
+{
+	guard_lock lock(&dsp_mutex);
+	shared.trxrb_fill = trxrb_fill;
+	shared.trxrb_size = trxrb_size;
+	shared.sndrb_fill = sndrb_fill;
+	shared.sndrb_size = sndrb_size;
+	if (sndrb_fill > shared.sndrb_max)
+		shared.sndrb_max = sndrb_fill;
+	shared.qrunner_depth = qrunner_depth;
+	if (qrunner_depth > shared.qrunner_max)
+		shared.qrunner_max = qrunner_depth;
+	qrunner_full = qrunner_nfull;
+}
+
+void dspstats_xrun(int kind)
+{
+	__sync_fetch_and_add(&xruns[kind], 1);
+}
+
+void dspstats_get(dsp_stats& st)
+{
+	guard_lock lock(&dsp_mutex);
+	st = shared;
+	for (int i = 0; i < DSP_NUM_XRUNS; i++)
+		st.xruns[i] = xruns[i] - xruns_base[i];
+	st.xruns[DSP_XRUN_QRUNNER_FULL] = qrunner_full - qrunner_full_base;
+}
+
+void dspstats_reset(void)
+{
+	guard_lock lock(&dsp_mutex);
+	dsp_stats st;
+	memset(&st, 0, sizeof(st));
+	// the levels are current, not cumulative
+	st.trxrb_fill = shared.trxrb_fill;
+	st.trxrb_size = shared.trxrb_size;
+	st.sndrb_fill = st.sndrb_max = shared.sndrb_fill;
+	st.sndrb_size = shared.sndrb_size;
+	st.qrunner_depth = st.qrunner_max = shared.qrunner_depth;
+	st.load = shared.load;
+	shared = st;
+	for (int i = 0; i < DSP_NUM_XRUNS; i++)
+		xruns_base[i] = xruns[i];
+	qrunner_full_base = qrunner_full;
+}
+
+const char* dspstats_stage_name(int stage)
+{
+	return stage >= 0 && stage < DSP_NUM_STAGES ? stage_names[stage] : "";
+}
+
+const char* dspstats_xrun_name(int kind)
+{
+	return kind >= 0 && kind < DSP_NUM_XRUNS ? xrun_names[kind] : "";
+}
+
+void dspstats_report(std::string& text)
+{
+	dsp_stats st;
+	dspstats_get(st);
+
+	char line[128];
+	text.clear();
+
+	snprintf(line, sizeof(line), "Receive load: %.1f%% of real time now, %.1f%% on average\n",
+		 100.0 * st.load, st.audio > 0.0 ? 100.0 * st.busy / st.audio : 0.0);
+	text += line;
+	snprintf(line, sizeof(line), "Blocks: %lu, %.0f s of audio, slowest %.2f ms\n\n",
+		 st.blocks, st.audio, st.block_max * 1e3);
+	text += line;
+
+	text += "Stage          total s  ms/block  % of audio\n";
+	for (int i = 0; i < DSP_NUM_STAGES; i++) {
+		snprintf(line, sizeof(line), "%-12s %9.2f %9.3f %10.2f\n", stage_names[i], st.stage[i],
+			 st.blocks ? 1e3 * st.stage[i] / st.blocks : 0.0,
+			 st.audio > 0.0 ? 100.0 * st.stage[i] / st.audio : 0.0);
+		text += line;
+	}
+
+	text += "\nBlock time       blocks\n";
+	for (int i = 0; i < DSP_HIST_BINS; i++) {
+		if (i < DSP_HIST_BINS - 1)
+			snprintf(line, sizeof(line), "< %7.3f ms %10lu\n", DSP_HIST_BASE * (1 << i) * 1e3, st.hist[i]);
+		else
+			snprintf(line, sizeof(line), ">=%7.3f ms %10lu\n", DSP_HIST_BASE * (1 << (i - 1)) * 1e3, st.hist[i]);
+		text += line;
+	}
+
+	text += "\nBuffers          now      max     size\n";
+	snprintf(line, sizeof(line), "sound card %8lu %8lu %8lu\n", (unsigned long)st.sndrb_fill,
+		 (unsigned long)st.sndrb_max, (unsigned long)st.sndrb_size);
+	text += line;
+	snprintf(line, sizeof(line), "history    %8lu        - %8lu\n", (unsigned long)st.trxrb_fill,
+		 (unsigned long)st.trxrb_size);
+	text += line;
+	snprintf(line, sizeof(line), "GUI queue  %8lu %8lu\n", (unsigned long)st.qrunner_depth,
+		 (unsigned long)st.qrunner_max);
+	text += line;
+
+	text += "\nOverflows\n";
+	for (int i = 0; i < DSP_NUM_XRUNS; i++) {
+		snprintf(line, sizeof(line), "%-24s %8lu\n", xrun_names[i], st.xruns[i]);
+		text += line;
+	}
+
+	std::vector<sc_stats> sc;
+	sidechain_stats(sc);
+	if (!sc.empty()) {
+		text += "\nSide-chain   % of real time   blocks  dropped\n";
+		for (size_t i = 0; i < sc.size(); i++) {
+			snprintf(line, sizeof(line), "%-12s %14.2f %8lu %8lu\n", sc[i].name,
+				 sc[i].audio > 0.0 ? 100.0 * sc[i].cpu / sc[i].audio : 0.0,
+				 sc[i].blocks, sc[i].dropped);
+			text += line;
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Status panel, refreshed once a second while it is shown
+
+#define DSP_PANEL_INTERVAL 1.0
+
+static Fl_Double_Window* panel;
+static Fl_Browser* panel_text;
+
+static void panel_update(void*)
+{
+	if (!panel->shown())
+		return;
+
+	std::string text;
+	dspstats_report(text);
+
+	int top = panel_text->topline();
+	panel_text->clear();
+	std::string::size_type i = 0, j;
+	while ((j = text.find('\n', i)) != std::string::npos) {
+		panel_text->add(text.substr(i, j - i).c_str());
+		i = j + 1;
+	}
+	panel_text->topline(top);
+
+	Fl::repeat_timeout(DSP_PANEL_INTERVAL, panel_update);
+}
+
+static void panel_reset_cb(Fl_Widget*, void*)
+{
+	dspstats_reset();
+	Fl::remove_timeout(panel_update);
+	Fl::add_timeout(0.0, panel_update);
+}
+
+static void panel_close_cb(Fl_Widget*, void*)
+{
+	Fl::remove_timeout(panel_update);
+	panel->hide();
+}
+
+void dspstats_show(void)
+{
+	if (!panel) {
+		int pad = 2;
+		panel = new Fl_Double_Window(440, 560, _("Receive load"));
+		panel->xclass(PACKAGE_TARNAME);
+
+		panel_text = new Fl_Browser(pad, pad, panel->w() - 2 * pad, panel->h() - 20 - 3 * pad);
+		panel_text->textfont(FL_COURIER);
+		panel_text->textsize(12);
+		panel_text->format_char(0);
+
+		Fl_Button* reset = new Fl_Button(panel->w() - 2 * (64 + pad), panel->h() - 20 - pad, 64, 20, _("Reset"));
+		reset->callback(panel_reset_cb);
+		Fl_Button* close = new Fl_Button(panel->w() - 64 - pad, panel->h() - 20 - pad, 64, 20, _("Close"));
+		close->callback(panel_close_cb);
+
+		panel->resizable(panel_text);
+		panel->callback(panel_close_cb);
+		panel->end();
+	}
+
+	panel->show();
+	Fl::remove_timeout(panel_update);
+	Fl::add_timeout(0.0, panel_update);
+}
@@ -183,12 +183,41 @@ modem::modem()
 	historyON = false;
 	cap = CAP_RX | CAP_TX;
 	PTTphaseacc = 0.0;
+	PTTchannel = 0;
+	PTTchannel_size = 0;
+	outbuf = 0;
 	frequency = 1000.0;
 	s2n_ncount = s2n_sum = s2n_sum2 = s2n_metric = 0.0;
 	s2n_valid = false;
 	track_freq_lock = 0;
 }
 
+modem::~modem()
+{
+	modem::free_txbuffers();
+}
+
+void modem::alloc_txbuffers()
+{
+	if (!outbuf)
+		outbuf = new double[OUTBUFSIZE]();
+}
+
+void modem::free_txbuffers()
+{
+	delete [] outbuf;
+	outbuf = 0;
+	delete [] PTTchannel;
+	PTTchannel = 0;
+	PTTchannel_size = 0;
+}
+
+size_t modem::txbuffers_size() const
+{
+	return (outbuf ? OUTBUFSIZE : 0) * sizeof(*outbuf) +
+		PTTchannel_size * sizeof(*PTTchannel);
+}
+
 // modem types CW and RTTY do not use the base init()
 void modem::init()
 {
@@ -425,9 +454,14 @@ void modem::s2nreport(void)
 void modem::ModulateXmtr(double *buffer, int len)
 {
     if (progdefaults.PTTrightchannel) {
+        if (PTTchannel_size < len) {
+            delete [] PTTchannel;
+            PTTchannel = new double[len];
+            PTTchannel_size = len;
+        }
         for (int i = 0; i < len; i++)
             PTTchannel[i] = PTTnco();
-            ModulateStereo( buffer, PTTchannel, len);
+        ModulateStereo( buffer, PTTchannel, len);
         return;
     }
 
@@ -0,0 +1,384 @@
+// ----------------------------------------------------------------------------
+// sidechain.cxx  --  receive side-chain detectors
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include <cstring>
+#include <ctime>
+
+#include "sidechain.h"
+#include "resampler.h"
+#include "threads.h"
+#include "timeops.h"
+#include "util.h"
+#include "debug.h"
+
+LOG_FILE_SOURCE(debug::LOG_MODEM);
+
+// blocks queued per sample rate; about 4 seconds at 8000 sps
+#define SC_NUMBLOCKS 64
+// interval between CPU time reports, in seconds of audio
+#define SC_REPORT_INTERVAL 600.0
+
+#ifdef CLOCK_THREAD_CPUTIME_ID
+#  define SC_CLOCK CLOCK_THREAD_CPUTIME_ID
+#else
+#  define SC_CLOCK CLOCK_MONOTONIC
+#endif
+
+struct sc_worker;
+
+// The audio at one sample rate.  The trx thread converts each receive block
+// once and writes it to the slots; every reader has its own read index and
+// processes the slots in place.  A slot is reused only when all readers have
+// finished with it.
+struct sc_stream {
+	sc_stream(int rate_) : rate(rate_), slots(new sc_block[SC_NUMBLOCKS]), widx(0), failed(0), paused(false) { }
+	~sc_stream() { delete [] slots; }
+
+	int rate;                       // 0 for the modem's rate
+	polyphase_resampler rs;
+	sc_block* slots;
+	volatile unsigned long widx;
+	std::vector<sc_worker*> readers;
+	int failed;                     // rate that could not be converted
+	bool paused;                    // no reader was enabled
+};
+
+struct sc_worker {
+	sc_worker(sc_detector* d)
+		: det(d), stream(0), ridx(0), idle(false), stop(false), dropped(0),
+		  cpu(0.0), audio(0.0), blocks(0)
+	{
+		pthread_mutex_init(&stats_mutex, NULL);
+	}
+	~sc_worker()
+	{
+		pthread_mutex_destroy(&stats_mutex);
+	}
+
+	sc_detector* det;
+	sc_stream* stream;
+	volatile unsigned long ridx;
+	pthread_t thread;
+	syncobj wake;
+	volatile bool idle, stop;
+	unsigned long dropped;  // written by the trx thread only
+
+	pthread_mutex_t stats_mutex;
+	double cpu, audio;
+	unsigned long blocks;
+};
+
+// workers is changed by the trx thread and read by sidechain_stats, which
+// may be called from any thread
+static pthread_mutex_t workers_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<sc_worker*> workers;
+static std::vector<sc_stream*> streams;
+static bool running = false;
+
+static pthread_mutex_t events_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<sc_event> events;
+static volatile size_t nevents = 0;
+
+static double report_audio = 0.0;
+
+static void* sidechain_loop(void* arg);
+
+void sidechain_add(sc_detector* det)
+{
+	if (running) {
+		LOG_ERROR("Cannot add %s detector while running", det->name);
+		return;
+	}
+
+	sc_worker* w = new sc_worker(det);
+	int rate = det->samplerate();
+	for (size_t i = 0; i < streams.size(); i++) {
+		if (streams[i]->rate == rate) {
+			w->stream = streams[i];
+			break;
+		}
+	}
+	if (!w->stream) {
+		w->stream = new sc_stream(rate);
+		streams.push_back(w->stream);
+	}
+	w->stream->readers.push_back(w);
+	guard_lock lock(&workers_mutex);
+	workers.push_back(w);
+}
+
+void sidechain_start(void)
+{
+	if (running)
+		return;
+
+	for (size_t i = 0; i < workers.size(); i++) {
+		if (pthread_create(&workers[i]->thread, NULL, sidechain_loop, workers[i]) != 0) {
+			LOG_PERROR("pthread_create");
+			workers[i]->stop = true;
+		}
+	}
+	report_audio = 0.0;
+	running = true;
+}
+
+static void sidechain_clear(void)
+{
+	pthread_mutex_lock(&workers_mutex);
+	for (size_t i = 0; i < workers.size(); i++)
+		delete workers[i];
+	workers.clear();
+	pthread_mutex_unlock(&workers_mutex);
+	for (size_t i = 0; i < streams.size(); i++)
+		delete streams[i];
+	streams.clear();
+}
+
+void sidechain_stop(void)
+{
+	if (!running) {
+		sidechain_clear();
+		return;
+	}
+
+	for (size_t i = 0; i < workers.size(); i++) {
+		sc_worker* w = workers[i];
+		if (w->stop) // never started
+			continue;
+		pthread_mutex_lock(w->wake.mtxp());
+		w->stop = true;
+		w->wake.signal();
+		pthread_mutex_unlock(w->wake.mtxp());
+		pthread_join(w->thread, NULL);
+	}
+
+	std::vector<sc_stats> stats;
+	sidechain_stats(stats);
+	for (size_t i = 0; i < stats.size(); i++)
+		LOG_INFO("%s: %lu blocks, %lu dropped, %.2f s CPU for %.0f s audio",
+			 stats[i].name, stats[i].blocks, stats[i].dropped,
+			 stats[i].cpu, stats[i].audio);
+
+	sidechain_clear();
+
+	pthread_mutex_lock(&events_mutex);
+	events.clear();
+	nevents = 0;
+	pthread_mutex_unlock(&events_mutex);
+
+	running = false;
+}
+
+// trx thread: whether any detector reading st wants the audio
+static bool stream_wanted(const sc_stream* st)
+{
+	for (size_t i = 0; i < st->readers.size(); i++)
+		if (st->readers[i]->det->enabled())
+			return true;
+	return false;
+}
+
+// Returns the next free slot of st, or 0 if a reader has fallen too far
+// behind; the block is then dropped for all readers of the stream.
+static sc_block* stream_slot(sc_stream* st)
+{
+	unsigned long w = st->widx;
+	unsigned long oldest = w;
+	for (size_t i = 0; i < st->readers.size(); i++)
+		if (w - st->readers[i]->ridx > w - oldest)
+			oldest = st->readers[i]->ridx;
+	if (w - oldest < SC_NUMBLOCKS) {
+		read_memory_barrier();
+		return &st->slots[w % SC_NUMBLOCKS];
+	}
+
+	for (size_t i = 0; i < st->readers.size(); i++)
+		st->readers[i]->dropped++;
+	return 0;
+}
+
+// Converts the block once for each stream and publishes it to the readers,
+// waking those that are sleeping.  The trx thread only ever takes a lock to
+// signal an idle worker, and never waits for one that is busy.
+void sidechain_queue(const float* buf, size_t len, int samplerate, double freq, bool reverse)
+{
+	for (size_t i = 0; i < streams.size(); i++) {
+		sc_stream* st = streams[i];
+		// with every reader disabled, neither convert nor wake them; their
+		// own timeouts discard what is already queued
+		if (!stream_wanted(st)) {
+			st->paused = true;
+			continue;
+		}
+		if (st->paused) { // don't carry the resampler's history over the gap
+			st->rs.reset();
+			st->paused = false;
+		}
+		int rate = st->rate ? st->rate : samplerate;
+		bool convert = (rate != samplerate);
+		if (convert && !st->rs.set_rates(samplerate, rate)) {
+			if (st->failed != samplerate) {
+				LOG_ERROR("Cannot convert %d to %d sps", samplerate, rate);
+				st->failed = samplerate;
+			}
+			continue;
+		}
+
+		const float* in = buf;
+		size_t inlen = len, used;
+		while (inlen) {
+			sc_block* b = stream_slot(st);
+			if (!b)
+				break;
+			if (convert)
+				b->len = st->rs.process(in, inlen, b->buf, SC_MAXBLOCK, used);
+			else {
+				b->len = used = MIN(inlen, (size_t)SC_MAXBLOCK);
+				memcpy(b->buf, in, used * sizeof(*in));
+			}
+			in += used;
+			inlen -= used;
+			if (b->len == 0) {
+				if (used == 0)
+					break;
+				continue;
+			}
+			b->samplerate = rate;
+			b->freq = freq;
+			b->reverse = reverse;
+			write_memory_barrier();
+			st->widx = st->widx + 1;
+		}
+
+		full_memory_barrier();
+		for (size_t j = 0; j < st->readers.size(); j++) {
+			sc_worker* w = st->readers[j];
+			if (w->idle) {
+				pthread_mutex_lock(w->wake.mtxp());
+				w->wake.signal();
+				pthread_mutex_unlock(w->wake.mtxp());
+			}
+		}
+	}
+
+	if (samplerate > 0)
+		report_audio += (double)len / samplerate;
+	if (unlikely(report_audio >= SC_REPORT_INTERVAL)) {
+		report_audio = 0.0;
+		std::vector<sc_stats> stats;
+		sidechain_stats(stats);
+		for (size_t i = 0; i < stats.size(); i++) {
+			if (stats[i].audio == 0.0)
+				continue;
+			LOG_VERBOSE("%s: %.2f%% of real time, %lu blocks dropped",
+				    stats[i].name, 100.0 * stats[i].cpu / stats[i].audio,
+				    stats[i].dropped);
+		}
+	}
+}
+
+// Hands the queued detections back to their detectors.  The queue size is
+// checked without the lock so that the common case costs nothing.
+void sidechain_dispatch(void)
+{
+	if (likely(nevents == 0))
+		return;
+
+	std::vector<sc_event> ev;
+	pthread_mutex_lock(&events_mutex);
+	ev.swap(events);
+	nevents = 0;
+	pthread_mutex_unlock(&events_mutex);
+
+	for (size_t i = 0; i < ev.size(); i++)
+		ev[i].det->dispatch(ev[i]);
+}
+
+void sidechain_stats(std::vector<sc_stats>& stats)
+{
+	guard_lock workers_lock(&workers_mutex);
+	stats.resize(workers.size());
+	for (size_t i = 0; i < workers.size(); i++) {
+		sc_worker* w = workers[i];
+		guard_lock lock(&w->stats_mutex);
+		stats[i].name = w->det->name;
+		stats[i].cpu = w->cpu;
+		stats[i].audio = w->audio;
+		stats[i].blocks = w->blocks;
+		stats[i].dropped = w->dropped;
+	}
+}
+
+static void* sidechain_loop(void* arg)
+{
+	sc_worker* w = static_cast<sc_worker*>(arg);
+	sc_stream* st = w->stream;
+	std::vector<sc_event> found;
+	struct timespec t0, t1;
+
+	for (;;) {
+		if (!w->det->enabled()) // discard everything queued so far
+			w->ridx = st->widx;
+		if (w->ridx == st->widx) {
+			pthread_mutex_lock(w->wake.mtxp());
+			w->idle = true;
+			full_memory_barrier();
+			// the producer checks idle after writing, so recheck before waiting;
+			// the timeout is only a safety net
+			if (w->ridx == st->widx && !w->stop)
+				w->wake.wait(0.5);
+			w->idle = false;
+			pthread_mutex_unlock(w->wake.mtxp());
+			if (w->stop)
+				break;
+			continue;
+		}
+		read_memory_barrier();
+
+		const sc_block& b = st->slots[w->ridx % SC_NUMBLOCKS];
+		clock_gettime(SC_CLOCK, &t0);
+		w->det->process(b, found);
+		clock_gettime(SC_CLOCK, &t1);
+
+		pthread_mutex_lock(&w->stats_mutex);
+		w->cpu += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		if (b.samplerate > 0)
+			w->audio += (double)b.len / b.samplerate;
+		w->blocks++;
+		pthread_mutex_unlock(&w->stats_mutex);
+
+		full_memory_barrier();
+		w->ridx = w->ridx + 1;
+
+		if (!found.empty()) {
+			pthread_mutex_lock(&events_mutex);
+			for (size_t i = 0; i < found.size(); i++) {
+				events.push_back(found[i]);
+				events.back().det = w->det;
+			}
+			nevents = events.size();
+			pthread_mutex_unlock(&events_mutex);
+			found.clear();
+		}
+	}
+
+	return NULL;
+}
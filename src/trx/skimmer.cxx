@@ -0,0 +1,795 @@
+// ----------------------------------------------------------------------------
+// skimmer.cxx  --  decode every signal in the passband
+//
+// This file is part of fldigi.
+//
+// Fldigi is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Fldigi is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with fldigi.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <config.h>
+
+#include <cmath>
+#include <ctime>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+
+#include "skimmer.h"
+#include "complex.h"
+#include "filters.h"
+#include "fft.h"
+#include "pskcoeff.h"
+#include "pskdemod.h"
+#include "rtty.h"
+#include "morse.h"
+#include "misc.h"
+#include "threads.h"
+#include "qrunner.h"
+#include "configuration.h"
+#include "status.h"
+#include "main.h"
+#include "fl_digi.h"
+#include "waterfall.h"
+#include "spot.h"
+#include "debug.h"
+
+LOG_FILE_SOURCE(debug::LOG_MODEM);
+
+#define SKIM_SAMPLERATE 8000
+#define SKIM_FFTLEN     1024            // 7.8 Hz bins, 128 ms
+#define SKIM_BINHZ      ((double)SKIM_SAMPLERATE / SKIM_FFTLEN)
+#define SKIM_HISTORY    16              // spectra kept for the keying test
+#define SKIM_SCAN       8               // spectra between scans
+#define SKIM_LOWFREQ    200
+#define SKIM_HIGHFREQ   3500
+#define SKIM_TIMEOUT    30.0            // seconds a lost signal is still decoded
+#define SKIM_VOTES      3               // scans needed to change a signal's mode
+#define SKIM_MAXTHREADS 8
+#define SKIM_LINE_MAX   80              // characters in a log line
+#define SKIM_LINE_IDLE  10              // seconds before an idle line is logged
+#define SKIM_RELEASED   -1              // event kind: a decoder was released
+
+#define SKIM_PSK_SQUELCH 0.4
+#define SKIM_PSK_DECAY   20             // symbols
+
+cSkimmer* skimmer = 0;
+
+//=====================================================================
+// decoders
+//=====================================================================
+
+// A phasor oscillator, mixing with exp(+j*2*pi*f*n/samplerate)
+struct skim_nco
+{
+	skim_nco() : z(1.0, 0.0), dz(1.0, 0.0), n(0) { }
+	void set(double f) {
+		dz = complex(cos(2.0 * M_PI * f / SKIM_SAMPLERATE),
+			     sin(2.0 * M_PI * f / SKIM_SAMPLERATE));
+	}
+	complex next(void) {
+		complex r = z;
+		z = z * dz;
+		if (++n == 1024) { // keep the amplitude at 1
+			z = z * (1.0 / z.mag());
+			n = 0;
+		}
+		return r;
+	}
+	complex z, dz;
+	int n;
+};
+
+struct skim_decoder
+{
+	skim_decoder(int id_, trx_mode mode_, double f)
+		: id(id_), mode(mode_), freq(f), seen(0.0), votes(0) { }
+	virtual ~skim_decoder() { }
+	virtual void rx(const float* buf, size_t len, bool reverse) = 0;
+
+	int id;
+	trx_mode mode;
+	double freq;            // may be changed by the AFC
+	double seen;            // when the signal was last found by a scan
+	int votes;              // successive scans that found another mode here
+	std::string text;       // decoded since the last block
+};
+
+// PSK31 and PSK63.  The signal is mixed and decimated here, the rest is
+// the browser's decoder.
+struct skim_psk : public skim_decoder
+{
+	skim_psk(int id_, trx_mode mode_, double f)
+		: skim_decoder(id_, mode_, f), centre(f), dcd(false)
+	{
+		double fir1c[FIRLEN];
+		symbollen = (mode == MODE_PSK63) ? 128 : 256;
+		bandwidth = (double)SKIM_SAMPLERATE / symbollen;
+		wsincfilt(fir1c, 1.0 / symbollen, true);
+		fir1.init(FIRLEN, symbollen / 16, fir1c, fir1c);
+		nco.set(freq);
+	}
+
+	void rx(const float* buf, size_t len, bool reverse)
+	{
+		complex z, symbol;
+		for (size_t i = 0; i < len; i++) {
+			z = nco.next() * buf[i];
+			if (fir1.run(z, z) && demod.sync(z, symbol))
+				rx_symbol(symbol);
+		}
+	}
+
+	void rx_symbol(complex symbol)
+	{
+		switch (demod.rx_symbol(symbol, SKIM_PSK_DECAY)) {
+		case pskdemod::DCD_PREAMBLE:
+			dcd = true;
+			break;
+		case pskdemod::DCD_POSTAMBLE:
+			dcd = false;
+			break;
+		default:
+			dcd = demod.quality.norm() > SKIM_PSK_SQUELCH;
+			break;
+		}
+		if (!dcd)
+			return;
+
+		int c = demod.rx_bit();
+		if (c == '\r')
+			c = '\n';
+		if (c == '\n' || (c > 0 && !iscntrl(c & 0xFF)))
+			text += c;
+
+		freq = clamp(freq - demod.freqerr(SKIM_SAMPLERATE, symbollen),
+			     centre - bandwidth, centre + bandwidth);
+		nco.set(freq);
+	}
+
+	int symbollen;
+	double bandwidth, centre;
+	skim_nco nco;
+	C_FIR_filter fir1;
+	pskdemod demod;
+	bool dcd;
+};
+
+// Baudot
+static const char letters[32] = {
+	'\0',	'E',	'\n',	'A',	' ',	'S',	'I',	'U',
+	'\r',	'D',	'R',	'J',	'N',	'F',	'C',	'K',
+	'T',	'Z',	'L',	'W',	'H',	'Y',	'P',	'Q',
+	'O',	'B',	'G',	' ',	'M',	'X',	'V',	' '
+};
+static const char figures[32] = {
+	'\0',	'3',	'\n',	'-',	' ',	'\a',	'8',	'7',
+	'\r',	'$',	'4',	'\'',	',',	'!',	':',	'(',
+	'5',	'"',	')',	'2',	'#',	'6',	'0',	'1',
+	'9',	'?',	'&',	' ',	'.',	'/',	';',	' '
+};
+#define BAUDOT_LTRS 0x1F
+#define BAUDOT_FIGS 0x1B
+
+// The shift, speed and framing of RTTY are taken from the RTTY settings,
+// so that the skimmer decodes what the modem would
+struct skim_rtty_settings
+{
+	double shift, baud;
+	int nbits;
+	bool parity;
+};
+
+static skim_rtty_settings rtty_settings(void)
+{
+	skim_rtty_settings s;
+	s.shift = (progdefaults.rtty_shift >= 0 ?
+		   rtty::SHIFT[progdefaults.rtty_shift] : progdefaults.rtty_custom_shift);
+	s.baud = rtty::BAUD[progdefaults.rtty_baud];
+	s.nbits = rtty::BITS[progdefaults.rtty_bits];
+	s.parity = s.nbits != 5 && progdefaults.rtty_parity != RTTY_PARITY_NONE;
+	return s;
+}
+
+struct skim_rtty : public skim_decoder
+{
+	skim_rtty(int id_, double f, const skim_rtty_settings& cfg_)
+		: skim_decoder(id_, MODE_RTTY, f), cfg(cfg_), reverse(false),
+		  bitlen(SKIM_SAMPLERATE / cfg.baud),
+		  msum(0.0, 0.0), ssum(0.0, 0.0), pos(0), prev(0.0), state(0), nbit(0),
+		  data(0), counter(0.0), qual(0.0), figs(false)
+	{
+		// the tone filters integrate over half a bit
+		mbuf.resize((size_t)(bitlen / 2), complex(0.0, 0.0));
+		sbuf.resize(mbuf.size(), complex(0.0, 0.0));
+		set_tones();
+	}
+
+	void set_tones(void)
+	{
+		double d = reverse ? -cfg.shift / 2 : cfg.shift / 2;
+		mark.set(freq + d);
+		space.set(freq - d);
+	}
+
+	void rx(const float* buf, size_t len, bool rev)
+	{
+		if (rev != reverse) {
+			reverse = rev;
+			set_tones();
+		}
+		for (size_t i = 0; i < len; i++) {
+			complex m = mark.next() * buf[i], s = space.next() * buf[i];
+			msum = msum + m - mbuf[pos];
+			ssum = ssum + s - sbuf[pos];
+			mbuf[pos] = m;
+			sbuf[pos] = s;
+			if (++pos == mbuf.size())
+				pos = 0;
+
+			double ma = msum.mag(), sa = ssum.mag();
+			double d = (ma - sa) / (ma + sa + 1e-20); // +1 mark, -1 space
+			bit(d);
+			prev = d;
+		}
+	}
+
+	void bit(double d)
+	{
+		if (state == 0) {
+			if (prev > 0 && d < 0) { // start bit edge
+				state = 1;
+				nbit = 0;
+				data = 0;
+				qual = 0.0;
+				counter = bitlen / 2;
+			}
+			return;
+		}
+		if ((counter -= 1.0) > 0)
+			return;
+		counter += bitlen;
+
+		int b = d > 0;
+		qual += fabs(d);
+		if (nbit == 0) {
+			if (b) // false start
+				state = 0;
+		}
+		else if (nbit <= cfg.nbits)
+			data |= b << (nbit - 1);
+		else if (nbit == cfg.nbits + 1 && cfg.parity)
+			; // the parity bit is not checked
+		else {
+			state = 0;
+			if (b && qual / (nbit + 1) > 0.5)
+				decode(data);
+		}
+		nbit++;
+	}
+
+	void decode(int c)
+	{
+		if (cfg.nbits != 5) {
+			c &= 0x7F;
+			if (c == '\r')
+				return;
+			if (c == '\n' || !iscntrl(c))
+				text += (char)c;
+			return;
+		}
+		if (c == BAUDOT_LTRS) {
+			figs = false;
+			return;
+		}
+		if (c == BAUDOT_FIGS) {
+			figs = true;
+			return;
+		}
+		char ch = figs ? figures[c] : letters[c];
+		if (ch == ' ') // unshift on space
+			figs = false;
+		if (ch == '\n' || (ch && !iscntrl(ch & 0xFF)))
+			text += ch;
+	}
+
+	skim_rtty_settings cfg;
+	bool reverse;
+	double bitlen;
+	skim_nco mark, space;
+	std::vector<complex> mbuf, sbuf;
+	complex msum, ssum;
+	size_t pos;
+	double prev;
+	int state, nbit, data;
+	double counter, qual;
+	bool figs;
+};
+
+// CW with an adaptive threshold and dot length.  The envelope is filtered to
+// about 50 Hz in two stages, 8000 -> 800 -> 200 sps, so one tick is 5 ms.
+struct skim_cw : public skim_decoder
+{
+	skim_cw(int id_, double f, morse* table_)
+		: skim_decoder(id_, MODE_CW, f), table(table_), peak(0.0), noise(0.0),
+		  key(false), mark(0), gap(0), dot(12.0), word(false), nsym(0)
+	{
+		double fir1c[FIRLEN], fir2c[FIRLEN];
+		wsincfilt(fir1c, 160.0 / SKIM_SAMPLERATE, true);
+		wsincfilt(fir2c, 50.0 / 800.0, true);
+		fir1.init(FIRLEN, 10, fir1c, fir1c);
+		fir2.init(FIRLEN, 4, fir2c, fir2c);
+		nco.set(freq);
+	}
+
+	void rx(const float* buf, size_t len, bool reverse)
+	{
+		complex z;
+		for (size_t i = 0; i < len; i++) {
+			z = nco.next() * buf[i];
+			if (fir1.run(z, z) && fir2.run(z, z))
+				tick(z.mag());
+		}
+	}
+
+	void tick(double env)
+	{
+		// fast attack, slow release for the peak; the reverse for the noise
+		peak = (env > peak) ? env : peak * 0.998;
+		noise = (env < noise || noise == 0.0) ? env : noise * 1.002;
+		bool strong = peak > 4.0 * noise;
+		double range = peak - noise;
+
+		if (!key && strong && env > noise + 0.6 * range) {
+			key = true;
+			mark = 0;
+		}
+		else if (key && (!strong || env < noise + 0.4 * range)) {
+			key = false;
+			element();
+			gap = 0;
+		}
+
+		if (key) {
+			mark++;
+			return;
+		}
+		gap++;
+		if (nsym && gap > 2 * dot) {
+			const char* c = table->rx_lookup(sym);
+			if (c)
+				text += c;
+			nsym = 0;
+			word = true;
+		}
+		else if (word && gap > 5 * dot) {
+			text += ' ';
+			word = false;
+		}
+	}
+
+	void element(void)
+	{
+		if (mark < 0.3 * dot) // a spike
+			return;
+		if (nsym == sizeof(sym) - 1) { // no such character
+			nsym = 0;
+			return;
+		}
+		if (mark < 2 * dot) {
+			sym[nsym++] = '.';
+			dot = 0.75 * dot + 0.25 * mark;
+		}
+		else {
+			sym[nsym++] = '-';
+			dot = 0.75 * dot + 0.25 * mark / 3.0;
+		}
+		sym[nsym] = '\0';
+		dot = clamp(dot, 2.0, 60.0);
+	}
+
+	morse* table;
+	skim_nco nco;
+	C_FIR_filter fir1, fir2;
+	double peak, noise;
+	bool key;
+	int mark, gap;
+	double dot;                      // in ticks
+	bool word;
+	char sym[9];                     // dots and dashes, nul terminated
+	size_t nsym;
+};
+
+//=====================================================================
+// detection
+//=====================================================================
+
+cSkimmer::cSkimmer()
+	: sc_detector("Skimmer"), fft(new Cfft(SKIM_FFTLEN)),
+	  fftbuf(SKIM_FFTLEN), window(SKIM_FFTLEN), avg(SKIM_FFTLEN / 2, 0.0),
+	  history(SKIM_HISTORY, std::vector<double>(SKIM_FFTLEN / 2, 0.0)),
+	  fftpos(0), nspectra(0), now(0.0), blk(0), pool(0),
+	  cw_table(new morse), log(0)
+{
+	for (int i = 0; i < SKIM_FFTLEN; i++)
+		window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / SKIM_FFTLEN);
+}
+
+cSkimmer::~cSkimmer()
+{
+	for (size_t i = 0; i < decoders.size(); i++)
+		delete decoders[i];
+	delete pool;
+	delete cw_table;
+	delete fft;
+
+	flush_lines(time(NULL), true);
+	if (log)
+		fclose(log);
+}
+
+int cSkimmer::samplerate(void)
+{
+	return SKIM_SAMPLERATE;
+}
+
+bool cSkimmer::enabled(void)
+{
+	return progdefaults.SkimmerEnabled;
+}
+
+void cSkimmer::decode_job(void* arg, size_t i)
+{
+	cSkimmer* s = static_cast<cSkimmer*>(arg);
+	s->decoders[i]->rx(s->blk->buf, s->blk->len, s->blk->reverse);
+}
+
+void cSkimmer::process(const sc_block& blk_, std::vector<sc_event>& events)
+{
+	if (!pool)
+		pool = new fork_join(std::max(0, std::min(fork_join::ncpus() - 1, SKIM_MAXTHREADS)));
+
+	for (size_t i = 0; i < blk_.len; i++) {
+		fftbuf[fftpos] = blk_.buf[i];
+		if (++fftpos == SKIM_FFTLEN) {
+			spectrum();
+			fftpos = 0;
+		}
+	}
+	now += (double)blk_.len / SKIM_SAMPLERATE;
+
+	// the spotter's buffers of released decoders are freed first, as their
+	// ids may already have been given to new decoders
+	for (size_t i = 0; i < released.size(); i++) {
+		sc_event ev(SKIM_RELEASED);
+		ev.arg2 = released[i];
+		events.push_back(ev);
+	}
+	released.clear();
+
+	// the decoders share the block and each keeps to its own state
+	blk = &blk_;
+	pool->run(decode_job, this, decoders.size());
+	blk = 0;
+
+	for (size_t i = 0; i < decoders.size(); i++) {
+		skim_decoder* d = decoders[i];
+		if (d->text.empty())
+			continue;
+		sc_event ev(d->mode, d->text);
+		ev.arg1 = (int)(d->freq + 0.5);
+		ev.arg2 = d->id;
+		events.push_back(ev);
+		d->text.clear();
+	}
+}
+
+// Averages the power spectrum and keeps the recent spectra for the keying
+// test.  A scan follows every SKIM_SCAN spectra.
+void cSkimmer::spectrum(void)
+{
+	std::vector<double> work(2 * SKIM_FFTLEN);
+	for (int i = 0; i < SKIM_FFTLEN; i++) {
+		work[2 * i] = fftbuf[i] * window[i];
+		work[2 * i + 1] = 0.0;
+	}
+	fft->cdft(&work[0]);
+
+	std::vector<double>& pwr = history[nspectra % SKIM_HISTORY];
+	for (int k = 0; k < SKIM_FFTLEN / 2; k++) {
+		pwr[k] = work[2 * k] * work[2 * k] + work[2 * k + 1] * work[2 * k + 1];
+		avg[k] = nspectra ? decayavg(avg[k], pwr[k], 4) : pwr[k];
+	}
+
+	if (++nspectra >= SKIM_HISTORY && nspectra % SKIM_SCAN == 0)
+		scan();
+}
+
+struct skim_peak {
+	skim_peak(double p_, int k_) : p(p_), k(k_) { }
+	bool operator<(const skim_peak& o) const { return p > o.p; }
+	double p;
+	int k;
+};
+
+static double tolerance(trx_mode mode)
+{
+	switch (mode) {
+	case MODE_CW: return 25.0;
+	case MODE_PSK31: return 30.0;
+	case MODE_PSK63: return 50.0;
+	default: return 40.0;
+	}
+}
+
+// A signal is keyed if its strongest and weakest power in the recent spectra
+// differ by more than 10 dB.
+bool cSkimmer::is_keyed(int k)
+{
+	double hmax = 0.0, hmin = HUGE_VAL;
+	for (int h = 0; h < SKIM_HISTORY; h++) {
+		double p = history[h][k-1] + history[h][k] + history[h][k+1];
+		hmax = std::max(hmax, p);
+		hmin = std::min(hmin, p);
+	}
+	return hmax > 10.0 * hmin;
+}
+
+// Finds the signals in the averaged spectrum, starts decoders for new ones
+// and releases those whose signal has gone.
+void cSkimmer::scan(void)
+{
+	int kmin = (int)(SKIM_LOWFREQ / SKIM_BINHZ);
+	int kmax = std::min((int)(SKIM_HIGHFREQ / SKIM_BINHZ), SKIM_FFTLEN / 2 - 2);
+
+	std::vector<double> sorted(avg.begin() + kmin, avg.begin() + kmax + 1);
+	std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+	double noise = sorted[sorted.size() / 2];
+	if (noise <= 0.0)
+		return;
+	double thr = noise * pow(10.0, progdefaults.SkimmerSNR / 10.0);
+
+	std::vector<skim_peak> peaks;
+	for (int k = kmin + 1; k < kmax; k++)
+		if (avg[k] > thr && avg[k] >= avg[k-1] && avg[k] > avg[k+1])
+			peaks.push_back(skim_peak(avg[k], k));
+	std::sort(peaks.begin(), peaks.end());
+
+	std::vector<bool> used(SKIM_FFTLEN / 2, false);
+	std::vector<std::pair<trx_mode, double> > found;
+	int shift = (int)floor(rtty_settings().shift / SKIM_BINHZ + 0.5);
+
+	for (size_t i = 0; i < peaks.size(); i++) {
+		int k = peaks[i].k;
+		if (used[k])
+			continue;
+
+		// occupied bandwidth: the bins within 20 dB of the peak
+		int l = k, r = k;
+		while (l > kmin && avg[l-1] > avg[k] / 100.0) l--;
+		while (r < kmax && avg[r+1] > avg[k] / 100.0) r++;
+		double width = (r - l + 1) * SKIM_BINHZ;
+		double sum = 0.0, moment = 0.0;
+		for (int j = l; j <= r; j++) {
+			sum += avg[j];
+			moment += avg[j] * j;
+		}
+		double f = moment / sum * SKIM_BINHZ;
+		bool keyed = is_keyed(k);
+
+		for (int j = l; j <= r; j++)
+			used[j] = true;
+
+		// RTTY: two keyed tones the configured shift apart
+		size_t partner = peaks.size();
+		if (keyed) {
+			for (size_t j = i + 1; j < peaks.size(); j++) {
+				int q = peaks[j].k;
+				if (used[q] || abs(abs(q - k) - shift) > 2)
+					continue;
+				if (peaks[j].p * 100.0 > peaks[i].p && is_keyed(q)) {
+					partner = j;
+					break;
+				}
+			}
+		}
+		if (partner < peaks.size()) {
+			// the keying sidebands must not be taken for other signals
+			int q = peaks[partner].k;
+			for (int j = std::max(std::min(k, q) - shift / 2, 0);
+			     j <= std::min(std::max(k, q) + shift / 2, SKIM_FFTLEN / 2 - 1); j++)
+				used[j] = true;
+			found.push_back(std::make_pair((trx_mode)MODE_RTTY, (k + q) / 2.0 * SKIM_BINHZ));
+		}
+		else if (keyed && width <= 80.0)
+			found.push_back(std::make_pair((trx_mode)MODE_CW, f));
+		else if (!keyed && width >= 40.0 && width <= 80.0)
+			found.push_back(std::make_pair((trx_mode)MODE_PSK31, f));
+		else if (!keyed && width > 80.0 && width <= 160.0)
+			found.push_back(std::make_pair((trx_mode)MODE_PSK63, f));
+	}
+
+	// A signal keeps its decoder while it is within the tolerance of either
+	// mode.  If it is classified differently a few times running, e.g. PSK63
+	// that looked like PSK31 during its preamble, the decoder is replaced.
+	for (size_t i = 0; i < found.size(); i++) {
+		trx_mode mode = found[i].first;
+		double f = found[i].second;
+		size_t j;
+		for (j = 0; j < decoders.size(); j++) {
+			skim_decoder* d = decoders[j];
+			if (fabs(d->freq - f) >= std::max(tolerance(d->mode), tolerance(mode)))
+				continue;
+			d->seen = now;
+			if (d->mode == mode)
+				d->votes = 0;
+			else if (++d->votes >= SKIM_VOTES) {
+				LOG_VERBOSE("Decoder %d at %.0f Hz is %s, not %s", d->id, d->freq,
+					    mode_info[mode].sname, mode_info[d->mode].sname);
+				release(d);
+				decoders[j] = 0; // its id may be reused
+				decoders[j] = new_decoder(mode, f);
+			}
+			break;
+		}
+		if (j == decoders.size() && (int)decoders.size() < progdefaults.SkimmerDecoders)
+			decoders.push_back(new_decoder(mode, f));
+	}
+
+	// release lost signals, and decoders that have drifted onto another
+	for (size_t i = 0; i < decoders.size(); ) {
+		skim_decoder* d = decoders[i];
+		bool dup = false;
+		for (size_t j = 0; j < i && !dup; j++)
+			dup = fabs(decoders[j]->freq - d->freq) < tolerance(d->mode);
+		if (dup || now - d->seen > SKIM_TIMEOUT) {
+			LOG_VERBOSE("Releasing %s decoder %d at %.0f Hz",
+				    mode_info[d->mode].sname, d->id, d->freq);
+			release(d);
+			decoders.erase(decoders.begin() + i);
+		}
+		else
+			i++;
+	}
+}
+
+// Decoders take the lowest id that is not in use, so that there are never
+// more ids, and spotter buffers and log lines, than decoders
+int cSkimmer::free_id(void)
+{
+	std::vector<bool> used(decoders.size() + 1, false);
+	for (size_t i = 0; i < decoders.size(); i++)
+		if (decoders[i] && decoders[i]->id < (int)used.size())
+			used[decoders[i]->id] = true;
+	return std::find(used.begin(), used.end(), false) - used.begin();
+}
+
+skim_decoder* cSkimmer::new_decoder(int kind, double f)
+{
+	skim_decoder* d;
+	int id = free_id();
+	switch (kind) {
+	case MODE_CW:
+		d = new skim_cw(id, f, cw_table);
+		break;
+	case MODE_RTTY:
+		d = new skim_rtty(id, f, rtty_settings());
+		break;
+	default:
+		d = new skim_psk(id, kind, f);
+		break;
+	}
+	d->seen = now;
+	LOG_VERBOSE("Starting %s decoder %d at %.0f Hz", mode_info[kind].sname, d->id, f);
+	return d;
+}
+
+void cSkimmer::release(skim_decoder* d)
+{
+	released.push_back(d->id);
+	delete d;
+}
+
+//=====================================================================
+// output, on the trx thread
+//=====================================================================
+
+// The spotters are fed on the main thread, like the receive text and the
+// signal browser
+static void skim_spot(std::string text, int decoder, int afreq, int md)
+{
+	if (!progStatus.spot_recv)
+		return;
+	for (size_t i = 0; i < text.length(); i++)
+		spot_recv(text[i], decoder, afreq, md);
+}
+
+void cSkimmer::dispatch(const sc_event& ev)
+{
+	if (ev.kind == SKIM_RELEASED) {
+		REQ(&spot_release, SKIM_DECODER_BASE + ev.arg2);
+		std::map<int, line_t>::iterator i = lines.find(ev.arg2);
+		if (i != lines.end()) {
+			write_line(i->second);
+			lines.erase(i);
+		}
+		return;
+	}
+
+	REQ(&skim_spot, ev.text, SKIM_DECODER_BASE + ev.arg2, ev.arg1, ev.kind);
+
+	time_t t = time(NULL);
+	if (progdefaults.SkimmerLog) {
+		line_t& line = lines[ev.arg2];
+		for (size_t i = 0; i < ev.text.length(); i++) {
+			if (line.text.empty()) {
+				long long rf = wf->rfcarrier();
+				line.rf = (rf > 0) ? (wf->USB() ? rf + ev.arg1 : rf - ev.arg1) : 0;
+				line.afreq = ev.arg1;
+				line.mode = ev.kind;
+				line.start = t;
+			}
+			if (ev.text[i] == '\n')
+				write_line(line);
+			else {
+				line.text += ev.text[i];
+				if (line.text.length() >= SKIM_LINE_MAX)
+					write_line(line);
+			}
+		}
+		line.last = t;
+	}
+	flush_lines(t, false);
+}
+
+void cSkimmer::flush_lines(time_t t, bool all)
+{
+	for (std::map<int, line_t>::iterator i = lines.begin(); i != lines.end(); ) {
+		if (all || t - i->second.last >= SKIM_LINE_IDLE) {
+			write_line(i->second);
+			lines.erase(i++);
+		}
+		else
+			++i;
+	}
+}
+
+// One line per signal and burst of text: the time it started, the RF
+// frequency in kHz (or the audio frequency if the rig frequency is not
+// known), the mode and the text.
+void cSkimmer::write_line(line_t& line)
+{
+	if (line.text.find_first_not_of(' ') == std::string::npos) {
+		line.text.clear();
+		return;
+	}
+	if (!log) {
+		std::string fname = HomeDir + "skimmer.log";
+		if ((log = fopen(fname.c_str(), "a")) == NULL) {
+			LOG_PERROR(fname.c_str());
+			line.text.clear();
+			return;
+		}
+	}
+
+	char tbuf[32];
+	strftime(tbuf, sizeof(tbuf), "%Y-%m-%d %H:%M:%SZ", gmtime(&line.start));
+	if (line.rf)
+		fprintf(log, "%s %12.3f %-6s %s\n", tbuf, line.rf / 1000.0,
+			mode_info[line.mode].sname, line.text.c_str());
+	else
+		fprintf(log, "%s %8d Hz  %-6s %s\n", tbuf, line.afreq,
+			mode_info[line.mode].sname, line.text.c_str());
+	fflush(log);
+	line.text.clear();
+}
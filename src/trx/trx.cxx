@@ -38,6 +38,9 @@
 #include "configuration.h"
 #include "status.h"
 #include "dtmf.h"
+#include "sidechain.h"
+#include "dspstats.h"
+#include "skimmer.h"
 
 #include "soundconf.h"
 #include "ringbuffer.h"
@@ -229,6 +232,7 @@ void trx_trx_receive_loop()
 	rbvec[0].buf = rbvec[1].buf = 0;
 
 	while (1) {
+		dspstats_begin();
 		try {
 			numread = 0;
 			while (numread < SCBLOCKSIZE && trx_state == STATE_RX)
@@ -251,13 +255,16 @@ void trx_trx_receive_loop()
 			break;
 
 		trxrb.write_advance(numread);
+		dspstats_stage(DSP_STAGE_READ);
 		REQ(&waterfall::sig_data, wf, rbvec[0].buf, numread, current_samplerate);
+		dspstats_stage(DSP_STAGE_WATERFALL);
 
 		if (!bHistory) {
 			active_modem->rx_process(rbvec[0].buf, numread);
-			if (progdefaults.rsid)
-				ReedSolomon->receive(fbuf, numread);
-			dtmf->receive(fbuf, numread);
+			dspstats_stage(DSP_STAGE_MODEM);
+			sidechain_queue(fbuf, numread, active_modem->get_samplerate(),
+					active_modem->get_freq(), !(wf->Reverse() ^ wf->USB()));
+			dspstats_stage(DSP_STAGE_SIDECHAIN);
 		}
 		else {
 			bool afc = progStatus.afconoff;
@@ -273,7 +280,16 @@ void trx_trx_receive_loop()
 			progStatus.afconoff = afc;
 			bHistory = false;
 			active_modem->HistoryON(false);
+			dspstats_stage(DSP_STAGE_MODEM);
 		}
+		sidechain_dispatch();
+		dspstats_stage(DSP_STAGE_DISPATCH);
+
+		size_t sndrb_fill, sndrb_size;
+		scard->rx_levels(sndrb_fill, sndrb_size);
+		dspstats_levels(trxrb.read_space(), trxrb.length(), sndrb_fill, sndrb_size,
+				cbq[TRX_TID]->size(), cbq[TRX_TID]->nfull);
+		dspstats_end(numread, current_samplerate);
 	}
 	if (scard->must_close(O_RDONLY))
 		scard->Close(O_RDONLY);
@@ -304,6 +320,7 @@ void trx_trx_transmit_loop()
 			push2talk->set(true);
 			REQ(&waterfall::set_XmtRcvBtn, wf, true);
 		}
+		active_modem->alloc_txbuffers();
 		active_modem->tx_init(scard);
 
 		if ((active_modem != null_modem && 
@@ -338,6 +355,7 @@ void trx_trx_transmit_loop()
 					scard->Close();
 					LOG_ERROR("%s", e.what());
 					put_status(e.what(), 5);
+					active_modem->free_txbuffers();
 					MilliSleep(10);
 					return;
 				}
@@ -361,6 +379,7 @@ void trx_trx_transmit_loop()
 		if (scard->must_close(O_WRONLY))
 			scard->Close(O_WRONLY);
 
+		active_modem->free_txbuffers();
 	} else
 		MilliSleep(10);
 
@@ -391,6 +410,7 @@ void trx_tune_loop()
 		}
 
 		push2talk->set(true);
+		active_modem->alloc_txbuffers();
 		active_modem->tx_init(scard);
 
 		try {
@@ -408,6 +428,7 @@ void trx_tune_loop()
 			scard->Close();
 			LOG_ERROR("%s", e.what());
 			put_status(e.what(), 5);
+			active_modem->free_txbuffers();
 			MilliSleep(10);
 			return;
 		}
@@ -415,6 +436,7 @@ void trx_tune_loop()
 		if (scard->must_close(O_WRONLY))
 			scard->Close(O_WRONLY);
 
+		active_modem->free_txbuffers();
 		_trx_tune = 0;
 	} else
 		MilliSleep(10);
@@ -505,9 +527,15 @@ void trx_start_modem_loop()
 	REQ(&waterfall::opmode, wf);
 
 	if (old_modem) {
+		LOG_VERBOSE("Released %s modem, %u kB",
+			    old_modem->get_mode_name(),
+			    (unsigned)(old_modem->footprint() / 1024));
 		*mode_info[old_modem->get_mode()].modem = 0;
 		delete old_modem;
 	}
+	LOG_INFO("Started %s modem, %u kB resident",
+		 active_modem->get_mode_name(),
+		 (unsigned)(active_modem->footprint() / 1024));
 }
 
 //=============================================================================
@@ -570,8 +598,10 @@ void trx_start(void)
 	}
 	
 	if (scard) delete scard;
+	sidechain_stop();
 	if (ReedSolomon) delete ReedSolomon;
 	if (dtmf) delete dtmf;
+	if (skimmer) delete skimmer;
 
 
 	switch (progdefaults.btnAudioIOis) {
@@ -599,6 +629,11 @@ void trx_start(void)
 
 	ReedSolomon = new cRsId;
 	dtmf = new cDTMF;
+	skimmer = new cSkimmer;
+	sidechain_add(ReedSolomon);
+	sidechain_add(dtmf);
+	sidechain_add(skimmer);
+	sidechain_start();
 
 #endif // !BENCHMARK_MODE
 
@@ -641,6 +676,8 @@ void trx_close()
 	while (trx_state != STATE_ENDED)
 		MilliSleep(100);
 
+	sidechain_stop();
+
 #if USE_NAMED_SEMAPHORES
 	if (sem_close(trx_sem) == -1)
 		LOG_PERROR("sem_close");
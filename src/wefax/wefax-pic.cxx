@@ -550,6 +550,15 @@ void wefax_pic::update_rx_pic_bw(unsigned char data, int pix_pos )
 	}
 }
 
+/// Called with a batch of consecutive bw pixels, typically one row,
+/// so that the decoder posts one request per row instead of one per pixel.
+void wefax_pic::update_rx_pic_row(const std::string & pixels, int pix_pos )
+{
+	for( size_t ix_pix = 0 ; ix_pix < pixels.size() ; ++ix_pix, pix_pos += bytes_per_pix ) {
+		update_rx_pic_bw( pixels[ix_pix], pix_pos );
+	}
+}
+
 static void wefax_cb_pic_rx_pause( Fl_Widget *, void *)
 {
 	wefax_btn_rx_pause->hide();
@@ -678,7 +687,7 @@ static void wefax_cb_pic_rx_auto_center( Fl_Widget *, void *)
 }
 
 /// This gets the directory where images are accessed by default.
-static const std::string & default_dir_get( const std::string & config_dir )
+const std::string & wefax_pic::default_dir_get( const std::string & config_dir )
 {
 	if( config_dir.empty() ) {
 		return PicsDir ;
@@ -713,7 +722,7 @@ static void wefax_cb_pic_rx_save( Fl_Widget *, void *)
 {
 	ENSURE_THREAD(FLMAIN_TID);
 	const char ffilter[] = "Portable Network Graphics\t*.png\n";
-	std::string dfname = default_dir_get( progdefaults.wefax_save_dir );
+	std::string dfname = wefax_pic::default_dir_get( progdefaults.wefax_save_dir );
 	dfname.append( wefax_serviceme->suggested_filename()  );
 
 	const char *file_name = FSEL::saveas(_("Save image as:"), ffilter, dfname.c_str(), NULL);
@@ -1276,7 +1285,7 @@ void wefax_pic::create_rx_viewer(int pos_x, int pos_y,int win_wid, int hei_win)
 	wefax_browse_rx_events = new Fl_Select_Browser(wid_off_two, hei_off_up, wid_btn_curr+2, wid_hei_two );
 	wefax_browse_rx_events->callback(wefax_cb_browse_rx_events, 0);
 	// static std::string tooltip_rx_events ;
-	std::string tooltip_rx_events = _("Files saved in ") + default_dir_get( progdefaults.wefax_save_dir );
+	std::string tooltip_rx_events = _("Files saved in ") + wefax_pic::default_dir_get( progdefaults.wefax_save_dir );
 	wefax_browse_rx_events->tooltip( tooltip_rx_events.c_str() );
 	/// TODO: The horizontal slider should not be always displayed.
 	wefax_browse_rx_events->has_scrollbar(Fl_Browser::VERTICAL_ALWAYS | Fl_Browser::HORIZONTAL);
@@ -1330,14 +1339,20 @@ void wefax_pic::set_rx_label(const std::string & win_label)
 
 void wefax_pic::save_image(const std::string & fil_name, const std::string & extra_comments )
 {
-	std::string dfname = default_dir_get( progdefaults.wefax_save_dir ) + fil_name ;
+	std::string dfname = wefax_pic::default_dir_get( progdefaults.wefax_save_dir ) + fil_name ;
 
 	std::stringstream local_comments;
 	local_comments << extra_comments ;
 	local_comments << "Slant:" << rx_slant_ratio << "\n" ;
 	local_comments << "Auto-Center:" << ( global_auto_center ? "On" : "Off" ) << "\n" ;
 	wefax_pic_rx_picture->save_png(dfname.c_str(),progdefaults.WEFAX_SaveMonochrome, local_comments.str().c_str());
-	add_to_files_list( dfname );
+	saved_image( fil_name );
+}
+
+/// Book-keeping once a received image is on disk, whoever wrote it.
+void wefax_pic::saved_image(const std::string & fil_name )
+{
+	add_to_files_list( wefax_pic::default_dir_get( progdefaults.wefax_save_dir ) + fil_name );
 	qso_notes( "RX:", fil_name );
 	wefax_serviceme->qso_rec_save();
 }
@@ -1480,7 +1495,7 @@ static void wefax_cb_pic_tx_load(Fl_Widget *, void *)
 		FSEL::select(_("Load image file"), "Portable Network Graphics\t*.png\n"
 			"Independent JPEG Group\t*.{jpg,jif,jpeg,jpe}\n"
 			"Graphics Interchange Format\t*.gif", 
-			default_dir_get( progdefaults.wefax_load_dir ).c_str() );
+			wefax_pic::default_dir_get( progdefaults.wefax_load_dir ).c_str() );
 	if (!fil_name) {
 		LOG_WARN( " Cannot FSEL::select" );
 		return ;
@@ -31,12 +31,17 @@
 #include <iostream>
 #include <iomanip>
 #include <cstring>
+#include <cerrno>
 #include <valarray>
 #include <cmath>
 #include <cstddef>
 #include <queue>
 #include <map>
+#include <vector>
+#include <ctime>
 #include <libgen.h>
+#include <zlib.h>
+#include <png.h>
 
 #include "debug.h"
 #include "gettext.h"
@@ -303,6 +308,146 @@ static int fm_deviation = -1 ;
 
 #define GARBAGE_STR "garbage"
 
+/// Spools the received rows to a raw temporary file, one byte per pixel.
+/// The PNG is then written row by row from this file, so that saving a
+/// received image never needs more memory than one row, whatever its height.
+class fax_row_spool {
+	FILE                     * m_fil ;
+	std::string                m_fil_nam ;
+	int                        m_width ;   // Pixels per row.
+	int                        m_rows ;    // Rows already written to the file.
+	std::vector<unsigned char> m_row ;     // Row being received.
+	bool                       m_row_set ; // Whether m_row received a pixel.
+
+	fax_row_spool(const fax_row_spool &);
+	fax_row_spool & operator=(const fax_row_spool &);
+
+	void write_row(void)
+	{
+		if( fwrite( &m_row[0], m_width, 1, m_fil ) != 1 ) {
+			LOG_ERROR("Cannot write %s:%s", m_fil_nam.c_str(), strerror(errno) );
+			discard();
+			return ;
+		}
+		++m_rows ;
+		std::fill( m_row.begin(), m_row.end(), 255 );
+		m_row_set = false ;
+	}
+public:
+	fax_row_spool() : m_fil(NULL), m_width(0), m_rows(0), m_row_set(false) {}
+	~fax_row_spool() { discard(); }
+
+	bool active(void) const { return m_fil != NULL ; }
+
+	int rows(void) const { return m_rows + ( m_row_set ? 1 : 0 ); }
+
+	/// Starts a new image, dropping the previous one if any.
+	void start( const std::string & fil_nam, int width )
+	{
+		discard();
+		m_fil = fopen( fil_nam.c_str(), "w+b" );
+		if( m_fil == NULL ) {
+			LOG_ERROR("Cannot open %s:%s", fil_nam.c_str(), strerror(errno) );
+			return ;
+		}
+		m_fil_nam = fil_nam ;
+		m_width = width ;
+		m_rows = 0 ;
+		m_row.assign( width, 255 );
+		m_row_set = false ;
+	}
+
+	/// Pixels are indexed from the image start. Skipped rows stay white,
+	/// pixels going backward to an already written row are ignored.
+	void put( int pix_idx, unsigned char pix_val )
+	{
+		if( m_fil == NULL ) return ;
+		int row = pix_idx / m_width ;
+		if( row < m_rows ) return ;
+		while( ( m_fil != NULL ) && ( row > m_rows ) ) {
+			write_row();
+		}
+		if( m_fil == NULL ) return ;
+		m_row[ pix_idx % m_width ] = pix_val ;
+		m_row_set = true ;
+	}
+
+	void discard(void)
+	{
+		if( m_fil == NULL ) return ;
+		fclose( m_fil );
+		m_fil = NULL ;
+		remove( m_fil_nam.c_str() );
+	}
+
+	/// Writes the spooled rows to a monochrome PNG file, then drops the spool.
+	bool save_png( const std::string & png_nam, const std::string & comments )
+	{
+		if( m_fil == NULL ) return false ;
+		if( m_row_set ) write_row();
+		if( ( m_fil == NULL ) || ( m_rows == 0 ) || fseek( m_fil, 0, SEEK_SET ) ) {
+			discard();
+			return false ;
+		}
+
+		FILE * fp = fopen( png_nam.c_str(), "wb" );
+		if( fp == NULL ) {
+			LOG_ERROR("Cannot open %s:%s", png_nam.c_str(), strerror(errno) );
+			discard();
+			return false ;
+		}
+
+		png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+		png_infop info = png ? png_create_info_struct(png) : NULL ;
+		if( info == NULL || setjmp(png_jmpbuf(png)) ) {
+			png_destroy_write_struct(&png, info ? &info : NULL);
+			fclose(fp);
+			remove( png_nam.c_str() );
+			discard();
+			return false ;
+		}
+
+		png_set_compression_level(png, Z_BEST_COMPRESSION);
+		png_init_io(png, fp);
+		png_set_IHDR(png, info, m_width, m_rows, 8,
+			     PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE,
+			     PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+		struct tm tm;
+		time_t t = time(NULL);
+		gmtime_r(&t, &tm);
+		char z[20 + 1];
+		strftime(z, sizeof(z), "%Y-%m-%dT%H:%M:%SZ", &tm);
+		z[sizeof(z) - 1] = '\0';
+
+		std::ostringstream comment;
+		comment << "Program: " PACKAGE_STRING << '\n'
+			<< "Received: " << z << '\n'
+			<< comments ;
+		std::string comment_str = comment.str();
+
+		png_text text;
+		text.key = const_cast<char *>("Comment");
+		text.text = const_cast<char *>(comment_str.c_str());
+		text.compression = PNG_TEXT_COMPRESSION_NONE;
+		png_set_text(png, info, &text, 1);
+		png_write_info(png, info);
+
+		/// m_row is reused as the read buffer: one row in memory at a time.
+		for( int ix_row = 0 ; ix_row < m_rows ; ++ix_row ) {
+			if( fread( &m_row[0], m_width, 1, m_fil ) != 1 ) {
+				std::fill( m_row.begin(), m_row.end(), 255 );
+			}
+			png_write_row(png, &m_row[0]);
+		}
+		png_write_end(png, info);
+		png_destroy_write_struct(&png, &info);
+		fclose(fp);
+		discard();
+		return true ;
+	}
+};
+
 class fax_implementation {
 	wefax * m_ptr_wefax ;  // Points to the modem of which this is the implementation.
 	fax_state m_rx_state ; // RXPHASING, RXIMAGE etc...
@@ -336,6 +481,9 @@ class fax_implementation {
 	int m_img_tx_rows;     // Number of rows when transmitting.
 	int m_carrier;         // Normalised fax carrier frequency. Should be identical to modem::get_freq().
 	int m_fax_pix_num;     // Index of current pixel in received image.
+	std::string m_row_pix; // Received pixels not yet sent to the viewer.
+	int m_row_pix_num;     // Index of the first pixel in m_row_pix.
+	fax_row_spool m_spool; // Received rows, when images are streamed to disk.
 	const unsigned char * m_xmt_pic_buf ; // Bytes to send. Number of pixels by three.
 	bool m_freq_mod ;      // Frequency modulation or AM.
 	bool m_manual_mode ;   // Tells whether everything is read, or apt+phasing detection.
@@ -415,9 +563,35 @@ class fax_implementation {
 
 	fax_implementation();
 
+	/// Sends the pending pixels to the viewer with a single request.
+	void flush_rx_pixels(void)
+	{
+		if( m_row_pix.empty() ) return ;
+		REQ( wefax_pic::update_rx_pic_row, m_row_pix, m_row_pix_num );
+		m_row_pix.clear();
+	}
+
+	/// Pixels are batched by row: Posting one request per pixel
+	/// floods the GUI thread queue with tiny updates.
+	void put_rx_pixel( unsigned char pix_val )
+	{
+		if( m_row_pix.empty() ) {
+			m_row_pix_num = m_fax_pix_num ;
+		} else if( m_fax_pix_num != m_row_pix_num + (int)m_row_pix.size() * bytes_per_pixel ) {
+			flush_rx_pixels();
+			m_row_pix_num = m_fax_pix_num ;
+		}
+		m_row_pix.push_back( pix_val );
+		if( (int)m_row_pix.size() >= m_img_width ) {
+			flush_rx_pixels();
+		}
+		m_spool.put( m_fax_pix_num / bytes_per_pixel, pix_val );
+	}
+
 	/// Needed when starting image reception, after phasing.
 	void reset_counters(void)
 	{
+		flush_rx_pixels();
 		m_last_col       = 0 ;
 		m_fax_pix_num    = 0 ;
 		m_img_sample     = 0;
@@ -520,6 +694,17 @@ public:
 	/// This generates a filename based on the frequency, current time, internal state etc...
 	std::string generate_filename( const char *extra_msg ) const ;
 
+	/// Every entry into RXIMAGE goes through here, with or without phasing,
+	/// so that every received image is spooled.
+	void start_rx_image(void)
+	{
+		m_rx_state = RXIMAGE ;
+		if( progdefaults.WEFAX_StreamSave ) {
+			m_spool.start( wefax_pic::default_dir_get( progdefaults.wefax_save_dir )
+					+ strformat( ".wefax_rx_%d.raw", getpid() ), m_img_width );
+		}
+	}
+
 	const char * state_rx_str(void) const
 	{
 		return state_to_str(m_rx_state);
@@ -1385,6 +1570,7 @@ fax_implementation::fax_implementation( int fax_mode, wefax * ptr_wefax  )
 	m_rx_state       = IDLE ;
 	m_tx_state       = IDLE ;
 	m_sample_rate    = 0 ;
+	m_row_pix_num    = 0 ;
 	reset_counters();
 
 	int index_of_correlation ;
@@ -1469,7 +1655,9 @@ void fax_implementation::decode(const int* buf, int nb_samples)
 		correlation_update(crr_val);
 
 		if( m_manual_mode ) {
-			m_rx_state = RXIMAGE;
+			if( m_rx_state != RXIMAGE ) {
+				start_rx_image();
+			}
 			bool is_max_lines_reached = decode_image(crr_val);
 			if( is_max_lines_reached ) {
 				skip_apt_rx();
@@ -1701,6 +1889,9 @@ void fax_implementation::save_automatic(
 	std::string new_filnam ;
 	std::stringstream extra_comments ;
 
+	/// The viewer must have received every pixel before its content is saved.
+	flush_rx_pixels();
+
 	/// These criteria used by rules-of-thumb to eliminate blank images.
 	m_statistics.calc();
 	double avg = m_statistics.average();
@@ -1784,7 +1975,15 @@ void fax_implementation::save_automatic(
 	extra_comments << "Standard deviation:"               << stddev << "\n" ;
 	extra_comments << "Comment:"                          << comment << "\n" ;
 	extra_comments << "PID:"                              << getpid() << "\n" ;
-	wefax_pic::save_image( new_filnam, extra_comments.str() );
+	if( m_spool.active() ) {
+		/// Slant and centering corrections done in the viewer do not apply here.
+		std::string png_nam = wefax_pic::default_dir_get( progdefaults.wefax_save_dir ) + new_filnam ;
+		if( m_spool.save_png( png_nam, extra_comments.str() ) ) {
+			REQ( wefax_pic::saved_image, new_filnam );
+		}
+	} else {
+		wefax_pic::save_image( new_filnam, extra_comments.str() );
+	}
 
 cleanup_rx:
 	/// This clears the current image.
@@ -1966,7 +2165,7 @@ bool fax_implementation::decode_image(int x)
 			// We could use the local clock to deduce where the pixel must be written:
 			// - Store the first pixel reception time.
 			// - Compute m_fax_pix_num = (reception_time * LPM * image_width)
-			REQ( wefax_pic::update_rx_pic_bw, m_pixel_val, m_fax_pix_num );
+			put_rx_pixel( m_pixel_val );
 			m_statistics.add_bw( m_pixel_val );
 			m_fax_pix_num += bytes_per_pixel ;
 		}
@@ -2042,7 +2241,7 @@ void fax_implementation::skip_phasing_to_image(bool auto_center)
 	m_ptr_wefax->qso_rec_init();
 
 	REQ( wefax_pic::skip_rx_phasing, auto_center );
-	m_rx_state=RXIMAGE;
+	start_rx_image();
 
 	/// For monochrome, LPM=60, 90, 100, 120, 180, 240. For colour, LPM =120, 240
 	/// So we round to the nearest integer to avoid slanting.
@@ -2086,6 +2285,7 @@ void fax_implementation::end_rx(void)
 	REQ(wefax_pic::abort_rx_viewer );
 	m_rx_state=RXAPTSTART;
 	reset_counters();
+	m_spool.discard();
 }
 
 /// Receives data from the soundcard.
@@ -2779,11 +2979,11 @@ void wefax::qso_rec_save(void)
 
 	m_qso_rec.setDateTime(false);
 
-	qsodb.qsoNewRec (&m_qso_rec);
+	cQsoRec *added = qsodb.qsoNewRec (&m_qso_rec);
 	qsodb.isdirty(0);
 	loadBrowser(true);
 
-	adifFile.writeLog (logbook_filename.c_str(), &qsodb);
+	adifFile.appendLog (logbook_filename.c_str(), &qsodb, added);
 	// dxcc_entity_cache_add(&rec);
 	LOG_INFO( _("Updating log book %s"), logbook_filename.c_str() );
 }
@@ -135,7 +135,10 @@ Fl_Menu_Item FTextRX::menu[] = {
 /// @param h
 /// @param l
 FTextRX::FTextRX(int x, int y, int w, int h, const char *l)
-        : FTextView(x, y, w, h, l)
+        : FTextView(x, y, w, h, l), rx_lines(0)
+#if FLDIGI_FLTK_API_MAJOR == 1 && FLDIGI_FLTK_API_MINOR == 3
+	, s_text_width(0), s_text_font(0), s_text_size(0)
+#endif
 {
 	memcpy(menu + RX_MENU_COPY, FTextView::menu, (FTextView::menu->size() - 1) * sizeof(*FTextView::menu));
 	context_menu = menu;
@@ -256,23 +259,134 @@ out:
 /// @param c The character
 /// @param attr The attribute (@see enum text_attr_e); RECV if omitted.
 ///
-
 #if FLDIGI_FLTK_API_MAJOR == 1 && FLDIGI_FLTK_API_MINOR == 3
 void FTextRX::add(unsigned int c, int attr)
+#else
+void FTextRX::add(unsigned char c, int attr)
+#endif
 {
-	if (c == '\r')
-		return;
+	add_begin();
+	add_char(c, attr);
+	add_end();
+}
 
-	char s[] = { '\0', '\0', FTEXT_DEF + attr, '\0' };
-	const char *cp = &s[0];
+/// Adds a string to the buffer
+///
+/// Verbatim characters are inserted in the text and style buffers by runs,
+/// and the visibility of the last line is tested once per call.
+///
+/// @param s The string
+/// @param attr The attribute (@see enum text_attr_e); RECV if omitted.
+///
+void FTextRX::add(const char *s, int attr)
+{
+	add_begin();
+	while (*s)
+		add_char((unsigned char)*s++, attr);
+	add_end();
+}
+
+void FTextRX::add_begin(void)
+{
+	// The buffer may have been emptied by something else than clear()
+	if (tbuf->length() == 0)
+		rx_lines = 0;
 
 	// The user may have moved the cursor by selecting text or
 	// scrolling. Place it at the end of the buffer.
 	if (mCursorPos != tbuf->length())
 		insert_position(tbuf->length());
+}
+
+void FTextRX::add_end(void)
+{
+	flush_pending();
+
+// test for bottom of text visibility
+#if FLDIGI_FLTK_API_MAJOR == 1 && FLDIGI_FLTK_API_MINOR == 3
+	if (// !mFastDisplay && 
+		(mVScrollBar->value() >= mNBufferLines - mNVisibleLines + mVScrollBar->linesize() - 1))
+		show_insert_position();
+#else
+	if (mTopLineNum + mNVisibleLines - 1 == mNBufferLines)
+//	if (mVScrollBar->value() >= mNBufferLines - mNVisibleLines + mVScrollBar->linesize() - 1)
+		show_insert_position();
+#endif
+}
+
+/// Inserts the pending verbatim characters and their styles.
+void FTextRX::flush_pending(void)
+{
+	if (pending_text.empty())
+		return;
+	sbuf->append(pending_style.c_str());
+	insert(pending_text.c_str());
+	pending_text.clear();
+	pending_style.clear();
+}
+
+/// Inserts a newline, maintaining the scrollback limit if we have one.
+///
+/// Old lines are dropped by batches of a sixteenth of the limit, so that the
+/// front of the buffers is moved once every many lines instead of on every line.
+///
+/// @param style The style string of the newline
+///
+void FTextRX::new_line(const char *style)
+{
+	int limit = progdefaults.rxtext_max_lines;
+	if (limit > 0 && rx_lines >= limit) {
+		int nlines = rx_lines - limit + 1 + limit / 16;
+		int le = tbuf->skip_lines(0, nlines);
+		tbuf->remove(0, le);
+		sbuf->remove(0, le);
+		rx_lines -= nlines;
+		if (rx_lines < 0)
+			rx_lines = 0;
+	}
+	insert("\n");
+	sbuf->append(style);
+	++rx_lines;
+}
+
+#if FLDIGI_FLTK_API_MAJOR == 1 && FLDIGI_FLTK_API_MINOR == 3
+/// Returns the width of the current line once \c cp has been appended to it.
+///
+/// The width of the previous characters is kept, so that only the new ones
+/// are measured. Non-ASCII or a changed font cause the whole line to be measured.
+///
+double FTextRX::line_width(const char *cp)
+{
+	fl_font( textfont(), textsize() );
+
+	bool ascii_only = true;
+	for (int i = 0; cp[i]; ++i)
+		if ((unsigned char)cp[i] & 0x80)
+			ascii_only = false;
+
+	if (s_text_width < 0 || !ascii_only ||
+	    s_text_font != textfont() || s_text_size != textsize()) {
+		s_text_width = fl_width( s_text.c_str(), s_text.length());
+		s_text_font = textfont();
+		s_text_size = textsize();
+	}
+	else
+		s_text_width += fl_width(cp);
+
+	return s_text_width;
+}
+
+void FTextRX::add_char(unsigned int c, int attr)
+{
+	if (c == '\r')
+		return;
+
+	char s[] = { '\0', '\0', FTEXT_DEF + attr, '\0' };
+	const char *cp = &s[0];
 
 	switch (c) {
 	case '\b':
+		flush_pending();
 		// we don't call kf_backspace because it kills selected text
 		if (s_text.length()) {
 			int character_start = tbuf->utf8_align(tbuf->length() - 1);
@@ -282,19 +396,15 @@ void FTextRX::add(unsigned int c, int attr)
 			sbuf->remove(character_start, sbuf->length());
 			s_text.resize(s_text.length() - character_length);
 			s_style.resize(s_style.length() - character_length);
+			s_text_width = -1;
 		}
 		break;
 	case '\n':
-		// maintain the scrollback limit, if we have one
-		if (max_lines > 0 && tbuf->count_lines(0, tbuf->length()) >= max_lines) {
-			int le = tbuf->line_end(0) + 1; // plus 1 for the newline
-			tbuf->remove(0, le);
-			sbuf->remove(0, le);
-		}
+		flush_pending();
 		s_text.clear();
 		s_style.clear();
-		insert("\n");
-		sbuf->append(s + 2);
+		s_text_width = 0;
+		new_line(s + 2);
 		break;
 	default:
 		if ((c < ' ' || c == 127) && attr != CTRL) // look it up
@@ -307,10 +417,11 @@ void FTextRX::add(unsigned int c, int attr)
 			s_style += s[2];
 		}
 
-		fl_font( textfont(), textsize() );
-		int lwidth = (int)fl_width( s_text.c_str(), s_text.length());
+		int lwidth = (int)line_width(cp);
 		bool wrapped = false;
 		if ( lwidth >= (text_area.w - mVScrollBar->w() - LEFT_MARGIN - RIGHT_MARGIN)) {
+			flush_pending();
+			s_text_width = -1;
 			if (c != ' ') {
 				size_t p = s_text.rfind(' ');
 				if (p != string::npos) {
@@ -319,8 +430,7 @@ void FTextRX::add(unsigned int c, int attr)
 					if (s_text.length() < 10) { // wrap and delete trailing space
 						tbuf->remove(tbuf->length() - s_text.length(), tbuf->length());
 						sbuf->remove(sbuf->length() - s_style.length(), sbuf->length());
-						insert("\n"); // always insert new line
-						sbuf->append(s + 2);
+						new_line(s + 2); // always insert new line
 						insert(s_text.c_str());
 						sbuf->append(s_style.c_str());
 						wrapped = true;
@@ -328,8 +438,7 @@ void FTextRX::add(unsigned int c, int attr)
 				}
 			}
 			if (!wrapped) { // add a new line if not wrapped
-				insert("\n");
-				sbuf->append(s + 2);
+				new_line(s + 2);
 				s_text.clear();
 				s_style.clear();
 				if (c != ' ') { // add character if not a space (no leading spaces)
@@ -343,46 +452,36 @@ void FTextRX::add(unsigned int c, int attr)
 			}
 		} else {
 			for (int i = 0; cp[i]; ++i)
-				sbuf->append(s + 2);
-			insert(cp);
+				pending_style.append(s + 2);
+			pending_text.append(cp);
 		}
 		break;
 	}
-
-// test for bottom of text visibility
-	if (// !mFastDisplay && 
-		(mVScrollBar->value() >= mNBufferLines - mNVisibleLines + mVScrollBar->linesize() - 1))
-		show_insert_position();
 }
 #else
-void FTextRX::add(unsigned char c, int attr)
+void FTextRX::add_char(unsigned char c, int attr)
 {
 	if (c == '\r')
 		return;
 
-	// The user may have moved the cursor by selecting text or
-	// scrolling. Place it at the end of the buffer.
-	if (mCursorPos != tbuf->length())
-		insert_position(tbuf->length());
-
 	switch (c) {
 	case '\b':
+		flush_pending();
 		// we don't call kf_backspace because it kills selected text
+		if (tbuf->length() && tbuf->character(tbuf->length() - 1) == '\n')
+			--rx_lines;
 		tbuf->remove(tbuf->length() - 1, tbuf->length());
 		sbuf->remove(sbuf->length() - 1, sbuf->length());
 		break;
-	case '\n':
-		// maintain the scrollback limit, if we have one
-		if (max_lines > 0 && tbuf->count_lines(0, tbuf->length()) >= max_lines) {
-			int le = tbuf->line_end(0) + 1; // plus 1 for the newline
-			tbuf->remove(0, le);
-			sbuf->remove(0, le);
-		}
-		// fall-through
 	default:
 		char s[] = { '\0', '\0', FTEXT_DEF + attr, '\0' };
 		const char *cp;
 
+		if (c == '\n') {
+			flush_pending();
+			new_line(s + 2);
+			break;
+		}
 		if ((c < ' ' || c == 127) && attr != CTRL) // look it up
 			cp = ascii[(unsigned char)c];
 		else { // insert verbatim
@@ -391,14 +490,10 @@ void FTextRX::add(unsigned char c, int attr)
 		}
 
 		for (int i = 0; cp[i]; ++i)
-			sbuf->append(s + 2);
-		insert(cp);
+			pending_style.append(s + 2);
+		pending_text.append(cp);
 		break;
 	}
-// test for bottom of text visibility
-	if (mTopLineNum + mNVisibleLines - 1 == mNBufferLines)
-//	if (mVScrollBar->value() >= mNBufferLines - mNVisibleLines + mVScrollBar->linesize() - 1)
-		show_insert_position();
 }
 #endif
 
@@ -429,9 +524,13 @@ void FTextRX::mark(FTextBase::TEXT_ATTR attr)
 void FTextRX::clear(void)
 {
 	FTextBase::clear();
+	rx_lines = 0;
+	pending_text.clear();
+	pending_style.clear();
 #if FLDIGI_FLTK_API_MAJOR == 1 && FLDIGI_FLTK_API_MINOR == 3
 	s_text.clear();
 	s_style.clear();
+	s_text_width = 0;
 #endif
 	static_cast<MVScrollbar*>(mVScrollBar)->clear();
 }
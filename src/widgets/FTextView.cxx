@@ -63,7 +63,7 @@ using namespace std;
 /// @param l 
 FTextBase::FTextBase(int x, int y, int w, int h, const char *l)
 	: Fl_Text_Editor_mod(x, y, w, h, l),
-          wrap(true), wrap_col(80), max_lines(0), scroll_hint(false)
+          wrap(true), wrap_col(80), scroll_hint(false)
 {
 	oldw = oldh = olds = -1;
 	oldf = (Fl_Font)-1;